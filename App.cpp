@@ -5,8 +5,11 @@
 #include "framework/ConstantBuffers.h"
 #include "framework/CwfException.h"
 #include "framework/Graphics.h"
+#include "framework/InputTimeline.h"
 #include "framework/Material.h"
+#include "framework/Mouse.h"
 #include "framework/Orientation.h"
+#include "framework/RenderQueue.h"
 #include "framework/Vertices.h"
 #include "framework/Window.h"
 #include "framework/WindowBuilder.h"
@@ -33,8 +36,7 @@ void App::doFrame() {
 	/*w->gfx().clearBuffer(0.0f,
 		std::clamp(static_cast<float>(w->mouse.getX()) / static_cast<float>(w->getClientWidth()), 0.0f, 1.0f),
 		std::clamp(static_cast<float>(w->mouse.getY()) / static_cast<float>(w->getClientHeight()), 0.0f, 1.0f));
-	w->gfx().drawTestCube(w->kbd.isKeyPressed('A'), w->kbd.isKeyPressed('D'),
-		w->kbd.isKeyPressed('W'), w->kbd.isKeyPressed('S'));*/
+	gfx.debugDraw().cube(math::XMMatrixTranslation(0.0f, 0.0f, 1.0f), DebugDraw::RED);*/
 	
 	float dX{ 0.0f };
 	float dY{ 0.0f };
@@ -48,25 +50,54 @@ void App::doFrame() {
 	if (m_window->kbd.isKeyPressed('S'))
 		dX -= dTheta;*/
 
-	while (!m_window->mouse.isRawQueueEmpty()) {
-		Mouse::PositionDelta dP{ *(m_window->mouse.pollRawQueue()) };
-		dY += dP.x * dThetaMouse;
-		dX += dP.y * dThetaMouse;
+	if (mp_input) {
+		const InputTimeline::State input{ mp_input->advance(InputTimeline::now()) };
+		dY += input.dx * dThetaMouse;
+		dX += input.dy * dThetaMouse;
+	} else {
+		// everything processMessagesOnQueue drained since the last frame, summed as it arrived, so none of it is dropped
+		const Mouse::PositionDelta delta{ m_window->mouse.consumeAccumulatedDelta() };
+		m_window->mouse.clearRawQueue(); // the same deltas, one by one; unread, so don't let them pile up
+		dY += delta.x * dThetaMouse;
+		dX += delta.y * dThetaMouse;
 	}
 
-	if (dX != 0.0f || dY != 0.0f) {
+	const bool moved{ dX != 0.0f || dY != 0.0f };
+	if (moved) {
 		// o.update(dX, dY, 0.0f);
 		gfx.camera().updateOrientation(dX, dY, 0.0f);
 		*mp_cbuf = {
 			math::XMMatrixIdentity()
-		};
-		m_cube.updateCopyConstantBuffer(0, gfx, mp_cbuf.get(), mp_cbuf->getBufferSize());
+		}; // picked up by stageConstantBuffers below, since m_cube reads it through a pointer
 	}
 
+	// hides the meshes the camera can't see; both draw paths below skip them
+	m_cube.cull(gfx);
+
+	// no Direct3D 11.1: map the constant buffer itself and replay the command list, which draw records again whenever
+	// the cull changed what is visible
+	if (!mp_ring) {
+		if (moved) m_cube.updateCopyConstantBuffer(0u, gfx, mp_cbuf.get(), mp_cbuf->getBufferSize());
+		gfx.clearBuffer(0, 0, 0);
+		m_cube.draw(gfx);
+		gfx.endFrame();
+		return;
+	}
+
+	// one map for every dynamic constant buffer this frame
+	mp_ring->beginFrame();
+	m_cube.stageConstantBuffers(*mp_ring);
+	mp_ring->endUpdates();
+
+	// everything drawn this frame goes through the queue, which sorts it and skips redundant binds
+	m_queue.clear();
+	m_cube.submit(m_queue);
+	// m_otherCube.submit(m_queue);
+
 	gfx.clearBuffer(0, 0, 0);
-	m_cube.draw(gfx);
-	// m_otherCube.draw(gfx);
+	m_queue.execute(gfx, *mp_ring);
 	gfx.endFrame();
+	mp_ring->endFrame();
 }
 
 LRESULT WndProc(Window* pWindow, HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -78,8 +109,9 @@ LRESULT WndProc(Window* pWindow, HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
 	return DefWindowProcW(hWnd, msg, wParam, lParam);
 }
 
-App::App(HINSTANCE hInstance) : m_cube{ CubeSkinned<L"bitmap.DDS", Vertices::Float3Tex>::material() }, 
-	m_otherCube{ m_cube }, mp_cbuf{} {
+App::App(HINSTANCE hInstance, bool windowInput)
+	: m_cube{ CubeSkinned<L"bitmap.DDS", Vertices::Float3Tex>::material() }, m_otherCube{ m_cube }, mp_cbuf{}, mp_ring{},
+	m_queue{}, mp_input{}, m_windowInput{ windowInput } {
 
 	WindowClass wc{ hInstance, s_className };
 	wc.registerClass();
@@ -96,6 +128,8 @@ App::App(HINSTANCE hInstance) : m_cube{ CubeSkinned<L"bitmap.DDS", Vertices::Flo
 	gfx.camera().setPosition( 0.0f, 0.0f, -2.0f );
 
 	mp_cbuf = std::make_unique<ConstantBuffers::VPTConstBuffer>(gfx);
+	// without Direct3D 11.1's constant buffer offsetting, doFrame maps each buffer itself
+	if (ConstantBufferRing::isSupported(gfx)) mp_ring = std::make_unique<ConstantBufferRing>(gfx);
 
 	using TexturedCube = CubeSkinned<L"bitmap.DDS", Vertices::Float3Tex>;
 	TexturedCube::addMesh();
@@ -110,7 +144,9 @@ App::App(HINSTANCE hInstance) : m_cube{ CubeSkinned<L"bitmap.DDS", Vertices::Flo
 }
 
 int App::run() {
-	m_window->mouse.enableRawInput();
+	if (!m_windowInput) mp_input = std::make_unique<InputThread>(m_window->getHWND());
+	else if (!m_window->mouse.enableRawInput())
+		throw CWF_EXCEPTION(CwfException::Type::FRAMEWORK, L"Could not enable the window's raw mouse input.");
 	m_cube.setupPipeline(m_window->gfx());
 	m_otherCube.setupPipeline(m_window->gfx());
 	m_window->showWindow();
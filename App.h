@@ -1,8 +1,11 @@
 #ifndef CWF_APP_H
 #define CWF_APP_H
 
+#include "framework/ConstantBufferRing.h"
 #include "framework/ConstantBuffers.h"
+#include "framework/InputThread.h"
 #include "framework/Material.h"
+#include "framework/RenderQueue.h"
 #include "framework/Submaterial.h"
 #include "framework/Vertices.h"
 #include "framework/Window.h"
@@ -25,8 +28,13 @@ private:
 	Material<Vertices::Float3Tex, uint16_t>& m_cube;
 	Submaterial<Vertices::Float3Tex, uint16_t> m_otherCube;
 	std::unique_ptr<ConstantBuffers::VPTConstBuffer> mp_cbuf;
+	std::unique_ptr<ConstantBufferRing> mp_ring;
+	RenderQueue m_queue;
+	std::unique_ptr<InputThread> mp_input; // null when the window reads raw input itself
+	bool m_windowInput;
 public:
-	App(HINSTANCE hInstance);
+	// windowInput: read the mouse through the window's own raw input (Mouse::enableRawInput) instead of an InputThread
+	App(HINSTANCE hInstance, bool windowInput);
 	~App() = default;
 	// no copy init/assign
 	App(const App& o) = delete;
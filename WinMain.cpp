@@ -1,6 +1,7 @@
 #include "App.h"
 #include "framework/CwfException.h"
 #include "framework/Window.h"
+#include <string_view>
 #include <Windows.h>
 
 int CALLBACK WinMain(
@@ -12,11 +13,13 @@ int CALLBACK WinMain(
 	/* 
 	* If the Window creation fails, there is no Window to own the message box, so the exceptions
 	* go to Window::createExceptionMessageBoxStatic. The App class handles its exceptions in run().
+	* -windowinput reads the mouse through the window's raw input instead of an InputThread.
 	*/
+	const bool windowInput{ std::string_view{ lpCmdLine }.find("-windowinput") != std::string_view::npos };
 
 	int exitCode{ 0 };
 	try {
-		App d3dTest{ hInstance };
+		App d3dTest{ hInstance, windowInput };
 		exitCode = d3dTest.run();
 	} catch (const CwfException& e) {
 		Window::createExceptionMessageBoxStatic(e);
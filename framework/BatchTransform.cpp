@@ -0,0 +1,232 @@
+#include "BatchTransform.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CWF_BATCHTRANSFORM_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CWF_TARGET_AVX2 // MSVC lets any function use AVX2 intrinsics
+#else
+#define CWF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace {
+	// one point by one matrix
+	inline void transformOne(const float* m, float x, float y, float z, float& ox, float& oy, float& oz) noexcept {
+		ox = x * m[0] + y * m[4] + z * m[8] + m[12];
+		oy = x * m[1] + y * m[5] + z * m[9] + m[13];
+		oz = x * m[2] + y * m[6] + z * m[10] + m[14];
+	}
+
+	void transformTail(const float* m, const BatchTransform::Points& points, size_t first,
+		const BatchTransform::Output& out, size_t outBase) noexcept {
+		for (size_t i{ first }; i < points.count; i++)
+			transformOne(m, points.x[i], points.y[i], points.z[i], out.x[outBase + i], out.y[outBase + i], out.z[outBase + i]);
+	}
+
+	// out = transpose(m * right)
+	inline void multiplyTransposedOne(const float* m, const float* right, float* out) noexcept {
+		for (size_t r{ 0u }; r < 4u; r++) {
+			for (size_t c{ 0u }; c < 4u; c++)
+				out[c * 4u + r] = m[r * 4u] * right[c] + m[r * 4u + 1u] * right[4u + c] + m[r * 4u + 2u] * right[8u + c] + m[r * 4u + 3u] * right[12u + c];
+		}
+	}
+
+#ifdef CWF_BATCHTRANSFORM_X86
+	void transformSse2(const float* pMatrices, size_t matrixCount, const BatchTransform::Points& points,
+		const BatchTransform::Output& out) noexcept {
+		const size_t vectorCount{ points.count & ~size_t{ 3u } };
+		for (size_t mi{ 0u }; mi < matrixCount; mi++) {
+			const float* m{ pMatrices + mi * 16u };
+			const size_t outBase{ mi * points.count };
+			for (size_t i{ 0u }; i < vectorCount; i += 4u) {
+				const __m128 x{ _mm_loadu_ps(points.x + i) };
+				const __m128 y{ _mm_loadu_ps(points.y + i) };
+				const __m128 z{ _mm_loadu_ps(points.z + i) };
+				for (size_t c{ 0u }; c < 3u; c++) {
+					__m128 r{ _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m[c])), _mm_set1_ps(m[12u + c])) };
+					r = _mm_add_ps(r, _mm_mul_ps(y, _mm_set1_ps(m[4u + c])));
+					r = _mm_add_ps(r, _mm_mul_ps(z, _mm_set1_ps(m[8u + c])));
+					float* pOut{ c == 0u ? out.x : (c == 1u ? out.y : out.z) };
+					_mm_storeu_ps(pOut + outBase + i, r);
+				}
+			}
+			transformTail(m, points, vectorCount, out, outBase);
+		}
+	}
+
+	CWF_TARGET_AVX2 void transformAvx2(const float* pMatrices, size_t matrixCount, const BatchTransform::Points& points,
+		const BatchTransform::Output& out) noexcept {
+		// the last partial group of points goes through masked loads/stores rather than scalar code, since mixing
+		// in non-VEX scalar code after 256-bit instructions costs a state transition on many CPUs
+		const size_t tail{ points.count & 7u };
+		alignas(32) int maskLanes[8]{};
+		for (size_t i{ 0u }; i < tail; i++) maskLanes[i] = -1;
+		const __m256i mask{ _mm256_load_si256(reinterpret_cast<const __m256i*>(maskLanes)) };
+
+		for (size_t mi{ 0u }; mi < matrixCount; mi++) {
+			const float* m{ pMatrices + mi * 16u };
+			const size_t outBase{ mi * points.count };
+			for (size_t i{ 0u }; i < points.count; i += 8u) {
+				const bool partial{ points.count - i < 8u };
+				const __m256 x{ partial ? _mm256_maskload_ps(points.x + i, mask) : _mm256_loadu_ps(points.x + i) };
+				const __m256 y{ partial ? _mm256_maskload_ps(points.y + i, mask) : _mm256_loadu_ps(points.y + i) };
+				const __m256 z{ partial ? _mm256_maskload_ps(points.z + i, mask) : _mm256_loadu_ps(points.z + i) };
+				for (size_t c{ 0u }; c < 3u; c++) { // output component c: x * m[0][c] + y * m[1][c] + z * m[2][c] + m[3][c]
+					__m256 r{ _mm256_fmadd_ps(x, _mm256_broadcast_ss(m + c), _mm256_broadcast_ss(m + 12u + c)) };
+					r = _mm256_fmadd_ps(y, _mm256_broadcast_ss(m + 4u + c), r);
+					r = _mm256_fmadd_ps(z, _mm256_broadcast_ss(m + 8u + c), r);
+					float* pOut{ (c == 0u ? out.x : (c == 1u ? out.y : out.z)) + outBase + i };
+					if (partial)
+						_mm256_maskstore_ps(pOut, mask, r);
+					else
+						_mm256_storeu_ps(pOut, r);
+				}
+			}
+		}
+		_mm256_zeroupper();
+	}
+
+	void multiplyTransposedSse2(const float* pMatrices, size_t count, const float* pRight, float* pOut, size_t outStride) noexcept {
+		const __m128 r0{ _mm_loadu_ps(pRight) };
+		const __m128 r1{ _mm_loadu_ps(pRight + 4u) };
+		const __m128 r2{ _mm_loadu_ps(pRight + 8u) };
+		const __m128 r3{ _mm_loadu_ps(pRight + 12u) };
+		for (size_t i{ 0u }; i < count; i++) {
+			const float* m{ pMatrices + i * 16u };
+			__m128 rows[4];
+			for (size_t r{ 0u }; r < 4u; r++) { // row r of the product: m[r][0] * right[0] + ... + m[r][3] * right[3]
+				__m128 row{ _mm_mul_ps(_mm_set1_ps(m[r * 4u]), r0) };
+				row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[r * 4u + 1u]), r1));
+				row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[r * 4u + 2u]), r2));
+				rows[r] = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[r * 4u + 3u]), r3));
+			}
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+			float* out{ pOut + i * outStride };
+			for (size_t r{ 0u }; r < 4u; r++)
+				_mm_storeu_ps(out + r * 4u, rows[r]);
+		}
+	}
+
+	CWF_TARGET_AVX2 void multiplyTransposedAvx2(const float* pMatrices, size_t count, const float* pRight, float* pOut,
+		size_t outStride) noexcept {
+		// each right-hand row in both halves, so one register computes two rows of the product
+		const __m256 r0{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pRight)) };
+		const __m256 r1{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pRight + 4u)) };
+		const __m256 r2{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pRight + 8u)) };
+		const __m256 r3{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pRight + 12u)) };
+		for (size_t i{ 0u }; i < count; i++) {
+			const float* m{ pMatrices + i * 16u };
+			__m256 pairs[2]; // rows 0 and 1, rows 2 and 3
+			for (size_t p{ 0u }; p < 2u; p++) {
+				const float* a{ m + p * 8u }; // row 2p, then row 2p + 1
+				__m256 pair{ _mm256_mul_ps(_mm256_set_m128(_mm_set1_ps(a[4]), _mm_set1_ps(a[0])), r0) };
+				pair = _mm256_fmadd_ps(_mm256_set_m128(_mm_set1_ps(a[5]), _mm_set1_ps(a[1])), r1, pair);
+				pair = _mm256_fmadd_ps(_mm256_set_m128(_mm_set1_ps(a[6]), _mm_set1_ps(a[2])), r2, pair);
+				pairs[p] = _mm256_fmadd_ps(_mm256_set_m128(_mm_set1_ps(a[7]), _mm_set1_ps(a[3])), r3, pair);
+			}
+			__m128 rows[4]{
+				_mm256_castps256_ps128(pairs[0]), _mm256_extractf128_ps(pairs[0], 1),
+				_mm256_castps256_ps128(pairs[1]), _mm256_extractf128_ps(pairs[1], 1)
+			};
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+			float* out{ pOut + i * outStride };
+			_mm256_storeu_ps(out, _mm256_set_m128(rows[1], rows[0]));
+			_mm256_storeu_ps(out + 8u, _mm256_set_m128(rows[3], rows[2]));
+		}
+		_mm256_zeroupper();
+	}
+
+	[[maybe_unused]] bool hasAvx2() noexcept {
+#ifdef _MSC_VER
+		int info[4]{};
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+		__cpuid(info, 1);
+		const bool osxsave{ (info[2] & (1 << 27)) != 0 };
+		const bool fma{ (info[2] & (1 << 12)) != 0 };
+		if (!osxsave || !fma) return false;
+		if ((_xgetbv(0) & 0x6u) != 0x6u) return false; // the OS saves the YMM registers
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+#endif
+}
+
+// the tests define CWF_BATCHTRANSFORM_FORCED_PATH and link tests/ForcedPath.cpp's path() instead, to run every path
+#ifndef CWF_BATCHTRANSFORM_FORCED_PATH
+BatchTransform::Path BatchTransform::path() noexcept {
+#ifdef CWF_BATCHTRANSFORM_X86
+	static const Path s_path{ hasAvx2() ? Path::AVX2 : Path::SSE2 };
+	return s_path;
+#else
+	return Path::SCALAR;
+#endif
+}
+#endif
+
+void BatchTransform::transformPoints(const float* pMatrices, size_t matrixCount, const Points& points, const Output& out) noexcept {
+	switch (path()) {
+#ifdef CWF_BATCHTRANSFORM_X86
+	case Path::AVX2:
+		transformAvx2(pMatrices, matrixCount, points, out);
+		break;
+	case Path::SSE2:
+		transformSse2(pMatrices, matrixCount, points, out);
+		break;
+#endif
+	default:
+		transformPointsScalar(pMatrices, matrixCount, points, out);
+	}
+}
+
+void BatchTransform::transformPointsScalar(const float* pMatrices, size_t matrixCount, const Points& points, const Output& out) noexcept {
+	for (size_t mi{ 0u }; mi < matrixCount; mi++)
+		transformTail(pMatrices + mi * 16u, points, 0u, out, mi * points.count);
+}
+
+void BatchTransform::multiplyTransposed(const float* pMatrices, size_t count, const float* pRight, float* pOut,
+	size_t outStride) noexcept {
+	switch (path()) {
+#ifdef CWF_BATCHTRANSFORM_X86
+	case Path::AVX2:
+		multiplyTransposedAvx2(pMatrices, count, pRight, pOut, outStride);
+		break;
+	case Path::SSE2:
+		multiplyTransposedSse2(pMatrices, count, pRight, pOut, outStride);
+		break;
+#endif
+	default:
+		multiplyTransposedScalar(pMatrices, count, pRight, pOut, outStride);
+	}
+}
+
+void BatchTransform::multiplyTransposedScalar(const float* pMatrices, size_t count, const float* pRight, float* pOut,
+	size_t outStride) noexcept {
+	for (size_t i{ 0u }; i < count; i++)
+		multiplyTransposedOne(pMatrices + i * 16u, pRight, pOut + i * outStride);
+}
+
+void BatchTransform::multiplyTransposedParallel(WorkerPool& pool, const float* pMatrices, size_t count, const float* pRight,
+	float* pOut, size_t outStride, unsigned threadCount) {
+	const size_t threads{ threadCount == 0u ? pool.getThreadCount() + 1u : threadCount };
+	const size_t chunks{ std::min(threads, std::max<size_t>(count / MIN_MATRICES_PER_THREAD, 1u)) };
+	const size_t chunkSize{ (count + chunks - 1u) / chunks };
+	pool.run(chunks, [=](size_t chunk) {
+		const size_t first{ chunk * chunkSize };
+		if (first < count)
+			multiplyTransposed(pMatrices + first * 16u, std::min(chunkSize, count - first), pRight, pOut + first * outStride, outStride);
+	});
+}
+
+void BatchTransform::multiplyTransposedParallel(const float* pMatrices, size_t count, const float* pRight, float* pOut,
+	size_t outStride, unsigned threadCount) {
+	multiplyTransposedParallel(WorkerPool::shared(), pMatrices, count, pRight, pOut, outStride, threadCount);
+}
\ No newline at end of file
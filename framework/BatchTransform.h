@@ -0,0 +1,60 @@
+#ifndef CWF_BATCHTRANSFORM_H
+#define CWF_BATCHTRANSFORM_H
+
+#include "WorkerPool.h"
+#include <cstddef>
+
+/*
+* Transforms one small set of points (e.g. a cube's corners) by many matrices at once, for baking thousands of
+* transformed copies of a mesh into one static vertex buffer.
+* Points are structure-of-arrays (all x, then all y, then all z) on the way in and out, so each SIMD lane holds one
+* point and a matrix element is simply broadcast; the result for matrix m, point i lands at index m * count + i.
+* Matrices are 16 floats each, row-major, applied to row vectors (x, y, z, 1) the way DirectXMath does, so an
+* array of XMFLOAT4X4 can be passed as is. w is not computed (the matrices are expected to be affine).
+* multiplyTransposed is the per-object side: it computes transpose(matrix[i] * right) for a whole array of matrices
+* (e.g. world matrices times the view projection, transposed for HLSL's column-major constants) and writes each result
+* outStride floats after the previous one, so it can fill a mapped constant/instance buffer (or a staging copy of one)
+* directly, leaving room for other per-object data in between. The parallel variant splits the array across the
+* threads of a WorkerPool (the caller's, or WorkerPool::shared()), which are started once rather than per call; it runs
+* on the calling thread alone when the batch is too small to be worth it.
+* The AVX2 path is picked at run time if the CPU has it; otherwise SSE2 on x86/x64, or plain C++ elsewhere.
+*/
+
+namespace BatchTransform {
+	enum class Path {
+		SCALAR, SSE2, AVX2
+	};
+
+	struct Points {
+		const float* x;
+		const float* y;
+		const float* z;
+		size_t count;
+	};
+
+	struct Output {
+		float* x; // each at least matrixCount * points.count floats
+		float* y;
+		float* z;
+	};
+
+	constexpr size_t MATRIX_FLOATS{ 16u };
+	constexpr size_t MIN_MATRICES_PER_THREAD{ 16384u }; // below this, another thread costs more than it saves
+
+	Path path() noexcept; // what transformPoints and multiplyTransposed use on this machine
+	void transformPoints(const float* pMatrices, size_t matrixCount, const Points& points, const Output& out) noexcept;
+	void transformPointsScalar(const float* pMatrices, size_t matrixCount, const Points& points, const Output& out) noexcept;
+
+	// pOut gets (count - 1) * outStride + 16 floats; outStride is at least 16
+	void multiplyTransposed(const float* pMatrices, size_t count, const float* pRight, float* pOut,
+		size_t outStride = MATRIX_FLOATS) noexcept;
+	void multiplyTransposedScalar(const float* pMatrices, size_t count, const float* pRight, float* pOut,
+		size_t outStride = MATRIX_FLOATS) noexcept;
+	// threadCount caps the threads used, the caller included; 0 means all of the pool's
+	void multiplyTransposedParallel(WorkerPool& pool, const float* pMatrices, size_t count, const float* pRight, float* pOut,
+		size_t outStride = MATRIX_FLOATS, unsigned threadCount = 0u);
+	void multiplyTransposedParallel(const float* pMatrices, size_t count, const float* pRight, float* pOut,
+		size_t outStride = MATRIX_FLOATS, unsigned threadCount = 0u); // on WorkerPool::shared()
+}
+
+#endif
\ No newline at end of file
@@ -1,91 +1,129 @@
 #include "Camera.h"
 #include "Orientation.h"
+#include <atomic>
+#include <cstdint>
 #include <DirectXMath.h>
 
 namespace math = DirectX;
 
+namespace {
+	// versions are unique across all cameras, so assigning a different camera also reads as a change
+	uint64_t nextVersion() noexcept {
+		static std::atomic<uint64_t> s_version{ 1u };
+		return s_version.fetch_add(1u, std::memory_order_relaxed);
+	}
+}
+
 Camera::Camera() noexcept
 	: m_pos{ 0.0f, 0.0f, 0.0f },
 	  m_up{ 0.0f, 1.0f, 0.0f },
 	  m_matrix{},
+	  m_basis{},
 	  m_o{},
-	  m_changed{ true } {}
+	  m_changed{ true },
+	  m_version{ nextVersion() } {}
 
 Camera::Camera(const math::XMFLOAT3& pos) noexcept
 	: m_pos{ pos },
 	  m_up{ 0.0f, 1.0f, 0.0f },
 	  m_matrix{},
+	  m_basis{},
 	  m_o{},
-	  m_changed{ true } {}
+	  m_changed{ true },
+	  m_version{ nextVersion() } {}
 
 Camera::Camera(float xTheta, float yTheta, float zTheta) noexcept
 	: m_pos{ 0.0f, 0.0f, 0.0f },
 	  m_up{ 0.0f, 1.0f, 0.0f },
 	  m_matrix{},
+	  m_basis{},
 	  m_o{ xTheta, yTheta, zTheta },
-	  m_changed{ true } {}
+	  m_changed{ true },
+	  m_version{ nextVersion() } {}
 
 Camera::Camera(const math::XMFLOAT3& pos, float xTheta, float yTheta, float zTheta) noexcept
 	: m_pos{ pos },
 	  m_up{ 0.0f, 1.0f, 0.0f },
 	  m_matrix{},
+	  m_basis{},
 	  m_o{ xTheta, yTheta, zTheta },
-	  m_changed{ true } {}
+	  m_changed{ true },
+	  m_version{ nextVersion() } {}
 
 void Camera::reset() noexcept {
 	m_pos = { 0.0f, 0.0f, 0.0f };
 	m_up = { 0.0f, 1.0f, 0.0f };
 	m_o.reset();
-	m_changed = true;
+	changed();
 }
 
 void Camera::setPosition(float x, float y, float z) noexcept {
 	m_pos = {x, y, z};
-	m_changed = true;
+	changed();
 }
 
 void Camera::setOrientation(float xTheta, float yTheta, float zTheta) noexcept {
 	m_o.set(xTheta, yTheta, zTheta);
-	m_changed = true;
+	changed();
 }
 
 void Camera::setUp(float x, float y, float z) noexcept {
 	m_up = {x, y, z};
-	m_changed = true;
+	changed();
 }
 
 void Camera::updatePosition(float x, float y, float z) noexcept {
 	m_pos.x += x;
 	m_pos.y += y;
 	m_pos.z += z;
-	m_changed = true;
+	changed();
 }
 
 void Camera::updateOrientation(float dxTheta, float dyTheta, float dzTheta) noexcept {
 	m_o.update(dxTheta, dyTheta, dzTheta);
-	m_changed = true;
+	changed();
 }
 
 void Camera::updateUp(float x, float y, float z) noexcept {
 	m_up.x += x;
 	m_up.y += y;
 	m_up.z += z;
-	m_changed = true;
+	changed();
 }
 
 math::XMMATRIX Camera::get() const noexcept {
-	if (m_changed) {
-		math::XMStoreFloat4x4(&m_matrix,
-			math::XMMatrixLookToLH(
-				math::XMLoadFloat3(&m_pos),
-				math::XMVector3Transform(
-					math::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f),
-					m_o.get()
-				),
-				math::XMLoadFloat3(&m_up)
-			)
-		);
-		m_changed = false;
-	}
+	update();
 	return math::XMLoadFloat4x4(&m_matrix);
+}
+
+const Camera::Basis& Camera::getBasis() const noexcept {
+	update();
+	return m_basis;
+}
+
+uint64_t Camera::getVersion() const noexcept {
+	return m_version;
+}
+
+void Camera::changed() noexcept {
+	m_changed = true;
+	m_version = nextVersion();
+}
+
+void Camera::update() const noexcept {
+	if (!m_changed) return;
+	math::XMStoreFloat4x4(&m_matrix,
+		math::XMMatrixLookToLH(
+			math::XMLoadFloat3(&m_pos),
+			m_o.rotate(math::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)),
+			math::XMLoadFloat3(&m_up)
+		)
+	);
+	// a view matrix's first three columns are the camera's axes
+	m_basis = {
+		{ m_matrix._11, m_matrix._21, m_matrix._31 },
+		{ m_matrix._12, m_matrix._22, m_matrix._32 },
+		{ m_matrix._13, m_matrix._23, m_matrix._33 }
+	};
+	m_changed = false;
 }
\ No newline at end of file
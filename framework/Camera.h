@@ -2,17 +2,27 @@
 #define CWF_CAMERA_H
 
 #include "Orientation.h"
+#include <cstdint>
 #include <DirectXMath.h>
 
 namespace math = DirectX;
 
 class Camera {
+public:
+	// the view's axes in world space (orthonormal; up is derived, so it need not equal the up set with setUp)
+	struct Basis {
+		math::XMFLOAT3 right;
+		math::XMFLOAT3 up;
+		math::XMFLOAT3 forward;
+	};
 private:
 	math::XMFLOAT3 m_pos;
 	math::XMFLOAT3 m_up;
 	mutable math::XMFLOAT4X4 m_matrix;
+	mutable Basis m_basis; // both recomputed together, when m_changed
 	Orientation m_o;
 	mutable bool m_changed;
+	uint64_t m_version; // new on every change, so dependents (e.g. Graphics::getViewProjection) can tell
 public:
 	Camera() noexcept;
 	Camera(const math::XMFLOAT3& pos) noexcept;
@@ -28,6 +38,11 @@ public:
 	void updateUp(float x, float y, float z) noexcept;
 
 	math::XMMATRIX get() const noexcept;
+	const Basis& getBasis() const noexcept;
+	uint64_t getVersion() const noexcept;
+private:
+	void changed() noexcept;
+	void update() const noexcept;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#define NOMINMAX
+
+#include "ConstantBufferRing.h"
+#include "CwfException.h"
+#include "Graphics.h"
+#include "RingAllocator.h"
+#include "ShaderStage.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cstring>
+#include <d3d11.h>
+#include <d3d11_1.h>
+#include <thread>
+
+ConstantBufferRing::ConstantBufferRing(const Graphics& gfx, size_t capacity)
+	: m_gfx{ gfx }, m_allocator{ RingAllocator::alignUp(capacity, RingAllocator::DEFAULT_ALIGNMENT) },
+	m_queryFrames{}, m_pMapped{ nullptr }, m_noOverwrite{ false }, m_fresh{ true }, m_frame{ 1u },
+	m_mapCount{ 0u }, m_allocationCount{ 0u } {
+
+	if (!m_gfx.getImmediateContext1())
+		throw CWF_EXCEPTION(CwfException::Type::FRAMEWORK, L"ConstantBufferRing requires Direct3D 11.1.");
+
+	Microsoft::WRL::ComPtr<ID3D11Device> pDevice{ m_gfx.getDevice() };
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+	THROW_IF_FAILED(m_gfx, pDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)));
+	if (!options.ConstantBufferOffsetting)
+		throw CWF_EXCEPTION(CwfException::Type::FRAMEWORK, L"Driver does not support constant buffer offsetting.");
+	m_noOverwrite = options.MapNoOverwriteOnDynamicConstantBuffer;
+
+	if (m_noOverwrite) {
+		D3D11_QUERY_DESC queryDesc{};
+		queryDesc.Query = D3D11_QUERY_EVENT;
+		queryDesc.MiscFlags = 0u;
+		for (auto& pQuery : m_frameQueries)
+			THROW_IF_FAILED(m_gfx, pDevice->CreateQuery(&queryDesc, &pQuery));
+	}
+
+	createBuffer(m_allocator.getCapacity());
+}
+
+bool ConstantBufferRing::isSupported(const Graphics& gfx) noexcept {
+	if (!gfx.getImmediateContext1()) return false;
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+	if (FAILED(gfx.getDevice()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) return false;
+	return options.ConstantBufferOffsetting;
+}
+
+void ConstantBufferRing::beginFrame() {
+	m_mapCount = 0u;
+	m_allocationCount = 0u;
+	if (m_noOverwrite) retireCompletedFrames(false);
+	map();
+}
+
+ConstantBufferRing::Allocation ConstantBufferRing::allocate(const void* pData, size_t byteWidth) {
+	if (!m_pMapped)
+		throw CWF_EXCEPTION(CwfException::Type::FRAMEWORK, L"ConstantBufferRing::allocate called outside of beginFrame/endUpdates.");
+
+	size_t offset{ m_allocator.allocate(byteWidth) };
+	if (offset == RingAllocator::INVALID_OFFSET && m_noOverwrite) {
+		retireCompletedFrames(true); // older frames might just need to finish
+		offset = m_allocator.allocate(byteWidth);
+	}
+	if (offset == RingAllocator::INVALID_OFFSET) { // this frame alone does not fit, so grow
+		m_gfx.getImmediateContext()->Unmap(m_pBuffer.Get(), 0u);
+		m_pMapped = nullptr;
+		m_outgrownBuffers.push_back(m_pBuffer); // earlier allocations this frame still point at it
+		createBuffer(std::max(m_allocator.getCapacity() * 2u, RingAllocator::alignUp(byteWidth, m_allocator.getAlignment())));
+		map();
+		offset = m_allocator.allocate(byteWidth);
+	}
+
+	std::memcpy(m_pMapped + offset, pData, byteWidth);
+	m_allocationCount++;
+	return {
+		m_pBuffer.Get(),
+		static_cast<UINT>(offset / CONSTANT_SIZE),
+		static_cast<UINT>(RingAllocator::alignUp(byteWidth, m_allocator.getAlignment()) / CONSTANT_SIZE)
+	};
+}
+
+void ConstantBufferRing::endUpdates() {
+	if (!m_pMapped) return;
+	m_gfx.getImmediateContext()->Unmap(m_pBuffer.Get(), 0u);
+	m_pMapped = nullptr;
+}
+
+void ConstantBufferRing::endFrame() {
+	endUpdates();
+	if (m_noOverwrite) {
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext{ m_gfx.getImmediateContext() };
+		const size_t slot{ m_frame % FRAMES_IN_FLIGHT };
+		if (m_queryFrames[slot] != 0u) { // too many frames in flight: wait for the oldest one to finish
+			while (pContext->GetData(m_frameQueries[slot].Get(), nullptr, 0u, 0u) == S_FALSE)
+				std::this_thread::yield();
+			m_allocator.retire(m_queryFrames[slot]);
+		}
+		pContext->End(m_frameQueries[slot].Get());
+		m_queryFrames[slot] = m_frame;
+		m_allocator.endFrame(m_frame);
+	} else { // the next frame discards, so everything can be reused right away
+		m_allocator.endFrame(m_frame);
+		m_allocator.retire(m_frame);
+	}
+	m_outgrownBuffers.clear(); // the runtime keeps them alive for any draws still in flight
+	m_frame++;
+}
+
+void ConstantBufferRing::bind(ShaderStage stage, UINT slot, const Allocation& allocation) const {
+	// through the state cache, so an unchanged slice (e.g. a static object's constants) is not rebound
+	m_gfx.getStateCache().setConstantBuffer1(stage, slot, allocation.pBuffer, allocation.firstConstant, allocation.numConstants);
+}
+
+size_t ConstantBufferRing::getCapacity() const noexcept {
+	return m_allocator.getCapacity();
+}
+
+size_t ConstantBufferRing::getMapCount() const noexcept {
+	return m_mapCount;
+}
+
+size_t ConstantBufferRing::getAllocationCount() const noexcept {
+	return m_allocationCount;
+}
+
+bool ConstantBufferRing::isMapped() const noexcept {
+	return m_pMapped != nullptr;
+}
+
+void ConstantBufferRing::createBuffer(size_t capacity) {
+	D3D11_BUFFER_DESC desc{};
+	desc.ByteWidth = static_cast<UINT>(capacity);
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = 0u;
+	desc.StructureByteStride = 0u;
+
+	THROW_IF_FAILED(m_gfx, m_gfx.getDevice()->CreateBuffer(&desc, nullptr, &m_pBuffer));
+	m_allocator.reset(capacity);
+	m_fresh = true;
+}
+
+void ConstantBufferRing::map() {
+	// NO_OVERWRITE promises not to touch memory the GPU may still read; the allocator's fences make that true
+	const D3D11_MAP mapType{ (m_noOverwrite && !m_fresh) ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD };
+	D3D11_MAPPED_SUBRESOURCE mapped{};
+	THROW_IF_FAILED(m_gfx, m_gfx.getImmediateContext()->Map(m_pBuffer.Get(), 0u, mapType, 0u, &mapped));
+	m_pMapped = static_cast<std::byte*>(mapped.pData);
+	m_fresh = false;
+	m_mapCount++;
+}
+
+void ConstantBufferRing::retireCompletedFrames(bool wait) {
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext{ m_gfx.getImmediateContext() };
+	uint64_t completed{ 0u };
+	for (size_t i{ 0u }; i < FRAMES_IN_FLIGHT; i++) {
+		if (m_queryFrames[i] == 0u) continue;
+		HRESULT hr{};
+		if (wait) {
+			while ((hr = pContext->GetData(m_frameQueries[i].Get(), nullptr, 0u, 0u)) == S_FALSE)
+				std::this_thread::yield();
+		} else {
+			hr = pContext->GetData(m_frameQueries[i].Get(), nullptr, 0u, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		}
+		if (hr == S_OK) {
+			completed = std::max(completed, m_queryFrames[i]);
+			m_queryFrames[i] = 0u;
+		}
+	}
+	// the GPU finishes frames in order, so everything up to the newest completed frame is free
+	if (completed != 0u) m_allocator.retire(completed);
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef CWF_CONSTANTBUFFERRING_H
+#define CWF_CONSTANTBUFFERRING_H
+
+#include "Graphics.h"
+#include "RingAllocator.h"
+#include "ShaderStage.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <d3d11.h>
+#include <d3d11_1.h>
+#include <vector>
+#include <wrl.h>
+
+/*
+* One large dynamic constant buffer that everything's per-frame constants are suballocated from, so a frame costs
+* one Map instead of one Map per object. Slices are 256-byte aligned and bound by offset with *SetConstantBuffers1,
+* so this requires Direct3D 11.1.
+* Usage per frame:
+*	beginFrame()    - maps the ring
+*	allocate(...)   - copies constants in, as often as needed
+*	endUpdates()    - unmaps the ring; must come before any draw that reads the allocations
+*	bind(...)       - binds an allocation, e.g. from Material::draw(gfx, ring)
+*	endFrame()      - after the frame's draws; fences the frame's allocations
+* If the driver can map dynamic constant buffers with NO_OVERWRITE, the ring keeps frames in flight fenced by event
+* queries and only reuses memory the GPU is done with. Otherwise every frame maps with DISCARD and starts over.
+* When a frame does not fit, the ring grows (doubling) and keeps the outgrown buffer alive until endFrame.
+* The constructor throws if the device can't bind by offset; check isSupported first to fall back to per-buffer maps.
+*/
+
+class ConstantBufferRing {
+public:
+	struct Allocation {
+		ID3D11Buffer* pBuffer{}; // not owning; valid until endFrame
+		UINT firstConstant{}; // in 16-byte shader constants, as *SetConstantBuffers1 expects
+		UINT numConstants{};
+	};
+
+	static constexpr size_t DEFAULT_CAPACITY{ 1u << 20 }; // 1 MiB
+	static constexpr size_t FRAMES_IN_FLIGHT{ 3u };
+	static constexpr size_t CONSTANT_SIZE{ 16u }; // bytes in one shader constant
+private:
+	const Graphics& m_gfx;
+	RingAllocator m_allocator;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pBuffer;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> m_outgrownBuffers;
+	std::array<Microsoft::WRL::ComPtr<ID3D11Query>, FRAMES_IN_FLIGHT> m_frameQueries;
+	std::array<uint64_t, FRAMES_IN_FLIGHT> m_queryFrames; // which frame each query fences, 0 if none
+	std::byte* m_pMapped;
+	bool m_noOverwrite;
+	bool m_fresh; // the buffer has never been mapped, so the first map must discard
+	uint64_t m_frame; // starts at 1 so that 0 can mean "no frame"
+	size_t m_mapCount;
+	size_t m_allocationCount;
+public:
+	ConstantBufferRing(const Graphics& gfx, size_t capacity = DEFAULT_CAPACITY);
+	~ConstantBufferRing() = default;
+	// no copy init/assign
+	ConstantBufferRing(const ConstantBufferRing& o) = delete;
+	ConstantBufferRing& operator=(const ConstantBufferRing& o) = delete;
+
+	static bool isSupported(const Graphics& gfx) noexcept; // Direct3D 11.1 and constant buffer offsetting
+
+	void beginFrame();
+	Allocation allocate(const void* pData, size_t byteWidth);
+	void endUpdates();
+	void endFrame();
+	void bind(ShaderStage stage, UINT slot, const Allocation& allocation) const;
+
+	size_t getCapacity() const noexcept;
+	size_t getMapCount() const noexcept; // for the current frame
+	size_t getAllocationCount() const noexcept; // for the current frame
+	bool isMapped() const noexcept;
+private:
+	void createBuffer(size_t capacity);
+	void map();
+	void retireCompletedFrames(bool wait);
+};
+
+#endif
\ No newline at end of file
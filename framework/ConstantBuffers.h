@@ -49,33 +49,14 @@ namespace ConstantBuffers {
 		const Graphics& m_gfx;
 
 		VPTConstBuffer(const Graphics& gfx, math::CXMMATRIX t) : m_gfx{ gfx }, m_transform{} {
-			math::XMStoreFloat4x4(&m_transform,
-				math::XMMatrixTranspose(
-					math::XMMatrixMultiply(
-						math::XMMatrixMultiply(
-							m_gfx.camera().get(),
-							m_gfx.getProjection()
-						),
-						t
-					)
-				)
-			);
+			*this = t;
 		}
 
 		VPTConstBuffer(const Graphics& gfx) : m_gfx{ gfx }, m_transform{} {}
 
 		VPTConstBuffer& XM_CALLCONV operator=(math::FXMMATRIX t) {
-			math::XMStoreFloat4x4(&m_transform,
-				math::XMMatrixTranspose(
-					math::XMMatrixMultiply(
-						math::XMMatrixMultiply(
-							m_gfx.camera().get(),
-							m_gfx.getProjection()
-						),
-						t
-					)
-				)
-			);
+			// the view projection is cached by Graphics, so this is one multiply (transposing as it stores)
+			math::XMStoreFloat4x4(&m_transform, math::XMMatrixMultiplyTranspose(m_gfx.getViewProjection(), t));
 			return *this;
 		}
 
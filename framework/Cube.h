@@ -2,11 +2,14 @@
 #define CWF_CUBE_H
 
 #include "Graphics.h"
+#include "InputLayout.h"
 #include "Material.h"
 #include "ShapeConcepts.h"
 #include <d3d11.h>
 #include <DirectXMath.h>
 #include <memory>
+#include <optional>
+#include <span>
 
 namespace math = DirectX;
 
@@ -16,8 +19,18 @@ public:
 	using Idx = uint16_t;
 private:
 	static Material<Vtx, Idx> s_cube;
-	static constexpr D3D11_INPUT_ELEMENT_DESC s_layout[]{
-		{"Position", 0u, DXGI_FORMAT_R32G32B32_FLOAT, 0u, 0u, D3D11_INPUT_PER_VERTEX_DATA, 0u}
+	static constexpr const auto& s_layout{ InputLayout::d3d<Vtx> }; // derived from Vtx::Layout
+	// same corners and triangles as mesh(), with the positions split by component for BatchTransform
+	static constexpr float s_cornerX[]{ -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f };
+	static constexpr float s_cornerY[]{ 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f };
+	static constexpr float s_cornerZ[]{ -0.5f, -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f };
+	static constexpr Idx s_indices[]{
+		1,0,3,  2,1,3,
+		5,4,0,  1,5,0,
+		2,3,7,  6,2,7,
+		6,7,4,  5,6,4,
+		0,4,7,  3,0,7,
+		5,1,2,  6,5,2
 	};
 public:
 	static Graphics::IndexedVertexList<Vtx, Idx> mesh() {
@@ -42,44 +55,17 @@ public:
 		return list;
 	}
 
-	static void XM_CALLCONV addMesh(math::FXMMATRIX t) {
-		math::XMFLOAT4 vtx[]{
-			{ -0.5f, 0.5f, -0.5f, 1.0f },
-			{ -0.5f, -0.5f, -0.5f, 1.0f },
-			{ 0.5f, -0.5f, -0.5f, 1.0f },
-			{ 0.5f, 0.5f, -0.5f, 1.0f },
-			{ -0.5f, 0.5f, 0.5f, 1.0f },
-			{ -0.5f, -0.5f, 0.5f, 1.0f },
-			{ 0.5f, -0.5f, 0.5f, 1.0f },
-			{ 0.5f, 0.5f, 0.5f, 1.0f }
-		};
-
-		constexpr size_t vtxSize{ std::size(vtx) };
-
-		math::XMFLOAT4 dst[vtxSize]{};
-		std::vector<Vtx> finalVtx{};
-
-		math::XMVector4TransformStream(
-			dst,
-			sizeof(math::XMFLOAT4),
-			vtx,
-			sizeof(math::XMFLOAT4),
-			vtxSize,
-			t
-		);
-
-		for (auto& v : dst)
-			finalVtx.emplace_back(v.x, v.y, v.z);
+	// bakes one cube per transform straight into the material (see Material::addTransformedMeshes), packing as many
+	// cubes into each mesh as 16-bit indices allow; returns the id of the first mesh added (std::nullopt if none were)
+	static std::optional<size_t> addMeshes(std::span<const math::XMFLOAT4X4> transforms) {
+		return s_cube.addTransformedMeshes({ s_cornerX, s_cornerY, s_cornerZ, std::size(s_cornerX) }, s_indices, transforms,
+			[](float x, float y, float z, size_t) { return Vtx(x, y, z); });
+	}
 
-		std::vector<Idx> indices {
-			1,0,3,  2,1,3,
-			5,4,0,  1,5,0,
-			2,3,7,  6,2,7,
-			6,7,4,  5,6,4,
-			0,4,7,  3,0,7,
-			5,1,2,  6,5,2
-		};
-		s_cube.addMesh(finalVtx, indices);
+	static void XM_CALLCONV addMesh(math::FXMMATRIX t) {
+		math::XMFLOAT4X4 transform{};
+		math::XMStoreFloat4x4(&transform, t);
+		addMeshes({ &transform, 1u });
 	}
 
 	static void addMesh() {
@@ -91,7 +77,7 @@ public:
 	}
 
 	static const D3D11_INPUT_ELEMENT_DESC* defaultLayout() noexcept {
-		return s_layout;
+		return s_layout.data();
 	}
 
 	static constexpr size_t defaultLayoutSize() noexcept {
@@ -106,7 +92,7 @@ public:
 template <Vertex Vtx>
 Material<Vtx, uint16_t> Cube<Vtx>::s_cube {
 	[] {
-		Material<Vtx, uint16_t> m{ DXGI_FORMAT_R16_UINT };
+		Material<Vtx, uint16_t> m{};
 		m.setTopology(topology());
 		m.setInputLayout(defaultLayout(), defaultLayoutSize());
 
@@ -2,12 +2,15 @@
 #define CWF_CUBESKINNED_H
 
 #include "Graphics.h"
+#include "InputLayout.h"
 #include "Material.h"
 #include "ShapeConcepts.h"
 #include "WStringLiteral.h"
 #include <d3d11.h>
 #include <DirectXMath.h>
 #include <memory>
+#include <optional>
+#include <span>
 
 namespace math = DirectX;
 
@@ -17,9 +20,21 @@ public:
 	using Idx = uint16_t;
 private:
 	static Material<Vtx, Idx> s_cube;
-	static constexpr D3D11_INPUT_ELEMENT_DESC s_layout[]{
-		{"Position", 0u, DXGI_FORMAT_R32G32B32_FLOAT, 0u, 0u, D3D11_INPUT_PER_VERTEX_DATA, 0u},
-		{"TextureCoord", 0u, DXGI_FORMAT_R32G32_FLOAT, 0u, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0u}
+	static constexpr const auto& s_layout{ InputLayout::d3d<Vtx> }; // derived from Vtx::Layout
+	// same vertices and triangles as mesh(), with the positions split by component for BatchTransform
+	static constexpr float s_cornerX[]{ -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f };
+	static constexpr float s_cornerY[]{ 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, 0.5f, -0.5f };
+	static constexpr float s_cornerZ[]{ -0.5f, -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f };
+	static constexpr float s_cornerU[]{ 1.0f / 3.0f, 1.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f, 2.0f / 3.0f,
+		2.0f / 3.0f, 1.0f / 3.0f, 2.0f / 3.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+	static constexpr float s_cornerV[]{ 0.25f, 0.5f, 0.5f, 0.25f, 1.0f, 0.75f, 0.75f, 1.0f, 0.0f, 0.0f, 0.25f, 0.5f, 0.25f, 0.5f };
+	static constexpr Idx s_indices[]{
+		0,3,1,    1,3,2,   // front face
+		7,4,6,    6,4,5,   // back face
+		10,0,11,  11,0,1,  // left face
+		3,12,2,   2,12,13, // right face
+		8,9,0,    0,9,3,   // top face
+		1,2,5,    5,2,6    // bottom face
 	};
 public:
 	static Graphics::IndexedVertexList<Vtx, Idx> mesh() {
@@ -74,66 +89,20 @@ public:
 		return list;
 	}
 
-	static void XM_CALLCONV addMesh(math::FXMMATRIX t) {
-		math::XMFLOAT4 vtx[] {
-			{ -0.5f, 0.5f, -0.5f },
-			{ -0.5f, -0.5f, -0.5f },
-			{ 0.5f, -0.5f, -0.5f },
-			{ 0.5f, 0.5f, -0.5f },
-			{ -0.5f, 0.5f, 0.5f },
-			{ -0.5f, -0.5f, 0.5f },
-			{ 0.5f, -0.5f, 0.5f },
-			{ 0.5f, 0.5f, 0.5f },
-			{ -0.5f, 0.5f, 0.5f },
-			{ 0.5f, 0.5f, 0.5f },
-			{ -0.5f, 0.5f, 0.5f },
-			{ -0.5f, -0.5f, 0.5f },
-			{ 0.5f, 0.5f, 0.5f },
-			{ 0.5f, -0.5f, 0.5f },
-		};
-
-		constexpr size_t vtxSize{ std::size(vtx) };
-
-		math::XMFLOAT4 dst[vtxSize]{};
-		std::vector<Vtx> finalVtx{};
-
-		math::XMVector4TransformStream(
-			dst,
-			sizeof(math::XMFLOAT4),
-			vtx,
-			sizeof(math::XMFLOAT4),
-			vtxSize,
-			t
-		);
-
-		for (auto& v : dst)
-			finalVtx.emplace_back(v.x, v.y, v.z);
+	// see Cube::addMeshes
+	static std::optional<size_t> addMeshes(std::span<const math::XMFLOAT4X4> transforms) {
+		return s_cube.addTransformedMeshes({ s_cornerX, s_cornerY, s_cornerZ, std::size(s_cornerX) }, s_indices, transforms,
+			[](float x, float y, float z, size_t i) {
+				Vtx v(x, y, z);
+				v.tex.set(s_cornerU[i], s_cornerV[i]);
+				return v;
+			});
+	}
 
-		constexpr float third = (1.0f / 3.0f);
-		finalVtx[0].tex.set(third, 0.25f);
-		finalVtx[1].tex.set(third, 0.5f);
-		finalVtx[2].tex.set(2 * third, 0.5f);
-		finalVtx[3].tex.set(2 * third, 0.25f);
-		finalVtx[4].tex.set(third, 1.0f);
-		finalVtx[5].tex.set(third, 0.75f);
-		finalVtx[6].tex.set(2 * third, 0.75f);
-		finalVtx[7].tex.set(2 * third, 1.0f);
-		finalVtx[8].tex.set(third, 0.0f);
-		finalVtx[9].tex.set(2 * third, 0.0f);
-		finalVtx[10].tex.set(0.0f, 0.25f);
-		finalVtx[11].tex.set(0.0f, 0.5f);
-		finalVtx[12].tex.set(1.0f, 0.25f);
-		finalVtx[13].tex.set(1.0f, 0.5f);
-
-		std::vector<Idx> indices = {
-			0,3,1,    1,3,2,   // front face
-			7,4,6,    6,4,5,   // back face
-			10,0,11,  11,0,1,  // left face
-			3,12,2,   2,12,13, // right face
-			8,9,0,    0,9,3,   // top face
-			1,2,5,    5,2,6    // bottom face
-		};
-		s_cube.addMesh(finalVtx, indices);
+	static void XM_CALLCONV addMesh(math::FXMMATRIX t) {
+		math::XMFLOAT4X4 transform{};
+		math::XMStoreFloat4x4(&transform, t);
+		addMeshes({ &transform, 1u });
 	}
 
 	static void addMesh() {
@@ -145,7 +114,7 @@ public:
 	}
 
 	static const D3D11_INPUT_ELEMENT_DESC* defaultLayout() noexcept {
-		return s_layout;
+		return s_layout.data();
 	}
 
 	static constexpr size_t defaultLayoutSize() noexcept {
@@ -160,7 +129,7 @@ public:
 template <WStringLiteral file, VertexAndTexture Vtx>
 Material<Vtx, uint16_t> CubeSkinned<file, Vtx>::s_cube {
 	[] {
-		Material<Vtx, uint16_t> m{ DXGI_FORMAT_R16_UINT };
+		Material<Vtx, uint16_t> m{};
 		m.setTopology(topology());
 		m.setInputLayout(defaultLayout(), defaultLayoutSize());
 		m.setTexture2D(Graphics::Texture2D{ file.value });
@@ -0,0 +1,219 @@
+#include "BatchTransform.h"
+#include "Culling.h"
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CWF_CULLING_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define CWF_TARGET_AVX2 // MSVC lets any function use AVX2 intrinsics
+#else
+#define CWF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace {
+	// distance of the point from the plane, scaled by the normal's length
+	inline float distance(const Culling::Plane& p, float x, float y, float z) noexcept {
+		return p.x * x + p.y * y + p.z * z + p.w;
+	}
+
+	// writes the visibility of bounds [first, count) one at a time; inside(i, plane) says whether bound i is not
+	// entirely outside plane
+	template <typename Inside>
+	size_t cullTail(const Culling::Frustum& frustum, size_t first, size_t count, uint8_t* pVisible, Inside inside) noexcept {
+		size_t visible{ 0u };
+		for (size_t i{ first }; i < count; i++) {
+			bool in{ true };
+			for (const Culling::Plane& plane : frustum.planes)
+				in = in && inside(i, plane);
+			pVisible[i] = in ? 1u : 0u;
+			visible += in ? 1u : 0u;
+		}
+		return visible;
+	}
+
+	size_t spheresTail(const Culling::Frustum& frustum, const Culling::Spheres& s, size_t first, uint8_t* pVisible) noexcept {
+		return cullTail(frustum, first, s.count, pVisible, [&s](size_t i, const Culling::Plane& p) {
+			return distance(p, s.x[i], s.y[i], s.z[i]) >= -s.radius[i];
+		});
+	}
+
+	size_t boxesTail(const Culling::Frustum& frustum, const Culling::Boxes& b, size_t first, uint8_t* pVisible) noexcept {
+		return cullTail(frustum, first, b.count, pVisible, [&b](size_t i, const Culling::Plane& p) {
+			const float reach{ std::abs(p.x) * b.extentX[i] + std::abs(p.y) * b.extentY[i] + std::abs(p.z) * b.extentZ[i] };
+			return distance(p, b.centerX[i], b.centerY[i], b.centerZ[i]) >= -reach;
+		});
+	}
+
+	// one byte per bit of outsideMask, inverted
+	inline size_t writeVisible(unsigned outsideMask, unsigned lanes, uint8_t* pVisible) noexcept {
+		for (unsigned k{ 0u }; k < lanes; k++)
+			pVisible[k] = static_cast<uint8_t>(~outsideMask >> k & 1u);
+		return lanes - static_cast<size_t>(std::popcount(outsideMask));
+	}
+
+#ifdef CWF_CULLING_X86
+	size_t cullSpheresSse2(const Culling::Frustum& frustum, const Culling::Spheres& s, uint8_t* pVisible) noexcept {
+		const size_t vectorCount{ s.count & ~size_t{ 3u } };
+		size_t visible{ 0u };
+		for (size_t i{ 0u }; i < vectorCount; i += 4u) {
+			const __m128 x{ _mm_loadu_ps(s.x + i) };
+			const __m128 y{ _mm_loadu_ps(s.y + i) };
+			const __m128 z{ _mm_loadu_ps(s.z + i) };
+			const __m128 negRadius{ _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(s.radius + i)) };
+			__m128 outside{ _mm_setzero_ps() };
+			for (const Culling::Plane& p : frustum.planes) {
+				__m128 d{ _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.x)), _mm_set1_ps(p.w)) };
+				d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(p.y)));
+				d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(p.z)));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negRadius));
+			}
+			visible += writeVisible(static_cast<unsigned>(_mm_movemask_ps(outside)), 4u, pVisible + i);
+		}
+		return visible + spheresTail(frustum, s, vectorCount, pVisible);
+	}
+
+	size_t cullBoxesSse2(const Culling::Frustum& frustum, const Culling::Boxes& b, uint8_t* pVisible) noexcept {
+		const size_t vectorCount{ b.count & ~size_t{ 3u } };
+		size_t visible{ 0u };
+		for (size_t i{ 0u }; i < vectorCount; i += 4u) {
+			const __m128 cx{ _mm_loadu_ps(b.centerX + i) };
+			const __m128 cy{ _mm_loadu_ps(b.centerY + i) };
+			const __m128 cz{ _mm_loadu_ps(b.centerZ + i) };
+			const __m128 ex{ _mm_loadu_ps(b.extentX + i) };
+			const __m128 ey{ _mm_loadu_ps(b.extentY + i) };
+			const __m128 ez{ _mm_loadu_ps(b.extentZ + i) };
+			__m128 outside{ _mm_setzero_ps() };
+			for (const Culling::Plane& p : frustum.planes) {
+				__m128 d{ _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(p.x)), _mm_set1_ps(p.w)) };
+				d = _mm_add_ps(d, _mm_mul_ps(cy, _mm_set1_ps(p.y)));
+				d = _mm_add_ps(d, _mm_mul_ps(cz, _mm_set1_ps(p.z)));
+				// how far the box reaches towards the plane's inside, negated
+				__m128 reach{ _mm_mul_ps(ex, _mm_set1_ps(-std::abs(p.x))) };
+				reach = _mm_sub_ps(reach, _mm_mul_ps(ey, _mm_set1_ps(std::abs(p.y))));
+				reach = _mm_sub_ps(reach, _mm_mul_ps(ez, _mm_set1_ps(std::abs(p.z))));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(d, reach));
+			}
+			visible += writeVisible(static_cast<unsigned>(_mm_movemask_ps(outside)), 4u, pVisible + i);
+		}
+		return visible + boxesTail(frustum, b, vectorCount, pVisible);
+	}
+
+	CWF_TARGET_AVX2 size_t cullSpheresAvx2(const Culling::Frustum& frustum, const Culling::Spheres& s, uint8_t* pVisible) noexcept {
+		const size_t vectorCount{ s.count & ~size_t{ 7u } };
+		size_t visible{ 0u };
+		for (size_t i{ 0u }; i < vectorCount; i += 8u) {
+			const __m256 x{ _mm256_loadu_ps(s.x + i) };
+			const __m256 y{ _mm256_loadu_ps(s.y + i) };
+			const __m256 z{ _mm256_loadu_ps(s.z + i) };
+			const __m256 negRadius{ _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(s.radius + i)) };
+			__m256 outside{ _mm256_setzero_ps() };
+			for (const Culling::Plane& p : frustum.planes) {
+				__m256 d{ _mm256_fmadd_ps(x, _mm256_set1_ps(p.x), _mm256_set1_ps(p.w)) };
+				d = _mm256_fmadd_ps(y, _mm256_set1_ps(p.y), d);
+				d = _mm256_fmadd_ps(z, _mm256_set1_ps(p.z), d);
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, negRadius, _CMP_LT_OQ));
+			}
+			visible += writeVisible(static_cast<unsigned>(_mm256_movemask_ps(outside)), 8u, pVisible + i);
+		}
+		_mm256_zeroupper(); // before the scalar tail
+		return visible + spheresTail(frustum, s, vectorCount, pVisible);
+	}
+
+	CWF_TARGET_AVX2 size_t cullBoxesAvx2(const Culling::Frustum& frustum, const Culling::Boxes& b, uint8_t* pVisible) noexcept {
+		const size_t vectorCount{ b.count & ~size_t{ 7u } };
+		size_t visible{ 0u };
+		for (size_t i{ 0u }; i < vectorCount; i += 8u) {
+			const __m256 cx{ _mm256_loadu_ps(b.centerX + i) };
+			const __m256 cy{ _mm256_loadu_ps(b.centerY + i) };
+			const __m256 cz{ _mm256_loadu_ps(b.centerZ + i) };
+			const __m256 ex{ _mm256_loadu_ps(b.extentX + i) };
+			const __m256 ey{ _mm256_loadu_ps(b.extentY + i) };
+			const __m256 ez{ _mm256_loadu_ps(b.extentZ + i) };
+			__m256 outside{ _mm256_setzero_ps() };
+			for (const Culling::Plane& p : frustum.planes) {
+				__m256 d{ _mm256_fmadd_ps(cx, _mm256_set1_ps(p.x), _mm256_set1_ps(p.w)) };
+				d = _mm256_fmadd_ps(cy, _mm256_set1_ps(p.y), d);
+				d = _mm256_fmadd_ps(cz, _mm256_set1_ps(p.z), d);
+				__m256 reach{ _mm256_mul_ps(ex, _mm256_set1_ps(-std::abs(p.x))) };
+				reach = _mm256_fnmadd_ps(ey, _mm256_set1_ps(std::abs(p.y)), reach);
+				reach = _mm256_fnmadd_ps(ez, _mm256_set1_ps(std::abs(p.z)), reach);
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, reach, _CMP_LT_OQ));
+			}
+			visible += writeVisible(static_cast<unsigned>(_mm256_movemask_ps(outside)), 8u, pVisible + i);
+		}
+		_mm256_zeroupper();
+		return visible + boxesTail(frustum, b, vectorCount, pVisible);
+	}
+#endif
+}
+
+Culling::Frustum Culling::frustum(const float* m) noexcept {
+	// clip = (x, y, z, 1) * m, so clip component c is the dot product with column c (Gribb & Hartmann)
+	auto column = [m](size_t c) {
+		return Plane{ m[c], m[4u + c], m[8u + c], m[12u + c] };
+	};
+	auto combine = [](const Plane& a, const Plane& b, float sign) {
+		return Plane{ a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z, a.w + sign * b.w };
+	};
+	const Plane x{ column(0u) };
+	const Plane y{ column(1u) };
+	const Plane z{ column(2u) };
+	const Plane w{ column(3u) };
+	Frustum f{ {
+		combine(w, x, 1.0f), // -w <= x
+		combine(w, x, -1.0f), // x <= w
+		combine(w, y, 1.0f),
+		combine(w, y, -1.0f),
+		z, // 0 <= z
+		combine(w, z, -1.0f) // z <= w
+	} };
+	for (Plane& p : f.planes) {
+		const float length{ std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z) };
+		if (length > 0.0f) {
+			p.x /= length;
+			p.y /= length;
+			p.z /= length;
+			p.w /= length;
+		}
+	}
+	return f;
+}
+
+size_t Culling::cullSpheres(const Frustum& frustum, const Spheres& spheres, uint8_t* pVisible) noexcept {
+	switch (BatchTransform::path()) {
+#ifdef CWF_CULLING_X86
+	case BatchTransform::Path::AVX2:
+		return cullSpheresAvx2(frustum, spheres, pVisible);
+	case BatchTransform::Path::SSE2:
+		return cullSpheresSse2(frustum, spheres, pVisible);
+#endif
+	default:
+		return cullSpheresScalar(frustum, spheres, pVisible);
+	}
+}
+
+size_t Culling::cullBoxes(const Frustum& frustum, const Boxes& boxes, uint8_t* pVisible) noexcept {
+	switch (BatchTransform::path()) {
+#ifdef CWF_CULLING_X86
+	case BatchTransform::Path::AVX2:
+		return cullBoxesAvx2(frustum, boxes, pVisible);
+	case BatchTransform::Path::SSE2:
+		return cullBoxesSse2(frustum, boxes, pVisible);
+#endif
+	default:
+		return cullBoxesScalar(frustum, boxes, pVisible);
+	}
+}
+
+size_t Culling::cullSpheresScalar(const Frustum& frustum, const Spheres& spheres, uint8_t* pVisible) noexcept {
+	return spheresTail(frustum, spheres, 0u, pVisible);
+}
+
+size_t Culling::cullBoxesScalar(const Frustum& frustum, const Boxes& boxes, uint8_t* pVisible) noexcept {
+	return boxesTail(frustum, boxes, 0u, pVisible);
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef CWF_CULLING_H
+#define CWF_CULLING_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+* CPU view-frustum culling of bounding spheres and axis-aligned boxes; knows nothing about DirectX.
+* frustum() extracts the six planes of the volume a matrix maps into Direct3D's clip space (x and y in [-w, w], z in
+* [0, w]); with a view projection they are in world space, with world * view * projection in the object's own space,
+* so bounds never have to be transformed. The matrix is 16 floats, row-major, applied to row vectors the way
+* DirectXMath does, so an XMFLOAT4X4 can be passed as is.
+* Bounds are structure-of-arrays, so the culling pass tests 8 (AVX2) or 4 (SSE2) bounds per iteration against each
+* plane; the path is picked at run time, the same one BatchTransform uses. A bound is visible unless it lies entirely
+* outside one plane, so it is conservative: near the frustum's corners, a few bounds that are outside stay visible.
+* The sphere test assumes the planes came from a matrix without non-uniform scale; the box test works for any.
+*/
+
+namespace Culling {
+	// points p with x * p.x + y * p.y + z * p.z + w >= 0 are on the inside; (x, y, z) is unit length
+	struct Plane {
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+
+	struct Frustum {
+		Plane planes[6]; // left, right, bottom, top, near, far
+	};
+
+	struct Spheres {
+		const float* x;
+		const float* y;
+		const float* z;
+		const float* radius;
+		size_t count;
+	};
+
+	struct Boxes {
+		const float* centerX;
+		const float* centerY;
+		const float* centerZ;
+		const float* extentX; // half the box's size
+		const float* extentY;
+		const float* extentZ;
+		size_t count;
+	};
+
+	Frustum frustum(const float* pMatrix) noexcept;
+
+	// pVisible[i] becomes 1 if bound i may be visible, 0 if it is certainly outside; returns how many may be visible
+	size_t cullSpheres(const Frustum& frustum, const Spheres& spheres, uint8_t* pVisible) noexcept;
+	size_t cullBoxes(const Frustum& frustum, const Boxes& boxes, uint8_t* pVisible) noexcept;
+	size_t cullSpheresScalar(const Frustum& frustum, const Spheres& spheres, uint8_t* pVisible) noexcept;
+	size_t cullBoxesScalar(const Frustum& frustum, const Boxes& boxes, uint8_t* pVisible) noexcept;
+}
+
+#endif
\ No newline at end of file
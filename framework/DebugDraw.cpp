@@ -0,0 +1,158 @@
+#define NOMINMAX
+
+#include "DebugDraw.h"
+#include "Graphics.h"
+#include "InputLayout.h"
+#include "PipelineCache.h"
+#include "shaders/DebugDrawPixelShader.h"
+#include "shaders/DebugDrawVertexShader.h"
+#include <algorithm>
+#include <cstring>
+#include <d3d11.h>
+#include <DirectXMath.h>
+
+namespace math = DirectX;
+
+DebugDraw::DebugDraw(const Graphics& gfx, float width, float height, size_t capacity)
+	: m_gfx{ gfx }, m_viewport{ 0.0f, 0.0f, width, height, 0.0f, 1.0f }, m_vertices{}, m_pVertexBuffer{},
+	m_pConstantBuffer{}, m_pVertexShader{}, m_pPixelShader{}, m_pLayout{}, m_capacity{ 0u }, m_head{ 0u },
+	m_fresh{ true }, m_lastFrameVertices{ 0u } {
+
+	PipelineCache& cache{ gfx.getPipelineCache() };
+	m_pVertexShader = cache.vertexShader(gfx, g_pDebugDrawVertexShader, sizeof(g_pDebugDrawVertexShader));
+	m_pPixelShader = cache.pixelShader(gfx, g_pDebugDrawPixelShader, sizeof(g_pDebugDrawPixelShader));
+	static constexpr const auto& s_layout{ InputLayout::d3d<Vertex> };
+	m_pLayout = cache.inputLayout(gfx, s_layout.data(), s_layout.size(),
+		g_pDebugDrawVertexShader, sizeof(g_pDebugDrawVertexShader));
+
+	D3D11_BUFFER_DESC cbDesc{};
+	cbDesc.ByteWidth = sizeof(math::XMFLOAT4X4);
+	cbDesc.Usage = D3D11_USAGE_DYNAMIC;
+	cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	cbDesc.MiscFlags = 0u;
+	cbDesc.StructureByteStride = 0u;
+	THROW_IF_FAILED(gfx, gfx.getDevice()->CreateBuffer(&cbDesc, nullptr, &m_pConstantBuffer));
+
+	createVertexBuffer(std::max<size_t>(capacity, 2u));
+	m_vertices.reserve(m_capacity);
+}
+
+void DebugDraw::line(const math::XMFLOAT3& from, const math::XMFLOAT3& to, uint32_t color) {
+	m_vertices.push_back({ { from.x, from.y, from.z }, color });
+	m_vertices.push_back({ { to.x, to.y, to.z }, color });
+}
+
+void DebugDraw::aabb(const math::XMFLOAT3& min, const math::XMFLOAT3& max, uint32_t color) {
+	math::XMVECTOR corners[8];
+	for (int i{ 0 }; i < 8; i++) {
+		corners[i] = math::XMVectorSet(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f);
+	}
+	box(corners, color);
+}
+
+void XM_CALLCONV DebugDraw::cube(math::FXMMATRIX transform, uint32_t color) {
+	math::XMVECTOR corners[8];
+	for (int i{ 0 }; i < 8; i++) {
+		corners[i] = math::XMVector3TransformCoord(
+			math::XMVectorSet(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f, 1.0f), transform);
+	}
+	box(corners, color);
+}
+
+void XM_CALLCONV DebugDraw::frustum(math::FXMMATRIX viewProjection, uint32_t color) {
+	const math::XMMATRIX inverse{ math::XMMatrixInverse(nullptr, viewProjection) };
+	math::XMVECTOR corners[8];
+	for (int i{ 0 }; i < 8; i++) { // Direct3D's clip space: x and y in [-1, 1], z in [0, 1]
+		corners[i] = math::XMVector3TransformCoord(
+			math::XMVectorSet(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : 0.0f, 1.0f), inverse);
+	}
+	box(corners, color);
+}
+
+void XM_CALLCONV DebugDraw::flush(math::FXMMATRIX viewProjection) {
+	m_lastFrameVertices = m_vertices.size();
+	if (m_vertices.empty()) return;
+
+	const size_t count{ m_vertices.size() };
+	if (count > m_capacity)
+		createVertexBuffer(std::max(count, 2u * m_capacity));
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext{ m_gfx.getImmediateContext() };
+
+	// append behind the vertices earlier frames may still be drawing from; start over when the end is reached
+	D3D11_MAP mapType{ D3D11_MAP_WRITE_NO_OVERWRITE };
+	if (m_fresh || m_head + count > m_capacity) {
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		m_head = 0u;
+		m_fresh = false;
+	}
+	D3D11_MAPPED_SUBRESOURCE mapped{};
+	THROW_IF_FAILED(m_gfx, pContext->Map(m_pVertexBuffer.Get(), 0u, mapType, 0u, &mapped));
+	std::memcpy(static_cast<Vertex*>(mapped.pData) + m_head, m_vertices.data(), count * sizeof(Vertex));
+	pContext->Unmap(m_pVertexBuffer.Get(), 0u);
+
+	THROW_IF_FAILED(m_gfx, pContext->Map(m_pConstantBuffer.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mapped));
+	math::XMStoreFloat4x4(static_cast<math::XMFLOAT4X4*>(mapped.pData), math::XMMatrixTranspose(viewProjection));
+	pContext->Unmap(m_pConstantBuffer.Get(), 0u);
+
+	const UINT stride{ sizeof(Vertex) };
+	const UINT offset{ 0u };
+	ID3D11RenderTargetView* pTarget{ m_gfx.getRenderTargetView().Get() };
+	pContext->OMSetRenderTargets(1u, &pTarget, m_gfx.getZBuffer().Get());
+	pContext->RSSetViewports(1u, &m_viewport);
+	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+	pContext->IASetInputLayout(m_pLayout.Get());
+	pContext->IASetVertexBuffers(0u, 1u, m_pVertexBuffer.GetAddressOf(), &stride, &offset);
+	pContext->VSSetShader(m_pVertexShader.Get(), nullptr, 0u);
+	pContext->VSSetConstantBuffers(0u, 1u, m_pConstantBuffer.GetAddressOf());
+	pContext->PSSetShader(m_pPixelShader.Get(), nullptr, 0u);
+
+	THROW_ON_INFO(m_gfx, pContext->Draw(static_cast<UINT>(count), static_cast<UINT>(m_head)));
+	m_head += count;
+	m_vertices.clear(); // keeps the capacity, so steady-state frames don't allocate
+}
+
+void DebugDraw::clear() noexcept {
+	m_vertices.clear();
+}
+
+size_t DebugDraw::getVertexCount() const noexcept {
+	return m_vertices.size();
+}
+
+size_t DebugDraw::getLastFrameVertexCount() const noexcept {
+	return m_lastFrameVertices;
+}
+
+size_t DebugDraw::getCapacity() const noexcept {
+	return m_capacity;
+}
+
+void DebugDraw::box(const math::XMVECTOR (&corners)[8], uint32_t color) {
+	for (int i{ 0 }; i < 8; i++) {
+		for (int axis{ 1 }; axis < 8; axis <<= 1) {
+			if (i & axis) continue; // each edge once, from its lower corner
+			math::XMFLOAT3 from{};
+			math::XMFLOAT3 to{};
+			math::XMStoreFloat3(&from, corners[i]);
+			math::XMStoreFloat3(&to, corners[i | axis]);
+			line(from, to, color);
+		}
+	}
+}
+
+void DebugDraw::createVertexBuffer(size_t capacity) {
+	capacity &= ~static_cast<size_t>(1u); // whole lines only
+	D3D11_BUFFER_DESC vbDesc{};
+	vbDesc.ByteWidth = static_cast<UINT>(capacity * sizeof(Vertex));
+	vbDesc.Usage = D3D11_USAGE_DYNAMIC;
+	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	vbDesc.MiscFlags = 0u;
+	vbDesc.StructureByteStride = sizeof(Vertex);
+	THROW_IF_FAILED(m_gfx, m_gfx.getDevice()->CreateBuffer(&vbDesc, nullptr, &m_pVertexBuffer));
+	m_capacity = capacity;
+	m_head = 0u;
+	m_fresh = true;
+}
\ No newline at end of file
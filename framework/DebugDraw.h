@@ -0,0 +1,95 @@
+#ifndef CWF_DEBUGDRAW_H
+#define CWF_DEBUGDRAW_H
+
+#include "InputLayout.h"
+#include <cstddef>
+#include <cstdint>
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <vector>
+#include <wrl.h>
+
+class Graphics;
+
+namespace math = DirectX;
+
+/*
+* Immediate-mode debug drawing: call line/aabb/cube/frustum any time during a frame and everything is drawn, as
+* colored lines in world space, by a single draw in Graphics::endFrame (after whatever the frame drew itself).
+* Shaders, input layout, constant buffer and vertex buffer are created once, when Graphics::debugDraw() is first called.
+* The frame's lines are collected in a CPU array that keeps its capacity, then appended to a dynamic vertex buffer used
+* as a ring: each flush maps with NO_OVERWRITE behind the previous frames' vertices and only DISCARDs when it reaches
+* the end, so the GPU is never waited on. A frame with more vertices than the buffer holds grows it (doubling).
+* Lines are depth tested against whatever the frame left in the depth buffer.
+*/
+
+class DebugDraw {
+public:
+	struct Vertex {
+		struct {
+			float x;
+			float y;
+			float z;
+		} pos;
+		uint32_t color;
+
+		using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>,
+			InputLayout::Element<"Color", decltype(color)>>;
+	};
+
+	static constexpr size_t DEFAULT_CAPACITY{ 1u << 16 }; // vertices
+	static constexpr uint32_t WHITE{ 0xffffffffu };
+	static constexpr uint32_t RED{ 0xff0000ffu };
+	static constexpr uint32_t GREEN{ 0xff00ff00u };
+	static constexpr uint32_t BLUE{ 0xffff0000u };
+	static constexpr uint32_t YELLOW{ 0xff00ffffu };
+private:
+	const Graphics& m_gfx;
+	D3D11_VIEWPORT m_viewport;
+	std::vector<Vertex> m_vertices; // this frame's, not yet flushed
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pVertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pConstantBuffer;
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> m_pVertexShader;
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> m_pPixelShader;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_pLayout;
+	size_t m_capacity; // in vertices
+	size_t m_head; // next free vertex in the ring
+	bool m_fresh; // the vertex buffer has never been mapped, so the first map must discard
+	size_t m_lastFrameVertices;
+public:
+	DebugDraw(const Graphics& gfx, float width, float height, size_t capacity = DEFAULT_CAPACITY);
+	~DebugDraw() = default;
+	// no copy init/assign
+	DebugDraw(const DebugDraw& o) = delete;
+	DebugDraw& operator=(const DebugDraw& o) = delete;
+
+	// packs a color the way the shader reads it (red in the low byte)
+	static constexpr uint32_t rgba(float r, float g, float b, float a = 1.0f) noexcept {
+		return toByte(r) | toByte(g) << 8 | toByte(b) << 16 | toByte(a) << 24;
+	}
+
+	void line(const math::XMFLOAT3& from, const math::XMFLOAT3& to, uint32_t color = WHITE);
+	void aabb(const math::XMFLOAT3& min, const math::XMFLOAT3& max, uint32_t color = WHITE);
+	// the edges of the unit cube around the origin (side 1, like Cube's), transformed
+	void XM_CALLCONV cube(math::FXMMATRIX transform, uint32_t color = WHITE);
+	// the edges of the volume viewProjection maps into clip space, e.g. another camera's view * projection
+	void XM_CALLCONV frustum(math::FXMMATRIX viewProjection, uint32_t color = WHITE);
+
+	// draws and forgets everything added since the last flush; called by Graphics::endFrame
+	void XM_CALLCONV flush(math::FXMMATRIX viewProjection);
+	void clear() noexcept; // forgets everything added since the last flush without drawing it
+
+	size_t getVertexCount() const noexcept; // waiting for the next flush
+	size_t getLastFrameVertexCount() const noexcept;
+	size_t getCapacity() const noexcept;
+private:
+	static constexpr uint32_t toByte(float channel) noexcept {
+		return static_cast<uint32_t>((channel < 0.0f ? 0.0f : channel > 1.0f ? 1.0f : channel) * 255.0f + 0.5f);
+	}
+
+	// corner i has x from bit 0, y from bit 1 and z from bit 2
+	void box(const math::XMVECTOR (&corners)[8], uint32_t color);
+	void createVertexBuffer(size_t capacity);
+};
+
+#endif
\ No newline at end of file
@@ -1,20 +1,38 @@
 #define NOMINMAX
 
 #include "Camera.h"
+#include "Culling.h"
 #include "CwfException.h"
+#include "DebugDraw.h"
 #include "Graphics.h"
+#include "PipelineCache.h"
+#include "StateCache.h"
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <d3d11.h>
-#include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include <memory>
 #include <Windows.h>
 
 namespace math = DirectX;
 
-Graphics::Graphics(HWND hWnd, int clientWidth, int clientHeight)
-	: m_clientWidth{ clientWidth }, m_clientHeight{ clientHeight },
-	m_projection{}, m_camera{} {
+namespace {
+	D3D_DRIVER_TYPE toDriverType(Graphics::Backend backend) noexcept {
+		switch (backend) {
+		case Graphics::Backend::WARP:
+			return D3D_DRIVER_TYPE_WARP;
+		case Graphics::Backend::HARDWARE:
+			[[fallthrough]];
+		default:
+			return D3D_DRIVER_TYPE_HARDWARE;
+		}
+	}
+}
+
+Graphics::Graphics(HWND hWnd, int clientWidth, int clientHeight, Backend backend)
+	: m_clientWidth{ clientWidth }, m_clientHeight{ clientHeight }, m_backend{ backend },
+	m_projection{}, m_projectionVersion{ 1u }, m_camera{}, m_viewProjection{} {
 
 	math::XMStoreFloat4x4(&m_projection, math::XMMatrixIdentity());
 	
@@ -43,7 +61,7 @@ Graphics::Graphics(HWND hWnd, int clientWidth, int clientHeight)
 	THROW_IF_FAILED(*this,
 		D3D11CreateDeviceAndSwapChain(
 			nullptr,
-			D3D_DRIVER_TYPE_HARDWARE,
+			toDriverType(m_backend),
 			nullptr,
 			deviceFlags,
 			nullptr,
@@ -57,18 +75,79 @@ Graphics::Graphics(HWND hWnd, int clientWidth, int clientHeight)
 		)
 	);
 
-	DXGI_SWAP_CHAIN_DESC tmp{};
-	m_pSwapChain->GetDesc(&tmp);
+	m_pContext.As(&m_pContext1); // optional, so failure is fine
+	if (m_pContext1) m_pStateCache = std::make_unique<StateCache>(m_pContext1.Get());
+	m_pPipelineCache = std::make_unique<PipelineCache>();
+
+	THROW_IF_FAILED(*this,
+		m_pSwapChain->GetBuffer(0u, __uuidof(ID3D11Texture2D), &m_pTargetTexture)
+	);
+
+	THROW_IF_FAILED(*this,
+		m_pDevice->CreateRenderTargetView(m_pTargetTexture.Get(), nullptr, &m_pTarget)
+	);
+
+	createDepthBuffer();
+}
+
+Graphics::Graphics(int width, int height, Backend backend)
+	: m_clientWidth{ width }, m_clientHeight{ height }, m_backend{ backend },
+	m_projection{}, m_projectionVersion{ 1u }, m_camera{}, m_viewProjection{} {
+
+	math::XMStoreFloat4x4(&m_projection, math::XMMatrixIdentity());
+
+	UINT deviceFlags = 0;
+#ifndef NDEBUG
+	deviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+
+	THROW_IF_FAILED(*this,
+		D3D11CreateDevice(
+			nullptr,
+			toDriverType(m_backend),
+			nullptr,
+			deviceFlags,
+			nullptr,
+			0,
+			D3D11_SDK_VERSION,
+			&m_pDevice,
+			nullptr,
+			&m_pContext
+		)
+	);
+
+	m_pContext.As(&m_pContext1); // optional, so failure is fine
+	if (m_pContext1) m_pStateCache = std::make_unique<StateCache>(m_pContext1.Get());
+	m_pPipelineCache = std::make_unique<PipelineCache>();
+
+	// offscreen color target, same format as the swap chain so frames compare 1:1 with windowed output
+	D3D11_TEXTURE2D_DESC targetDesc{};
+	targetDesc.Width = width;
+	targetDesc.Height = height;
+	targetDesc.MipLevels = 1u;
+	targetDesc.ArraySize = 1u;
+	targetDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+	targetDesc.SampleDesc.Count = 1u;
+	targetDesc.SampleDesc.Quality = 0u;
+	targetDesc.Usage = D3D11_USAGE_DEFAULT;
+	targetDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	targetDesc.CPUAccessFlags = 0u;
+	targetDesc.MiscFlags = 0u;
 
-	Microsoft::WRL::ComPtr<ID3D11Resource> pBuffer;
 	THROW_IF_FAILED(*this,
-		m_pSwapChain->GetBuffer(0u, __uuidof(ID3D11Resource), &pBuffer)
+		m_pDevice->CreateTexture2D(&targetDesc, nullptr, &m_pTargetTexture)
 	);
 
 	THROW_IF_FAILED(*this,
-		m_pDevice->CreateRenderTargetView(pBuffer.Get(), nullptr, &m_pTarget)
+		m_pDevice->CreateRenderTargetView(m_pTargetTexture.Get(), nullptr, &m_pTarget)
 	);
 
+	createDepthBuffer();
+}
+
+Graphics::~Graphics() = default;
+
+void Graphics::createDepthBuffer() {
 	// Z Buffer setup below
 	D3D11_DEPTH_STENCIL_DESC zBufferDesc{};
 	zBufferDesc.DepthEnable = TRUE;
@@ -84,8 +163,8 @@ Graphics::Graphics(HWND hWnd, int clientWidth, int clientHeight)
 	m_pContext->OMSetDepthStencilState(pState.Get(), 1u);
 
 	D3D11_TEXTURE2D_DESC zBufferTextureDesc{};
-	zBufferTextureDesc.Width = clientWidth;
-	zBufferTextureDesc.Height = clientHeight;
+	zBufferTextureDesc.Width = m_clientWidth;
+	zBufferTextureDesc.Height = m_clientHeight;
 	zBufferTextureDesc.MipLevels = 1u;
 	zBufferTextureDesc.ArraySize = 1u;
 	zBufferTextureDesc.Format = DXGI_FORMAT_D32_FLOAT;
@@ -96,9 +175,8 @@ Graphics::Graphics(HWND hWnd, int clientWidth, int clientHeight)
 	zBufferTextureDesc.CPUAccessFlags = 0;
 	zBufferTextureDesc.MiscFlags = 0;
 
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> pZBufferTexture;
 	THROW_IF_FAILED(*this,
-		m_pDevice->CreateTexture2D(&zBufferTextureDesc, nullptr, &pZBufferTexture)
+		m_pDevice->CreateTexture2D(&zBufferTextureDesc, nullptr, &m_pZBufferTexture)
 	);
 
 	D3D11_DEPTH_STENCIL_VIEW_DESC zBufferViewDesc;
@@ -108,13 +186,22 @@ Graphics::Graphics(HWND hWnd, int clientWidth, int clientHeight)
 	zBufferViewDesc.Texture2D.MipSlice = 0;
 
 	THROW_IF_FAILED(*this,
-		m_pDevice->CreateDepthStencilView(pZBufferTexture.Get(), &zBufferViewDesc, &m_pZBuffer)
+		m_pDevice->CreateDepthStencilView(m_pZBufferTexture.Get(), &zBufferViewDesc, &m_pZBuffer)
 	);
 
 	m_pContext->OMSetRenderTargets(1u, m_pTarget.GetAddressOf(), m_pZBuffer.Get());
 }
 
 void Graphics::endFrame() {
+	if (m_pDebugDraw) {
+		m_pDebugDraw->flush(getViewProjection());
+		if (m_pStateCache) m_pStateCache->invalidate(); // bound behind the cache's back
+	}
+	if (m_pStateCache) m_pStateCache->endFrame();
+	if (!m_pSwapChain) { // headless: nothing to present, just kick off the queued work
+		m_pContext->Flush();
+		return;
+	}
 	// TODO: frame rate management
 	// Present( SyncInterval, Flags)
 	THROW_IF_FAILED(*this,
@@ -128,155 +215,53 @@ void Graphics::clearBuffer(float r, float g, float b) {
 	m_pContext->ClearDepthStencilView(m_pZBuffer.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0u);
 }
 
-void Graphics::drawTestCube(bool isLeftPressed, bool isRightPressed, bool isUpPressed, bool isDownPressed) {
-	struct Vertex2D {
-		struct {
-			float x;
-			float y;
-			float z;
-		} pos;
-	};
-
-	const constexpr float half_S = 0.5f;
-	const Vertex2D vertices[]{
-		{-half_S, half_S, 0},     // 0
-		{-half_S, -half_S, 0},    // 1
-		{half_S, -half_S, 0},     // 2
-		{half_S, half_S, 0},      // 3
-		{-half_S, half_S, 1.0f},  // 4
-		{-half_S, -half_S, 1.0f}, // 5
-		{half_S, -half_S, 1.0f},  // 6
-		{half_S, half_S, 1.0f},   // 7
-	}; // NDC
-	
-	D3D11_BUFFER_DESC bDesc{};
-	bDesc.ByteWidth = sizeof(vertices);
-	bDesc.Usage = D3D11_USAGE_DEFAULT;
-	bDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bDesc.CPUAccessFlags = 0u;
-	bDesc.MiscFlags = 0u;
-	bDesc.StructureByteStride = sizeof(Vertex2D);
-
-	D3D11_SUBRESOURCE_DATA data{};
-	data.pSysMem = &vertices;
-
-	Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer;
-	THROW_IF_FAILED(*this, m_pDevice->CreateBuffer(&bDesc, &data, &pBuffer));
-
-	UINT stride{ sizeof(Vertex2D) };
-	UINT offset{ 0u };
-	m_pContext->IASetVertexBuffers(0u, 1u, pBuffer.GetAddressOf(), &stride, &offset);
-
-	const uint16_t indices[]{
-		1,0,3,  2,1,3, // front face
-		5,4,0,  1,5,0, // left face
-		2,3,7,  6,2,7, // right face
-		6,7,4,  5,6,4, // back face
-		0,4,7,  3,0,7, // top face
-		5,1,2,  6,5,2  // bottom face
-	};
-
-	D3D11_BUFFER_DESC ibDesc{};
-	ibDesc.ByteWidth = sizeof(indices);
-	ibDesc.Usage = D3D11_USAGE_DEFAULT;
-	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibDesc.CPUAccessFlags = 0u;
-	ibDesc.MiscFlags = 0u;
-	ibDesc.StructureByteStride = sizeof(uint16_t);
-
-	D3D11_SUBRESOURCE_DATA iData{};
-	iData.pSysMem = &indices;
-	
-	Microsoft::WRL::ComPtr<ID3D11Buffer> pIndexBuffer;
-	THROW_IF_FAILED(*this, m_pDevice->CreateBuffer(&ibDesc, &iData, &pIndexBuffer));
-
-	m_pContext->IASetIndexBuffer(pIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0u);
-
-	static float angleY{ 0.0f };
-	angleY += (isLeftPressed ? 0.1f : isRightPressed ? -0.1f : 0.0f);
-	static float angleX{ 0.0f };
-	angleX += (isUpPressed ? 0.1f : isDownPressed ? -0.1f : 0.0f);
-	struct CBufMatrixTransform {
-		math::XMMATRIX transform;
-	};
-	CBufMatrixTransform t{ math::XMMatrixTranspose(
-								math::XMMatrixRotationX(angleX)
-								* math::XMMatrixRotationY(angleY)
-								* math::XMMatrixTranslation(0.0f, 0.0f, 2.0f)
-								* math::XMMatrixPerspectiveLH(1.0f, 1.0f, 0.5f, 4.0f)) };
-	
-	D3D11_BUFFER_DESC cbDesc{};
-	cbDesc.ByteWidth = sizeof(t);
-	cbDesc.Usage = D3D11_USAGE_DYNAMIC;
-	cbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	cbDesc.MiscFlags = 0u;
-	cbDesc.StructureByteStride = 0u;
-	D3D11_SUBRESOURCE_DATA cbData{};
-	cbData.pSysMem = &t;
-
-	Microsoft::WRL::ComPtr<ID3D11Buffer> pCBuffer;
-	THROW_IF_FAILED(*this, m_pDevice->CreateBuffer(&cbDesc, &cbData, &pCBuffer));
-
-	m_pContext->VSSetConstantBuffers(0u, 1u, pCBuffer.GetAddressOf());
-
-	struct CBufColors {
-		float colors[6][4];
-	};
-	CBufColors cBuffer{
-		{
-			{1.0f, 0.0f, 0.0f, 1.0f},
-			{0.0f, 1.0f, 0.0f, 1.0f},
-			{0.0f, 0.0f, 1.0f, 1.0f},
-			{0.5f, 0.0f, 0.5f, 1.0f},
-			{0.0f, 0.5f, 0.5f, 1.0f},
-			{0.5f, 0.5f, 0.0, 1.0f}
-		}
-	};
-
-	cbDesc.ByteWidth = sizeof(cBuffer);
-	cbDesc.Usage = D3D11_USAGE_DYNAMIC;
-	cbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	cbDesc.MiscFlags = 0u;
-	cbDesc.StructureByteStride = 0u;
-	cbData.pSysMem = &cBuffer;
+void Graphics::executeCommandList(ID3D11CommandList* pCommandList) const {
+	m_pContext->ExecuteCommandList(pCommandList, FALSE);
+	if (m_pStateCache) m_pStateCache->invalidate(); // executing resets the immediate context's state
+}
 
-	THROW_IF_FAILED(*this, m_pDevice->CreateBuffer(&cbDesc, &cbData, &pCBuffer));
+template <typename Texel>
+Graphics::Readback<Texel> Graphics::readTexture(ID3D11Texture2D* pTexture) const {
+	D3D11_TEXTURE2D_DESC stagingDesc{};
+	pTexture->GetDesc(&stagingDesc);
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.BindFlags = 0u;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	stagingDesc.MiscFlags = 0u;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> pStaging;
+	THROW_IF_FAILED(*this, m_pDevice->CreateTexture2D(&stagingDesc, nullptr, &pStaging));
+	m_pContext->CopyResource(pStaging.Get(), pTexture);
+
+	// Map on a staging resource blocks until the GPU (or WARP) has finished the copy
+	D3D11_MAPPED_SUBRESOURCE mapped{};
+	THROW_IF_FAILED(*this, m_pContext->Map(pStaging.Get(), 0u, D3D11_MAP_READ, 0u, &mapped));
+
+	Readback<Texel> result{ stagingDesc.Width, stagingDesc.Height, {} };
+	result.texels.resize(static_cast<size_t>(stagingDesc.Width) * stagingDesc.Height);
+	const std::byte* pRow{ static_cast<const std::byte*>(mapped.pData) };
+	for (UINT y{ 0u }; y < stagingDesc.Height; y++) { // rows may be padded, so copy one at a time
+		std::memcpy(result.texels.data() + static_cast<size_t>(y) * stagingDesc.Width, pRow, stagingDesc.Width * sizeof(Texel));
+		pRow += mapped.RowPitch;
+	}
+	m_pContext->Unmap(pStaging.Get(), 0u);
+	return result;
+}
 
-	m_pContext->PSSetConstantBuffers(0u, 1u, pCBuffer.GetAddressOf());
+Graphics::Readback<uint32_t> Graphics::readRenderTarget() const {
+	return readTexture<uint32_t>(m_pTargetTexture.Get());
+}
 
-	m_pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+Graphics::Readback<float> Graphics::readZBuffer() const {
+	return readTexture<float>(m_pZBufferTexture.Get());
+}
 
-	Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
-	THROW_IF_FAILED(*this, D3DReadFileToBlob(L"TestTriangleVertexShader.cso", &pBlob));
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> pVertexShader;
-	THROW_IF_FAILED(*this, m_pDevice->CreateVertexShader(pBlob->GetBufferPointer(), pBlob->GetBufferSize(), nullptr, &pVertexShader));
-	m_pContext->VSSetShader(pVertexShader.Get(), nullptr, 0u);
+bool Graphics::isHeadless() const noexcept {
+	return !m_pSwapChain;
+}
 
-	const D3D11_INPUT_ELEMENT_DESC pDescs[] = {
-		{ "Position", 0u, DXGI_FORMAT_R32G32B32_FLOAT, 0u, 0u, D3D11_INPUT_PER_VERTEX_DATA, 0u },
-	};
-	Microsoft::WRL::ComPtr<ID3D11InputLayout> pInputLayout;
-	THROW_IF_FAILED(*this,
-		m_pDevice->CreateInputLayout(pDescs, std::size(pDescs), pBlob->GetBufferPointer(), pBlob->GetBufferSize(), &pInputLayout));
-	m_pContext->IASetInputLayout(pInputLayout.Get());
-
-	THROW_IF_FAILED(*this, D3DReadFileToBlob(L"TestTrianglePixelShader.cso", &pBlob));
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pPixelShader;
-	THROW_IF_FAILED(*this, m_pDevice->CreatePixelShader(pBlob->GetBufferPointer(), pBlob->GetBufferSize(), nullptr, &pPixelShader));
-	m_pContext->PSSetShader(pPixelShader.Get(), nullptr, 0u);
-
-	D3D11_VIEWPORT viewport{};
-	viewport.TopLeftX = 0.0f;
-	viewport.TopLeftY = 0.0f;
-	viewport.Width = m_clientWidth;
-	viewport.Height = m_clientHeight;
-	viewport.MinDepth = 0.0f;
-	viewport.MaxDepth = 1.0f;
-	m_pContext->RSSetViewports(1u, &viewport);
-
-	THROW_ON_INFO(*this, m_pContext->DrawIndexed(std::size(indices), 0u, 0));
+Graphics::Backend Graphics::getBackend() const noexcept {
+	return m_backend;
 }
 
 HRESULT Graphics::getDeviceRemovedReason() const noexcept {
@@ -292,6 +277,26 @@ Microsoft::WRL::ComPtr<ID3D11DeviceContext> Graphics::getImmediateContext() cons
 	return m_pContext;
 }
 
+Microsoft::WRL::ComPtr<ID3D11DeviceContext1> Graphics::getImmediateContext1() const noexcept {
+	return m_pContext1;
+}
+
+StateCache& Graphics::getStateCache() const {
+	if (!m_pStateCache)
+		throw CWF_EXCEPTION(CwfException::Type::FRAMEWORK, L"The state cache requires Direct3D 11.1.");
+	return *m_pStateCache;
+}
+
+PipelineCache& Graphics::getPipelineCache() const noexcept {
+	return *m_pPipelineCache;
+}
+
+DebugDraw& Graphics::debugDraw() {
+	if (!m_pDebugDraw)
+		m_pDebugDraw = std::make_unique<DebugDraw>(*this, static_cast<float>(m_clientWidth), static_cast<float>(m_clientHeight));
+	return *m_pDebugDraw;
+}
+
 Microsoft::WRL::ComPtr<ID3D11RenderTargetView> Graphics::getRenderTargetView() const noexcept {
 	return m_pTarget;
 }
@@ -303,12 +308,58 @@ Microsoft::WRL::ComPtr<ID3D11DepthStencilView> Graphics::getZBuffer() const noex
 void Graphics::setProjection(float fov_deg, float nearZ, float farZ) noexcept {
 	float aspectRatio = static_cast<float>(m_clientWidth) / static_cast<float>(m_clientHeight);
 	math::XMStoreFloat4x4(&m_projection, math::XMMatrixPerspectiveFovLH(math::XMConvertToRadians(fov_deg), aspectRatio, nearZ, farZ));
+	m_projectionVersion++;
 }
 
 math::XMMATRIX Graphics::getProjection() const noexcept {
 	return math::XMLoadFloat4x4(&m_projection);
 }
 
+math::XMMATRIX Graphics::getViewProjection() const noexcept {
+	return math::XMLoadFloat4x4(&viewProjection().matrix);
+}
+
+math::XMMATRIX Graphics::getViewProjectionTransposed() const noexcept {
+	return math::XMLoadFloat4x4(&viewProjection().transposed);
+}
+
+math::XMMATRIX Graphics::getInverseViewProjection() const noexcept {
+	const ViewProjection& vp{ viewProjection() };
+	if (!vp.inverseValid) {
+		math::XMStoreFloat4x4(&m_viewProjection.inverse, math::XMMatrixInverse(nullptr, math::XMLoadFloat4x4(&vp.matrix)));
+		m_viewProjection.inverseValid = true;
+	}
+	return math::XMLoadFloat4x4(&vp.inverse);
+}
+
+const Culling::Frustum& Graphics::getFrustum() const noexcept {
+	const ViewProjection& vp{ viewProjection() };
+	if (!vp.frustumValid) {
+		m_viewProjection.frustum = Culling::frustum(&vp.matrix._11);
+		m_viewProjection.frustumValid = true;
+	}
+	return vp.frustum;
+}
+
+uint64_t Graphics::getViewProjectionVersion() const noexcept {
+	return viewProjection().version;
+}
+
+const Graphics::ViewProjection& Graphics::viewProjection() const noexcept {
+	ViewProjection& vp{ m_viewProjection };
+	if (vp.version == 0u || vp.cameraVersion != m_camera.getVersion() || vp.projectionVersion != m_projectionVersion) {
+		const math::XMMATRIX matrix{ math::XMMatrixMultiply(m_camera.get(), getProjection()) };
+		math::XMStoreFloat4x4(&vp.matrix, matrix);
+		math::XMStoreFloat4x4(&vp.transposed, math::XMMatrixTranspose(matrix));
+		vp.cameraVersion = m_camera.getVersion();
+		vp.projectionVersion = m_projectionVersion;
+		vp.version++;
+		vp.inverseValid = false;
+		vp.frustumValid = false;
+	}
+	return vp;
+}
+
 const Camera& Graphics::camera() const noexcept {
 	return m_camera;
 }
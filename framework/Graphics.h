@@ -2,13 +2,18 @@
 #define CWF_GRAPHICS_H
 
 #include "Camera.h"
+#include "Culling.h"
 #include "CwfException.h"
+#include "PipelineCache.h"
+#include "StateCache.h"
 
 #ifndef NDEBUG
 #include "DXDebugInfoManager.h"
 #endif
 
 #include <d3d11.h>
+#include <d3d11_1.h>
+#include <cstdint>
 #include <DirectXMath.h>
 #include <memory>
 #include <utility>
@@ -38,17 +43,49 @@
 
 namespace math = DirectX;
 
+class DebugDraw;
+
 class Graphics {
+public:
+	/*
+	* Which driver backs the device. WARP is Direct3D's multithreaded software rasterizer, so a
+	* WARP device renders correctly (if slowly) on machines without a usable GPU.
+	*/
+	enum class Backend {
+		HARDWARE, WARP
+	};
 private:
+	// camera().get() * getProjection() and what's derived from it, recomputed when either changes
+	struct ViewProjection {
+		math::XMFLOAT4X4 matrix;
+		math::XMFLOAT4X4 transposed;
+		math::XMFLOAT4X4 inverse;
+		Culling::Frustum frustum;
+		uint64_t cameraVersion; // what it was computed from
+		uint64_t projectionVersion;
+		uint64_t version; // bumped on every recompute
+		bool inverseValid; // the inverse and frustum are only computed when asked for
+		bool frustumValid;
+	};
+
 	int m_clientWidth;
 	int m_clientHeight;
+	Backend m_backend;
 	math::XMFLOAT4X4 m_projection;
+	uint64_t m_projectionVersion; // bumped by setProjection
 	Camera m_camera;
-	Microsoft::WRL::ComPtr<IDXGISwapChain> m_pSwapChain;
+	mutable ViewProjection m_viewProjection;
+	Microsoft::WRL::ComPtr<IDXGISwapChain> m_pSwapChain; // empty when headless
 	Microsoft::WRL::ComPtr<ID3D11Device> m_pDevice;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_pContext;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> m_pContext1; // empty if the runtime predates Direct3D 11.1
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_pTargetTexture;
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> m_pTarget;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_pZBufferTexture;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> m_pZBuffer;
+	std::unique_ptr<StateCache> m_pStateCache; // empty without Direct3D 11.1
+	std::unique_ptr<PipelineCache> m_pPipelineCache;
+	std::unique_ptr<DebugDraw> m_pDebugDraw; // created on first use
 public:
 #ifndef NDEBUG
 	mutable DXDebugInfoManager info;
@@ -121,27 +158,61 @@ public:
 		Texture2D(const wchar_t* szFileName) : content{ File{ szFileName } } {}
 	};
 
+	// CPU-side copy of a render target or depth buffer, tightly packed (no row padding)
+	template <typename Texel>
+	struct Readback {
+		UINT width;
+		UINT height;
+		std::vector<Texel> texels;
+
+		const Texel& at(UINT x, UINT y) const {
+			return texels[static_cast<size_t>(y) * width + x];
+		}
+	};
+
 public:
-	Graphics(HWND hWnd, int clientWidth, int clientHeight);
-	~Graphics() = default;
+	Graphics(HWND hWnd, int clientWidth, int clientHeight, Backend backend = Backend::HARDWARE);
+	// headless: renders into an offscreen B8G8R8A8 target, no window or swap chain required
+	Graphics(int width, int height, Backend backend = Backend::WARP);
+	~Graphics(); // out of line, since DebugDraw is incomplete here
 	// no copy init/assign
 	Graphics(const Graphics& o) = delete;
 	Graphics& operator=(const Graphics& o) = delete;
 
 	void endFrame();
 	void clearBuffer(float r, float g, float b);
-	void drawTestCube(bool, bool, bool, bool);
+	void executeCommandList(ID3D11CommandList* pCommandList) const; // on the immediate context
 
+	Readback<uint32_t> readRenderTarget() const;
+	Readback<float> readZBuffer() const;
+
+	bool isHeadless() const noexcept;
+	Backend getBackend() const noexcept;
 	HRESULT getDeviceRemovedReason() const noexcept;
 	Microsoft::WRL::ComPtr<ID3D11Device> getDevice() const noexcept;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> getImmediateContext() const noexcept;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> getImmediateContext1() const noexcept;
+	StateCache& getStateCache() const; // binds on the immediate context; throws without Direct3D 11.1
+	PipelineCache& getPipelineCache() const noexcept; // shared shaders, input layouts and samplers
+	DebugDraw& debugDraw(); // lines drawn at the next endFrame
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> getRenderTargetView() const noexcept;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> getZBuffer() const noexcept;
 	
 	void setProjection(float fov_deg, float nearZ, float farZ) noexcept;
 	math::XMMATRIX getProjection() const noexcept;
+	// camera().get() * getProjection(), only multiplied again after the camera or projection changed
+	math::XMMATRIX getViewProjection() const noexcept;
+	math::XMMATRIX getViewProjectionTransposed() const noexcept; // as shaders expect it
+	math::XMMATRIX getInverseViewProjection() const noexcept; // clip space back to world space
+	uint64_t getViewProjectionVersion() const noexcept; // changes whenever getViewProjection() does
+	const Culling::Frustum& getFrustum() const noexcept; // the camera's, in world space
 	const Camera& camera() const noexcept;
 	Camera& camera() noexcept;
+private:
+	void createDepthBuffer();
+	const ViewProjection& viewProjection() const noexcept; // brought up to date first
+	template <typename Texel>
+	Readback<Texel> readTexture(ID3D11Texture2D* pTexture) const;
 };
 
 inline void throwIfFailed(const Graphics& gfx, HRESULT hr, const char* file, int line) {
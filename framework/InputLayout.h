@@ -0,0 +1,270 @@
+#ifndef CWF_INPUTLAYOUT_H
+#define CWF_INPUTLAYOUT_H
+
+#include "StringLiteral.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcmp
+#include <span>
+#include <type_traits>
+
+/*
+* Input layouts derived from the vertex structs themselves, so a layout can't drift from its struct.
+* A vertex type lists its members in declaration order as a Layout alias:
+*	using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>, ...>;
+* Each member's format comes from its component type and count (a struct of 3 floats is R32G32B32_FLOAT, of 2
+* Vertices::Unorm16s is R16G16_UNORM, etc.), offsets follow from the sizes and alignments, and of<Vtx>() checks that
+* the resulting stride is sizeof(Vtx), so a member missing from the Layout is a compile error.
+* Everything here is constexpr and free of D3D types (ElementDesc mirrors D3D11_INPUT_ELEMENT_DESC field for field and
+* Format uses DXGI_FORMAT's values), so it can be checked with static_asserts anywhere; d3d<Vtx> is the
+* D3D11_INPUT_ELEMENT_DESC array to hand to Material::setInputLayout.
+* hash() fingerprints an element array (either kind) and signature() finds a compiled shader's input signature, which
+* together key InputLayoutCache.
+*/
+
+namespace InputLayout {
+	// same values as DXGI_FORMAT (checked below on Windows)
+	enum class Format : unsigned {
+		UNKNOWN = 0u,
+		R32G32B32A32_FLOAT = 2u, R32G32B32A32_UINT = 3u, R32G32B32A32_SINT = 4u,
+		R32G32B32_FLOAT = 6u, R32G32B32_UINT = 7u, R32G32B32_SINT = 8u,
+		R16G16B16A16_FLOAT = 10u, R16G16B16A16_UNORM = 11u, R16G16B16A16_SNORM = 13u,
+		R32G32_FLOAT = 16u, R32G32_UINT = 17u, R32G32_SINT = 18u,
+		R16G16_FLOAT = 34u, R16G16_UNORM = 35u, R16G16_SNORM = 37u,
+		R32_FLOAT = 41u, R32_UINT = 42u, R32_SINT = 43u,
+		R16_FLOAT = 54u, R16_UNORM = 56u, R16_SNORM = 58u
+	};
+
+	// same values as D3D11_INPUT_CLASSIFICATION
+	enum class Classification : unsigned {
+		PER_VERTEX_DATA = 0u, PER_INSTANCE_DATA = 1u
+	};
+
+	// field for field D3D11_INPUT_ELEMENT_DESC, hence the names
+	struct ElementDesc {
+		const char* SemanticName;
+		unsigned SemanticIndex;
+		InputLayout::Format Format;
+		unsigned InputSlot;
+		unsigned AlignedByteOffset;
+		Classification InputSlotClass;
+		unsigned InstanceDataStepRate;
+	};
+
+	// formats for 1 to 4 components of a type; UNKNOWN where DXGI has none (e.g. three 16-bit components)
+	// specialized for the 16-bit component types in Vertices.h
+	template <class Component>
+	struct ComponentFormats {
+		static constexpr std::array<Format, 4u> formats{ Format::UNKNOWN, Format::UNKNOWN, Format::UNKNOWN, Format::UNKNOWN };
+	};
+
+	template <>
+	struct ComponentFormats<float> {
+		static constexpr std::array<Format, 4u> formats{ Format::R32_FLOAT, Format::R32G32_FLOAT, Format::R32G32B32_FLOAT, Format::R32G32B32A32_FLOAT };
+	};
+
+	template <>
+	struct ComponentFormats<uint32_t> {
+		static constexpr std::array<Format, 4u> formats{ Format::R32_UINT, Format::R32G32_UINT, Format::R32G32B32_UINT, Format::R32G32B32A32_UINT };
+	};
+
+	template <>
+	struct ComponentFormats<int32_t> {
+		static constexpr std::array<Format, 4u> formats{ Format::R32_SINT, Format::R32G32_SINT, Format::R32G32B32_SINT, Format::R32G32B32A32_SINT };
+	};
+
+	// a member is either one component, or a struct of them named x, y, z(, w) or u, v
+	template <class Member>
+	struct Components {
+		using Type = Member;
+	};
+
+	template <class Member> requires requires (Member m) { m.x; }
+	struct Components<Member> {
+		using Type = std::remove_cvref_t<decltype(std::declval<Member>().x)>;
+	};
+
+	template <class Member> requires requires (Member m) { m.u; }
+	struct Components<Member> {
+		using Type = std::remove_cvref_t<decltype(std::declval<Member>().u)>;
+	};
+
+	template <StringLiteral Semantic, class Member, unsigned SemanticIndex = 0u>
+	struct Element {
+		using Component = typename Components<Member>::Type;
+		static constexpr size_t COUNT{ sizeof(Member) / sizeof(Component) };
+		static_assert(sizeof(Member) % sizeof(Component) == 0u && COUNT >= 1u && COUNT <= 4u,
+			"An input element is 1 to 4 components of one type.");
+		static constexpr Format FORMAT{ ComponentFormats<Component>::formats[COUNT - 1u] };
+		static_assert(FORMAT != Format::UNKNOWN, "No DXGI format matches this member (see InputLayout::ComponentFormats).");
+
+		static constexpr size_t SIZE{ sizeof(Member) };
+		static constexpr size_t ALIGNMENT{ alignof(Member) };
+		static constexpr const char* SEMANTIC{ Semantic.value };
+		static constexpr unsigned SEMANTIC_INDEX{ SemanticIndex };
+	};
+
+	template <class... Members>
+	struct Elements {
+		static constexpr size_t COUNT{ sizeof...(Members) };
+
+		// offsets as the compiler lays the members out: each one at the next multiple of its alignment
+		static constexpr std::array<unsigned, COUNT> offsets() noexcept {
+			std::array<unsigned, COUNT> result{};
+			const size_t sizes[]{ Members::SIZE... };
+			const size_t alignments[]{ Members::ALIGNMENT... };
+			size_t end{ 0u };
+			for (size_t i{ 0u }; i < COUNT; i++) {
+				end = (end + alignments[i] - 1u) / alignments[i] * alignments[i];
+				result[i] = static_cast<unsigned>(end);
+				end += sizes[i];
+			}
+			return result;
+		}
+
+		static constexpr unsigned stride() noexcept {
+			size_t end{ 0u };
+			size_t alignment{ 1u };
+			const size_t sizes[]{ Members::SIZE... };
+			const size_t alignments[]{ Members::ALIGNMENT... };
+			for (size_t i{ 0u }; i < COUNT; i++) {
+				end = (end + alignments[i] - 1u) / alignments[i] * alignments[i] + sizes[i];
+				if (alignments[i] > alignment) alignment = alignments[i];
+			}
+			return static_cast<unsigned>((end + alignment - 1u) / alignment * alignment);
+		}
+
+		static constexpr std::array<ElementDesc, COUNT> descs() noexcept {
+			const std::array<unsigned, COUNT> o{ offsets() };
+			size_t i{ 0u };
+			return { ElementDesc{ Members::SEMANTIC, Members::SEMANTIC_INDEX, Members::FORMAT, 0u, o[i++],
+				Classification::PER_VERTEX_DATA, 0u }... };
+		}
+	};
+
+	// the derived elements of a vertex type
+	template <class Vtx>
+	constexpr std::array<ElementDesc, Vtx::Layout::COUNT> of() noexcept {
+		static_assert(Vtx::Layout::stride() == sizeof(Vtx), "The vertex's Layout doesn't cover all of its members.");
+		return Vtx::Layout::descs();
+	}
+
+	template <class Vtx>
+	constexpr unsigned stride() noexcept {
+		return Vtx::Layout::stride();
+	}
+
+	// FNV-1a
+	constexpr uint64_t FNV_OFFSET{ 14695981039346656037ull };
+	constexpr uint64_t FNV_PRIME{ 1099511628211ull };
+
+	constexpr uint64_t hashValue(uint64_t hash, uint64_t value) noexcept {
+		for (unsigned i{ 0u }; i < 8u; i++) {
+			hash ^= (value >> (i * 8u)) & 0xFFu;
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	// works on ElementDesc and D3D11_INPUT_ELEMENT_DESC alike, with equal results for equal layouts
+	template <class Desc>
+	constexpr uint64_t hash(std::span<const Desc> descs) noexcept {
+		uint64_t h{ FNV_OFFSET };
+		for (const Desc& d : descs) {
+			for (const char* p{ d.SemanticName }; p && *p; p++) {
+				h ^= static_cast<unsigned char>(*p);
+				h *= FNV_PRIME;
+			}
+			h = hashValue(h, d.SemanticIndex);
+			h = hashValue(h, static_cast<uint64_t>(d.Format));
+			h = hashValue(h, d.InputSlot);
+			h = hashValue(h, d.AlignedByteOffset);
+			h = hashValue(h, static_cast<uint64_t>(d.InputSlotClass));
+			h = hashValue(h, d.InstanceDataStepRate);
+		}
+		return h;
+	}
+
+	inline uint64_t hash(const void* pBytes, size_t length) noexcept {
+		uint64_t h{ FNV_OFFSET };
+		const unsigned char* p{ static_cast<const unsigned char*>(pBytes) };
+		for (size_t i{ 0u }; i < length; i++) {
+			h ^= p[i];
+			h *= FNV_PRIME;
+		}
+		return h;
+	}
+
+	// the input signature chunk (ISGN/ISG1) of compiled shader bytecode, which is all an input layout is validated
+	// against; the whole bytecode if it isn't a DXBC container or has no such chunk
+	inline std::span<const std::byte> signature(const void* pByteCode, size_t length) noexcept {
+		const std::byte* pBytes{ static_cast<const std::byte*>(pByteCode) };
+		const std::span<const std::byte> whole{ pBytes, length };
+		auto read32 = [pBytes](size_t offset) {
+			uint32_t value{};
+			std::memcpy(&value, pBytes + offset, sizeof(value));
+			return value;
+		};
+		// header: "DXBC", 16-byte checksum, version, total size, chunk count, then one offset per chunk
+		constexpr size_t HEADER{ 32u };
+		if (length < HEADER || std::memcmp(pBytes, "DXBC", 4u) != 0) return whole;
+		const uint32_t chunkCount{ read32(28u) };
+		if (chunkCount > (length - HEADER) / 4u) return whole;
+		for (uint32_t i{ 0u }; i < chunkCount; i++) {
+			const size_t offset{ read32(HEADER + i * 4u) };
+			if (offset > length - 8u) return whole;
+			const size_t size{ read32(offset + 4u) };
+			const bool input{ std::memcmp(pBytes + offset, "ISGN", 4u) == 0 || std::memcmp(pBytes + offset, "ISG1", 4u) == 0 };
+			if (input && size <= length - offset - 8u) return { pBytes + offset + 8u, size };
+		}
+		return whole;
+	}
+}
+
+#ifdef _WIN32
+#include <d3d11.h>
+
+namespace InputLayout {
+	static_assert(static_cast<unsigned>(Format::R32G32B32A32_FLOAT) == DXGI_FORMAT_R32G32B32A32_FLOAT);
+	static_assert(static_cast<unsigned>(Format::R32G32B32A32_UINT) == DXGI_FORMAT_R32G32B32A32_UINT);
+	static_assert(static_cast<unsigned>(Format::R32G32B32A32_SINT) == DXGI_FORMAT_R32G32B32A32_SINT);
+	static_assert(static_cast<unsigned>(Format::R32G32B32_FLOAT) == DXGI_FORMAT_R32G32B32_FLOAT);
+	static_assert(static_cast<unsigned>(Format::R32G32B32_UINT) == DXGI_FORMAT_R32G32B32_UINT);
+	static_assert(static_cast<unsigned>(Format::R32G32B32_SINT) == DXGI_FORMAT_R32G32B32_SINT);
+	static_assert(static_cast<unsigned>(Format::R16G16B16A16_FLOAT) == DXGI_FORMAT_R16G16B16A16_FLOAT);
+	static_assert(static_cast<unsigned>(Format::R16G16B16A16_UNORM) == DXGI_FORMAT_R16G16B16A16_UNORM);
+	static_assert(static_cast<unsigned>(Format::R16G16B16A16_SNORM) == DXGI_FORMAT_R16G16B16A16_SNORM);
+	static_assert(static_cast<unsigned>(Format::R32G32_FLOAT) == DXGI_FORMAT_R32G32_FLOAT);
+	static_assert(static_cast<unsigned>(Format::R32G32_UINT) == DXGI_FORMAT_R32G32_UINT);
+	static_assert(static_cast<unsigned>(Format::R32G32_SINT) == DXGI_FORMAT_R32G32_SINT);
+	static_assert(static_cast<unsigned>(Format::R16G16_FLOAT) == DXGI_FORMAT_R16G16_FLOAT);
+	static_assert(static_cast<unsigned>(Format::R16G16_UNORM) == DXGI_FORMAT_R16G16_UNORM);
+	static_assert(static_cast<unsigned>(Format::R16G16_SNORM) == DXGI_FORMAT_R16G16_SNORM);
+	static_assert(static_cast<unsigned>(Format::R32_FLOAT) == DXGI_FORMAT_R32_FLOAT);
+	static_assert(static_cast<unsigned>(Format::R32_UINT) == DXGI_FORMAT_R32_UINT);
+	static_assert(static_cast<unsigned>(Format::R32_SINT) == DXGI_FORMAT_R32_SINT);
+	static_assert(static_cast<unsigned>(Format::R16_FLOAT) == DXGI_FORMAT_R16_FLOAT);
+	static_assert(static_cast<unsigned>(Format::R16_UNORM) == DXGI_FORMAT_R16_UNORM);
+	static_assert(static_cast<unsigned>(Format::R16_SNORM) == DXGI_FORMAT_R16_SNORM);
+	static_assert(static_cast<unsigned>(Classification::PER_INSTANCE_DATA) == D3D11_INPUT_PER_INSTANCE_DATA);
+	static_assert(sizeof(ElementDesc) == sizeof(D3D11_INPUT_ELEMENT_DESC));
+
+	template <size_t N>
+	constexpr std::array<D3D11_INPUT_ELEMENT_DESC, N> toD3D(const std::array<ElementDesc, N>& descs) noexcept {
+		std::array<D3D11_INPUT_ELEMENT_DESC, N> result{};
+		for (size_t i{ 0u }; i < N; i++) {
+			result[i] = { descs[i].SemanticName, descs[i].SemanticIndex, static_cast<DXGI_FORMAT>(descs[i].Format),
+				descs[i].InputSlot, descs[i].AlignedByteOffset, static_cast<D3D11_INPUT_CLASSIFICATION>(descs[i].InputSlotClass),
+				descs[i].InstanceDataStepRate };
+		}
+		return result;
+	}
+
+	// the derived layout of a vertex type, ready for Material::setInputLayout
+	template <class Vtx>
+	inline constexpr std::array<D3D11_INPUT_ELEMENT_DESC, Vtx::Layout::COUNT> d3d{ toD3D(of<Vtx>()) };
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "Graphics.h"
+#include "InputLayout.h"
+#include "InputLayoutCache.h"
+#include <algorithm>
+#include <cstring>
+#include <d3d11.h>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+	bool sameElements(const std::vector<D3D11_INPUT_ELEMENT_DESC>& cached, const D3D11_INPUT_ELEMENT_DESC* pDescs, size_t count) {
+		return cached.size() == count && std::equal(cached.cbegin(), cached.cend(), pDescs,
+			[](const D3D11_INPUT_ELEMENT_DESC& a, const D3D11_INPUT_ELEMENT_DESC& b) {
+				return std::strcmp(a.SemanticName, b.SemanticName) == 0 && a.SemanticIndex == b.SemanticIndex
+					&& a.Format == b.Format && a.InputSlot == b.InputSlot && a.AlignedByteOffset == b.AlignedByteOffset
+					&& a.InputSlotClass == b.InputSlotClass && a.InstanceDataStepRate == b.InstanceDataStepRate;
+			});
+	}
+}
+
+InputLayoutCache::InputLayoutCache() : m_entries{}, m_stats{} {}
+
+Microsoft::WRL::ComPtr<ID3D11InputLayout> InputLayoutCache::get(const Graphics& gfx, const D3D11_INPUT_ELEMENT_DESC* pDescs,
+	size_t count, const void* pShaderByteCode, size_t shaderLength) {
+
+	const std::span<const std::byte> signature{ InputLayout::signature(pShaderByteCode, shaderLength) };
+	const uint64_t signatureHash{ InputLayout::hash(signature.data(), signature.size()) };
+	const uint64_t key{ InputLayout::hashValue(InputLayout::hash(std::span<const D3D11_INPUT_ELEMENT_DESC>{ pDescs, count }), signatureHash) };
+
+	auto [first, last] = m_entries.equal_range(key);
+	for (auto it{ first }; it != last; ++it) {
+		const Entry& e{ it->second };
+		if (e.signatureHash == signatureHash && e.signatureLength == signature.size() && sameElements(e.descs, pDescs, count)) {
+			m_stats.hits++;
+			return e.pLayout;
+		}
+	}
+
+	Entry e{ { pDescs, pDescs + count }, {}, signatureHash, signature.size(), nullptr };
+	e.semantics.reserve(count);
+	for (size_t i{ 0u }; i < count; i++)
+		e.descs[i].SemanticName = e.semantics.emplace_back(pDescs[i].SemanticName).c_str();
+	THROW_IF_FAILED(gfx, gfx.getDevice()->CreateInputLayout(pDescs, static_cast<UINT>(count), pShaderByteCode, shaderLength, &e.pLayout));
+	m_stats.misses++;
+	return m_entries.emplace(key, std::move(e))->second.pLayout;
+}
+
+size_t InputLayoutCache::releaseUnused() {
+	size_t released{ 0u };
+	for (auto it{ m_entries.begin() }; it != m_entries.end();) {
+		it->second.pLayout->AddRef();
+		if (it->second.pLayout->Release() == 1u) { // only ours
+			it = m_entries.erase(it);
+			released++;
+		} else {
+			++it;
+		}
+	}
+	return released;
+}
+
+void InputLayoutCache::clear() noexcept {
+	m_entries.clear();
+}
+
+size_t InputLayoutCache::size() const noexcept {
+	return m_entries.size();
+}
+
+InputLayoutCache::Stats InputLayoutCache::getStats() const noexcept {
+	return m_stats;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef CWF_INPUTLAYOUTCACHE_H
+#define CWF_INPUTLAYOUTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <d3d11.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wrl.h>
+
+class Graphics;
+
+/*
+* Hands out one ID3D11InputLayout per distinct (element array, vertex shader input signature), so materials with the
+* same vertex type and shader inputs share a layout object instead of each creating their own.
+* Lookups are keyed by the hashes from InputLayout.h; the elements themselves are compared too, so a hash collision
+* can't hand out the wrong layout (the signature is only compared by hash and length).
+* Part of PipelineCache (see Graphics::getPipelineCache); layouts live as long as the cache or their last user.
+*/
+
+class InputLayoutCache {
+public:
+	struct Stats {
+		size_t hits;
+		size_t misses; // i.e. layouts created
+	};
+private:
+	struct Entry {
+		std::vector<D3D11_INPUT_ELEMENT_DESC> descs; // SemanticName points into semantics
+		std::vector<std::string> semantics;
+		uint64_t signatureHash;
+		size_t signatureLength;
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> pLayout;
+	};
+
+	std::unordered_multimap<uint64_t, Entry> m_entries;
+	Stats m_stats;
+public:
+	InputLayoutCache();
+	~InputLayoutCache() = default;
+	// no copy init/assign
+	InputLayoutCache(const InputLayoutCache& o) = delete;
+	InputLayoutCache& operator=(const InputLayoutCache& o) = delete;
+
+	// the shared layout for these elements and this vertex shader, created on first request
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> get(const Graphics& gfx, const D3D11_INPUT_ELEMENT_DESC* pDescs, size_t count,
+		const void* pShaderByteCode, size_t shaderLength);
+
+	size_t releaseUnused(); // drops layouts only the cache still holds; returns how many
+	void clear() noexcept;
+	size_t size() const noexcept;
+	Stats getStats() const noexcept;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "InputLog.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace {
+	constexpr char MAGIC[4]{ 'C', 'W', 'I', 'L' };
+	constexpr size_t HEADER_SIZE{ 16u };
+	constexpr size_t MIN_RECORD_SIZE{ 3u }; // time, frame and type
+
+	using Type = InputLog::Record::Type;
+
+	bool hasCode(Type type) noexcept {
+		return type <= Type::BUTTON_DOUBLECLICKED;
+	}
+
+	bool hasPosition(Type type) noexcept {
+		return type >= Type::BUTTON_PRESSED;
+	}
+
+	void put16(std::vector<std::byte>& out, uint16_t value) {
+		for (size_t i{ 0u }; i < 2u; i++) out.push_back(static_cast<std::byte>(value >> (8u * i)));
+	}
+
+	void put64(std::vector<std::byte>& out, uint64_t value) {
+		for (size_t i{ 0u }; i < 8u; i++) out.push_back(static_cast<std::byte>(value >> (8u * i)));
+	}
+
+	void putVarint(std::vector<std::byte>& out, uint64_t value) {
+		while (value >= 0x80u) {
+			out.push_back(static_cast<std::byte>(value | 0x80u));
+			value >>= 7u;
+		}
+		out.push_back(static_cast<std::byte>(value));
+	}
+
+	void putSigned(std::vector<std::byte>& out, int32_t value) {
+		putVarint(out, (static_cast<uint32_t>(value) << 1u) ^ static_cast<uint32_t>(value >> 31)); // zigzag
+	}
+
+	class Reader {
+	private:
+		std::span<const std::byte> m_bytes;
+		size_t m_offset;
+		bool m_failed;
+	public:
+		explicit Reader(std::span<const std::byte> bytes, size_t offset) noexcept
+			: m_bytes{ bytes }, m_offset{ offset }, m_failed{ false } {}
+
+		bool failed() const noexcept { return m_failed; }
+
+		uint8_t byte() noexcept {
+			if (m_offset >= m_bytes.size()) {
+				m_failed = true;
+				return 0u;
+			}
+			return static_cast<uint8_t>(m_bytes[m_offset++]);
+		}
+
+		uint64_t varint() noexcept {
+			uint64_t value{ 0u };
+			for (unsigned int shift{ 0u }; shift < 64u; shift += 7u) {
+				const uint8_t b{ byte() };
+				value |= static_cast<uint64_t>(b & 0x7fu) << shift;
+				if (!(b & 0x80u)) return value;
+			}
+			m_failed = true; // longer than any value written
+			return 0u;
+		}
+
+		int32_t signedVarint() noexcept {
+			const uint64_t zigzag{ varint() };
+			if (zigzag > UINT32_MAX) m_failed = true;
+			const uint32_t value{ static_cast<uint32_t>(zigzag) };
+			return static_cast<int32_t>((value >> 1u) ^ (0u - (value & 1u)));
+		}
+	};
+}
+
+// Recorder
+InputLog::Recorder::Recorder(Source source)
+	: m_records{}, m_start{ std::chrono::steady_clock::now() }, m_frame{ 0u }, m_source{ source } {}
+
+void InputLog::Recorder::record(Record::Type type, uint8_t code, int32_t x, int32_t y, int32_t wheel) {
+	const uint64_t time{ static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - m_start).count()) };
+	m_records.push_back({ time, m_frame, type, code, x, y, wheel });
+}
+
+void InputLog::Recorder::nextFrame() noexcept {
+	m_frame++;
+}
+
+void InputLog::Recorder::restart() noexcept {
+	m_records.clear();
+	m_start = std::chrono::steady_clock::now();
+	m_frame = 0u;
+}
+
+InputLog::Source InputLog::Recorder::getSource() const noexcept {
+	return m_source;
+}
+
+InputLog InputLog::Recorder::log() const {
+	return InputLog{ m_records, m_source };
+}
+
+// InputLog
+InputLog::InputLog() noexcept : m_records{}, m_source{ Source::WINDOW } {}
+
+InputLog::InputLog(std::vector<Record> records, Source source) noexcept
+	: m_records{ std::move(records) }, m_source{ source } {}
+
+std::span<const InputLog::Record> InputLog::records() const noexcept {
+	return m_records;
+}
+
+size_t InputLog::size() const noexcept {
+	return m_records.size();
+}
+
+uint64_t InputLog::getDuration() const noexcept {
+	return m_records.empty() ? 0u : m_records.back().time;
+}
+
+InputLog::Source InputLog::getSource() const noexcept {
+	return m_source;
+}
+
+std::vector<std::byte> InputLog::encode() const {
+	std::vector<std::byte> out{};
+	out.reserve(HEADER_SIZE + m_records.size() * 6u);
+	for (char c : MAGIC) out.push_back(static_cast<std::byte>(c));
+	put16(out, VERSION);
+	out.push_back(static_cast<std::byte>(m_source));
+	out.push_back(std::byte{ 0u });
+	put64(out, m_records.size());
+
+	uint64_t time{ 0u };
+	uint32_t frame{ 0u };
+	for (const Record& r : m_records) {
+		putVarint(out, r.time - time); // records are in the order they were made, so neither goes backwards
+		putVarint(out, r.frame - frame);
+		time = r.time;
+		frame = r.frame;
+		out.push_back(static_cast<std::byte>(r.type));
+		if (hasCode(r.type)) out.push_back(static_cast<std::byte>(r.code));
+		if (hasPosition(r.type)) {
+			putSigned(out, r.x);
+			putSigned(out, r.y);
+		}
+		if (r.type == Type::SCROLLED) putSigned(out, r.wheel);
+	}
+	return out;
+}
+
+bool InputLog::decode(std::span<const std::byte> bytes) {
+	m_records.clear();
+	m_source = Source::WINDOW;
+	if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) != 0) return false;
+	uint16_t version{};
+	uint64_t count{};
+	std::memcpy(&version, bytes.data() + 4u, sizeof(version));
+	const uint8_t source{ static_cast<uint8_t>(bytes[6u]) }; // version 1's u32 version has zeros here, so WINDOW
+	std::memcpy(&count, bytes.data() + 8u, sizeof(count));
+	if (version == 0u || version > VERSION || source > static_cast<uint8_t>(Source::TIMELINE)
+		|| bytes[7u] != std::byte{ 0u } || count > (bytes.size() - HEADER_SIZE) / MIN_RECORD_SIZE) return false;
+
+	std::vector<Record> records{};
+	records.reserve(static_cast<size_t>(count));
+	Reader in{ bytes, HEADER_SIZE };
+	uint64_t time{ 0u };
+	uint32_t frame{ 0u };
+	for (uint64_t i{ 0u }; i < count; i++) {
+		Record r{};
+		time += in.varint();
+		frame += static_cast<uint32_t>(in.varint());
+		r.time = time;
+		r.frame = frame;
+		const uint8_t type{ in.byte() };
+		if (type > static_cast<uint8_t>(Type::RAW)) return false;
+		r.type = static_cast<Type>(type);
+		if (hasCode(r.type)) r.code = in.byte();
+		if (hasPosition(r.type)) {
+			r.x = in.signedVarint();
+			r.y = in.signedVarint();
+		}
+		if (r.type == Type::SCROLLED) r.wheel = in.signedVarint();
+		if (in.failed()) return false;
+		records.push_back(r);
+	}
+	m_records = std::move(records);
+	m_source = static_cast<Source>(source);
+	return true;
+}
+
+bool InputLog::write(const std::filesystem::path& path) const {
+	const std::vector<std::byte> out{ encode() };
+	std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+	file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+	return static_cast<bool>(file);
+}
+
+bool InputLog::read(const std::filesystem::path& path) {
+	m_records.clear();
+	std::ifstream file{ path, std::ios::binary };
+	if (!file) return false;
+	const std::vector<char> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	return decode(std::as_bytes(std::span{ bytes }));
+}
\ No newline at end of file
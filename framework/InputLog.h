@@ -0,0 +1,91 @@
+#ifndef CWF_INPUTLOG_H
+#define CWF_INPUTLOG_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+/*
+* A recording of a run's input, event for event, so a run (e.g. a camera flythrough) can be played back identically
+* later through InputReplayer and frame timings compared across builds.
+* Records are filled in by an InputLog::Recorder, from one of two sources: Window hands it to its Keyboard and Mouse
+* (Window::setInputRecorder), which record the calls they were given, and InputThread records the events each advance
+* of its InputTimeline takes in (InputThread::setInputRecorder). Each record carries the time since recording started
+* and the frame (pass over the message queue, or advance of the timeline) it arrived in, so playback can follow either
+* the clock or the frames. The log keeps its source, since the two number mouse buttons differently.
+* Portable; no exceptions, a missing or malformed log just fails to read.
+*
+* Format, all little-endian:
+*	header  - "CWIL", version (u16), source (u8), 0 (u8), record count (u64)                          16 bytes
+*	records - time delta in nanoseconds and frame delta (unsigned LEB128), type (u8), then by type:
+*	          a code (u8) for keys, characters and buttons, the position or delta (zigzag LEB128 each) for everything but
+*	          keys and characters, and the wheel delta (zigzag LEB128) for SCROLLED
+* A flythrough's records are mostly small raw mouse deltas about a millisecond apart, which come to 7 bytes each.
+* Version 1 had a u32 version and no source; its logs read as WINDOW ones.
+*/
+
+class InputLog {
+public:
+	static constexpr uint16_t VERSION{ 2u };
+
+	enum class Source : uint8_t {
+		WINDOW, // Keyboard and Mouse's handlers; buttons are Mouse::Event::Button
+		TIMELINE // InputTimeline events; buttons are InputTimeline::Button; only keys, buttons, RAW and SCROLLED occur
+	};
+
+	struct Record {
+		enum class Type : uint8_t { // the Keyboard or Mouse handler it was passed to
+			KEY_PRESSED, KEY_RELEASED, CHARACTER_TYPED, BUTTON_PRESSED, BUTTON_RELEASED, BUTTON_DOUBLECLICKED,
+			SCROLLED, MOVED, ENTERED, LEFT, RAW
+		};
+
+		uint64_t time; // nanoseconds since recording started
+		uint32_t frame;
+		Type type;
+		uint8_t code; // key, character, or button (see Source)
+		int32_t x; // position, or raw delta
+		int32_t y;
+		int32_t wheel; // SCROLLED's delta, in WHEEL_DELTA units of 120
+	};
+
+	class Recorder {
+	private:
+		std::vector<Record> m_records;
+		std::chrono::steady_clock::time_point m_start;
+		uint32_t m_frame;
+		Source m_source;
+	public:
+		explicit Recorder(Source source = Source::WINDOW);
+		~Recorder() = default;
+		// no copy init/assign
+		Recorder(const Recorder& o) = delete;
+		Recorder& operator=(const Recorder& o) = delete;
+
+		void record(Record::Type type, uint8_t code, int32_t x = 0, int32_t y = 0, int32_t wheel = 0);
+		void nextFrame() noexcept;
+		void restart() noexcept; // drops everything recorded and restarts the clock at frame 0
+		Source getSource() const noexcept;
+		InputLog log() const;
+	};
+private:
+	std::vector<Record> m_records;
+	Source m_source;
+public:
+	InputLog() noexcept;
+	explicit InputLog(std::vector<Record> records, Source source = Source::WINDOW) noexcept;
+
+	std::span<const Record> records() const noexcept;
+	size_t size() const noexcept;
+	uint64_t getDuration() const noexcept; // nanoseconds, up to the last record
+	Source getSource() const noexcept;
+
+	std::vector<std::byte> encode() const;
+	bool decode(std::span<const std::byte> bytes); // replaces the records and source; false, leaving none, if malformed
+	bool write(const std::filesystem::path& path) const;
+	bool read(const std::filesystem::path& path);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "InputLog.h"
+#include "InputReplayer.h"
+#include "InputTimeline.h"
+#include "Keyboard.h"
+#include "Mouse.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <Windows.h>
+
+InputReplayer::InputReplayer(InputLog log, Pace pace, double speed) noexcept
+	: m_log{ std::move(log) }, m_pace{ pace }, m_speed{ speed }, m_next{ 0u }, m_frame{ 0u }, m_start{},
+	m_started{ false } {}
+
+size_t InputReplayer::replay(Keyboard& kbd, Mouse& mouse) {
+	const std::span<const InputLog::Record> records{ m_log.records() };
+	const size_t first{ due() };
+	if (m_log.getSource() == InputLog::Source::WINDOW) {
+		for (size_t i{ first }; i < m_next; i++) apply(records[i], kbd, mouse);
+	}
+	return m_next - first;
+}
+
+size_t InputReplayer::replay(InputTimeline& timeline, InputTimeline::Time time) {
+	const std::span<const InputLog::Record> records{ m_log.records() };
+	const size_t first{ due() };
+	if (m_log.getSource() == InputLog::Source::TIMELINE) {
+		for (size_t i{ first }; i < m_next; i++) inject(records[i], timeline, time);
+	}
+	return m_next - first;
+}
+
+bool InputReplayer::isFinished() const noexcept {
+	return m_next == m_log.size();
+}
+
+uint32_t InputReplayer::getFrame() const noexcept {
+	return m_frame;
+}
+
+void InputReplayer::restart() noexcept {
+	m_next = 0u;
+	m_frame = 0u;
+	m_started = false;
+}
+
+size_t InputReplayer::due() noexcept {
+	const std::span<const InputLog::Record> records{ m_log.records() };
+	if (!m_started) { // the clock starts at the first pass, not at construction
+		m_start = std::chrono::steady_clock::now();
+		m_started = true;
+	}
+
+	const size_t first{ m_next };
+	if (m_pace == Pace::FRAME) {
+		while (m_next < records.size() && records[m_next].frame <= m_frame) m_next++;
+	} else {
+		const std::chrono::duration<double, std::nano> elapsed{ std::chrono::steady_clock::now() - m_start };
+		const double dueTime{ elapsed.count() * m_speed };
+		while (m_next < records.size() && static_cast<double>(records[m_next].time) <= dueTime) m_next++;
+	}
+	m_frame++;
+	return first;
+}
+
+void InputReplayer::apply(const InputLog::Record& r, Keyboard& kbd, Mouse& mouse) {
+	using Type = InputLog::Record::Type;
+	const Mouse::Event::Button button{ static_cast<Mouse::Event::Button>(r.code) };
+	switch (r.type) {
+	case Type::KEY_PRESSED:
+		kbd.keyPressed(r.code);
+		break;
+	case Type::KEY_RELEASED:
+		kbd.keyReleased(r.code);
+		break;
+	case Type::CHARACTER_TYPED:
+		kbd.characterTyped(r.code);
+		break;
+	case Type::BUTTON_PRESSED:
+		mouse.buttonPressed(button, r.x, r.y);
+		break;
+	case Type::BUTTON_RELEASED:
+		mouse.buttonReleased(button, r.x, r.y);
+		break;
+	case Type::BUTTON_DOUBLECLICKED:
+		mouse.buttonDoubleClicked(button, r.x, r.y);
+		break;
+	case Type::SCROLLED:
+		mouse.scrolled(MAKEWPARAM(0u, static_cast<WORD>(r.wheel)), r.x, r.y);
+		break;
+	case Type::MOVED:
+		mouse.moved(r.x, r.y);
+		break;
+	case Type::ENTERED:
+		mouse.entered(r.x, r.y);
+		break;
+	case Type::LEFT:
+		mouse.left(r.x, r.y);
+		break;
+	case Type::RAW:
+		mouse.raw(r.x, r.y);
+		break;
+	}
+}
+
+void InputReplayer::inject(const InputLog::Record& r, InputTimeline& timeline, InputTimeline::Time time) {
+	using Type = InputLog::Record::Type;
+	using EventType = InputTimeline::Event::Type;
+	// the inverse of what InputThread records
+	switch (r.type) {
+	case Type::KEY_PRESSED:
+		timeline.inject({ time, EventType::KEY_DOWN, r.code, 0, 0 });
+		break;
+	case Type::KEY_RELEASED:
+		timeline.inject({ time, EventType::KEY_UP, r.code, 0, 0 });
+		break;
+	case Type::BUTTON_PRESSED:
+		timeline.inject({ time, EventType::BUTTON_DOWN, r.code, 0, 0 });
+		break;
+	case Type::BUTTON_RELEASED:
+		timeline.inject({ time, EventType::BUTTON_UP, r.code, 0, 0 });
+		break;
+	case Type::RAW:
+		timeline.inject({ time, EventType::MOTION, 0u, r.x, r.y });
+		break;
+	case Type::SCROLLED:
+		timeline.inject({ time, EventType::WHEEL, 0u, r.wheel, 0 });
+		break;
+	default: // nothing InputThread records
+		break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef CWF_INPUTREPLAYER_H
+#define CWF_INPUTREPLAYER_H
+
+#include "InputLog.h"
+#include "InputTimeline.h"
+#include "Keyboard.h"
+#include "Mouse.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Plays an InputLog back where it was recorded from, so the application can't tell a replay from the run that was
+* recorded: a WINDOW log into a Keyboard and Mouse through the same handlers Window feeds live input to, a TIMELINE log
+* into an InputTimeline through inject, on the consumer's side. Window drives it once per pass over the message queue,
+* and InputThread once per advance of its timeline (setInputReplayer on either); both ignore the real keyboard and
+* mouse meanwhile. Records replayed into the other kind of target are skipped, since the two number mouse buttons
+* differently.
+* Pace::FRAME hands each pass the records of the matching recorded frame: the same input lands on the same frame however
+* fast or slow frames now take, which is what makes two builds' frame timings comparable. Pace::RECORDED follows the
+* clock instead, at the recorded speed or a multiple of it.
+*/
+
+class InputReplayer {
+public:
+	enum class Pace {
+		FRAME, RECORDED
+	};
+private:
+	InputLog m_log;
+	Pace m_pace;
+	double m_speed;
+	size_t m_next; // first record not yet replayed
+	uint32_t m_frame;
+	std::chrono::steady_clock::time_point m_start;
+	bool m_started;
+public:
+	explicit InputReplayer(InputLog log, Pace pace = Pace::FRAME, double speed = 1.0) noexcept;
+	~InputReplayer() = default;
+	// no copy init/assign
+	InputReplayer(const InputReplayer& o) = delete;
+	InputReplayer& operator=(const InputReplayer& o) = delete;
+
+	size_t replay(Keyboard& kbd, Mouse& mouse); // returns how many records were due
+	// injects the due records stamped with time, so an advance to time takes them all; from the timeline's consumer
+	size_t replay(InputTimeline& timeline, InputTimeline::Time time);
+	bool isFinished() const noexcept;
+	uint32_t getFrame() const noexcept; // passes replayed so far
+	void restart() noexcept;
+private:
+	size_t due() noexcept; // moves m_next past the records due this pass; returns where they start
+	void apply(const InputLog::Record& r, Keyboard& kbd, Mouse& mouse);
+	static void inject(const InputLog::Record& r, InputTimeline& timeline, InputTimeline::Time time);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "CwfException.h"
+#include "InputLog.h"
+#include "InputReplayer.h"
+#include "InputThread.h"
+#include "InputTimeline.h"
+#include "Mouse.h"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <Windows.h>
+
+namespace {
+	constexpr USHORT GENERIC_DESKTOP{ 0x01 }; // usage page
+	constexpr USHORT MOUSE{ 0x02 }; // usage ids
+	constexpr USHORT KEYBOARD{ 0x06 };
+}
+
+std::atomic<bool> InputThread::s_alive{ false };
+
+InputThread::InputThread(HWND target)
+	: m_target{ target }, m_timeline{}, m_hWnd{ nullptr }, m_threadId{ 0u }, m_pRecorder{ nullptr },
+	m_pReplayer{ nullptr }, m_applied{}, m_thread{} {
+
+	if (s_alive.exchange(true))
+		throw CWF_EXCEPTION(CwfException::Type::FRAMEWORK, L"Only one InputThread may be alive at a time.");
+	if (Mouse::isAnyRawInputEnabled()) {
+		s_alive = false;
+		throw CWF_EXCEPTION(CwfException::Type::FRAMEWORK, L"InputThread can't own raw input while a Mouse has it enabled.");
+	}
+	std::promise<HRESULT> started{};
+	std::future<HRESULT> result{ started.get_future() };
+	// the thread owns the promise, so setting it never touches this constructor's frame, which may already be gone
+	m_thread = std::thread{ [this, p = std::move(started)]() mutable { run(p); } };
+	const HRESULT hr{ result.get() };
+	if (FAILED(hr)) {
+		m_thread.join();
+		s_alive = false;
+		throw CwfException{ CwfException::Type::WINDOWS, CwfException::getWindowsErrorString(hr), __FILE__, __LINE__ };
+	}
+}
+
+InputThread::~InputThread() {
+	PostThreadMessageW(m_threadId, WM_QUIT, 0u, 0);
+	m_thread.join();
+	s_alive = false;
+}
+
+InputTimeline& InputThread::timeline() noexcept {
+	return m_timeline;
+}
+
+InputTimeline::State InputThread::advance(InputTimeline::Time time) {
+	using Record = InputLog::Record;
+	using Type = InputTimeline::Event::Type;
+	if (InputReplayer* pReplayer{ m_pReplayer.load(std::memory_order_relaxed) }) pReplayer->replay(m_timeline, time);
+	InputLog::Recorder* pRecorder{ m_pRecorder.load(std::memory_order_relaxed) };
+	if (!pRecorder) return m_timeline.advance(time);
+
+	m_applied.clear();
+	const InputTimeline::State state{ m_timeline.advance(time, m_applied) };
+	// InputReplayer::inject turns these back into the same events
+	for (const InputTimeline::Event& e : m_applied) {
+		switch (e.type) {
+		case Type::KEY_DOWN:
+			pRecorder->record(Record::Type::KEY_PRESSED, e.code);
+			break;
+		case Type::KEY_UP:
+			pRecorder->record(Record::Type::KEY_RELEASED, e.code);
+			break;
+		case Type::BUTTON_DOWN:
+			pRecorder->record(Record::Type::BUTTON_PRESSED, e.code);
+			break;
+		case Type::BUTTON_UP:
+			pRecorder->record(Record::Type::BUTTON_RELEASED, e.code);
+			break;
+		case Type::MOTION:
+			pRecorder->record(Record::Type::RAW, 0u, e.x, e.y);
+			break;
+		case Type::WHEEL:
+			pRecorder->record(Record::Type::SCROLLED, 0u, 0, 0, e.x);
+			break;
+		}
+	}
+	pRecorder->nextFrame();
+	return state;
+}
+
+void InputThread::setInputRecorder(InputLog::Recorder* pRecorder) noexcept {
+	m_pRecorder.store(pRecorder, std::memory_order_relaxed);
+}
+
+void InputThread::setInputReplayer(InputReplayer* pReplayer) noexcept {
+	m_pReplayer.store(pReplayer, std::memory_order_relaxed);
+}
+
+bool InputThread::isAlive() noexcept {
+	return s_alive;
+}
+
+void InputThread::run(std::promise<HRESULT>& started) noexcept {
+	m_threadId = GetCurrentThreadId();
+	const HINSTANCE hInstance{ GetModuleHandleW(nullptr) };
+	WNDCLASSEXW wc{};
+	wc.cbSize = sizeof(wc);
+	wc.lpfnWndProc = windowProc;
+	wc.hInstance = hInstance;
+	wc.lpszClassName = s_className;
+	if (!RegisterClassExW(&wc)) {
+		const DWORD error{ GetLastError() };
+		if (error != ERROR_CLASS_ALREADY_EXISTS) { // another InputThread registered it
+			started.set_value(HRESULT_FROM_WIN32(error));
+			return;
+		}
+	}
+
+	m_hWnd = CreateWindowExW(0u, s_className, L"", 0u, 0, 0, 0, 0, HWND_MESSAGE, nullptr, hInstance, nullptr);
+	if (!m_hWnd) {
+		started.set_value(HRESULT_FROM_WIN32(GetLastError()));
+		return;
+	}
+	SetWindowLongPtrW(m_hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+	RAWINPUTDEVICE devices[2]{
+		{ GENERIC_DESKTOP, MOUSE, RIDEV_INPUTSINK, m_hWnd },
+		{ GENERIC_DESKTOP, KEYBOARD, RIDEV_INPUTSINK, m_hWnd }
+	};
+	if (!RegisterRawInputDevices(devices, 2u, sizeof(RAWINPUTDEVICE))) {
+		started.set_value(HRESULT_FROM_WIN32(GetLastError()));
+		DestroyWindow(m_hWnd);
+		return;
+	}
+	started.set_value(S_OK); // the window gave this thread a message queue, so the destructor's WM_QUIT will arrive
+
+	MSG msg{};
+	while (GetMessageW(&msg, nullptr, 0u, 0u) > 0)
+		DispatchMessageW(&msg);
+
+	for (RAWINPUTDEVICE& device : devices) {
+		device.dwFlags = RIDEV_REMOVE;
+		device.hwndTarget = nullptr;
+	}
+	RegisterRawInputDevices(devices, 2u, sizeof(RAWINPUTDEVICE));
+	DestroyWindow(m_hWnd);
+}
+
+void InputThread::rawInput(HRAWINPUT hRawInput) noexcept {
+	using Type = InputTimeline::Event::Type;
+	const InputTimeline::Time time{ InputTimeline::now() };
+	RAWINPUT raw{}; // a keyboard's or mouse's always fits, so no allocation
+	UINT size{ sizeof(raw) };
+	if (GetRawInputData(hRawInput, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)) return;
+	const bool foreground{ GetForegroundWindow() == m_target };
+
+	if (raw.header.dwType == RIM_TYPEKEYBOARD) {
+		const RAWKEYBOARD& keyboard{ raw.data.keyboard };
+		if (keyboard.VKey >= 0xff) return; // part of an escape sequence, not a key of its own
+		if (keyboard.Flags & RI_KEY_BREAK) publish(time, Type::KEY_UP, static_cast<uint8_t>(keyboard.VKey));
+		else if (foreground) publish(time, Type::KEY_DOWN, static_cast<uint8_t>(keyboard.VKey));
+	} else if (raw.header.dwType == RIM_TYPEMOUSE) {
+		const RAWMOUSE& mouse{ raw.data.mouse };
+		// in InputTimeline::Button order; each button's up flag is its down flag shifted left by one
+		static constexpr USHORT s_downFlags[]{ RI_MOUSE_LEFT_BUTTON_DOWN, RI_MOUSE_RIGHT_BUTTON_DOWN,
+			RI_MOUSE_MIDDLE_BUTTON_DOWN, RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_5_DOWN };
+		for (uint8_t button{ 0u }; button < std::size(s_downFlags); button++) {
+			if (mouse.usButtonFlags & (s_downFlags[button] << 1)) publish(time, Type::BUTTON_UP, button);
+			else if (foreground && (mouse.usButtonFlags & s_downFlags[button])) publish(time, Type::BUTTON_DOWN, button);
+		}
+		if (!foreground) return;
+		if (!(mouse.usFlags & MOUSE_MOVE_ABSOLUTE) && (mouse.lLastX != 0 || mouse.lLastY != 0))
+			publish(time, Type::MOTION, 0u, mouse.lLastX, mouse.lLastY);
+		if (mouse.usButtonFlags & RI_MOUSE_WHEEL)
+			publish(time, Type::WHEEL, 0u, static_cast<SHORT>(mouse.usButtonData));
+	}
+}
+
+void InputThread::publish(InputTimeline::Time time, InputTimeline::Event::Type type, uint8_t code, int32_t x,
+	int32_t y) noexcept {
+
+	if (m_pReplayer.load(std::memory_order_relaxed)) return; // the replay is the only input
+	m_timeline.publish({ time, type, code, x, y }); // dropped input is counted by the timeline
+}
+
+LRESULT CALLBACK InputThread::windowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) noexcept {
+	if (msg == WM_INPUT) {
+		InputThread* pThis{ reinterpret_cast<InputThread*>(GetWindowLongPtrW(hWnd, GWLP_USERDATA)) };
+		if (pThis) pThis->rawInput(reinterpret_cast<HRAWINPUT>(lParam));
+	}
+	return DefWindowProcW(hWnd, msg, wParam, lParam); // also frees WM_INPUT's data
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef CWF_INPUTTHREAD_H
+#define CWF_INPUTTHREAD_H
+
+#include "InputLog.h"
+#include "InputTimeline.h"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+#include <Windows.h>
+
+/*
+* Reads keyboard and mouse raw input on a thread of its own and publishes it, timestamped, to an InputTimeline, so
+* input keeps arriving (and keeps its real timing) while the render thread is busy or blocked in Present.
+* The thread owns a message-only window registered as the raw input target for the keyboard and mouse (RIDEV_INPUTSINK,
+* since a message-only window is never in the foreground); presses and motion are only published while the target
+* window is in the foreground, releases always, so nothing stays held down after switching away.
+* Raw input registration is per process, so it has one owner at a time: an InputThread can't be created while another
+* is alive or while a Mouse has raw input enabled (the constructor throws), and Mouse::enableRawInput fails while an
+* InputThread is alive. The window's regular keyboard and mouse messages still arrive as before.
+* Recording and replay happen on the render thread, in advance(), so the input thread only ever publishes: a recorder
+* (Source::TIMELINE) gets the events each advance folds into its frame, and while a replayer is installed the thread
+* drops live input and advance() injects the replayer's due records into the timeline instead, so the application reads
+* a replay through the same timeline as live input. The two are installed through atomics, which the input thread only
+* checks for the replayer.
+*/
+
+class InputReplayer;
+
+class InputThread {
+private:
+	static constexpr const wchar_t* s_className = L"CwfInputThread";
+	static std::atomic<bool> s_alive;
+
+	HWND m_target;
+	InputTimeline m_timeline;
+	HWND m_hWnd; // the message-only window, owned by the thread
+	DWORD m_threadId;
+	std::atomic<InputLog::Recorder*> m_pRecorder;
+	std::atomic<InputReplayer*> m_pReplayer; // also read by the input thread, to drop live input while set
+	std::vector<InputTimeline::Event> m_applied; // advance's, for the recorder; reused
+	std::thread m_thread;
+public:
+	explicit InputThread(HWND target);
+	~InputThread();
+	// no copy init/assign
+	InputThread(const InputThread& o) = delete;
+	InputThread& operator=(const InputThread& o) = delete;
+
+	InputTimeline& timeline() noexcept; // sample/advance from one thread only
+	// the timeline's advance, after replaying the records due this frame if a replayer is installed, and recording what
+	// it took in if a recorder is; use this rather than timeline().advance for either to work
+	InputTimeline::State advance(InputTimeline::Time time);
+	// each advance records what it took in into pRecorder, until this is called again with nullptr; call from the thread
+	// that advances, and the previous recorder is free as soon as this returns
+	void setInputRecorder(InputLog::Recorder* pRecorder) noexcept;
+	// while set, live input is dropped and each advance replays the next of pReplayer's records (a TIMELINE log); call
+	// from the thread that advances
+	void setInputReplayer(InputReplayer* pReplayer) noexcept;
+	static bool isAlive() noexcept;
+private:
+	void run(std::promise<HRESULT>& started) noexcept;
+	void rawInput(HRAWINPUT hRawInput) noexcept;
+	void publish(InputTimeline::Time time, InputTimeline::Event::Type type, uint8_t code, int32_t x = 0,
+		int32_t y = 0) noexcept;
+	static LRESULT CALLBACK windowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) noexcept;
+};
+
+#endif
\ No newline at end of file
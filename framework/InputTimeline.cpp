@@ -0,0 +1,100 @@
+#include "InputTimeline.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+InputTimeline::InputTimeline() noexcept : m_queue{}, m_pending{}, m_base{} {}
+
+InputTimeline::Time InputTimeline::now() noexcept {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+}
+
+bool InputTimeline::publish(const Event& e) noexcept {
+	return m_queue.push(e);
+}
+
+uint64_t InputTimeline::getOverflowCount() const noexcept {
+	return m_queue.getOverflowCount();
+}
+
+void InputTimeline::inject(const Event& e) {
+	poll();
+	m_pending.push_back(e);
+}
+
+InputTimeline::State InputTimeline::sample(Time time) {
+	poll();
+	State state{ m_base };
+	apply(state, time);
+	return state;
+}
+
+InputTimeline::State InputTimeline::advance(Time time) {
+	poll();
+	State state{ m_base };
+	commit(state, apply(state, time));
+	return state;
+}
+
+InputTimeline::State InputTimeline::advance(Time time, std::vector<Event>& applied) {
+	poll();
+	State state{ m_base };
+	const size_t count{ apply(state, time) };
+	// copied before anything changes, so a throw leaves the timeline as it was
+	applied.insert(applied.end(), m_pending.cbegin(), m_pending.cbegin() + count);
+	commit(state, count);
+	return state;
+}
+
+size_t InputTimeline::getPendingCount() const noexcept {
+	return m_pending.size();
+}
+
+void InputTimeline::poll() {
+	while (std::optional<Event> e{ m_queue.pop() })
+		m_pending.push_back(*e);
+}
+
+size_t InputTimeline::apply(State& state, Time time) const noexcept {
+	state.time = time;
+	// one producer stamps its events in order, so the first one past time ends the run; one that arrived after an
+	// advance past its stamp simply counts towards the next frame
+	size_t i{ 0u };
+	for (; i < m_pending.size() && m_pending[i].time <= time; i++) {
+		const Event& e{ m_pending[i] };
+		switch (e.type) {
+		case Event::Type::KEY_DOWN:
+			state.keys[e.code] = true;
+			break;
+		case Event::Type::KEY_UP:
+			state.keys[e.code] = false;
+			break;
+		case Event::Type::BUTTON_DOWN:
+			state.buttons |= static_cast<uint8_t>(1u << e.code);
+			break;
+		case Event::Type::BUTTON_UP:
+			state.buttons &= static_cast<uint8_t>(~(1u << e.code));
+			break;
+		case Event::Type::MOTION:
+			state.dx += e.x;
+			state.dy += e.y;
+			break;
+		case Event::Type::WHEEL:
+			state.wheel += e.x;
+			break;
+		}
+	}
+	return i;
+}
+
+void InputTimeline::commit(const State& state, size_t applied) noexcept {
+	m_pending.erase(m_pending.begin(), m_pending.begin() + applied);
+	m_base = state;
+	m_base.dx = 0;
+	m_base.dy = 0;
+	m_base.wheel = 0;
+}
\ No newline at end of file
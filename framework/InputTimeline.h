@@ -0,0 +1,89 @@
+#ifndef CWF_INPUTTIMELINE_H
+#define CWF_INPUTTIMELINE_H
+
+#include "SpscRing.h"
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Timestamped input, handed from the thread that reads it (InputThread, or anything else that calls publish) to the
+* thread that simulates and renders, which asks what the input looked like at a given time instead of draining a queue.
+* Events carry the time they were read, from now() (std::chrono::steady_clock, which is QueryPerformanceCounter on
+* Windows), and travel through an SpscRing, so neither side locks or allocates on the producer's path.
+* sample(t) is the state as of t: keys and buttons after every event up to t, plus the mouse motion and wheel summed
+* from the last advance() up to t. advance(t) samples, then makes t the start of the next sums, so a frame that
+* advances to just before it builds its view consumes exactly the motion that arrived since the previous frame did, and
+* events stamped later than t wait for the next frame rather than being lost. Knows nothing about Windows, so the core
+* can be driven by synthetic producers.
+* The consumer can add events of its own with inject (e.g. a replay), which queue up behind everything already
+* published without going through the ring, so the ring keeps its one producer; and advance can hand back the events it
+* folded in, so they can be recorded on the consumer's side too.
+*/
+
+class InputTimeline {
+public:
+	using Time = int64_t; // nanoseconds
+
+	struct Event {
+		enum class Type : uint8_t {
+			KEY_DOWN, KEY_UP, BUTTON_DOWN, BUTTON_UP, MOTION, WHEEL
+		};
+
+		Time time;
+		Type type;
+		uint8_t code; // virtual key, or button (Button)
+		int32_t x; // motion delta, or wheel delta
+		int32_t y;
+	};
+
+	enum Button : uint8_t {
+		LEFT, RIGHT, MIDDLE, X1, X2
+	};
+
+	struct State {
+		static constexpr unsigned int VIRTUAL_KEYS = 256u;
+
+		Time time;
+		std::bitset<VIRTUAL_KEYS> keys;
+		uint8_t buttons; // bit per Button
+		long dx; // motion since the last advance
+		long dy;
+		int wheel;
+
+		bool isKeyPressed(uint8_t key) const noexcept { return keys[key]; }
+		bool isButtonPressed(Button button) const noexcept { return buttons >> button & 1u; }
+	};
+
+	static constexpr size_t QUEUE_CAPACITY{ 4096u };
+private:
+	SpscRing<Event, QUEUE_CAPACITY> m_queue;
+	std::vector<Event> m_pending; // polled from the queue, not yet folded into m_base; in the order published
+	State m_base; // as of the last advance, with nothing summed
+public:
+	InputTimeline() noexcept;
+	~InputTimeline() = default;
+	// no copy init/assign
+	InputTimeline(const InputTimeline& o) = delete;
+	InputTimeline& operator=(const InputTimeline& o) = delete;
+
+	static Time now() noexcept;
+
+	// producer thread only; false if the queue was full and the event was dropped
+	bool publish(const Event& e) noexcept;
+	uint64_t getOverflowCount() const noexcept;
+
+	// consumer thread only
+	void inject(const Event& e); // after everything published so far; never dropped
+	State sample(Time time);
+	State advance(Time time);
+	State advance(Time time, std::vector<Event>& applied); // also appends the events it folded in, in order
+	size_t getPendingCount() const noexcept; // events received but later than the last advance
+private:
+	void poll();
+	size_t apply(State& state, Time time) const noexcept; // returns how many of m_pending were applied
+	void commit(const State& state, size_t applied) noexcept; // makes state the base, dropping what it applied
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef CWF_INSTANCEBATCHER_H
+#define CWF_INSTANCEBATCHER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional> // std::hash
+#include <vector>
+
+/*
+* CPU-side planner for instanced drawing; does not touch DirectX at all.
+* Objects are submitted one at a time as (key, per-instance data), where the key identifies what they can be batched
+* under (e.g. a pointer to their Material). plan() groups the submissions so every key owns one contiguous run of
+* instance data, ready to be handed to Material::setInstances and drawn with a single instanced draw call.
+* Batches come out in the order their key was first submitted, and instances keep their submission order within a batch.
+* Keys are looked up in a flat open-addressing table (linear probing) rather than a node-based map, so clear() keeps
+* every allocation and a frame that submits no more than earlier ones did allocates nothing.
+*/
+
+template <typename Key, typename Instance, typename Hash = std::hash<Key>>
+class InstanceBatcher {
+public:
+	struct Batch {
+		Key key;
+		size_t first; // index of the batch's first instance in instances()
+		size_t count;
+	};
+private:
+	struct Submission {
+		size_t batch;
+		Instance instance;
+	};
+
+	std::vector<Submission> m_submissions;
+	std::vector<Batch> m_batches;
+	std::vector<Instance> m_instances;
+	// key -> index into m_batches + 1, or 0 for an empty slot; a power of two in size, never more than half full
+	std::vector<size_t> m_batchLookup;
+	std::vector<size_t> m_cursors; // scratch for plan(), kept to avoid reallocating
+	Hash m_hash;
+public:
+	InstanceBatcher() = default;
+	~InstanceBatcher() = default;
+
+	void submit(const Key& key, const Instance& instance) {
+		if ((m_batches.size() + 1u) * 2u > m_batchLookup.size())
+			grow();
+		const size_t mask{ m_batchLookup.size() - 1u };
+		size_t slot{ home(key) & mask };
+		while (m_batchLookup[slot] != 0u && !(m_batches[m_batchLookup[slot] - 1u].key == key))
+			slot = (slot + 1u) & mask;
+		if (m_batchLookup[slot] == 0u) {
+			m_batches.push_back({ key, 0u, 0u });
+			m_batchLookup[slot] = m_batches.size();
+		}
+		const size_t batch{ m_batchLookup[slot] - 1u };
+		m_batches[batch].count++;
+		m_submissions.push_back({ batch, instance });
+	}
+
+	// counting sort: one pass to find where each batch starts, one pass to scatter, so O(submissions)
+	const std::vector<Batch>& plan() {
+		size_t first{ 0u };
+		for (Batch& b : m_batches) {
+			b.first = first;
+			first += b.count;
+		}
+
+		m_instances.resize(m_submissions.size());
+		m_cursors.resize(m_batches.size());
+		for (size_t i{ 0u }; i < m_batches.size(); i++)
+			m_cursors[i] = m_batches[i].first;
+		for (const Submission& s : m_submissions)
+			m_instances[m_cursors[s.batch]++] = s.instance;
+
+		return m_batches;
+	}
+
+	const std::vector<Batch>& batches() const noexcept {
+		return m_batches;
+	}
+
+	const std::vector<Instance>& instances() const noexcept {
+		return m_instances;
+	}
+
+	size_t submissionCount() const noexcept {
+		return m_submissions.size();
+	}
+
+	// keeps all allocations so that steady-state frames don't allocate
+	void clear() noexcept {
+		m_submissions.clear();
+		m_batches.clear();
+		m_instances.clear();
+		std::fill(m_batchLookup.begin(), m_batchLookup.end(), size_t{ 0u });
+	}
+private:
+	// std::hash of a pointer or an integer is often the value itself, so spread the high bits into the low ones
+	size_t home(const Key& key) const noexcept {
+		const uint64_t h{ static_cast<uint64_t>(m_hash(key)) * 0x9e3779b97f4a7c15ull };
+		return static_cast<size_t>(h ^ (h >> 32u));
+	}
+
+	void grow() {
+		m_batchLookup.assign(std::max<size_t>(16u, m_batchLookup.size() * 2u), 0u);
+		const size_t mask{ m_batchLookup.size() - 1u };
+		for (size_t i{ 0u }; i < m_batches.size(); i++) { // every key is distinct, so no comparisons needed
+			size_t slot{ home(m_batches[i].key) & mask };
+			while (m_batchLookup[slot] != 0u)
+				slot = (slot + 1u) & mask;
+			m_batchLookup[slot] = i + 1u;
+		}
+	}
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,11 @@
+#include "InputLog.h"
 #include "Keyboard.h"
 #include <bitset>
+#include <cstdint>
 #include <optional>
-#include <queue>
 
-Keyboard::Keyboard() : m_keyStates{}, m_characterBuffer{}, m_autorepeat{ true } {}
+Keyboard::Keyboard() : m_keyStates{}, m_keyEvents{}, m_characterBuffer{}, m_autorepeat{ true },
+	m_pRecorder{ nullptr } {}
 
 bool Keyboard::isKeyPressed(unsigned char key) {
 	if (key <= 0 || key >= VIRTUAL_KEYS) return false;
@@ -15,18 +17,15 @@ bool Keyboard::isEventQueueEmpty() const noexcept {
 }
 
 std::optional<Keyboard::Event> Keyboard::pollEventQueue() {
-	if (!m_keyEvents.empty()) {
-		Event e = m_keyEvents.front();
-		m_keyEvents.pop();
-		return e;
-	} else return {};
+	return m_keyEvents.pop();
 }
 
 void Keyboard::clearEventQueue() {
-	// although the underlying std::deque does have a clear()
-	// operation, it's the same complexity to just reassign,
-	// and now we can keep std::queue and abstract away the implementation
-	m_keyEvents = std::queue<Event>{};
+	m_keyEvents.clear();
+}
+
+uint64_t Keyboard::getEventOverflowCount() const noexcept {
+	return m_keyEvents.getOverflowCount();
 }
 
 bool Keyboard::isCharQueueEmpty() const noexcept {
@@ -34,18 +33,15 @@ bool Keyboard::isCharQueueEmpty() const noexcept {
 }
 
 std::optional<unsigned char> Keyboard::pollCharQueue() {
-	if (!m_characterBuffer.empty()) {
-		unsigned char c = m_characterBuffer.front();
-		m_characterBuffer.pop();
-		return c;
-	} else return {};
+	return m_characterBuffer.pop();
 }
 
 void Keyboard::clearCharQueue() {
-	// although the underlying std::deque does have a clear()
-	// operation, it's the same complexity to just reassign,
-	// and now we can keep std::queue and abstract away the implementation
-	m_characterBuffer = std::queue<unsigned char>{};
+	m_characterBuffer.clear();
+}
+
+uint64_t Keyboard::getCharOverflowCount() const noexcept {
+	return m_characterBuffer.getOverflowCount();
 }
 
 void Keyboard::enableAutorepeat() noexcept {
@@ -60,33 +56,17 @@ bool Keyboard::isAutorepeatEnabled() const noexcept {
 	return m_autorepeat;
 }
 
-inline void Keyboard::manageEventQueueSize() {
-	// we call this everytime we insert a new event,
-	// so the only time we need to make room is if
-	// the size is equal to the max size
-	if (m_keyEvents.size() == MAX_QUEUE_SIZE)
-		m_keyEvents.pop();
-}
-
-inline void Keyboard::manageCharQueueSize() {
-	// we call this everytime we insert a new char,
-	// so the only time we need to make room is if
-	// the size is equal to the max size
-	if (m_characterBuffer.size() == MAX_QUEUE_SIZE)
-		m_characterBuffer.pop();
-}
-
 void Keyboard::keyPressed(unsigned char key) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::KEY_PRESSED, key);
 	if (key >= 0 && key < VIRTUAL_KEYS) {
-		manageEventQueueSize();
 		m_keyStates[key] = true;
 		m_keyEvents.emplace(key, Event::Type::PRESSED);
 	}
 }
 
 void Keyboard::keyReleased(unsigned char key) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::KEY_RELEASED, key);
 	if (key >= 0 && key < VIRTUAL_KEYS) {
-		manageEventQueueSize();
 		m_keyStates[key] = false;
 		m_keyEvents.emplace(key, Event::Type::RELEASED);
 	}
@@ -94,7 +74,7 @@ void Keyboard::keyReleased(unsigned char key) {
 
 void Keyboard::characterTyped(unsigned char character) {
 	// no arg checking, only available to Window
-	manageCharQueueSize();
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::CHARACTER_TYPED, character);
 	m_characterBuffer.push(character);
 }
 
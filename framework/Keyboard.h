@@ -1,15 +1,19 @@
 #ifndef CWF_KEYBOARD_H
 #define CWF_KEYBOARD_H
 
+#include "InputLog.h"
+#include "SpscRing.h"
 #include <bitset>
+#include <cstdint>
 #include <optional>
-#include <queue>
 
+class InputReplayer;
 class Window;
 
 class Keyboard {
 public:
 	friend class Window;
+	friend class InputReplayer;
 	class Event {
 	public:
 		enum class Type {
@@ -28,12 +32,14 @@ public:
 	};
 private:
 	static constexpr unsigned int VIRTUAL_KEYS = 256u;
-	static constexpr unsigned int MAX_QUEUE_SIZE = 16u;
+	static constexpr unsigned int QUEUE_CAPACITY = 64u;
 	
 	std::bitset<VIRTUAL_KEYS> m_keyStates;
-	std::queue<Event> m_keyEvents;
-	std::queue<unsigned char> m_characterBuffer;
+	// filled by the message pump; may be polled from one other thread (see SpscRing.h), and drop new input when full
+	SpscRing<Event, QUEUE_CAPACITY> m_keyEvents;
+	SpscRing<unsigned char, QUEUE_CAPACITY> m_characterBuffer;
 	bool m_autorepeat;
+	InputLog::Recorder* m_pRecorder; // set by Window::setInputRecorder
 public:
 	Keyboard();
 	~Keyboard() = default;
@@ -47,18 +53,18 @@ public:
 	bool isEventQueueEmpty() const noexcept;
 	std::optional<Event> pollEventQueue();
 	void clearEventQueue();
+	uint64_t getEventOverflowCount() const noexcept; // events dropped because the queue was full
 
 	bool isCharQueueEmpty() const noexcept;
 	std::optional<unsigned char> pollCharQueue();
 	void clearCharQueue();
+	uint64_t getCharOverflowCount() const noexcept;
 
 	void enableAutorepeat() noexcept;
 	void disableAutorepeat() noexcept;
 	bool isAutorepeatEnabled() const noexcept;
 	
 private:
-	inline void manageEventQueueSize();
-	inline void manageCharQueueSize();
 	void keyPressed(unsigned char key);
 	void keyReleased(unsigned char key);
 	void characterTyped(unsigned char character);
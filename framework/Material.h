@@ -1,26 +1,59 @@
 #ifndef CWF_MATERIAL_H
 #define CWF_MATERIAL_H
 
+#include "BatchTransform.h"
+#include "ConstantBufferRing.h"
+#include "Culling.h"
 #include "Graphics.h"
+#include "InputLayout.h"
+#include "MeshRegistry.h"
+#include "PipelineCache.h"
+#include "RenderQueue.h"
 #include "ShaderStage.h"
+#include "StateCache.h"
 #include "Submaterial.h"
+#include "VertexQuantization.h"
 #include "lib/DirectXTK/DDSTextureLoader.h"
+#include <algorithm> // std::min, std::max
 #include <cstddef> // for std::byte
+#include <cstdint>
 #include <cstring> // for std::memcpy
 #include <d3d11.h>
+#include <DirectXMath.h>
 #include <initializer_list>
 #include <memory> // std::unique_ptr
 #include <optional>
+#include <span>
+#include <type_traits>
 #include <vector>
 #include <wrl.h>
 
 /*
 * A material is a class-like object, representing a type of DirectX object that uses the same shader,resources,etc.
 * You can add as many meshes as you want; they all just have to be of the same material.
+* Meshes are pooled into one vertex buffer and one index buffer (see MeshRegistry); each is drawn from its own range,
+* so its indices stay local to it, and any mesh can be hidden (setMeshVisible) without touching the others.
+* The index buffer's format is picked at setupPipeline from the largest index in use: R16 if every mesh fits, whatever
+* Index is; otherwise the IndexPolicy decides between splitting the big meshes into several R16 draws and promoting the
+* whole buffer to R32 (see MeshRegistry::pack).
 * An bershader is one large shader that uses conditionals to determine which code to execute; this means that we
 * don't have to load multiple shaders, which is expensive.
+*
+* Instancing: if any instances are added (addInstance/setInstances), the material draws all of its meshes once per
+* instance with one DrawIndexedInstancedIndirect per mesh. Each instance's world transform is fed to the vertex shader
+* through vertex buffer slot 1 with the semantic InstanceTransform (a row-major float4x4), so the shader must declare it.
+* The draw's instance count lives in a GPU argument buffer, so it can change every frame without rebuilding the
+* command list; only the capacity is fixed at setupPipeline. Submaterials draw the same instances from argument buffers
+* of their own (their meshes' parts are not the material's), which updateInstances refreshes along with the material's.
+*
+* Dynamic (non-read-only) constant buffers can either be updated one Map at a time (updateCopyConstantBuffer, then
+* draw(gfx)), or suballocated from a per-frame ConstantBufferRing (stageConstantBuffers, then draw(gfx, ring)), which
+* maps once per frame for all materials. The ring path binds the pipeline on the immediate context rather than
+* replaying the baked command list, since a command list cannot pick up per-frame buffer offsets.
 */
 
+namespace math = DirectX;
+
 template <class Vertex, typename Index>
 class Material {
 private:
@@ -35,20 +68,35 @@ private:
 		size_t length;
 		ShaderStage stage;
 		bool readOnly;
-		ConstantBuffer(const void* p, size_t l, ShaderStage s, bool r) 
-			: pBuffer{ p }, length{ l }, stage{ s }, readOnly{ r }{}
+		UINT slot; // register within its stage
+		std::byte* pCopy; // our own copy of the data, if copied
+		ConstantBuffer(const void* p, size_t l, ShaderStage s, bool r, UINT sl, std::byte* c = nullptr)
+			: pBuffer{ p }, length{ l }, stage{ s }, readOnly{ r }, slot{ sl }, pCopy{ c } {}
+	};
+public:
+	static constexpr D3D11_INPUT_ELEMENT_DESC s_instanceLayout[]{
+		{"InstanceTransform", 0u, DXGI_FORMAT_R32G32B32A32_FLOAT, 1u, 0u, D3D11_INPUT_PER_INSTANCE_DATA, 1u},
+		{"InstanceTransform", 1u, DXGI_FORMAT_R32G32B32A32_FLOAT, 1u, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1u},
+		{"InstanceTransform", 2u, DXGI_FORMAT_R32G32B32A32_FLOAT, 1u, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1u},
+		{"InstanceTransform", 3u, DXGI_FORMAT_R32G32B32A32_FLOAT, 1u, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1u}
 	};
 private:
 	// set by user
 	D3D11_PRIMITIVE_TOPOLOGY m_primitiveTopology;
 	const D3D11_INPUT_ELEMENT_DESC* m_pDescriptions;
 	size_t m_numberOfDescs;
-	DXGI_FORMAT m_indexFormat;
-	std::vector<Vertex> m_vtx;
-	std::vector<Index> m_idx;
+	DXGI_FORMAT m_indexFormat; // picked in createResources
+	IndexPolicy m_indexPolicy;
+	MeshRegistry<Vertex, Index> m_meshes;
+	unsigned m_meshOptimization; // MeshOptimizer::Stage bits
+	std::vector<MeshOptimizer::Report> m_optimizationReports;
 	std::vector<std::unique_ptr<std::byte[]>> m_copiedConstantBuffers;
 	std::vector<std::unique_ptr<std::byte[], Graphics::AlignedDeleter>> m_copiedAlignedConstantBuffers;
 	std::vector<ConstantBuffer> m_cBuffers;
+	std::vector<ConstantBufferRing::Allocation> m_ringAllocations; // parallel to m_cBuffers
+	std::vector<math::XMFLOAT4X4> m_instances;
+	size_t m_instanceCapacity;
+	std::vector<Submaterial<Vertex, Index>*> m_submaterials; // attached by their constructors, for updateInstances
 	Shader m_vs;
 	std::optional<Shader> m_oPS;
 	std::optional<Microsoft::WRL::ComPtr<ID3D11RenderTargetView>> m_oPRTV;
@@ -67,6 +115,13 @@ private:
 			Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer{};
 		} index{};
 		struct {
+			Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer{};
+			Microsoft::WRL::ComPtr<ID3D11Buffer> pArgs{}; // D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS, one per mesh part
+			UINT stride{};
+			UINT offset{};
+		} instance{};
+		struct {
+			std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> buffers{}; // parallel to m_cBuffers
 			std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> vertexBuffers{};
 			std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> pixelBuffers{};
 			std::vector<ID3D11Buffer*> vertexRawBuffers{};
@@ -85,53 +140,231 @@ private:
 
 	// generated by DirectX
 	Microsoft::WRL::ComPtr<ID3D11CommandList> m_pCmdList;
+	std::vector<bool> m_recordedVisibility; // which meshes m_pCmdList draws
 
 public:
-	Material(DXGI_FORMAT indexFormat) : m_primitiveTopology{}, m_numberOfDescs{}, m_indexFormat{ indexFormat } {}
+	using MeshId = typename MeshRegistry<Vertex, Index>::MeshId;
+
+	Material(IndexPolicy indexPolicy = IndexPolicy::SPLIT) : m_primitiveTopology{}, m_pDescriptions{}, m_numberOfDescs{},
+		m_indexFormat{ DXGI_FORMAT_R16_UINT }, m_indexPolicy{ indexPolicy }, m_meshes{},
+		m_meshOptimization{ MeshOptimizer::NONE }, m_optimizationReports{}, m_instanceCapacity{}, m_submaterials{},
+		m_recordedVisibility{} {}
 
+	// R16 or R32, decided at setupPipeline
 	DXGI_FORMAT getIndexFormat() const noexcept {
 		return m_indexFormat;
 	}
 
+	// what to do with meshes that don't fit 16-bit indices; only read at setupPipeline (submaterials use it too)
+	void setIndexPolicy(IndexPolicy indexPolicy) noexcept {
+		m_indexPolicy = indexPolicy;
+	}
+
+	IndexPolicy getIndexPolicy() const noexcept {
+		return m_indexPolicy;
+	}
+
 	// do not interact with DirectX
 	void setTopology(D3D11_PRIMITIVE_TOPOLOGY primitiveTopology) noexcept {
 		m_primitiveTopology = primitiveTopology;
 	}
 
+	// optional for vertex types with a Layout (see InputLayout.h), which is used if nothing is set
 	void setInputLayout(const D3D11_INPUT_ELEMENT_DESC* pDescriptions, size_t size) noexcept {
 		m_pDescriptions = pDescriptions;
 		m_numberOfDescs = size;
 	}
 
-	void addMesh(std::initializer_list<Vertex> vertices, std::initializer_list<Index> indices) noexcept {
-		m_vtx.insert(m_vtx.cend(), vertices);
-		m_idx.insert(m_idx.cend(), indices);
+	// indices are local to the mesh (0 is its first vertex); meshes must be added before setupPipeline
+	MeshId addMesh(std::initializer_list<Vertex> vertices, std::initializer_list<Index> indices) noexcept {
+		return m_meshes.add(vertices, indices);
+	}
+
+	MeshId addMesh(const std::vector<Vertex>& vertices, const std::vector<Index>& indices) noexcept {
+		return m_meshes.add(vertices, indices);
+	}
+
+	MeshId addMesh(const Graphics::IndexedVertexList<Vertex, Index>& mesh) noexcept {
+		return m_meshes.add(mesh.vertices, mesh.indices);
+	}
+
+	// quantizes a full-precision mesh into this material's packed Vertex as it is added (see VertexQuantization.h);
+	// the report has the error and, for box-relative formats, the bounds to decode with
+	template <class Source> requires (!std::is_same_v<Source, Vertex>)
+	MeshId addMesh(const Graphics::IndexedVertexList<Source, Index>& mesh, VertexQuantization::Report* pReport = nullptr) {
+		return m_meshes.add(VertexQuantization::quantize<Vertex, Source>(mesh.vertices, pReport), mesh.indices);
+	}
+
+	/*
+	* Bakes one copy of a mesh per transform. Copies are packed into as few meshes as 16-bit indices allow (at most 65536
+	* vertices each, so they never need splitting), with their indices rebased within their mesh, and written straight
+	* into the vertex/index pools. The mesh's positions are given as structure-of-arrays (see BatchTransform.h);
+	* makeVertex(x, y, z, i) builds the stored vertex for local vertex i at transformed position (x, y, z).
+	* Returns the id of the first mesh added, or std::nullopt if transforms is empty (nothing is added then).
+	*/
+	template <typename MakeVertex>
+	std::optional<MeshId> addTransformedMeshes(const BatchTransform::Points& local, std::span<const Index> indices,
+		std::span<const math::XMFLOAT4X4> transforms, MakeVertex makeVertex) {
+		if (transforms.empty()) return std::nullopt;
+		constexpr size_t BLOCK{ 256u }; // transforms per SIMD batch
+		const size_t maxVertices{ static_cast<size_t>(MeshRegistry<Vertex, Index>::MAX_INDEX_16) + 1u };
+		const size_t copiesPerMesh{ std::max<size_t>(1u, std::min(maxVertices / std::max<size_t>(local.count, 1u), transforms.size())) };
+
+		std::vector<float> transformed(std::min(BLOCK, transforms.size()) * local.count * 3u);
+		const BatchTransform::Output out{
+			transformed.data(),
+			transformed.data() + transformed.size() / 3u,
+			transformed.data() + transformed.size() / 3u * 2u
+		};
+
+		const MeshId first{ m_meshes.size() };
+		m_meshes.reserve(m_meshes.vertices().size() + transforms.size() * local.count, 
+			m_meshes.indices().size() + transforms.size() * indices.size());
+		for (size_t meshStart{ 0u }; meshStart < transforms.size(); meshStart += copiesPerMesh) {
+			const size_t copies{ std::min(copiesPerMesh, transforms.size() - meshStart) };
+			m_meshes.add(copies * local.count, copies * indices.size(), [&](std::vector<Vertex>& vertices, std::vector<Index>& pool) {
+				for (size_t blockStart{ 0u }; blockStart < copies; blockStart += BLOCK) {
+					const size_t blockCount{ std::min(BLOCK, copies - blockStart) };
+					BatchTransform::transformPoints(&transforms[meshStart + blockStart].m[0][0], blockCount, local, out);
+					for (size_t c{ 0u }; c < blockCount; c++) {
+						const size_t src{ c * local.count };
+						for (size_t i{ 0u }; i < local.count; i++)
+							vertices.push_back(makeVertex(out.x[src + i], out.y[src + i], out.z[src + i], i));
+						const Index base{ static_cast<Index>((blockStart + c) * local.count) };
+						for (Index index : indices)
+							pool.push_back(static_cast<Index>(index + base));
+					}
+				}
+			});
+		}
+		return first;
+	}
+
+	// hidden meshes are skipped by draw(gfx, ring) and draw(gfx); the latter records its command list again when the
+	// visible set has changed since, so prefer the ring where meshes are culled every frame
+	void setMeshVisible(MeshId id, bool visible) noexcept {
+		m_meshes.setVisible(id, visible);
+	}
+
+	// hides the meshes entirely outside the camera's view until the next cull (returns how many may be visible); world
+	// is what the meshes are drawn with, the identity if they were baked in world space. The culler doesn't know the
+	// instances' transforms, so a material with instances is never culled.
+	size_t XM_CALLCONV cull(const Graphics& gfx, math::FXMMATRIX world = math::XMMatrixIdentity()) noexcept {
+		if (!m_instances.empty()) {
+			m_meshes.uncull();
+			return m_meshes.size();
+		}
+		math::XMFLOAT4X4 worldViewProjection{};
+		math::XMStoreFloat4x4(&worldViewProjection, math::XMMatrixMultiply(world, gfx.getViewProjection()));
+		return m_meshes.cull(Culling::frustum(&worldViewProjection._11));
 	}
 
-	void addMesh(std::vector<Vertex> vertices, std::vector<Index> indices) noexcept {
-		m_vtx.insert(m_vtx.cend(), vertices.begin(), vertices.end());
-		m_idx.insert(m_idx.cend(), indices.begin(), indices.end());
+	size_t cull(const Culling::Frustum& frustum) noexcept { // in the meshes' own space
+		return m_meshes.cull(frustum);
 	}
 
-	void addMesh(const Graphics::IndexedVertexList<Vertex, Index>& mesh) noexcept {
-		m_vtx.insert(m_vtx.cend(), mesh.vertices.begin(), mesh.vertices.end());
-		m_idx.insert(m_idx.cend(), mesh.indices.begin(), mesh.indices.end());
+	void uncull() noexcept {
+		m_meshes.uncull();
+	}
+
+	const MeshRegistry<Vertex, Index>& getMeshes() const noexcept {
+		return m_meshes;
+	}
+
+	// reorders each mesh's indices and vertices at setupPipeline (see MeshOptimizer.h); only for triangle lists
+	void setMeshOptimization(unsigned stages = MeshOptimizer::ALL) noexcept {
+		m_meshOptimization = stages;
+	}
+
+	unsigned getMeshOptimization() const noexcept {
+		return m_meshOptimization;
+	}
+
+	bool shouldOptimizeMeshes() const noexcept {
+		return m_meshOptimization != MeshOptimizer::NONE && m_primitiveTopology == D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	}
+
+	// ACMR/ATVR before and after, one per mesh; empty until setupPipeline has optimized
+	const std::vector<MeshOptimizer::Report>& getOptimizationReports() const noexcept {
+		return m_optimizationReports;
+	}
+
+	// returns the index of the new instance
+	size_t XM_CALLCONV addInstance(math::FXMMATRIX world) {
+		math::XMStoreFloat4x4(&m_instances.emplace_back(), world);
+		return m_instances.size() - 1;
+	}
+
+	void XM_CALLCONV setInstance(size_t index, math::FXMMATRIX world) {
+		if (index < m_instances.size())
+			math::XMStoreFloat4x4(&m_instances[index], world);
+	}
+
+	// replaces every instance, e.g. with one batch planned by an InstanceBatcher
+	void setInstances(const math::XMFLOAT4X4* pWorlds, size_t count) {
+		m_instances.assign(pWorlds, pWorlds + count);
+	}
+
+	// makes room for instances added after setupPipeline; does nothing once the pipeline exists
+	void reserveInstances(size_t capacity) noexcept {
+		if (!m_pCmdList && capacity > m_instanceCapacity) m_instanceCapacity = capacity;
+	}
+
+	size_t getInstanceCount() const noexcept {
+		return m_instances.size();
+	}
+
+	// how many instances a draw covers: every instance, up to the capacity
+	UINT getDrawnInstanceCount() const noexcept {
+		return static_cast<UINT>(std::min(m_instances.size(), m_instanceCapacity));
+	}
+
+	bool isInstanced() const noexcept {
+		return m_instanceCapacity > 0u || !m_instances.empty();
+	}
+
+	// uploads all instances with one map and updates the draw's instance count, the submaterials' too; instances past
+	// the capacity are not drawn
+	void updateInstances(const Graphics& gfx) {
+		if (!Data.instance.pBuffer) return;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> pImmediateContext{ gfx.getImmediateContext() };
+		const UINT count{ getDrawnInstanceCount() };
+		if (count > 0u) {
+			D3D11_MAPPED_SUBRESOURCE mappedResource{ 0 };
+			THROW_IF_FAILED(gfx,
+				pImmediateContext->Map(Data.instance.pBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource));
+			std::memcpy(mappedResource.pData, m_instances.data(), count * sizeof(math::XMFLOAT4X4));
+			pImmediateContext->Unmap(Data.instance.pBuffer.Get(), 0);
+		}
+		const std::vector<D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS> args{ indirectArgs(m_meshes, count) };
+		pImmediateContext->UpdateSubresource(Data.instance.pArgs.Get(), 0u, nullptr, args.data(), 0u, 0u);
+		for (Submaterial<Vertex, Index>* pSubmaterial : m_submaterials)
+			pSubmaterial->updateInstanceCount(gfx, count);
+	}
+
+	// called by Submaterial's constructor and destructor
+	void attach(Submaterial<Vertex, Index>* pSubmaterial) {
+		m_submaterials.push_back(pSubmaterial);
+	}
+
+	void detach(Submaterial<Vertex, Index>* pSubmaterial) noexcept {
+		m_submaterials.erase(std::remove(m_submaterials.begin(), m_submaterials.end(), pSubmaterial), m_submaterials.end());
 	}
 
 	void addConstantBuffer(const void* pBuffer, size_t byteWidth, ShaderStage stage, bool readOnly = true) noexcept {
-		m_cBuffers.emplace_back(pBuffer, byteWidth, stage, readOnly);
+		m_cBuffers.emplace_back(pBuffer, byteWidth, stage, readOnly, nextSlot(stage));
 	}
 
 	void copyConstantBuffer(const void* pBuffer, size_t byteWidth, ShaderStage stage, bool readOnly = true, bool aligned = false) {
 		if (!aligned) {
 			auto copiedBuffer = std::make_unique<std::byte[]>(byteWidth);
 			std::memcpy(copiedBuffer.get(), pBuffer, byteWidth);
-			m_cBuffers.emplace_back(copiedBuffer.get(), byteWidth, stage, readOnly);
+			m_cBuffers.emplace_back(copiedBuffer.get(), byteWidth, stage, readOnly, nextSlot(stage), copiedBuffer.get());
 			m_copiedConstantBuffers.push_back(std::move(copiedBuffer));
 		} else {
 			void* raw = _aligned_malloc(byteWidth, 16);
 			std::memcpy(raw, pBuffer, byteWidth);
-			m_cBuffers.emplace_back(raw, byteWidth, stage, readOnly);
+			m_cBuffers.emplace_back(raw, byteWidth, stage, readOnly, nextSlot(stage), reinterpret_cast<std::byte*>(raw));
 			m_copiedAlignedConstantBuffers.push_back(std::unique_ptr<std::byte[], Graphics::AlignedDeleter>{ reinterpret_cast<std::byte*>(raw) });
 		}
 	}
@@ -140,26 +373,30 @@ public:
 		if (index >= m_cBuffers.size() || m_cBuffers[index].readOnly || !m_pCmdList) return;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> pImmediateContext{ gfx.getImmediateContext() };
 		D3D11_MAPPED_SUBRESOURCE mappedResource{ 0 };
-		ID3D11Buffer* pConstantBuffer{};
-		switch (m_cBuffers[index].stage) {
-		case ShaderStage::VERTEX:
-			pConstantBuffer = Data.constant.vertexRawBuffers[index];
-			break;
-		case ShaderStage::PIXEL:
-			pConstantBuffer = Data.constant.pixelRawBuffers[index];
-			break;
-		default:
-#ifndef NDEBUG
-			OutputDebugStringW(L"Update your other stage switch, dumb dumb.\n");
-#endif
-			return;
-		}
+		ID3D11Buffer* pConstantBuffer{ Data.constant.buffers[index].Get() };
 		THROW_IF_FAILED(gfx, 
 			pImmediateContext->Map(pConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource));
 		std::memcpy(mappedResource.pData, pBuffer, byteWidth);
 		pImmediateContext->Unmap(pConstantBuffer, 0);
 	}
 
+	// cheap: only updates our CPU-side copy, which stageConstantBuffers picks up (buffers added with addConstantBuffer
+	// are read straight from the caller's memory, so they never need this)
+	void setCopyConstantBuffer(size_t index, const void* pBuffer, size_t byteWidth) noexcept {
+		if (index >= m_cBuffers.size() || !m_cBuffers[index].pCopy) return;
+		std::memcpy(m_cBuffers[index].pCopy, pBuffer, std::min(byteWidth, m_cBuffers[index].length));
+	}
+
+	// copies the current contents of every dynamic constant buffer into the ring; call between ring.beginFrame()
+	// and ring.endUpdates()
+	void stageConstantBuffers(ConstantBufferRing& ring) {
+		m_ringAllocations.resize(m_cBuffers.size());
+		for (size_t i{ 0u }; i < m_cBuffers.size(); i++) {
+			if (!m_cBuffers[i].readOnly)
+				m_ringAllocations[i] = ring.allocate(m_cBuffers[i].pBuffer, m_cBuffers[i].length);
+		}
+	}
+
 	void setVertexShader(const void* pByteCode, size_t length, bool bind = true) noexcept {
 		m_vs = { pByteCode, length, bind };
 	}
@@ -167,6 +404,15 @@ public:
 	void setPixelShader(const void* pByteCode, size_t length) noexcept {								   // optional
 		m_oPS = { pByteCode, length, true };
 	}
+
+	// e.g. a ShaderPack blob, used in place; the bytes only have to stay valid until setupPipeline
+	void setVertexShader(std::span<const std::byte> byteCode, bool bind = true) noexcept {
+		setVertexShader(byteCode.data(), byteCode.size(), bind);
+	}
+
+	void setPixelShader(std::span<const std::byte> byteCode) noexcept {
+		setPixelShader(byteCode.data(), byteCode.size());
+	}
 	
 	void setRenderTarget(Microsoft::WRL::ComPtr<ID3D11RenderTargetView> renderTarget, 
 		Microsoft::WRL::ComPtr<ID3D11DepthStencilView> zbuffer) noexcept {								   // optional
@@ -196,24 +442,96 @@ public:
 
 	void setupPipeline(const Graphics& gfx) {
 		if (m_pCmdList) return; // do not re-generate resources
-
-		Microsoft::WRL::ComPtr<ID3D11Device> pDevice{ gfx.getDevice() };
-		
-		Microsoft::WRL::ComPtr<ID3D11DeviceContext> pDeferred;
-		THROW_IF_FAILED(gfx, pDevice->CreateDeferredContext(0, &pDeferred));
-
-		setupPipeline(gfx, pDeferred, m_pCmdList);
+		record(gfx);
 	}
 
 	//  should call in another thread for optimal performance
+	//  pMeshes: what to draw (a submaterial passes its own meshes, and pArgs, their indirect arguments if instanced);
+	//  this material's meshes if null
 	void setupPipeline(const Graphics& gfx, Microsoft::WRL::ComPtr<ID3D11DeviceContext> pDeferred, 
-		Microsoft::WRL::ComPtr<ID3D11CommandList>& pListToFill, bool submaterialCalling = false) {
+		Microsoft::WRL::ComPtr<ID3D11CommandList>& pListToFill, bool submaterialCalling = false,
+		const MeshRegistry<Vertex, Index>* pMeshes = nullptr, ID3D11Buffer* pArgs = nullptr) {
+		createResources(gfx, submaterialCalling);
+		DeferredStateCache cache{ pDeferred.Get() };
+		bindPipeline(cache, submaterialCalling);
+
+		// draw command
+		if (pMeshes) issueDraw(pDeferred.Get(), *pMeshes, pArgs);
+		else issueDraw(pDeferred.Get());
+
+		// generate command list
+		THROW_IF_FAILED(gfx, pDeferred->FinishCommandList(FALSE, &pListToFill));
+	}
+
+	// call on main thread; a mesh hidden, shown or culled since the command list was recorded has it recorded again
+	void draw(const Graphics& gfx) {
+		if (m_pCmdList && !m_meshes.hasVisibility(m_recordedVisibility)) record(gfx);
+		gfx.executeCommandList(m_pCmdList.Get());
+	}
+
+	// call on main thread, after stageConstantBuffers and ring.endUpdates(); requires setupPipeline first
+	// skip is a mask of RenderQueue::Skip bits for state the previous draw already bound
+	void draw(const Graphics& gfx, const ConstantBufferRing& ring, unsigned skip = RenderQueue::SKIP_NONE) {
+		if (!m_pCmdList) return;
+		StateCache& cache{ gfx.getStateCache() };
+		bindPipeline(cache, false, skip);
+		bindRingConstantBuffers(ring);
+		issueDraw(cache.getContext());
+	}
+
+	// queues draw(gfx, ring) for RenderQueue::execute; depth is normalized view depth, for front-to-back ordering
+	void submit(RenderQueue& queue, float depth = 0.0f, uint8_t layer = 0u) {
+		const uint64_t key{ RenderQueue::SortKey::make(layer, queue.idFor(getShaderState()), queue.idFor(getTextureState()), depth) };
+		queue.submit(key, this, [](const void* pObject, const Graphics& gfx, const ConstantBufferRing& ring, unsigned skip) {
+			const_cast<Material*>(static_cast<const Material*>(pObject))->draw(gfx, ring, skip);
+		}, getPipelineState(), getTextureState());
+	}
+
+	// identify the state bindPipeline binds, for RenderQueue: shaders, layout, topology, target and viewport belong
+	// to the material (its submaterials share them), the texture is its shader resource view
+	uint64_t getPipelineState() const noexcept {
+		return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(this));
+	}
+
+	// the shader objects, which the pipeline cache shares between materials; the sort key groups by this, so materials
+	// using the same shaders draw back to back and the state cache elides the rebinds
+	uint64_t getShaderState() const noexcept {
+		const uint64_t vs{ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(Data.shader.pVertex.Get())) };
+		const uint64_t ps{ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(Data.shader.pPixel.Get())) };
+		return vs ^ (ps * 0x9E3779B97F4A7C15ull);
+	}
+
+	uint64_t getTextureState() const noexcept {
+		return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(Data.texture2D.pSRView.Get()));
+	}
+
+	// binds the ring slices from the last stageConstantBuffers over the material's own dynamic constant buffers
+	void bindRingConstantBuffers(const ConstantBufferRing& ring) const {
+		for (size_t i{ 0u }; i < m_ringAllocations.size(); i++) {
+			if (!m_cBuffers[i].readOnly && m_ringAllocations[i].pBuffer)
+				ring.bind(m_cBuffers[i].stage, m_cBuffers[i].slot, m_ringAllocations[i]);
+		}
+	}
+
+	// creates every resource the pipeline needs; anything already created is kept
+	void createResources(const Graphics& gfx, bool submaterialCalling = false) {
 		Microsoft::WRL::ComPtr<ID3D11Device> pDevice{ gfx.getDevice() };
 
+		// optional index/vertex reordering, before the buffers are filled
+		if (!submaterialCalling && !Data.vertex.pBuffer && shouldOptimizeMeshes())
+			m_optimizationReports = m_meshes.optimize(m_meshOptimization);
+
+		// index format, and the vertices/indices as they will be uploaded
+		const bool fillBuffers{ !submaterialCalling && (!Data.vertex.pBuffer || !Data.index.pBuffer) };
+		const auto packed{ fillBuffers ? m_meshes.pack(m_indexPolicy) : typename MeshRegistry<Vertex, Index>::Packed{} };
+		if (fillBuffers)
+			m_indexFormat = packed.wide ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+
 		// vertex buffer
-		if (!submaterialCalling) {
+		if (!submaterialCalling && !Data.vertex.pBuffer) {
+			const std::span<const Vertex> vertices{ m_meshes.vertexData(packed) };
 			D3D11_BUFFER_DESC vtxDesc{};
-			vtxDesc.ByteWidth = m_vtx.size() * sizeof(Vertex);
+			vtxDesc.ByteWidth = vertices.size() * sizeof(Vertex);
 			vtxDesc.Usage = D3D11_USAGE_DEFAULT;
 			vtxDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 			vtxDesc.CPUAccessFlags = 0u;
@@ -221,36 +539,71 @@ public:
 			vtxDesc.StructureByteStride = sizeof(Vertex);
 
 			D3D11_SUBRESOURCE_DATA vtxData{};
-			vtxData.pSysMem = m_vtx.data();
+			vtxData.pSysMem = vertices.data();
 
 			THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&vtxDesc, &vtxData, &Data.vertex.pBuffer));
 
 			Data.vertex.stride = sizeof(Vertex);
 			Data.vertex.offset = 0u;
-
-			pDeferred->IASetVertexBuffers(0u, 1u, Data.vertex.pBuffer.GetAddressOf(), &Data.vertex.stride, &Data.vertex.offset);
 		}
 
 		// index buffer
-		if (!submaterialCalling) {
+		if (!submaterialCalling && !Data.index.pBuffer) {
+			const std::span<const std::byte> indices{ m_meshes.indexData(packed) };
 			D3D11_BUFFER_DESC idxDesc{};
-			idxDesc.ByteWidth = m_idx.size() * sizeof(Index);
+			idxDesc.ByteWidth = indices.size();
 			idxDesc.Usage = D3D11_USAGE_DEFAULT;
 			idxDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 			idxDesc.CPUAccessFlags = 0u;
 			idxDesc.MiscFlags = 0u;
-			idxDesc.StructureByteStride = sizeof(Index);
+			idxDesc.StructureByteStride = packed.wide ? sizeof(uint32_t) : sizeof(uint16_t);
 
 			D3D11_SUBRESOURCE_DATA idxData{};
-			idxData.pSysMem = m_idx.data();
+			idxData.pSysMem = indices.data();
 
 			THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&idxDesc, &idxData, &Data.index.pBuffer));
+		}
+
+		// instance buffer and indirect draw arguments
+		if (isInstanced() && !Data.instance.pBuffer) { // shared by submaterials, so only generate once
+			m_instanceCapacity = std::max(m_instanceCapacity, m_instances.size());
+
+			D3D11_BUFFER_DESC instDesc{};
+			instDesc.ByteWidth = m_instanceCapacity * sizeof(math::XMFLOAT4X4);
+			instDesc.Usage = D3D11_USAGE_DYNAMIC;
+			instDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			instDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			instDesc.MiscFlags = 0u;
+			instDesc.StructureByteStride = sizeof(math::XMFLOAT4X4);
+
+			std::vector<math::XMFLOAT4X4> initial{ m_instances };
+			initial.resize(m_instanceCapacity);
+			D3D11_SUBRESOURCE_DATA instData{};
+			instData.pSysMem = initial.data();
+
+			THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&instDesc, &instData, &Data.instance.pBuffer));
+
+			Data.instance.stride = sizeof(math::XMFLOAT4X4);
+			Data.instance.offset = 0u;
+
+			const std::vector<D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS> args{ indirectArgs(m_meshes, getDrawnInstanceCount()) };
+
+			D3D11_BUFFER_DESC argsDesc{};
+			argsDesc.ByteWidth = args.size() * sizeof(D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS);
+			argsDesc.Usage = D3D11_USAGE_DEFAULT;
+			argsDesc.BindFlags = 0u;
+			argsDesc.CPUAccessFlags = 0u;
+			argsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+			argsDesc.StructureByteStride = 0u;
+
+			D3D11_SUBRESOURCE_DATA argsData{};
+			argsData.pSysMem = args.data();
 
-			pDeferred->IASetIndexBuffer(Data.index.pBuffer.Get(), m_indexFormat, 0u);
+			THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&argsDesc, &argsData, &Data.instance.pArgs));
 		}
 
 		// constant buffer
-		if (!submaterialCalling) {
+		if (!submaterialCalling && Data.constant.buffers.empty()) {
 			for (ConstantBuffer& cb : m_cBuffers) {
 				D3D11_BUFFER_DESC cbDesc{};
 				cbDesc.ByteWidth = cb.length;
@@ -265,6 +618,7 @@ public:
 
 				Microsoft::WRL::ComPtr<ID3D11Buffer> pCBuff;
 				THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&cbDesc, &cbData, &pCBuff));
+				Data.constant.buffers.push_back(pCBuff);
 
 				switch (cb.stage) {
 				case ShaderStage::VERTEX:
@@ -283,137 +637,198 @@ public:
 				Data.constant.vertexRawBuffers.push_back(comPtr.Get());
 			for (auto& comPtr : Data.constant.pixelBuffers)
 				Data.constant.pixelRawBuffers.push_back(comPtr.Get());
-			if (!Data.constant.vertexRawBuffers.empty())
-				pDeferred->VSSetConstantBuffers(0u, Data.constant.vertexRawBuffers.size(), Data.constant.vertexRawBuffers.data());
-			if (!Data.constant.pixelRawBuffers.empty())
-				pDeferred->VSSetConstantBuffers(0u, Data.constant.pixelRawBuffers.size(), Data.constant.pixelRawBuffers.data());
 		}
 
-		// primitive topology
-		{
-			pDeferred->IASetPrimitiveTopology(m_primitiveTopology);
-		}
+		// shaders, input layout and sampler come from the pipeline cache, shared with every material asking for the same
+		PipelineCache& pipelines{ gfx.getPipelineCache() };
 
 		// vertex shader
-		{
-			if (m_vs.bind) {
-				if (!Data.shader.pVertex) // if already generated, skip
-					THROW_IF_FAILED(gfx, pDevice->CreateVertexShader(m_vs.pByteCode, m_vs.length, nullptr, &Data.shader.pVertex));
-				pDeferred->VSSetShader(Data.shader.pVertex.Get(), nullptr, 0u);
-			}
-		}
+		if (m_vs.bind && !Data.shader.pVertex)
+			Data.shader.pVertex = pipelines.vertexShader(gfx, m_vs.pByteCode, m_vs.length);
 
 		// pixel shader
-		{
-			if (m_oPS) {
-				if (!Data.shader.pPixel) // if already generated, skip
-					THROW_IF_FAILED(gfx, pDevice->CreatePixelShader(m_oPS->pByteCode, m_oPS->length, nullptr, &Data.shader.pPixel));
-				pDeferred->PSSetShader(Data.shader.pPixel.Get(), nullptr, 0u);
-			}
-		}
+		if (m_oPS && !Data.shader.pPixel)
+			Data.shader.pPixel = pipelines.pixelShader(gfx, m_oPS->pByteCode, m_oPS->length);
 
 		// input layout
-		{
-			if (!Data.pLayout) // if already generated, skip
-				THROW_IF_FAILED(gfx, pDevice->CreateInputLayout(m_pDescriptions, m_numberOfDescs, m_vs.pByteCode, m_vs.length, &Data.pLayout));
-			pDeferred->IASetInputLayout(Data.pLayout.Get());
+		if (!Data.pLayout) {
+			if constexpr (requires { typename Vertex::Layout; }) {
+				if (!m_pDescriptions) // nothing set, so derive it from the vertex type
+					setInputLayout(InputLayout::d3d<Vertex>.data(), InputLayout::d3d<Vertex>.size());
+			}
+			if (isInstanced()) { // per-vertex elements from the user, followed by the per-instance transform
+				std::vector<D3D11_INPUT_ELEMENT_DESC> descs{ m_pDescriptions, m_pDescriptions + m_numberOfDescs };
+				descs.insert(descs.cend(), std::begin(s_instanceLayout), std::end(s_instanceLayout));
+				Data.pLayout = pipelines.inputLayout(gfx, descs.data(), descs.size(), m_vs.pByteCode, m_vs.length);
+			} else {
+				Data.pLayout = pipelines.inputLayout(gfx, m_pDescriptions, m_numberOfDescs, m_vs.pByteCode, m_vs.length);
+			}
 		}
 
-		// render target and z buffer
-		{
-			if (m_oPRTV) {
-				pDeferred->OMSetRenderTargets(1u, m_oPRTV->GetAddressOf(), m_oPDSV->Get());
+		// texture
+		if (m_oTex2D && !Data.texture2D.pSRView) {
+			bool valid_type{ true };
+			if (std::holds_alternative<Graphics::Texture2D::RawData>(m_oTex2D->content)) {
+				Graphics::Texture2D::RawData& rd{ std::get<Graphics::Texture2D::RawData>(m_oTex2D->content) };
+				D3D11_TEXTURE2D_DESC textureDesc{};
+				textureDesc.Width = rd.width;
+				textureDesc.Height = rd.height;
+				textureDesc.MipLevels = rd.mipLevels;
+				textureDesc.ArraySize = rd.arraySize;
+				textureDesc.Format = rd.format;
+				textureDesc.SampleDesc.Count = rd.sampleCount;
+				textureDesc.SampleDesc.Quality = rd.sampleQuality;
+				textureDesc.Usage = D3D11_USAGE_DEFAULT;
+				textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+				textureDesc.CPUAccessFlags = rd.cpuAccessFlags;
+				textureDesc.MiscFlags = rd.miscFlags;
+
+				D3D11_SUBRESOURCE_DATA textureData{};
+				textureData.pSysMem = rd.pData;
+				textureData.SysMemPitch = rd.pitch;
+
+				Microsoft::WRL::ComPtr<ID3D11Texture2D> pTexture;
+				THROW_IF_FAILED(gfx, pDevice->CreateTexture2D(&textureDesc, &textureData, &pTexture));
+
+				D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+				srvDesc.Format = rd.format;
+				srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+				srvDesc.Texture2D.MostDetailedMip = rd.mostDetailedMip;
+				srvDesc.Texture2D.MipLevels = rd.mipLevels;
+
+				THROW_IF_FAILED(gfx, pDevice->CreateShaderResourceView(pTexture.Get(), &srvDesc, &Data.texture2D.pSRView));
+			} else if (std::holds_alternative<Graphics::Texture2D::File>(m_oTex2D->content)) {
+				Graphics::Texture2D::File& file{ std::get<Graphics::Texture2D::File>(m_oTex2D->content) };
+				THROW_IF_FAILED(gfx,
+					DirectX::CreateDDSTextureFromFile(pDevice.Get(), file.filename, nullptr, &Data.texture2D.pSRView)
+				);
+			} else {
+				valid_type = false;
+#ifndef NDEBUG
+				OutputDebugStringW(L"Texture2D variant had an unexpected type (update your if statement)");
+#endif
 			}
-		}
 
-		// viewport
-		{
-			if (m_oVP) {
-				pDeferred->RSSetViewports(1u, &(*m_oVP));
+			if (valid_type) { // only execute if the type was valid
+				D3D11_SAMPLER_DESC samplerDesc{};
+				samplerDesc.Filter = m_oTex2D->sampler.filter;
+				samplerDesc.AddressU = m_oTex2D->sampler.u;
+				samplerDesc.AddressV = m_oTex2D->sampler.v;
+				samplerDesc.AddressW = m_oTex2D->sampler.w;
+				samplerDesc.MipLODBias = m_oTex2D->sampler.mipLODBias;
+				samplerDesc.MaxAnisotropy = m_oTex2D->sampler.maxAnisotropy;
+				samplerDesc.ComparisonFunc = m_oTex2D->sampler.comparisonFunc;
+				samplerDesc.BorderColor[0] = m_oTex2D->sampler.borderColor.r;
+				samplerDesc.BorderColor[1] = m_oTex2D->sampler.borderColor.g;
+				samplerDesc.BorderColor[2] = m_oTex2D->sampler.borderColor.b;
+				samplerDesc.BorderColor[3] = m_oTex2D->sampler.borderColor.a;
+				samplerDesc.MinLOD = m_oTex2D->sampler.minLOD;
+				samplerDesc.MaxLOD = m_oTex2D->sampler.maxLOD;
+
+				Data.texture2D.pSampler = pipelines.sampler(gfx, samplerDesc);
 			}
 		}
+	}
+
+	// records every state binding of the pipeline through cache (deferred or immediate); binds that would not change
+	// anything are dropped by the cache
+	template <typename Context>
+	void bindPipeline(BasicStateCache<Context>& cache, bool submaterialCalling = false, unsigned skip = RenderQueue::SKIP_NONE) const {
+		// vertex, index and constant buffers (a submaterial binds its own)
+		if (!submaterialCalling) {
+			cache.setVertexBuffer(0u, Data.vertex.pBuffer.Get(), Data.vertex.stride, Data.vertex.offset);
+			cache.setIndexBuffer(Data.index.pBuffer.Get(), m_indexFormat, 0u);
+			if (!Data.constant.vertexRawBuffers.empty())
+				cache.setConstantBuffers(ShaderStage::VERTEX, 0u, Data.constant.vertexRawBuffers.size(), Data.constant.vertexRawBuffers.data());
+			if (!Data.constant.pixelRawBuffers.empty())
+				cache.setConstantBuffers(ShaderStage::PIXEL, 0u, Data.constant.pixelRawBuffers.size(), Data.constant.pixelRawBuffers.data());
+		}
+
+		if (Data.instance.pBuffer)
+			cache.setVertexBuffer(1u, Data.instance.pBuffer.Get(), Data.instance.stride, Data.instance.offset);
+
+		if (!(skip & RenderQueue::SKIP_PIPELINE)) {
+			// primitive topology
+			cache.setPrimitiveTopology(m_primitiveTopology);
+
+			// shaders
+			if (m_vs.bind)
+				cache.setVertexShader(Data.shader.pVertex.Get());
+			if (m_oPS)
+				cache.setPixelShader(Data.shader.pPixel.Get());
+
+			// input layout
+			cache.setInputLayout(Data.pLayout.Get());
+
+			// render target and z buffer
+			if (m_oPRTV)
+				cache.setRenderTarget(m_oPRTV->Get(), m_oPDSV->Get());
+
+			// viewport
+			if (m_oVP)
+				cache.setViewport(*m_oVP);
+		}
 
 		// texture
-		{
-			if (m_oTex2D) {
-				bool valid_type{ true };
-				if (std::holds_alternative<Graphics::Texture2D::RawData>(m_oTex2D->content)) {
-					Graphics::Texture2D::RawData& rd{ std::get<Graphics::Texture2D::RawData>(m_oTex2D->content) };
-					D3D11_TEXTURE2D_DESC textureDesc{};
-					textureDesc.Width = rd.width;
-					textureDesc.Height = rd.height;
-					textureDesc.MipLevels = rd.mipLevels;
-					textureDesc.ArraySize = rd.arraySize;
-					textureDesc.Format = rd.format;
-					textureDesc.SampleDesc.Count = rd.sampleCount;
-					textureDesc.SampleDesc.Quality = rd.sampleQuality;
-					textureDesc.Usage = D3D11_USAGE_DEFAULT;
-					textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-					textureDesc.CPUAccessFlags = rd.cpuAccessFlags;
-					textureDesc.MiscFlags = rd.miscFlags;
-
-					D3D11_SUBRESOURCE_DATA textureData{};
-					textureData.pSysMem = rd.pData;
-					textureData.SysMemPitch = rd.pitch;
-
-					Microsoft::WRL::ComPtr<ID3D11Texture2D> pTexture;
-					THROW_IF_FAILED(gfx, pDevice->CreateTexture2D(&textureDesc, &textureData, &pTexture));
-
-					D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-					srvDesc.Format = rd.format;
-					srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-					srvDesc.Texture2D.MostDetailedMip = rd.mostDetailedMip;
-					srvDesc.Texture2D.MipLevels = rd.mipLevels;
-
-					THROW_IF_FAILED(gfx, pDevice->CreateShaderResourceView(pTexture.Get(), &srvDesc, &Data.texture2D.pSRView));
-
-					pDeferred->PSSetShaderResources(0u, 1u, Data.texture2D.pSRView.GetAddressOf());
-				} else if (std::holds_alternative<Graphics::Texture2D::File>(m_oTex2D->content)) {
-					Graphics::Texture2D::File& file{ std::get<Graphics::Texture2D::File>(m_oTex2D->content) };
-					THROW_IF_FAILED(gfx,
-						DirectX::CreateDDSTextureFromFile(pDevice.Get(), file.filename, nullptr, &Data.texture2D.pSRView)
-					);
-					pDeferred->PSSetShaderResources(0u, 1u, Data.texture2D.pSRView.GetAddressOf());
-				} else {
-					valid_type = false;
-#ifndef NDEBUG
-					OutputDebugStringW(L"Texture2D variant had an unexpected type (update your if statement)");
-#endif
-				}
+		if (!(skip & RenderQueue::SKIP_TEXTURE)) {
+			if (Data.texture2D.pSRView)
+				cache.setShaderResource(ShaderStage::PIXEL, 0u, Data.texture2D.pSRView.Get());
+			if (Data.texture2D.pSampler)
+				cache.setSampler(ShaderStage::PIXEL, 0u, Data.texture2D.pSampler.Get());
+		}
+	}
 
-				if (valid_type) { // only execute if the type was valid
-					D3D11_SAMPLER_DESC samplerDesc{};
-					samplerDesc.Filter = m_oTex2D->sampler.filter;
-					samplerDesc.AddressU = m_oTex2D->sampler.u;
-					samplerDesc.AddressV = m_oTex2D->sampler.v;
-					samplerDesc.AddressW = m_oTex2D->sampler.w;
-					samplerDesc.MipLODBias = m_oTex2D->sampler.mipLODBias;
-					samplerDesc.MaxAnisotropy = m_oTex2D->sampler.maxAnisotropy;
-					samplerDesc.ComparisonFunc = m_oTex2D->sampler.comparisonFunc;
-					samplerDesc.BorderColor[0] = m_oTex2D->sampler.borderColor.r;
-					samplerDesc.BorderColor[1] = m_oTex2D->sampler.borderColor.g;
-					samplerDesc.BorderColor[2] = m_oTex2D->sampler.borderColor.b;
-					samplerDesc.BorderColor[3] = m_oTex2D->sampler.borderColor.a;
-					samplerDesc.MinLOD = m_oTex2D->sampler.minLOD;
-					samplerDesc.MaxLOD = m_oTex2D->sampler.maxLOD;
-
-					THROW_IF_FAILED(gfx, pDevice->CreateSamplerState(&samplerDesc, &Data.texture2D.pSampler));
-
-					pDeferred->PSSetSamplers(0u, 1u, Data.texture2D.pSampler.GetAddressOf());
-				}
+	// one draw per part of each visible mesh; meshes is this material's own or a submaterial's (which bound its own
+	// buffers), and pArgs their indirect arguments, one per part, if instanced (the instance count is read from there)
+	void issueDraw(ID3D11DeviceContext* pContext, const MeshRegistry<Vertex, Index>& meshes, ID3D11Buffer* pArgs) const {
+		for (MeshId id{ 0u }; id < meshes.size(); id++) {
+			if (!meshes.isVisible(id)) continue;
+			size_t part{ meshes.firstPart(id) };
+			for (const auto& range : meshes.parts(id)) {
+				if (pArgs)
+					pContext->DrawIndexedInstancedIndirect(pArgs,
+						static_cast<UINT>(part * sizeof(D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS)));
+				else
+					pContext->DrawIndexed(range.indexCount, range.firstIndex, range.baseVertex);
+				part++;
 			}
 		}
+	}
 
-		// draw command
-		pDeferred->DrawIndexed(m_idx.size(), 0u, 0);
+	void issueDraw(ID3D11DeviceContext* pContext) const {
+		issueDraw(pContext, m_meshes, Data.instance.pArgs.Get());
+	}
 
-		// generate command list
-		THROW_IF_FAILED(gfx, pDeferred->FinishCommandList(FALSE, &pListToFill));
+	// the indirect arguments of every part of meshes, in part order, each drawing instanceCount instances
+	static std::vector<D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS> indirectArgs(const MeshRegistry<Vertex, Index>& meshes,
+		UINT instanceCount) {
+
+		std::vector<D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS> args{};
+		args.reserve(std::max<size_t>(meshes.partCount(), 1u));
+		for (MeshId id{ 0u }; id < meshes.size(); id++) {
+			for (const auto& range : meshes.parts(id))
+				args.push_back({ range.indexCount, instanceCount, range.firstIndex, range.baseVertex, 0u });
+		}
+		if (args.empty()) args.push_back({ 0u, 0u, 0u, 0, 0u }); // buffers can't be empty
+		return args;
 	}
 
-	// call on main thread
-	void draw(const Graphics& gfx) {
-		gfx.getImmediateContext()->ExecuteCommandList(m_pCmdList.Get(), FALSE);
+private:
+
+	// (re)records m_pCmdList with the meshes visible now; the resources are only created the first time
+	void record(const Graphics& gfx) {
+		Microsoft::WRL::ComPtr<ID3D11Device> pDevice{ gfx.getDevice() };
+		
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> pDeferred;
+		THROW_IF_FAILED(gfx, pDevice->CreateDeferredContext(0, &pDeferred));
+
+		setupPipeline(gfx, pDeferred, m_pCmdList);
+		m_meshes.getVisibility(m_recordedVisibility);
+	}
+
+	UINT nextSlot(ShaderStage stage) const noexcept {
+		return static_cast<UINT>(std::count_if(m_cBuffers.cbegin(), m_cBuffers.cend(),
+			[stage](const ConstantBuffer& cb) { return cb.stage == stage; }));
 	}
 };
 
@@ -0,0 +1,324 @@
+#ifndef CWF_MESHOPTIMIZER_H
+#define CWF_MESHOPTIMIZER_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+/*
+* Reorders the index (and vertex) data of triangle-list meshes so the GPU does less work drawing them. The stages are
+* meant to run in this order, each keeping the work of the previous ones mostly intact:
+*	optimizeVertexCache - Forsyth's linear-speed reordering, so triangles reuse vertices still in the post-transform
+*	                      cache instead of running the vertex shader on them again
+*	optimizeOverdraw    - cuts the cache-ordered triangles into clusters where the cache is cold anyway and sorts the
+*	                      clusters so outward-facing ones are drawn first (as in Tipsify), so more pixels fail early-Z
+*	optimizeVertexFetch - renumbers the vertices in the order the indices first use them, so vertex fetches walk
+*	                      through memory linearly; unreferenced vertices are moved to the end
+* analyzeVertexCache simulates a FIFO post-transform cache to measure the result:
+*	ACMR - average cache miss ratio, vertex shader runs per triangle (0.5 is ideal for large meshes, 3 is worst)
+*	ATVR - average transform to vertex ratio, vertex shader runs per vertex (1 is ideal)
+* Nothing here knows about DirectX; vertices only need pos.x, pos.y and pos.z (see ShapeConcepts.h).
+*/
+
+namespace MeshOptimizer {
+	enum Stage : unsigned {
+		NONE = 0u,
+		VERTEX_CACHE = 1u << 0,
+		OVERDRAW = 1u << 1,
+		VERTEX_FETCH = 1u << 2,
+		ALL = VERTEX_CACHE | OVERDRAW | VERTEX_FETCH
+	};
+
+	struct CacheStats {
+		float acmr;
+		float atvr;
+	};
+
+	struct Report {
+		CacheStats before;
+		CacheStats after;
+		size_t triangles;
+	};
+
+	inline constexpr unsigned DEFAULT_FIFO_SIZE{ 16u }; // a conservative guess at a post-transform cache's size
+
+	template <typename Index>
+	CacheStats analyzeVertexCache(std::span<const Index> indices, size_t vertexCount, unsigned cacheSize = DEFAULT_FIFO_SIZE) {
+		const size_t triangles{ indices.size() / 3u };
+		if (triangles == 0u || vertexCount == 0u) return { 0.0f, 0.0f };
+
+		// a vertex is in the FIFO if fewer than cacheSize misses happened since it was last loaded
+		std::vector<size_t> loadedAt(vertexCount, 0u);
+		size_t misses{ 0u };
+		for (size_t i{ 0u }; i < triangles * 3u; i++) {
+			const Index v{ indices[i] };
+			if (loadedAt[v] == 0u || misses + 1u - loadedAt[v] > cacheSize) {
+				misses++;
+				loadedAt[v] = misses; // 1-based, so 0 can mean never loaded
+			}
+		}
+		return { static_cast<float>(misses) / triangles, static_cast<float>(misses) / vertexCount };
+	}
+
+	namespace detail {
+		inline constexpr unsigned FORSYTH_CACHE_SIZE{ 32u };
+		inline constexpr unsigned FORSYTH_MAX_VALENCE{ 32u }; // valences past this score the same
+
+		struct ForsythTables {
+			std::array<float, FORSYTH_CACHE_SIZE> cache;
+			std::array<float, FORSYTH_MAX_VALENCE + 1u> valence;
+		};
+
+		inline const ForsythTables& forsythTables() {
+			static const ForsythTables tables{ [] {
+				ForsythTables t{};
+				for (unsigned i{ 0u }; i < FORSYTH_CACHE_SIZE; i++) {
+					if (i < 3u) { // the last triangle's vertices: a fixed score, so no strip direction is favoured
+						t.cache[i] = 0.75f;
+					} else {
+						const float scaled{ 1.0f - static_cast<float>(i - 3u) / static_cast<float>(FORSYTH_CACHE_SIZE - 3u) };
+						t.cache[i] = std::pow(scaled, 1.5f);
+					}
+				}
+				t.valence[0] = 0.0f;
+				for (unsigned i{ 1u }; i <= FORSYTH_MAX_VALENCE; i++)
+					t.valence[i] = 2.0f / std::sqrt(static_cast<float>(i)); // finish off vertices with few triangles left
+				return t;
+			}() };
+			return tables;
+		}
+
+		inline float forsythScore(int cachePosition, uint32_t remainingValence) {
+			if (remainingValence == 0u) return -1.0f; // nothing left to draw with this vertex
+			const ForsythTables& t{ forsythTables() };
+			const float cacheScore{ cachePosition < 0 ? 0.0f : t.cache[cachePosition] };
+			return cacheScore + t.valence[std::min(remainingValence, FORSYTH_MAX_VALENCE)];
+		}
+	}
+
+	// reorders the triangles of indices in place
+	template <typename Index>
+	void optimizeVertexCache(std::span<Index> indices, size_t vertexCount) {
+		using namespace detail;
+		const size_t triangles{ indices.size() / 3u };
+		if (triangles < 2u || vertexCount == 0u) return;
+
+		// vertex -> triangles adjacency, packed
+		std::vector<uint32_t> valence(vertexCount, 0u);
+		for (size_t i{ 0u }; i < triangles * 3u; i++)
+			valence[indices[i]]++;
+		std::vector<uint32_t> adjacencyStart(vertexCount + 1u, 0u);
+		std::partial_sum(valence.cbegin(), valence.cend(), adjacencyStart.begin() + 1);
+		std::vector<uint32_t> adjacency(triangles * 3u);
+		{
+			std::vector<uint32_t> fill{ adjacencyStart.cbegin(), adjacencyStart.cend() - 1 };
+			for (size_t t{ 0u }; t < triangles; t++) {
+				for (size_t k{ 0u }; k < 3u; k++)
+					adjacency[fill[indices[t * 3u + k]]++] = static_cast<uint32_t>(t);
+			}
+		}
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (size_t v{ 0u }; v < vertexCount; v++)
+			vertexScore[v] = forsythScore(-1, valence[v]);
+		std::vector<float> triangleScore(triangles);
+		for (size_t t{ 0u }; t < triangles; t++)
+			triangleScore[t] = vertexScore[indices[t * 3u]] + vertexScore[indices[t * 3u + 1u]] + vertexScore[indices[t * 3u + 2u]];
+		std::vector<bool> emitted(triangles, false);
+		std::vector<Index> output{};
+		output.reserve(triangles * 3u);
+
+		// LRU cache of vertices, with room for the 3 pushed in before the oldest fall out
+		std::array<uint32_t, FORSYTH_CACHE_SIZE + 3u> cache{};
+		size_t cacheCount{ 0u };
+		size_t scanCursor{ 0u }; // everything before it has been emitted
+		size_t best{ 0u };
+		for (size_t emittedCount{ 0u }; emittedCount < triangles; emittedCount++) {
+			emitted[best] = true;
+			std::array<uint32_t, FORSYTH_CACHE_SIZE + 3u> next{};
+			size_t nextCount{ 0u };
+			for (size_t k{ 0u }; k < 3u; k++) {
+				const uint32_t v{ static_cast<uint32_t>(indices[best * 3u + k]) };
+				output.push_back(static_cast<Index>(v));
+				next[nextCount++] = v;
+				// this triangle no longer counts towards the vertex's valence
+				const uint32_t begin{ adjacencyStart[v] };
+				const uint32_t end{ begin + valence[v] };
+				for (uint32_t a{ begin }; a < end; a++) {
+					if (adjacency[a] == best) {
+						std::swap(adjacency[a], adjacency[end - 1u]);
+						break;
+					}
+				}
+				valence[v]--;
+			}
+			for (size_t c{ 0u }; c < cacheCount; c++) { // the rest of the cache moves back by up to 3
+				const uint32_t v{ cache[c] };
+				if (v != next[0] && v != next[1] && v != next[2]) next[nextCount++] = v;
+			}
+
+			// rescore every vertex that moved in the cache (including those that fell out) and their triangles
+			const size_t kept{ std::min<size_t>(nextCount, FORSYTH_CACHE_SIZE) };
+			for (size_t c{ 0u }; c < nextCount; c++)
+				cachePosition[next[c]] = c < kept ? static_cast<int>(c) : -1;
+			float bestScore{ -1.0f };
+			best = triangles;
+			for (size_t c{ 0u }; c < nextCount; c++) {
+				const uint32_t v{ next[c] };
+				const float newScore{ forsythScore(cachePosition[v], valence[v]) };
+				const float delta{ newScore - vertexScore[v] };
+				vertexScore[v] = newScore;
+				const uint32_t begin{ adjacencyStart[v] };
+				for (uint32_t a{ begin }; a < begin + valence[v]; a++) {
+					const uint32_t t{ adjacency[a] };
+					triangleScore[t] += delta;
+					if (c < kept && triangleScore[t] > bestScore) {
+						bestScore = triangleScore[t];
+						best = t;
+					}
+				}
+			}
+			std::copy(next.cbegin(), next.cbegin() + kept, cache.begin());
+			cacheCount = kept;
+
+			if (best == triangles) { // nothing in the cache leads anywhere: start over at the next triangle not yet drawn
+				while (scanCursor < triangles && emitted[scanCursor]) scanCursor++;
+				if (scanCursor == triangles) break;
+				best = scanCursor; // a full scan for the best score would make meshes with many islands quadratic
+			}
+		}
+		std::copy(output.cbegin(), output.cend(), indices.begin());
+	}
+
+	// reorders clusters of the (cache-optimized) triangles in place so that outward-facing ones come first
+	template <typename Vertex, typename Index>
+	void optimizeOverdraw(std::span<Index> indices, std::span<const Vertex> vertices, unsigned cacheSize = DEFAULT_FIFO_SIZE) {
+		const size_t triangles{ indices.size() / 3u };
+		if (triangles < 2u || vertices.empty()) return;
+
+		// cluster boundaries: triangles where all three vertices miss the cache, so moving a cluster costs nothing
+		std::vector<size_t> clusterStart{ 0u };
+		{
+			std::vector<size_t> loadedAt(vertices.size(), 0u);
+			size_t misses{ 0u };
+			for (size_t t{ 0u }; t < triangles; t++) {
+				unsigned triangleMisses{ 0u };
+				for (size_t k{ 0u }; k < 3u; k++) {
+					const Index v{ indices[t * 3u + k] };
+					if (loadedAt[v] == 0u || misses + 1u - loadedAt[v] > cacheSize) {
+						misses++;
+						triangleMisses++;
+						loadedAt[v] = misses;
+					}
+				}
+				if (triangleMisses == 3u && t != 0u) clusterStart.push_back(t);
+			}
+		}
+		const size_t clusters{ clusterStart.size() };
+		if (clusters < 2u) return;
+		clusterStart.push_back(triangles);
+
+		struct Float3 { float x, y, z; };
+		auto position = [&vertices](Index i) -> Float3 {
+			const auto& p{ vertices[i].pos };
+			return { p.x, p.y, p.z };
+		};
+
+		// area-weighted centroids and normals
+		Float3 meshCentroid{ 0.0f, 0.0f, 0.0f };
+		float meshArea{ 0.0f };
+		std::vector<Float3> centroids(clusters);
+		std::vector<Float3> normals(clusters);
+		for (size_t c{ 0u }; c < clusters; c++) {
+			Float3 centroid{ 0.0f, 0.0f, 0.0f };
+			Float3 normal{ 0.0f, 0.0f, 0.0f };
+			float area{ 0.0f };
+			for (size_t t{ clusterStart[c] }; t < clusterStart[c + 1u]; t++) {
+				const Float3 a{ position(indices[t * 3u]) };
+				const Float3 b{ position(indices[t * 3u + 1u]) };
+				const Float3 d{ position(indices[t * 3u + 2u]) };
+				const Float3 e1{ b.x - a.x, b.y - a.y, b.z - a.z };
+				const Float3 e2{ d.x - a.x, d.y - a.y, d.z - a.z };
+				const Float3 n{ e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+				const float w{ std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z) };
+				centroid.x += (a.x + b.x + d.x) * w;
+				centroid.y += (a.y + b.y + d.y) * w;
+				centroid.z += (a.z + b.z + d.z) * w;
+				normal.x += n.x;
+				normal.y += n.y;
+				normal.z += n.z;
+				area += w;
+			}
+			meshCentroid.x += centroid.x;
+			meshCentroid.y += centroid.y;
+			meshCentroid.z += centroid.z;
+			meshArea += area;
+			const float scale{ area > 0.0f ? 1.0f / (area * 3.0f) : 0.0f };
+			centroids[c] = { centroid.x * scale, centroid.y * scale, centroid.z * scale };
+			normals[c] = normal;
+		}
+		if (meshArea > 0.0f) {
+			const float scale{ 1.0f / (meshArea * 3.0f) };
+			meshCentroid = { meshCentroid.x * scale, meshCentroid.y * scale, meshCentroid.z * scale };
+		}
+
+		// the further a cluster faces away from the middle of the mesh, the more likely it occludes the others
+		std::vector<float> sortKey(clusters);
+		for (size_t c{ 0u }; c < clusters; c++) {
+			const Float3& n{ normals[c] };
+			const float length{ std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z) };
+			const Float3 d{ centroids[c].x - meshCentroid.x, centroids[c].y - meshCentroid.y, centroids[c].z - meshCentroid.z };
+			sortKey[c] = length > 0.0f ? (d.x * n.x + d.y * n.y + d.z * n.z) / length : 0.0f;
+		}
+		std::vector<size_t> order(clusters);
+		std::iota(order.begin(), order.end(), size_t{ 0u });
+		std::stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+		std::vector<Index> output{};
+		output.reserve(triangles * 3u);
+		for (size_t c : order)
+			output.insert(output.cend(), indices.begin() + clusterStart[c] * 3u, indices.begin() + clusterStart[c + 1u] * 3u);
+		std::copy(output.cbegin(), output.cend(), indices.begin());
+	}
+
+	// renumbers vertices in first-use order, rewriting indices and vertices in place; the vertex count is unchanged
+	template <typename Vertex, typename Index>
+	void optimizeVertexFetch(std::span<Index> indices, std::span<Vertex> vertices) {
+		constexpr uint32_t UNUSED{ UINT32_MAX };
+		std::vector<uint32_t> remap(vertices.size(), UNUSED);
+		uint32_t next{ 0u };
+		for (Index& i : indices) {
+			if (remap[i] == UNUSED) remap[i] = next++;
+			i = static_cast<Index>(remap[i]);
+		}
+		for (uint32_t& r : remap) {
+			if (r == UNUSED) r = next++;
+		}
+
+		std::vector<Vertex> reordered{ vertices.begin(), vertices.end() };
+		for (size_t v{ 0u }; v < vertices.size(); v++)
+			reordered[remap[v]] = vertices[v];
+		std::copy(reordered.cbegin(), reordered.cend(), vertices.begin());
+	}
+
+	// runs the requested stages (a mask of Stage bits) on one triangle-list mesh
+	template <typename Vertex, typename Index>
+	Report optimize(std::span<Index> indices, std::span<Vertex> vertices, unsigned stages = ALL) {
+		Report report{};
+		report.triangles = indices.size() / 3u;
+		report.before = analyzeVertexCache<Index>(indices, vertices.size());
+		if (stages & VERTEX_CACHE) optimizeVertexCache<Index>(indices, vertices.size());
+		if (stages & OVERDRAW) optimizeOverdraw<Vertex, Index>(indices, vertices);
+		if (stages & VERTEX_FETCH) optimizeVertexFetch<Vertex, Index>(indices, vertices);
+		report.after = analyzeVertexCache<Index>(indices, vertices.size());
+		return report;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,378 @@
+#ifndef CWF_MESHREGISTRY_H
+#define CWF_MESHREGISTRY_H
+
+#include "Culling.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/*
+* Pools every mesh of a Material (or Submaterial) into one vertex array and one index array, which become one vertex
+* buffer and one index buffer. Each mesh keeps its own range in the pool:
+*	baseVertex - where its vertices start; added to every one of its indices by the draw (DrawIndexed's BaseVertexLocation)
+*	firstIndex - where its indices start
+*	indexCount - how many indices it has
+* so its indices stay local (0 is its first vertex) and never need rebasing, a 16-bit index buffer can pool more than
+* 65536 vertices as long as each mesh fits, and any mesh can be drawn, culled or instanced on its own.
+* Meshes are identified by the MeshId returned from add, in the order they were added.
+*
+* pack() decides the GPU index format from the largest local index of every mesh: 16-bit whenever every mesh fits
+* (narrowing a 32-bit Index if need be), otherwise per IndexPolicy:
+*	SPLIT   - meshes over the 16-bit limit are cut into parts of at most 65536 vertices, each drawn on its own with
+*	          16-bit indices (vertices shared between parts are duplicated)
+*	PROMOTE - the whole buffer uses 32-bit indices
+* After packing, a mesh is drawn as its parts(id) instead of its range(id).
+*
+* Every mesh also gets a bounding box and sphere in its own space when it is added, kept as structure-of-arrays for
+* Culling. cull(frustum) marks the meshes entirely outside the frustum, which isVisible() then reports as hidden
+* until the next cull() or uncull(); this is separate from setVisible(), so culling never unhides a hidden mesh.
+*/
+
+enum class IndexPolicy {
+	SPLIT, PROMOTE
+};
+
+template <class Vertex, typename Index>
+class MeshRegistry {
+public:
+	using MeshId = size_t;
+
+	struct Range {
+		int32_t baseVertex;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t vertexCount;
+	};
+
+	static constexpr uint32_t MAX_INDEX_16{ 0xFFFFu };
+
+	// what pack() decided; the buffer contents come from vertexData(packed) and indexData(packed)
+	struct Packed {
+		bool wide; // 32-bit indices
+		size_t splitMeshes; // meshes cut into several 16-bit parts
+		std::vector<Vertex> vertices; // the pool laid out again, if any mesh was split; empty otherwise
+		std::vector<uint16_t> indices16; // 16-bit copy of the indices, if Index is wider or a mesh was split
+	};
+private:
+	static_assert(std::is_same_v<Index, uint16_t> || std::is_same_v<Index, uint32_t>,
+		"Direct3D index buffers hold 16- or 32-bit unsigned indices.");
+
+	std::vector<Vertex> m_vertices;
+	std::vector<Index> m_indices;
+	std::vector<Range> m_ranges;
+	std::vector<uint32_t> m_maxIndices; // parallel to m_ranges: largest local index of each mesh
+	std::vector<bool> m_visible; // parallel to m_ranges
+	std::vector<uint8_t> m_inFrustum; // parallel to m_ranges: 0 if the last cull() put the mesh outside
+	struct {
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ; // half the box's size
+		std::vector<float> radius; // the sphere shares the box's center
+	} m_bounds; // parallel to m_ranges
+	std::vector<Range> m_parts; // after pack(): the draws, grouped by mesh
+	std::vector<size_t> m_firstPart; // after pack(): per mesh, plus one past the end
+public:
+	MeshRegistry() : m_vertices{}, m_indices{}, m_ranges{}, m_maxIndices{}, m_visible{}, m_inFrustum{}, m_bounds{},
+		m_parts{}, m_firstPart{} {}
+
+	MeshId add(std::span<const Vertex> vertices, std::span<const Index> indices) {
+		m_ranges.push_back({
+			static_cast<int32_t>(m_vertices.size()),
+			static_cast<uint32_t>(m_indices.size()),
+			static_cast<uint32_t>(indices.size()),
+			static_cast<uint32_t>(vertices.size())
+		});
+		m_visible.push_back(true);
+		m_vertices.insert(m_vertices.cend(), vertices.begin(), vertices.end());
+		m_indices.insert(m_indices.cend(), indices.begin(), indices.end());
+		added();
+		return m_ranges.size() - 1u;
+	}
+
+	MeshId add(std::initializer_list<Vertex> vertices, std::initializer_list<Index> indices) {
+		return add(std::span<const Vertex>{ vertices.begin(), vertices.size() },
+			std::span<const Index>{ indices.begin(), indices.size() });
+	}
+
+	// adds a mesh by letting write append exactly vertexCount vertices and indexCount indices to the pools (which have
+	// room reserved for them), so bulk producers can skip building their own arrays first
+	template <typename Write>
+	MeshId add(size_t vertexCount, size_t indexCount, Write write) {
+		m_vertices.reserve(m_vertices.size() + vertexCount);
+		m_indices.reserve(m_indices.size() + indexCount);
+		m_ranges.push_back({
+			static_cast<int32_t>(m_vertices.size()),
+			static_cast<uint32_t>(m_indices.size()),
+			static_cast<uint32_t>(indexCount),
+			static_cast<uint32_t>(vertexCount)
+		});
+		m_visible.push_back(true);
+		write(m_vertices, m_indices);
+		added();
+		return m_ranges.size() - 1u;
+	}
+
+	void reserve(size_t vertexCount, size_t indexCount) {
+		m_vertices.reserve(vertexCount);
+		m_indices.reserve(indexCount);
+	}
+
+	void clear() noexcept {
+		m_vertices.clear();
+		m_indices.clear();
+		m_ranges.clear();
+		m_maxIndices.clear();
+		m_visible.clear();
+		m_inFrustum.clear();
+		m_bounds = {};
+		m_parts.clear();
+		m_firstPart.clear();
+	}
+
+	const Range& range(MeshId id) const noexcept {
+		return m_ranges[id];
+	}
+
+	uint32_t maxIndex(MeshId id) const noexcept {
+		return m_maxIndices[id];
+	}
+
+	uint32_t maxIndex() const noexcept { // over every mesh
+		return m_maxIndices.empty() ? 0u : *std::max_element(m_maxIndices.cbegin(), m_maxIndices.cend());
+	}
+
+	// the draws that make up a mesh: its own range until pack() splits it
+	std::span<const Range> parts(MeshId id) const noexcept {
+		if (m_firstPart.empty()) return { &m_ranges[id], 1u };
+		return { m_parts.data() + m_firstPart[id], m_firstPart[id + 1u] - m_firstPart[id] };
+	}
+
+	// index of a mesh's first part among all parts (e.g. into an indirect argument buffer)
+	size_t firstPart(MeshId id) const noexcept {
+		return m_firstPart.empty() ? id : m_firstPart[id];
+	}
+
+	size_t partCount() const noexcept {
+		return m_firstPart.empty() ? m_ranges.size() : m_parts.size();
+	}
+
+	// invisible meshes are skipped by draws; everything starts out visible
+	void setVisible(MeshId id, bool visible) noexcept {
+		if (id < m_visible.size()) m_visible[id] = visible;
+	}
+
+	void setAllVisible(bool visible) noexcept {
+		m_visible.assign(m_visible.size(), visible);
+	}
+
+	bool isVisible(MeshId id) const noexcept {
+		return id < m_visible.size() && m_visible[id] && m_inFrustum[id];
+	}
+
+	// isVisible for every mesh, kept by whoever records the draws so it can tell when they are out of date
+	void getVisibility(std::vector<bool>& visibility) const {
+		visibility.resize(m_ranges.size());
+		for (MeshId id{ 0u }; id < m_ranges.size(); id++) visibility[id] = isVisible(id);
+	}
+
+	bool hasVisibility(const std::vector<bool>& visibility) const noexcept {
+		if (visibility.size() != m_ranges.size()) return false;
+		for (MeshId id{ 0u }; id < m_ranges.size(); id++) {
+			if (visibility[id] != isVisible(id)) return false;
+		}
+		return true;
+	}
+
+	// frustum in the meshes' own space (see Culling::frustum); tests the boxes, returns how many meshes may be visible
+	size_t cull(const Culling::Frustum& frustum) noexcept {
+		return Culling::cullBoxes(frustum, boxes(), m_inFrustum.data());
+	}
+
+	void uncull() noexcept {
+		m_inFrustum.assign(m_inFrustum.size(), 1u);
+	}
+
+	Culling::Boxes boxes() const noexcept {
+		return { m_bounds.centerX.data(), m_bounds.centerY.data(), m_bounds.centerZ.data(),
+			m_bounds.extentX.data(), m_bounds.extentY.data(), m_bounds.extentZ.data(), m_ranges.size() };
+	}
+
+	Culling::Spheres spheres() const noexcept {
+		return { m_bounds.centerX.data(), m_bounds.centerY.data(), m_bounds.centerZ.data(), m_bounds.radius.data(), m_ranges.size() };
+	}
+
+	// the vertices and indices of a single mesh; indices are local to the mesh
+	std::span<const Vertex> vertices(MeshId id) const noexcept {
+		return { m_vertices.data() + m_ranges[id].baseVertex, m_ranges[id].vertexCount };
+	}
+
+	std::span<const Index> indices(MeshId id) const noexcept {
+		return { m_indices.data() + m_ranges[id].firstIndex, m_ranges[id].indexCount };
+	}
+
+	// the whole pool, for creating the buffers
+	const std::vector<Vertex>& vertices() const noexcept {
+		return m_vertices;
+	}
+
+	const std::vector<Index>& indices() const noexcept {
+		return m_indices;
+	}
+
+	size_t size() const noexcept {
+		return m_ranges.size();
+	}
+
+	bool empty() const noexcept {
+		return m_ranges.empty();
+	}
+
+	// runs MeshOptimizer over every mesh, each within its own range (triangle lists only); one report per mesh
+	std::vector<MeshOptimizer::Report> optimize(unsigned stages = MeshOptimizer::ALL) {
+		std::vector<MeshOptimizer::Report> reports{};
+		reports.reserve(m_ranges.size());
+		for (MeshId id{ 0u }; id < m_ranges.size(); id++) {
+			const Range& r{ m_ranges[id] };
+			reports.push_back(MeshOptimizer::optimize<Vertex, Index>(
+				std::span<Index>{ m_indices.data() + r.firstIndex, r.indexCount },
+				std::span<Vertex>{ m_vertices.data() + r.baseVertex, r.vertexCount },
+				stages
+			));
+			m_maxIndices[id] = scanMaxIndex(r); // vertex fetch reordering renumbers
+		}
+		m_parts.clear();
+		m_firstPart.clear();
+		return reports;
+	}
+
+	// picks the index format and lays out the draws (see above); call again after adding meshes
+	Packed pack(IndexPolicy policy) {
+		Packed packed{ false, 0u, {}, {} };
+		m_parts.clear();
+		m_firstPart.clear();
+		const bool fits16{ maxIndex() <= MAX_INDEX_16 };
+		if (!fits16 && policy == IndexPolicy::PROMOTE) {
+			packed.wide = true; // Index is 32-bit here, so the pool is uploaded as is
+			return packed;
+		}
+		if (fits16) {
+			if constexpr (!std::is_same_v<Index, uint16_t>)
+				packed.indices16.assign(m_indices.cbegin(), m_indices.cend()); // every index fits, so narrowing is exact
+			return packed;
+		}
+
+		// split: lay every mesh out again, cutting the oversized ones into parts of at most 65536 vertices
+		packed.vertices.reserve(m_vertices.size());
+		packed.indices16.reserve(m_indices.size());
+		m_firstPart.reserve(m_ranges.size() + 1u);
+		std::vector<uint32_t> remap{};
+		std::vector<uint32_t> touched{};
+		for (MeshId id{ 0u }; id < m_ranges.size(); id++) {
+			const Range& r{ m_ranges[id] };
+			m_firstPart.push_back(m_parts.size());
+			if (m_maxIndices[id] <= MAX_INDEX_16) {
+				m_parts.push_back({ static_cast<int32_t>(packed.vertices.size()), static_cast<uint32_t>(packed.indices16.size()),
+					r.indexCount, r.vertexCount });
+				packed.vertices.insert(packed.vertices.cend(), m_vertices.cbegin() + r.baseVertex,
+					m_vertices.cbegin() + r.baseVertex + r.vertexCount);
+				packed.indices16.insert(packed.indices16.cend(), m_indices.cbegin() + r.firstIndex,
+					m_indices.cbegin() + r.firstIndex + r.indexCount);
+				continue;
+			}
+
+			constexpr uint32_t UNUSED{ UINT32_MAX };
+			packed.splitMeshes++;
+			remap.assign(static_cast<size_t>(m_maxIndices[id]) + 1u, UNUSED);
+			Range part{ static_cast<int32_t>(packed.vertices.size()), static_cast<uint32_t>(packed.indices16.size()), 0u, 0u };
+			auto closePart = [&] {
+				part.indexCount = static_cast<uint32_t>(packed.indices16.size()) - part.firstIndex;
+				if (part.indexCount > 0u) m_parts.push_back(part);
+				for (uint32_t v : touched) remap[v] = UNUSED;
+				touched.clear();
+				part = { static_cast<int32_t>(packed.vertices.size()), static_cast<uint32_t>(packed.indices16.size()), 0u, 0u };
+			};
+			for (uint32_t i{ 0u }; i + 3u <= r.indexCount; i += 3u) {
+				const Index* pTriangle{ m_indices.data() + r.firstIndex + i };
+				uint32_t newVertices{ 0u };
+				for (uint32_t k{ 0u }; k < 3u; k++) {
+					const bool repeated{ (k > 0u && pTriangle[k] == pTriangle[0]) || (k > 1u && pTriangle[k] == pTriangle[1]) };
+					if (remap[pTriangle[k]] == UNUSED && !repeated) newVertices++;
+				}
+				if (part.vertexCount + newVertices > MAX_INDEX_16 + 1u) closePart();
+				for (uint32_t k{ 0u }; k < 3u; k++) {
+					const uint32_t v{ static_cast<uint32_t>(pTriangle[k]) };
+					if (remap[v] == UNUSED) {
+						remap[v] = part.vertexCount++;
+						touched.push_back(v);
+						packed.vertices.push_back(m_vertices[r.baseVertex + v]);
+					}
+					packed.indices16.push_back(static_cast<uint16_t>(remap[v]));
+				}
+			}
+			closePart();
+		}
+		m_firstPart.push_back(m_parts.size());
+		return packed;
+	}
+
+	// what to upload for a Packed from pack()
+	std::span<const Vertex> vertexData(const Packed& packed) const noexcept {
+		if (!packed.vertices.empty()) return packed.vertices;
+		return m_vertices;
+	}
+
+	std::span<const std::byte> indexData(const Packed& packed) const noexcept {
+		if (!packed.indices16.empty()) return std::as_bytes(std::span<const uint16_t>{ packed.indices16 });
+		return std::as_bytes(std::span<const Index>{ m_indices });
+	}
+private:
+	uint32_t scanMaxIndex(const Range& r) const noexcept {
+		uint32_t max{ 0u };
+		for (uint32_t i{ 0u }; i < r.indexCount; i++)
+			max = std::max(max, static_cast<uint32_t>(m_indices[r.firstIndex + i]));
+		return max;
+	}
+
+	void addBounds(const Range& r) {
+		float lo[3]{ 0.0f, 0.0f, 0.0f };
+		float hi[3]{ 0.0f, 0.0f, 0.0f };
+		for (uint32_t i{ 0u }; i < r.vertexCount; i++) {
+			const Vertex& v{ m_vertices[r.baseVertex + i] };
+			const float p[3]{ static_cast<float>(v.pos.x), static_cast<float>(v.pos.y), static_cast<float>(v.pos.z) };
+			for (int a{ 0 }; a < 3; a++) {
+				lo[a] = i == 0u ? p[a] : std::min(lo[a], p[a]);
+				hi[a] = i == 0u ? p[a] : std::max(hi[a], p[a]);
+			}
+		}
+		const float center[3]{ 0.5f * (lo[0] + hi[0]), 0.5f * (lo[1] + hi[1]), 0.5f * (lo[2] + hi[2]) };
+		float radiusSq{ 0.0f }; // tighter than the box's half diagonal
+		for (uint32_t i{ 0u }; i < r.vertexCount; i++) {
+			const Vertex& v{ m_vertices[r.baseVertex + i] };
+			const float d[3]{ static_cast<float>(v.pos.x) - center[0], static_cast<float>(v.pos.y) - center[1],
+				static_cast<float>(v.pos.z) - center[2] };
+			radiusSq = std::max(radiusSq, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		}
+		m_bounds.centerX.push_back(center[0]);
+		m_bounds.centerY.push_back(center[1]);
+		m_bounds.centerZ.push_back(center[2]);
+		m_bounds.extentX.push_back(0.5f * (hi[0] - lo[0]));
+		m_bounds.extentY.push_back(0.5f * (hi[1] - lo[1]));
+		m_bounds.extentZ.push_back(0.5f * (hi[2] - lo[2]));
+		m_bounds.radius.push_back(std::sqrt(radiusSq));
+		m_inFrustum.push_back(1u);
+	}
+
+	void added() {
+		m_maxIndices.push_back(scanMaxIndex(m_ranges.back()));
+		addBounds(m_ranges.back());
+		m_parts.clear(); // any earlier pack() is stale
+		m_firstPart.clear();
+	}
+};
+
+#endif
\ No newline at end of file
@@ -1,13 +1,26 @@
 #include "CwfException.h"
+#include "InputLog.h"
+#include "InputThread.h"
 #include "Mouse.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
-#include <queue>
 #include <utility>
 #include <Windows.h>
 
+std::atomic<unsigned int> Mouse::s_rawInputCount{ 0u };
+
 Mouse::Mouse() noexcept : m_leftPressed{ false }, m_middlePressed{ false }, 
 	m_rightPressed{ false }, m_inClientRegion{ false }, m_rawInputEnabled{ false },
-	m_x{ 0 }, m_y{ 0 }, m_wheelDeltaAccumulator{ 0 }, m_eventQueue{}, m_rawQueue{} {}
+	m_x{ 0 }, m_y{ 0 }, m_wheelDeltaAccumulator{ 0 }, m_eventQueue{}, m_rawQueue{},
+	m_rawAccumulator{ 0u }, m_deltaHistory{}, m_deltaHistoryCount{ 0u }, m_pRecorder{ nullptr } {}
+
+Mouse::~Mouse() {
+	disableRawInput();
+}
 
 int Mouse::getX() const noexcept {
 	return m_x;
@@ -38,12 +51,7 @@ bool Mouse::isInClientRegion() const noexcept {
 }
 
 std::optional<Mouse::Event> Mouse::pollEventQueue() {
-	if (!m_eventQueue.empty()) {
-		Mouse::Event e = m_eventQueue.front();
-		m_eventQueue.pop();
-		return e;
-	}
-	return {};
+	return m_eventQueue.pop();
 }
 
 bool Mouse::isEventQueueEmpty() const noexcept {
@@ -51,19 +59,25 @@ bool Mouse::isEventQueueEmpty() const noexcept {
 }
 
 void Mouse::clearEventQueue() {
-	// same complexity as std::deque::clear(),
-	// but don't have to expose the std::deque
-	m_eventQueue = std::queue<Event>{};
+	m_eventQueue.clear();
+}
+
+uint64_t Mouse::getEventOverflowCount() const noexcept {
+	return m_eventQueue.getOverflowCount();
 }
 
 bool Mouse::enableRawInput() {
 	if (m_rawInputEnabled) return true;
+	if (InputThread::isAlive()) return false; // it owns raw input; registering here would take it away
 	RAWINPUTDEVICE mouse{};
 	mouse.usUsagePage = 0x01; // Generic Desktop Controls usage page
 	mouse.usUsage = 0x02; // generic mouse usage id
 	mouse.dwFlags = 0;
 	mouse.hwndTarget = nullptr; // follows keyboard focus
-	return RegisterRawInputDevices(&mouse, 1u, sizeof(mouse));
+	if (!RegisterRawInputDevices(&mouse, 1u, sizeof(mouse))) return false;
+	m_rawInputEnabled = true;
+	s_rawInputCount++;
+	return true;
 }
 
 bool Mouse::disableRawInput() {
@@ -73,20 +87,22 @@ bool Mouse::disableRawInput() {
 	mouse.usUsage = 0x02; // generic mouse usage id
 	mouse.dwFlags = RIDEV_REMOVE; // do not read further raw input from this device
 	mouse.hwndTarget = nullptr;
-	return RegisterRawInputDevices(&mouse, 1u, sizeof(mouse));
+	if (!RegisterRawInputDevices(&mouse, 1u, sizeof(mouse))) return false;
+	m_rawInputEnabled = false;
+	s_rawInputCount--;
+	return true;
 }
 
 bool Mouse::isRawInputEnabled() const noexcept {
 	return m_rawInputEnabled;
 }
 
+bool Mouse::isAnyRawInputEnabled() noexcept {
+	return s_rawInputCount > 0u;
+}
+
 std::optional<Mouse::PositionDelta> Mouse::pollRawQueue() {
-	if (!m_rawQueue.empty()) {
-		PositionDelta dP{ m_rawQueue.front() };
-		m_rawQueue.pop();
-		return dP;
-	}
-	return {};
+	return m_rawQueue.pop();
 }
 
 bool Mouse::isRawQueueEmpty() const noexcept {
@@ -94,7 +110,56 @@ bool Mouse::isRawQueueEmpty() const noexcept {
 }
 
 void Mouse::clearRawQueue() {
-	m_rawQueue = std::queue<PositionDelta>{};
+	m_rawQueue.clear();
+}
+
+uint64_t Mouse::getRawOverflowCount() const noexcept {
+	return m_rawQueue.getOverflowCount();
+}
+
+Mouse::PositionDelta Mouse::consumeAccumulatedDelta() noexcept {
+	// the accumulator holds y * 2^32 + x, wrapping, so one fetch_add sums both and one exchange takes both; x is the low
+	// half read as signed, and what's left once it's removed is y in the high half, as long as each sum fits in 32 bits
+	const uint64_t packed{ m_rawAccumulator.exchange(0u, std::memory_order_acquire) };
+	const int32_t x{ static_cast<int32_t>(static_cast<uint32_t>(packed)) };
+	const int32_t y{ static_cast<int32_t>((packed - static_cast<uint64_t>(static_cast<int64_t>(x))) >> 32u) };
+	const PositionDelta delta{ x, y };
+
+	const int64_t time{ std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count() };
+	m_deltaHistory[m_deltaHistoryCount % DELTA_HISTORY_SIZE] = { time, delta };
+	m_deltaHistoryCount++;
+	return delta;
+}
+
+size_t Mouse::getDeltaHistorySize() const noexcept {
+	return m_deltaHistoryCount < DELTA_HISTORY_SIZE ? m_deltaHistoryCount : DELTA_HISTORY_SIZE;
+}
+
+Mouse::TimedDelta Mouse::getDeltaHistory(size_t age) const noexcept {
+	if (age >= getDeltaHistorySize()) return {};
+	return m_deltaHistory[(m_deltaHistoryCount - 1u - age) % DELTA_HISTORY_SIZE];
+}
+
+Mouse::Velocity Mouse::getVelocity(int64_t window) const noexcept {
+	// each delta covers the time since the one before it, so the span runs from the last one left out to the latest
+	const size_t size{ getDeltaHistorySize() };
+	if (size < 2u) return {};
+	const int64_t latest{ getDeltaHistory(0u).time };
+	long x{ 0 };
+	long y{ 0 };
+	size_t age{ 0u };
+	for (; age + 1u < size; age++) {
+		const TimedDelta d{ getDeltaHistory(age) };
+		x += d.delta.x;
+		y += d.delta.y;
+		if (latest - getDeltaHistory(age + 1u).time >= window) break;
+	}
+	if (age + 1u == size) age--; // ran out of history; the oldest delta has no start
+	const int64_t span{ latest - getDeltaHistory(age + 1u).time };
+	if (span <= 0) return {};
+	const double seconds{ static_cast<double>(span) * 1e-9 };
+	return { static_cast<double>(x) / seconds, static_cast<double>(y) / seconds };
 }
 
 void Mouse::clearButtonStates() noexcept {
@@ -104,21 +169,8 @@ void Mouse::clearButtonStates() noexcept {
 	m_wheelDeltaAccumulator = 0;
 }
 
-inline void Mouse::manageQueueSize() {
-	// called before any event is inserted into queue,
-	// so only need to check once
-	if (m_eventQueue.size() == MAX_QUEUE_SIZE)
-		m_eventQueue.pop();
-}
-
-inline void Mouse::manageRawQueueSize() {
-	// called before any position delta is inserted into queue,
-	// so only need to check once
-	if (m_rawQueue.size() == MAX_QUEUE_SIZE)
-		m_rawQueue.pop();
-}
-
 void Mouse::buttonPressed(Mouse::Event::Button button, int x, int y) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::BUTTON_PRESSED, static_cast<uint8_t>(button), x, y);
 	switch (button) {
 	case Event::Button::LEFT:
 		m_leftPressed = true;
@@ -131,12 +183,12 @@ void Mouse::buttonPressed(Mouse::Event::Button button, int x, int y) {
 		break;
 	}
 	if (button != Event::Button::OTHER) {
-		manageQueueSize();
 		m_eventQueue.emplace(Event::Type::PRESSED, button, x, y);
 	}
 }
 
 void Mouse::buttonReleased(Mouse::Event::Button button, int x, int y) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::BUTTON_RELEASED, static_cast<uint8_t>(button), x, y);
 	switch (button) {
 	case Event::Button::LEFT:
 		m_leftPressed = false;
@@ -149,20 +201,20 @@ void Mouse::buttonReleased(Mouse::Event::Button button, int x, int y) {
 		break;
 	}
 	if (button != Event::Button::OTHER) {
-		manageQueueSize();
 		m_eventQueue.emplace(Event::Type::RELEASED, button, x, y);
 	}
 }
 
 void Mouse::buttonDoubleClicked(Mouse::Event::Button button, int x, int y) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::BUTTON_DOUBLECLICKED, static_cast<uint8_t>(button), x, y);
 	if (button != Event::Button::OTHER) {
-		manageQueueSize();
 		m_eventQueue.emplace(Event::Type::DOUBLECLICK, button, x, y);
 	}
 }
 
 void Mouse::scrolled(WPARAM packedDelta, int x, int y) {
 	int delta = GET_WHEEL_DELTA_WPARAM(packedDelta);
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::SCROLLED, 0u, x, y, delta);
 #ifndef NDEBUG
 	if (delta % WHEEL_DELTA != 0 && WHEEL_DELTA % delta != 0)
 		throw CWF_EXCEPTION(CwfException::Type::WINDOWS,
@@ -171,14 +223,12 @@ void Mouse::scrolled(WPARAM packedDelta, int x, int y) {
 	m_wheelDeltaAccumulator += delta;
 
 	while (m_wheelDeltaAccumulator >= WHEEL_DELTA) {
-		manageQueueSize();
 		m_eventQueue.emplace(Event::Type::SCROLL_UP,
 			Event::Button::MIDDLE, x, y);
 		m_wheelDeltaAccumulator -= WHEEL_DELTA;
 	}
 
 	while (m_wheelDeltaAccumulator <= -WHEEL_DELTA) {
-		manageQueueSize();
 		m_eventQueue.emplace(Event::Type::SCROLL_DOWN,
 			Event::Button::MIDDLE, x, y);
 		m_wheelDeltaAccumulator += WHEEL_DELTA;
@@ -186,28 +236,31 @@ void Mouse::scrolled(WPARAM packedDelta, int x, int y) {
 }
 
 void Mouse::moved(int x, int y) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::MOVED, 0u, x, y);
 	m_x = x;
 	m_y = y;
-	manageQueueSize();
 	m_eventQueue.emplace(Event::Type::MOVE, Event::Button::OTHER,
 		m_x, m_y);
 }
 
 void Mouse::entered(int x, int y) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::ENTERED, 0u, x, y);
 	m_inClientRegion = true;
-	manageQueueSize();
 	m_eventQueue.emplace(Event::Type::ENTER_CLIENT,
 		Event::Button::OTHER, x, y);
 }
 
 void Mouse::left(int x, int y) {
+	if (m_pRecorder) m_pRecorder->record(InputLog::Record::Type::LEFT, 0u, x, y);
 	m_inClientRegion = false;
-	manageQueueSize();
 	m_eventQueue.emplace(Event::Type::LEAVE_CLIENT,
 		Event::Button::OTHER, x, y);
 }
 
 void Mouse::raw(long dx, long dy) {
-	manageRawQueueSize();
+	m_rawAccumulator.fetch_add((static_cast<uint64_t>(static_cast<int64_t>(dy)) << 32u)
+		+ static_cast<uint64_t>(static_cast<int64_t>(dx)), std::memory_order_release);
+	if (m_pRecorder)
+		m_pRecorder->record(InputLog::Record::Type::RAW, 0u, static_cast<int32_t>(dx), static_cast<int32_t>(dy));
 	m_rawQueue.emplace(dx, dy);
 }
\ No newline at end of file
@@ -1,16 +1,23 @@
 #ifndef CWF_MOUSE_H
 #define CWF_MOUSE_H
  
+#include "InputLog.h"
+#include "SpscRing.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
-#include <queue>
 #include <utility>
 #include <Windows.h>
 
+class InputReplayer;
 class Window;
 
 class Mouse {
 public:
 	friend class Window;
+	friend class InputReplayer;
 	class Event {
 	public:
 		enum class Type {
@@ -40,8 +47,22 @@ public:
 		long x;
 		long y;
 	};
+
+	struct TimedDelta {
+		int64_t time; // steady_clock nanoseconds when it was consumed
+		PositionDelta delta; // since the previous one
+	};
+
+	struct Velocity {
+		double x; // counts per second
+		double y;
+	};
+
+	static constexpr size_t DELTA_HISTORY_SIZE = 64u;
 private:
-	static constexpr unsigned int MAX_QUEUE_SIZE = 16u;
+	static constexpr unsigned int QUEUE_CAPACITY = 64u;
+	static constexpr unsigned int RAW_QUEUE_CAPACITY = 256u; // raw deltas arrive at the mouse's polling rate
+	static std::atomic<unsigned int> s_rawInputCount; // mice with raw input enabled
 	bool m_leftPressed;
 	bool m_middlePressed;
 	bool m_rightPressed;
@@ -50,11 +71,17 @@ private:
 	int m_x;
 	int m_y;
 	int m_wheelDeltaAccumulator;
-	std::queue<Event> m_eventQueue;
-	std::queue<PositionDelta> m_rawQueue;
+	// filled by the message pump; may be polled from one other thread (see SpscRing.h), and drop new input when full
+	SpscRing<Event, QUEUE_CAPACITY> m_eventQueue;
+	SpscRing<PositionDelta, RAW_QUEUE_CAPACITY> m_rawQueue;
+	// every raw delta summed as it arrives, x in the low half and y in the high (see Mouse.cpp); never drops anything
+	std::atomic<uint64_t> m_rawAccumulator;
+	std::array<TimedDelta, DELTA_HISTORY_SIZE> m_deltaHistory; // consumer's; a ring of the latest consumed deltas
+	size_t m_deltaHistoryCount;
+	InputLog::Recorder* m_pRecorder; // set by Window::setInputRecorder
 public:
 	Mouse() noexcept;
-	~Mouse() = default;
+	~Mouse();
 	// no copy init/assign
 	Mouse(const Mouse& o) = delete;
 	Mouse& operator=(const Mouse& o) = delete;
@@ -71,19 +98,30 @@ public:
 	std::optional<Event> pollEventQueue();
 	bool isEventQueueEmpty() const noexcept;
 	void clearEventQueue();
+	uint64_t getEventOverflowCount() const noexcept; // events dropped because the queue was full
 
+	// fails while an InputThread is alive, since raw input registration is per process (see InputThread.h)
 	bool enableRawInput();
 	bool disableRawInput();
 	bool isRawInputEnabled() const noexcept;
+	static bool isAnyRawInputEnabled() noexcept;
 	std::optional<PositionDelta> pollRawQueue();
 	bool isRawQueueEmpty() const noexcept;
 	void clearRawQueue();
+	uint64_t getRawOverflowCount() const noexcept;
+
+	// the sum of every raw delta since the last call, in O(1) however many arrived, from one thread (like the raw queue);
+	// each call is kept, timestamped, in the delta history
+	PositionDelta consumeAccumulatedDelta() noexcept;
+	size_t getDeltaHistorySize() const noexcept;
+	TimedDelta getDeltaHistory(size_t age) const noexcept; // 0 is the latest
+	// motion over the consumed deltas of about the last window nanoseconds, whatever the frame or polling rate; scaled
+	// by a frame's duration it gives a smoothed delta, and by a time ahead a predicted one
+	Velocity getVelocity(int64_t window) const noexcept;
 
 	void clearButtonStates() noexcept;
 
 private:
-	inline void manageQueueSize();
-	inline void manageRawQueueSize();
 	void buttonPressed(Event::Button button, int x, int y);
 	void buttonReleased(Event::Button button, int x, int y);
 	void buttonDoubleClicked(Event::Button button, int x, int y);
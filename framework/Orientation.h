@@ -5,45 +5,73 @@
 
 namespace math = DirectX;
 
+/*
+* A rotation, kept as a unit quaternion. update() composes in a further roll-pitch-yaw rotation (applied after the
+* current one, like multiplying the matrix on the right) and renormalizes, so no matter how many updates accumulate
+* the rotation never drifts away from orthonormal (repeatedly multiplying a matrix does). The matrix is only built
+* when get() asks for it after a change.
+*/
+
 class Orientation {
 private:
-	math::XMFLOAT4X4 m_matrix;
+	math::XMFLOAT4 m_quaternion;
+	mutable math::XMFLOAT4X4 m_matrix;
+	mutable bool m_changed;
 public:
-	Orientation() noexcept : m_matrix{} {
-		math::XMStoreFloat4x4(&m_matrix,
-			math::XMMatrixIdentity()
-		);
-	}
-	Orientation(float xTheta, float yTheta, float zTheta) noexcept : m_matrix{} {
-		math::XMStoreFloat4x4(&m_matrix,
-			math::XMMatrixRotationRollPitchYaw(xTheta, yTheta, zTheta)
-		);
+	Orientation() noexcept : m_quaternion{ 0.0f, 0.0f, 0.0f, 1.0f }, m_matrix{}, m_changed{ true } {}
+	Orientation(float xTheta, float yTheta, float zTheta) noexcept : m_quaternion{}, m_matrix{}, m_changed{ true } {
+		set(xTheta, yTheta, zTheta);
 	}
 
 	void update(float xTheta, float yTheta, float zTheta) noexcept {
-		math::XMStoreFloat4x4(&m_matrix,
-			math::XMMatrixMultiply(
-				math::XMLoadFloat4x4(&m_matrix),
-				math::XMMatrixRotationRollPitchYaw(xTheta, yTheta, zTheta)
+		const math::XMVECTOR q{
+			math::XMQuaternionMultiply(
+				math::XMLoadFloat4(&m_quaternion),
+				math::XMQuaternionRotationRollPitchYaw(xTheta, yTheta, zTheta)
+			)
+		};
+		// the product of unit quaternions is off unit length by rounding only, so one Newton step, q * (3 - |q|^2) / 2,
+		// renormalizes it without the square root and divide of XMQuaternionNormalize
+		math::XMStoreFloat4(&m_quaternion,
+			math::XMVectorMultiply(q,
+				math::XMVectorNegativeMultiplySubtract(math::XMVectorReplicate(0.5f), math::XMQuaternionLengthSq(q), math::XMVectorReplicate(1.5f))
 			)
 		);
+		m_changed = true;
 	}
 
 	void set(float xTheta, float yTheta, float zTheta) noexcept {
-		math::XMStoreFloat4x4(&m_matrix,
-			math::XMMatrixRotationRollPitchYaw(xTheta, yTheta, zTheta)
+		math::XMStoreFloat4(&m_quaternion,
+			math::XMQuaternionRotationRollPitchYaw(xTheta, yTheta, zTheta)
 		);
+		m_changed = true;
 	}
 
 	void reset() noexcept {
-		math::XMStoreFloat4x4(&m_matrix,
-			math::XMMatrixIdentity()
+		math::XMStoreFloat4(&m_quaternion,
+			math::XMQuaternionIdentity()
 		);
+		m_changed = true;
 	}
 
 	math::XMMATRIX get() const noexcept {
+		if (m_changed) {
+			math::XMStoreFloat4x4(&m_matrix,
+				math::XMMatrixRotationQuaternion(math::XMLoadFloat4(&m_quaternion))
+			);
+			m_changed = false;
+		}
 		return math::XMLoadFloat4x4(&m_matrix);
 	}
+
+	math::XMVECTOR getQuaternion() const noexcept {
+		return math::XMLoadFloat4(&m_quaternion);
+	}
+
+	// v rotated, without building the matrix
+	math::XMVECTOR XM_CALLCONV rotate(math::FXMVECTOR v) const noexcept {
+		return math::XMVector3Rotate(v, math::XMLoadFloat4(&m_quaternion));
+	}
 };
 
 
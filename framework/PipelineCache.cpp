@@ -0,0 +1,129 @@
+#include "Graphics.h"
+#include "InputLayoutCache.h"
+#include "PipelineCache.h"
+#include <cstring>
+#include <d3d11.h>
+#include <utility>
+
+namespace {
+	// true if the cache holds the only reference
+	template <typename Object>
+	bool unused(const Microsoft::WRL::ComPtr<Object>& p) noexcept {
+		p->AddRef();
+		return p->Release() == 1u;
+	}
+
+	template <typename Map, typename Get>
+	size_t eraseUnused(Map& map, Get get) {
+		size_t released{ 0u };
+		for (auto it{ map.begin() }; it != map.end();) {
+			if (unused(get(it->second))) {
+				it = map.erase(it);
+				released++;
+			} else {
+				++it;
+			}
+		}
+		return released;
+	}
+
+	// looks the bytecode up in map, or makes a new entry with create(&pShader)
+	template <typename Object, typename Map, typename Create>
+	Microsoft::WRL::ComPtr<Object> findOrCreate(Map& map, PipelineCache::Counts& counts, const void* pByteCode, size_t length, Create create) {
+		const uint64_t key{ PipelineCache::hash(pByteCode, length) };
+		auto [first, last] = map.equal_range(key);
+		for (auto it{ first }; it != last; ++it) {
+			const auto& code{ it->second.byteCode };
+			if (code.size() == length && std::memcmp(code.data(), pByteCode, length) == 0) {
+				counts.hits++;
+				return it->second.pShader;
+			}
+		}
+		const std::byte* pBytes{ static_cast<const std::byte*>(pByteCode) };
+		typename Map::mapped_type entry{ { pBytes, pBytes + length }, nullptr };
+		create(&entry.pShader);
+		counts.misses++;
+		return map.emplace(key, std::move(entry))->second.pShader;
+	}
+}
+
+PipelineCache::PipelineCache() : m_vertexShaders{}, m_pixelShaders{}, m_samplers{}, m_inputLayouts{},
+	m_vertexShaderCounts{}, m_pixelShaderCounts{}, m_samplerCounts{} {}
+
+Microsoft::WRL::ComPtr<ID3D11VertexShader> PipelineCache::vertexShader(const Graphics& gfx, const void* pByteCode, size_t length) {
+	return findOrCreate<ID3D11VertexShader>(m_vertexShaders, m_vertexShaderCounts, pByteCode, length, [&](ID3D11VertexShader** ppShader) {
+		THROW_IF_FAILED(gfx, gfx.getDevice()->CreateVertexShader(pByteCode, length, nullptr, ppShader));
+	});
+}
+
+Microsoft::WRL::ComPtr<ID3D11PixelShader> PipelineCache::pixelShader(const Graphics& gfx, const void* pByteCode, size_t length) {
+	return findOrCreate<ID3D11PixelShader>(m_pixelShaders, m_pixelShaderCounts, pByteCode, length, [&](ID3D11PixelShader** ppShader) {
+		THROW_IF_FAILED(gfx, gfx.getDevice()->CreatePixelShader(pByteCode, length, nullptr, ppShader));
+	});
+}
+
+Microsoft::WRL::ComPtr<ID3D11InputLayout> PipelineCache::inputLayout(const Graphics& gfx, const D3D11_INPUT_ELEMENT_DESC* pDescs,
+	size_t count, const void* pShaderByteCode, size_t shaderLength) {
+	return m_inputLayouts.get(gfx, pDescs, count, pShaderByteCode, shaderLength);
+}
+
+Microsoft::WRL::ComPtr<ID3D11SamplerState> PipelineCache::sampler(const Graphics& gfx, const D3D11_SAMPLER_DESC& desc) {
+	// every member is 4 bytes, so there is no padding to trip up hashing and comparing the raw bytes
+	const uint64_t key{ hash(&desc, sizeof(desc)) };
+	auto [first, last] = m_samplers.equal_range(key);
+	for (auto it{ first }; it != last; ++it) {
+		if (std::memcmp(&it->second.desc, &desc, sizeof(desc)) == 0) {
+			m_samplerCounts.hits++;
+			return it->second.pSampler;
+		}
+	}
+	SamplerEntry entry{ desc, nullptr };
+	THROW_IF_FAILED(gfx, gfx.getDevice()->CreateSamplerState(&desc, &entry.pSampler));
+	m_samplerCounts.misses++;
+	return m_samplers.emplace(key, std::move(entry))->second.pSampler;
+}
+
+size_t PipelineCache::releaseUnused() {
+	return eraseUnused(m_vertexShaders, [](const ShaderEntry<ID3D11VertexShader>& e) -> const auto& { return e.pShader; })
+		+ eraseUnused(m_pixelShaders, [](const ShaderEntry<ID3D11PixelShader>& e) -> const auto& { return e.pShader; })
+		+ eraseUnused(m_samplers, [](const SamplerEntry& e) -> const auto& { return e.pSampler; })
+		+ m_inputLayouts.releaseUnused();
+}
+
+void PipelineCache::clear() noexcept {
+	m_vertexShaders.clear();
+	m_pixelShaders.clear();
+	m_samplers.clear();
+	m_inputLayouts.clear();
+}
+
+size_t PipelineCache::size() const noexcept {
+	return m_vertexShaders.size() + m_pixelShaders.size() + m_samplers.size() + m_inputLayouts.size();
+}
+
+PipelineCache::Stats PipelineCache::getStats() const noexcept {
+	const InputLayoutCache::Stats layouts{ m_inputLayouts.getStats() };
+	return { m_vertexShaderCounts, m_pixelShaderCounts, { layouts.hits, layouts.misses }, m_samplerCounts };
+}
+
+uint64_t PipelineCache::hash(const void* pBytes, size_t length) noexcept {
+	constexpr uint64_t MULTIPLIER{ 0x9E3779B97F4A7C15ull };
+	const unsigned char* p{ static_cast<const unsigned char*>(pBytes) };
+	uint64_t h{ length * MULTIPLIER };
+	auto mix = [](uint64_t x) {
+		x ^= x >> 33;
+		x *= 0xFF51AFD7ED558CCDull;
+		x ^= x >> 33;
+		return x;
+	};
+	size_t i{ 0u };
+	for (; i + 8u <= length; i += 8u) {
+		uint64_t word{};
+		std::memcpy(&word, p + i, sizeof(word));
+		h = (h ^ mix(word)) * MULTIPLIER;
+	}
+	uint64_t tail{};
+	std::memcpy(&tail, p + i, length - i);
+	h = (h ^ mix(tail)) * MULTIPLIER;
+	return mix(h);
+}
\ No newline at end of file
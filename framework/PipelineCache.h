@@ -0,0 +1,78 @@
+#ifndef CWF_PIPELINECACHE_H
+#define CWF_PIPELINECACHE_H
+
+#include "InputLayoutCache.h"
+#include <cstddef>
+#include <cstdint>
+#include <d3d11.h>
+#include <unordered_map>
+#include <vector>
+#include <wrl.h>
+
+class Graphics;
+
+/*
+* Content-addressed cache for the pipeline objects materials create: vertex and pixel shaders are keyed by a hash of
+* their bytecode, input layouts by their elements and shader input signature (see InputLayoutCache), and samplers by
+* their description. Identical requests get the same object back (a ComPtr, so it is shared and reference counted), so
+* hundreds of materials fed the same shader bytes compile it once.
+* Lookups compare the full bytecode/description after the hash matches, so collisions can't hand out the wrong object.
+* The cache holds a reference to everything it created; releaseUnused() drops the ones nobody else holds any more.
+* Owned by Graphics (see Graphics::getPipelineCache).
+*/
+
+class PipelineCache {
+public:
+	struct Counts {
+		size_t hits;
+		size_t misses; // i.e. objects created
+	};
+
+	struct Stats {
+		Counts vertexShaders;
+		Counts pixelShaders;
+		Counts inputLayouts;
+		Counts samplers;
+	};
+private:
+	template <typename Object>
+	struct ShaderEntry {
+		std::vector<std::byte> byteCode;
+		Microsoft::WRL::ComPtr<Object> pShader;
+	};
+
+	struct SamplerEntry {
+		D3D11_SAMPLER_DESC desc;
+		Microsoft::WRL::ComPtr<ID3D11SamplerState> pSampler;
+	};
+
+	std::unordered_multimap<uint64_t, ShaderEntry<ID3D11VertexShader>> m_vertexShaders;
+	std::unordered_multimap<uint64_t, ShaderEntry<ID3D11PixelShader>> m_pixelShaders;
+	std::unordered_multimap<uint64_t, SamplerEntry> m_samplers;
+	InputLayoutCache m_inputLayouts;
+	Counts m_vertexShaderCounts;
+	Counts m_pixelShaderCounts;
+	Counts m_samplerCounts;
+public:
+	PipelineCache();
+	~PipelineCache() = default;
+	// no copy init/assign
+	PipelineCache(const PipelineCache& o) = delete;
+	PipelineCache& operator=(const PipelineCache& o) = delete;
+
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader(const Graphics& gfx, const void* pByteCode, size_t length);
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader(const Graphics& gfx, const void* pByteCode, size_t length);
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout(const Graphics& gfx, const D3D11_INPUT_ELEMENT_DESC* pDescs, size_t count,
+		const void* pShaderByteCode, size_t shaderLength);
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler(const Graphics& gfx, const D3D11_SAMPLER_DESC& desc);
+
+	size_t releaseUnused(); // returns how many objects were released
+	void clear() noexcept;
+	size_t size() const noexcept;
+	Stats getStats() const noexcept;
+
+	// 64-bit hash of a byte range, 8 bytes at a time
+	static uint64_t hash(const void* pBytes, size_t length) noexcept;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "RawInputDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+RawInputDecoder::RawInputDecoder() noexcept : m_dx{ 0 }, m_dy{ 0 }, m_moved{ false }, m_packetCount{ 0u } {}
+
+void RawInputDecoder::decode(const std::byte* packet, size_t bytes) noexcept {
+	decodePacket(packet, bytes, NATIVE.headerSize);
+}
+
+size_t RawInputDecoder::decodeBuffer(const std::byte* data, size_t bytes, size_t count, Layout layout) noexcept {
+	size_t offset{ 0u };
+	size_t decoded{ 0u };
+	for (; decoded < count; decoded++) {
+		const size_t size{ packetSize(data, bytes, offset, layout) };
+		if (size == 0u) break; // a torn packet; nothing after it can be trusted
+		decodePacket(data + offset, size, layout.headerSize);
+		offset += (size + layout.alignment - 1u) & ~(layout.alignment - 1u); // NEXTRAWINPUTBLOCK
+		if (offset > bytes) offset = bytes;
+	}
+	return decoded;
+}
+
+size_t RawInputDecoder::filledBytes(const std::byte* data, size_t capacity, size_t count, Layout layout) noexcept {
+	size_t offset{ 0u };
+	size_t end{ 0u };
+	for (size_t i{ 0u }; i < count; i++) {
+		const size_t size{ packetSize(data, capacity, offset, layout) };
+		if (size == 0u) break;
+		end = offset + size;
+		offset += (size + layout.alignment - 1u) & ~(layout.alignment - 1u);
+		if (offset > capacity) offset = capacity;
+	}
+	return end;
+}
+
+std::optional<RawInputDecoder::Delta> RawInputDecoder::take() noexcept {
+	if (!m_moved) return std::nullopt;
+	const Delta delta{ m_dx, m_dy };
+	m_dx = 0;
+	m_dy = 0;
+	m_moved = false;
+	return delta;
+}
+
+uint64_t RawInputDecoder::getPacketCount() const noexcept {
+	return m_packetCount;
+}
+
+size_t RawInputDecoder::packetSize(const std::byte* data, size_t bytes, size_t offset, Layout layout) noexcept {
+	if (bytes - offset < layout.headerSize) return 0u;
+	uint32_t size{};
+	std::memcpy(&size, data + offset + offsetof(Header, size), sizeof(size)); // type and size sit first in either layout
+	return size < layout.headerSize || size > bytes - offset ? 0u : size;
+}
+
+void RawInputDecoder::decodePacket(const std::byte* packet, size_t bytes, size_t headerSize) noexcept {
+	if (bytes < headerSize) return;
+	m_packetCount++;
+	uint32_t type{};
+	std::memcpy(&type, packet + offsetof(Header, type), sizeof(type));
+	if (type != TYPE_MOUSE || bytes < headerSize + sizeof(Mouse)) return;
+
+	Mouse mouse{};
+	std::memcpy(&mouse, packet + headerSize, sizeof(mouse));
+	// absolute positions (tablets, remote desktop) are not deltas, and a packet can be only buttons or the wheel
+	if ((mouse.flags & MOVE_ABSOLUTE) || (mouse.lastX == 0 && mouse.lastY == 0)) return;
+	m_dx += mouse.lastX;
+	m_dy += mouse.lastY;
+	m_moved = true;
+}
\ No newline at end of file
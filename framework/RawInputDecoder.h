@@ -0,0 +1,77 @@
+#ifndef CWF_RAWINPUTDECODER_H
+#define CWF_RAWINPUTDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+/*
+* Decodes raw input packets, as GetRawInputData and GetRawInputBuffer write them, into relative mouse motion, coalesced
+* until take() hands it on (e.g. once per pass over the message queue, into Mouse's raw queue). Nothing is allocated:
+* the caller owns the buffer the packets were read into and can reuse it for every read.
+* Header and Mouse mirror RAWINPUTHEADER and RAWMOUSE field for field (Window.cpp checks this against the real ones), so
+* this knows nothing about Windows and can be fed recorded packets anywhere.
+* GetRawInputBuffer packs its packets one after the other, each aligned as NEXTRAWINPUTBLOCK expects; a 32-bit process
+* on 64-bit Windows gets the 64-bit header there (WOW64), so decodeBuffer takes the layout to walk. GetRawInputBuffer
+* only returns how many packets it wrote; filledBytes walks them to find where the last one ends.
+*/
+
+class RawInputDecoder {
+public:
+	struct Header { // RAWINPUTHEADER
+		uint32_t type;
+		uint32_t size; // of the whole packet, header included
+		void* device;
+		uintptr_t wParam;
+	};
+
+	struct Mouse { // RAWMOUSE
+		uint16_t flags;
+		uint16_t padding;
+		uint16_t buttonFlags;
+		uint16_t buttonData;
+		uint32_t rawButtons;
+		int32_t lastX;
+		int32_t lastY;
+		uint32_t extraInformation;
+	};
+
+	struct Layout {
+		size_t headerSize;
+		size_t alignment;
+	};
+
+	struct Delta {
+		long x;
+		long y;
+	};
+
+	static constexpr uint32_t TYPE_MOUSE{ 0u }; // RIM_TYPEMOUSE
+	static constexpr uint16_t MOVE_ABSOLUTE{ 0x01u }; // MOUSE_MOVE_ABSOLUTE
+	static constexpr Layout NATIVE{ sizeof(Header), alignof(Header) };
+	static constexpr Layout WOW64{ 24u, 8u };
+private:
+	long m_dx;
+	long m_dy;
+	bool m_moved;
+	uint64_t m_packetCount;
+public:
+	RawInputDecoder() noexcept;
+	~RawInputDecoder() = default;
+	// no copy init/assign
+	RawInputDecoder(const RawInputDecoder& o) = delete;
+	RawInputDecoder& operator=(const RawInputDecoder& o) = delete;
+
+	void decode(const std::byte* packet, size_t bytes) noexcept; // one packet, as GetRawInputData writes it
+	// bytes is how much of data holds packets, not its capacity; returns how many whole packets were decoded
+	size_t decodeBuffer(const std::byte* data, size_t bytes, size_t count, Layout layout = NATIVE) noexcept;
+	// where the first count packets in data (at most capacity bytes) end; a torn packet ends the walk
+	static size_t filledBytes(const std::byte* data, size_t capacity, size_t count, Layout layout = NATIVE) noexcept;
+	std::optional<Delta> take() noexcept; // the motion since the last take, if there was any
+	uint64_t getPacketCount() const noexcept;
+private:
+	static size_t packetSize(const std::byte* data, size_t bytes, size_t offset, Layout layout) noexcept; // 0 if torn
+	void decodePacket(const std::byte* packet, size_t bytes, size_t headerSize) noexcept;
+};
+
+#endif
\ No newline at end of file
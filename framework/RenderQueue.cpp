@@ -0,0 +1,105 @@
+#include "RenderQueue.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+RenderQueue::RenderQueue() : m_submissions{}, m_entries{}, m_scratch{}, m_ids{}, m_stats{}, m_sorted{ true } {}
+
+uint16_t RenderQueue::idFor(uint64_t state) {
+	// past 65536 distinct states ids wrap around; that only makes the sort group less well, since skipping
+	// compares the full state values instead of ids
+	auto [it, inserted] = m_ids.try_emplace(state, static_cast<uint16_t>(m_ids.size()));
+	return it->second;
+}
+
+uint16_t RenderQueue::idFor(const void* pState) {
+	return idFor(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pState)));
+}
+
+void RenderQueue::submit(uint64_t key, const void* pObject, DrawFunction draw, uint64_t pipelineState, uint64_t textureState) {
+	m_entries.push_back({ key, static_cast<uint32_t>(m_submissions.size()) });
+	m_submissions.push_back({ pObject, draw, pipelineState, textureState });
+	m_sorted = false;
+}
+
+void RenderQueue::sort() {
+	if (m_sorted) return;
+	radixSort(m_entries, m_scratch);
+	m_sorted = true;
+}
+
+void RenderQueue::execute(const Graphics& gfx, const ConstantBufferRing& ring) {
+	sort();
+	m_stats = { m_entries.size(), 0u, 0u };
+	const Submission* pPrevious{ nullptr };
+	for (const Entry& e : m_entries) {
+		const Submission& s{ m_submissions[e.submission] };
+		unsigned skip{ SKIP_NONE };
+		if (pPrevious && s.pipelineState != 0u && s.pipelineState == pPrevious->pipelineState)
+			skip |= SKIP_PIPELINE;
+		else
+			m_stats.pipelineBinds++;
+		if (pPrevious && s.textureState != 0u && s.textureState == pPrevious->textureState)
+			skip |= SKIP_TEXTURE;
+		else
+			m_stats.textureBinds++;
+		s.draw(s.pObject, gfx, ring, skip);
+		pPrevious = &s;
+	}
+}
+
+void RenderQueue::clear() noexcept {
+	m_submissions.clear();
+	m_entries.clear();
+	m_sorted = true;
+}
+
+size_t RenderQueue::size() const noexcept {
+	return m_entries.size();
+}
+
+const std::vector<RenderQueue::Entry>& RenderQueue::entries() const noexcept {
+	return m_entries;
+}
+
+RenderQueue::Stats RenderQueue::getStats() const noexcept {
+	return m_stats;
+}
+
+void RenderQueue::radixSort(std::vector<Entry>& entries, std::vector<Entry>& scratch) {
+	constexpr unsigned PASSES{ sizeof(uint64_t) };
+	constexpr size_t BUCKETS{ 256u };
+	const size_t n{ entries.size() };
+	if (n < 2u) return;
+	scratch.resize(n);
+
+	// every histogram in one read of the keys
+	std::array<std::array<size_t, BUCKETS>, PASSES> histograms{};
+	for (const Entry& e : entries) {
+		for (unsigned pass{ 0u }; pass < PASSES; pass++)
+			histograms[pass][(e.key >> (pass * 8u)) & 0xFFu]++;
+	}
+
+	Entry* pSrc{ entries.data() };
+	Entry* pDst{ scratch.data() };
+	for (unsigned pass{ 0u }; pass < PASSES; pass++) {
+		std::array<size_t, BUCKETS>& histogram{ histograms[pass] };
+		const unsigned shift{ pass * 8u };
+		if (histogram[(pSrc[0].key >> shift) & 0xFFu] == n) continue; // every key has this byte, nothing to do
+
+		size_t offset{ 0u };
+		for (size_t& count : histogram) { // counts -> starting offsets
+			const size_t c{ count };
+			count = offset;
+			offset += c;
+		}
+		for (size_t i{ 0u }; i < n; i++)
+			pDst[histogram[(pSrc[i].key >> shift) & 0xFFu]++] = pSrc[i];
+		std::swap(pSrc, pDst);
+	}
+
+	if (pSrc != entries.data()) // an odd number of passes ran, so the result is in scratch
+		entries.swap(scratch);
+}
\ No newline at end of file
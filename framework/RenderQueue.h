@@ -0,0 +1,123 @@
+#ifndef CWF_RENDERQUEUE_H
+#define CWF_RENDERQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class ConstantBufferRing;
+class Graphics;
+
+/*
+* Collects a frame's draws, sorts them once, then draws them in order.
+* Each submission carries a 64-bit sort key (see SortKey), so draws end up grouped by layer, then by shader state,
+* then by texture, then front to back (which lets early-Z reject hidden pixels).
+* While drawing, consecutive submissions that share pipeline state or texture are told to skip rebinding it.
+* Sorting is an LSD radix sort over the keys, so a frame costs O(submissions); the queue keeps its memory between
+* frames, so steady-state frames don't allocate.
+* Objects are drawn through a plain function pointer (see Material::submit), so the queue knows nothing about them.
+*/
+
+class RenderQueue {
+public:
+	// bits passed to a DrawFunction: state that is already bound by the previous submission
+	enum Skip : unsigned {
+		SKIP_NONE = 0u,
+		SKIP_PIPELINE = 1u << 0, // shaders, input layout, topology, render target and viewport
+		SKIP_TEXTURE = 1u << 1 // shader resource view and sampler
+	};
+
+	using DrawFunction = void(*)(const void* pObject, const Graphics& gfx, const ConstantBufferRing& ring, unsigned skip);
+
+	// layer (8 bits) | shader id (16 bits) | texture id (16 bits) | quantized depth (24 bits), most significant first
+	struct SortKey {
+		static constexpr unsigned DEPTH_BITS{ 24u };
+		static constexpr unsigned TEXTURE_BITS{ 16u };
+		static constexpr unsigned SHADER_BITS{ 16u };
+		static constexpr unsigned LAYER_BITS{ 8u };
+		static constexpr unsigned TEXTURE_SHIFT{ DEPTH_BITS };
+		static constexpr unsigned SHADER_SHIFT{ TEXTURE_SHIFT + TEXTURE_BITS };
+		static constexpr unsigned LAYER_SHIFT{ SHADER_SHIFT + SHADER_BITS };
+		static constexpr uint32_t MAX_DEPTH{ (1u << DEPTH_BITS) - 1u };
+
+		// depth is normalized to [0, 1] (e.g. view-space distance / far plane); values outside are clamped
+		static constexpr uint32_t quantizeDepth(float depth) noexcept {
+			if (!(depth > 0.0f)) return 0u; // also catches NaN
+			if (depth >= 1.0f) return MAX_DEPTH;
+			return static_cast<uint32_t>(depth * static_cast<float>(MAX_DEPTH));
+		}
+
+		static constexpr uint64_t make(uint8_t layer, uint16_t shader, uint16_t texture, float depth) noexcept {
+			return (static_cast<uint64_t>(layer) << LAYER_SHIFT)
+				| (static_cast<uint64_t>(shader) << SHADER_SHIFT)
+				| (static_cast<uint64_t>(texture) << TEXTURE_SHIFT)
+				| static_cast<uint64_t>(quantizeDepth(depth));
+		}
+
+		static constexpr uint8_t layer(uint64_t key) noexcept {
+			return static_cast<uint8_t>(key >> LAYER_SHIFT);
+		}
+
+		static constexpr uint16_t shader(uint64_t key) noexcept {
+			return static_cast<uint16_t>(key >> SHADER_SHIFT);
+		}
+
+		static constexpr uint16_t texture(uint64_t key) noexcept {
+			return static_cast<uint16_t>(key >> TEXTURE_SHIFT);
+		}
+
+		static constexpr uint32_t depth(uint64_t key) noexcept {
+			return static_cast<uint32_t>(key & MAX_DEPTH);
+		}
+	};
+
+	struct Entry {
+		uint64_t key;
+		uint32_t submission; // index into the submission list
+	};
+
+	struct Stats {
+		size_t submissions;
+		size_t pipelineBinds;
+		size_t textureBinds;
+	};
+private:
+	struct Submission {
+		const void* pObject;
+		DrawFunction draw;
+		uint64_t pipelineState; // exact state identity (0 if unknown); the 16-bit ids in the key are only for ordering
+		uint64_t textureState;
+	};
+
+	std::vector<Submission> m_submissions;
+	std::vector<Entry> m_entries;
+	std::vector<Entry> m_scratch;
+	std::unordered_map<uint64_t, uint16_t> m_ids;
+	Stats m_stats;
+	bool m_sorted;
+public:
+	RenderQueue();
+	~RenderQueue() = default;
+	// no copy init/assign
+	RenderQueue(const RenderQueue& o) = delete;
+	RenderQueue& operator=(const RenderQueue& o) = delete;
+
+	// small, stable id for a piece of state (e.g. a shader or texture pointer); ids are handed out in first-seen order
+	uint16_t idFor(uint64_t state);
+	uint16_t idFor(const void* pState);
+
+	void submit(uint64_t key, const void* pObject, DrawFunction draw, uint64_t pipelineState = 0u, uint64_t textureState = 0u);
+	void sort();
+	void execute(const Graphics& gfx, const ConstantBufferRing& ring); // sorts first if needed
+	void clear() noexcept;
+
+	size_t size() const noexcept;
+	const std::vector<Entry>& entries() const noexcept;
+	Stats getStats() const noexcept; // from the last execute
+
+	// stable LSD radix sort on Entry::key, one byte per pass; passes where every key has the same byte are skipped
+	static void radixSort(std::vector<Entry>& entries, std::vector<Entry>& scratch);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef CWF_RINGALLOCATOR_H
+#define CWF_RINGALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Bookkeeping for a ring buffer that is suballocated linearly each frame; it only hands out offsets, so it knows
+* nothing about DirectX (see ConstantBufferRing for the GPU side).
+* Every allocation is aligned (256 bytes by default, what constant buffer offsets need). When the end of the ring is
+* too small for an allocation, the rest of the ring is skipped and the allocation wraps to the front.
+* Memory is reclaimed a whole frame at a time: endFrame(fence) tags everything allocated since the last endFrame
+* with a fence value, and retire(completed) frees every frame whose fence is <= completed. Fences must increase.
+*/
+
+class RingAllocator {
+public:
+	static constexpr size_t DEFAULT_ALIGNMENT{ 256u };
+	static constexpr size_t INVALID_OFFSET{ SIZE_MAX };
+private:
+	struct FrameMarker {
+		uint64_t fence;
+		size_t head; // where the frame's allocations ended
+		size_t size; // bytes the frame consumed, including space skipped by wrapping
+	};
+
+	size_t m_capacity;
+	size_t m_alignment;
+	size_t m_head; // next free byte
+	size_t m_tail; // oldest byte still in use
+	size_t m_used;
+	size_t m_frameSize;
+	std::vector<FrameMarker> m_frames; // oldest first; only ever as long as the number of frames in flight
+public:
+	RingAllocator(size_t capacity, size_t alignment = DEFAULT_ALIGNMENT) noexcept
+		: m_capacity{ capacity }, m_alignment{ alignment }, m_head{ 0u }, m_tail{ 0u },
+		m_used{ 0u }, m_frameSize{ 0u }, m_frames{} {}
+
+	static constexpr size_t alignUp(size_t value, size_t alignment) noexcept {
+		return (value + alignment - 1u) / alignment * alignment; // alignment need not be a power of two
+	}
+
+	// returns the offset of the allocation, or INVALID_OFFSET if there is no room until older frames retire
+	size_t allocate(size_t size) noexcept {
+		const size_t aligned{ alignUp(size, m_alignment) };
+		if (aligned == 0u || aligned > m_capacity) return INVALID_OFFSET;
+
+		if (m_used == 0u) { // nothing in flight, so start over at the front instead of fragmenting
+			m_head = 0u;
+			m_tail = 0u;
+		}
+
+		size_t offset{ INVALID_OFFSET };
+		size_t consumed{ aligned };
+		if (m_head > m_tail || m_used == 0u) { // free space is [head, capacity) and [0, tail)
+			if (m_capacity - m_head >= aligned) {
+				offset = m_head;
+			} else if (m_tail >= aligned) { // wrap, wasting the end of the ring
+				consumed += m_capacity - m_head;
+				offset = 0u;
+			}
+		} else if (m_tail - m_head >= aligned) { // free space is [head, tail)
+			offset = m_head;
+		}
+		if (offset == INVALID_OFFSET) return INVALID_OFFSET;
+
+		m_head = offset + aligned;
+		if (m_head == m_capacity) m_head = 0u;
+		m_used += consumed;
+		m_frameSize += consumed;
+		return offset;
+	}
+
+	void endFrame(uint64_t fence) {
+		if (m_frameSize == 0u) return; // nothing to wait on
+		m_frames.push_back({ fence, m_head, m_frameSize });
+		m_frameSize = 0u;
+	}
+
+	// frees every frame whose fence has completed
+	void retire(uint64_t completedFence) noexcept {
+		size_t retired{ 0u };
+		while (retired < m_frames.size() && m_frames[retired].fence <= completedFence) {
+			m_tail = m_frames[retired].head;
+			m_used -= m_frames[retired].size;
+			retired++;
+		}
+		m_frames.erase(m_frames.begin(), m_frames.begin() + retired);
+	}
+
+	// forgets every allocation, e.g. after the backing buffer was replaced by a bigger one
+	void reset(size_t capacity) noexcept {
+		m_capacity = capacity;
+		m_head = 0u;
+		m_tail = 0u;
+		m_used = 0u;
+		m_frameSize = 0u;
+		m_frames.clear();
+	}
+
+	size_t getCapacity() const noexcept {
+		return m_capacity;
+	}
+
+	size_t getAlignment() const noexcept {
+		return m_alignment;
+	}
+
+	size_t getUsed() const noexcept {
+		return m_used;
+	}
+
+	size_t getFramesInFlight() const noexcept {
+		return m_frames.size();
+	}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "SceneGraph.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace math = DirectX;
+
+SceneGraph::SceneGraph() noexcept
+	: m_local{}, m_world{}, m_parent{}, m_depth{}, m_dirty{}, m_changed{}, m_nodeAt{}, m_indexOf{}, m_free{},
+	m_firstDirty{ 0u }, m_firstChanged{ 0u }, m_unsorted{ false } {}
+
+SceneGraph::Node XM_CALLCONV SceneGraph::create(Node parent, math::FXMMATRIX local) {
+	Node node{};
+	if (m_free.empty()) {
+		node = static_cast<Node>(m_indexOf.size());
+		m_indexOf.push_back(NONE);
+	} else {
+		node = m_free.back();
+		m_free.pop_back();
+	}
+	const uint32_t parentIndex{ parent == NONE ? NONE : m_indexOf[parent] };
+	const uint32_t depth{ parentIndex == NONE ? 0u : m_depth[parentIndex] + 1u };
+	if (!m_depth.empty() && m_depth.back() > depth)
+		m_unsorted = true; // still after its parent, but no longer in depth order
+
+	const size_t index{ m_local.size() };
+	math::XMFLOAT4X4 world{};
+	math::XMStoreFloat4x4(&world,
+		parentIndex == NONE ? local : math::XMMatrixMultiply(local, math::XMLoadFloat4x4(&m_world[parentIndex]))
+	);
+	m_local.emplace_back();
+	math::XMStoreFloat4x4(&m_local.back(), local);
+	m_world.push_back(world);
+	m_parent.push_back(parentIndex);
+	m_depth.push_back(depth);
+	m_dirty.push_back(0u);
+	m_changed.push_back(0u);
+	m_nodeAt.push_back(node);
+	m_indexOf[node] = static_cast<uint32_t>(index);
+	markDirty(index); // the world above is only as current as the parent's
+	return node;
+}
+
+void SceneGraph::destroy(Node node) {
+	if (!contains(node)) return;
+	if (m_unsorted) sort(); // descendants must come after their ancestors for the pass below
+	const size_t first{ m_indexOf[node] };
+	const size_t count{ m_local.size() };
+
+	std::vector<uint8_t> removed(count, 0u);
+	std::vector<uint32_t> newIndex(count, NONE);
+	removed[first] = 1u;
+	size_t kept{ first };
+	for (size_t i{ first }; i < count; i++) {
+		if (i > first && m_parent[i] != NONE) removed[i] = removed[m_parent[i]];
+		if (removed[i]) {
+			m_indexOf[m_nodeAt[i]] = NONE;
+			m_free.push_back(m_nodeAt[i]);
+			continue;
+		}
+		// the order of what is left does not change, so it stays sorted; parents are remapped once everything moved
+		m_local[kept] = m_local[i];
+		m_world[kept] = m_world[i];
+		m_parent[kept] = m_parent[i];
+		m_depth[kept] = m_depth[i];
+		m_dirty[kept] = m_dirty[i];
+		m_changed[kept] = m_changed[i];
+		m_nodeAt[kept] = m_nodeAt[i];
+		m_indexOf[m_nodeAt[kept]] = static_cast<uint32_t>(kept);
+		newIndex[i] = static_cast<uint32_t>(kept);
+		kept++;
+	}
+	for (size_t i{ first }; i < kept; i++) {
+		if (m_parent[i] != NONE && m_parent[i] >= first)
+			m_parent[i] = newIndex[m_parent[i]];
+	}
+	m_local.resize(kept);
+	m_world.resize(kept);
+	m_parent.resize(kept);
+	m_depth.resize(kept);
+	m_dirty.resize(kept);
+	m_changed.resize(kept);
+	m_nodeAt.resize(kept);
+	m_firstDirty = std::min(m_firstDirty, first);
+	m_firstChanged = std::min(m_firstChanged, first);
+}
+
+bool SceneGraph::setParent(Node node, Node parent) {
+	const uint32_t index{ m_indexOf[node] };
+	const uint32_t parentIndex{ parent == NONE ? NONE : m_indexOf[parent] };
+	for (uint32_t ancestor{ parentIndex }; ancestor != NONE; ancestor = m_parent[ancestor]) {
+		if (ancestor == index) return false;
+	}
+	m_parent[index] = parentIndex;
+	m_unsorted = true; // its subtree's depths changed with it
+	markDirty(index);
+	return true;
+}
+
+SceneGraph::Node SceneGraph::getParent(Node node) const noexcept {
+	const uint32_t parentIndex{ m_parent[m_indexOf[node]] };
+	return parentIndex == NONE ? NONE : m_nodeAt[parentIndex];
+}
+
+bool SceneGraph::contains(Node node) const noexcept {
+	return node < m_indexOf.size() && m_indexOf[node] != NONE;
+}
+
+size_t SceneGraph::size() const noexcept {
+	return m_local.size();
+}
+
+void SceneGraph::clear() noexcept {
+	m_local.clear();
+	m_world.clear();
+	m_parent.clear();
+	m_depth.clear();
+	m_dirty.clear();
+	m_changed.clear();
+	m_nodeAt.clear();
+	m_indexOf.clear();
+	m_free.clear();
+	m_firstDirty = 0u;
+	m_firstChanged = 0u;
+	m_unsorted = false;
+}
+
+void XM_CALLCONV SceneGraph::setLocal(Node node, math::FXMMATRIX local) noexcept {
+	const uint32_t index{ m_indexOf[node] };
+	math::XMStoreFloat4x4(&m_local[index], local);
+	markDirty(index);
+}
+
+math::XMMATRIX SceneGraph::getLocal(Node node) const noexcept {
+	return math::XMLoadFloat4x4(&m_local[m_indexOf[node]]);
+}
+
+math::XMMATRIX SceneGraph::getWorld(Node node) const noexcept {
+	return math::XMLoadFloat4x4(&m_world[m_indexOf[node]]);
+}
+
+bool SceneGraph::hasWorldChanged(Node node) const noexcept {
+	return m_changed[m_indexOf[node]] != 0u;
+}
+
+size_t SceneGraph::update() {
+	if (m_unsorted) sort();
+	const size_t count{ m_local.size() };
+	const size_t first{ std::min(m_firstDirty, count) };
+	// the last update's flags before this one's first node would otherwise linger; from there on, all are rewritten
+	if (m_firstChanged < first)
+		std::fill(m_changed.begin() + m_firstChanged, m_changed.begin() + first, uint8_t{ 0u });
+	m_firstChanged = first;
+
+	size_t recomputed{ 0u };
+	for (size_t i{ first }; i < count; i++) {
+		const uint32_t parent{ m_parent[i] };
+		const bool changed{ m_dirty[i] || (parent != NONE && m_changed[parent]) };
+		m_changed[i] = changed ? 1u : 0u;
+		if (!changed) continue;
+		math::XMMATRIX world{ math::XMLoadFloat4x4(&m_local[i]) };
+		if (parent != NONE)
+			world = math::XMMatrixMultiply(world, math::XMLoadFloat4x4(&m_world[parent]));
+		math::XMStoreFloat4x4(&m_world[i], world);
+		m_dirty[i] = 0u;
+		recomputed++;
+	}
+	m_firstDirty = count;
+	return recomputed;
+}
+
+std::span<const math::XMFLOAT4X4> SceneGraph::getWorlds() const noexcept {
+	return m_world;
+}
+
+size_t SceneGraph::getIndex(Node node) const noexcept {
+	return m_indexOf[node];
+}
+
+void SceneGraph::markDirty(size_t index) noexcept {
+	m_dirty[index] = 1u;
+	m_firstDirty = std::min(m_firstDirty, index);
+}
+
+void SceneGraph::sort() {
+	const size_t count{ m_local.size() };
+
+	// depths from scratch, since setParent moves whole subtrees; each node is walked to once
+	std::vector<uint32_t> depth(count, NONE);
+	std::vector<uint32_t> path{};
+	uint32_t maxDepth{ 0u };
+	for (size_t i{ 0u }; i < count; i++) {
+		uint32_t ancestor{ static_cast<uint32_t>(i) };
+		while (ancestor != NONE && depth[ancestor] == NONE) {
+			path.push_back(ancestor);
+			ancestor = m_parent[ancestor];
+		}
+		uint32_t d{ ancestor == NONE ? 0u : depth[ancestor] + 1u };
+		for (size_t p{ path.size() }; p-- > 0u; d++)
+			depth[path[p]] = d;
+		path.clear();
+		maxDepth = std::max(maxDepth, depth[i]);
+	}
+
+	// counting sort by depth; stable, so siblings keep their relative order
+	std::vector<uint32_t> start(static_cast<size_t>(maxDepth) + 2u, 0u);
+	for (uint32_t d : depth)
+		start[d + 1u]++;
+	for (size_t d{ 1u }; d < start.size(); d++)
+		start[d] += start[d - 1u];
+	std::vector<uint32_t> newIndex(count);
+	for (size_t i{ 0u }; i < count; i++)
+		newIndex[i] = start[depth[i]]++;
+
+	auto permute = [&newIndex](auto& values) {
+		std::remove_reference_t<decltype(values)> sorted(values.size());
+		for (size_t i{ 0u }; i < values.size(); i++)
+			sorted[newIndex[i]] = values[i];
+		values.swap(sorted);
+	};
+	permute(m_local);
+	permute(m_world);
+	permute(m_parent);
+	permute(m_dirty);
+	permute(m_changed);
+	permute(m_nodeAt);
+	m_depth.resize(count);
+	for (size_t i{ 0u }; i < count; i++) {
+		m_depth[newIndex[i]] = depth[i];
+		if (m_parent[i] != NONE) m_parent[i] = newIndex[m_parent[i]];
+		m_indexOf[m_nodeAt[i]] = static_cast<uint32_t>(i);
+	}
+
+	m_firstDirty = static_cast<size_t>(std::find(m_dirty.begin(), m_dirty.end(), uint8_t{ 1u }) - m_dirty.begin());
+	m_firstChanged = 0u; // the flags moved around
+	m_unsorted = false;
+}
\ No newline at end of file
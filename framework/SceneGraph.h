@@ -0,0 +1,71 @@
+#ifndef CWF_SCENEGRAPH_H
+#define CWF_SCENEGRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace math = DirectX;
+
+/*
+* A transform hierarchy: each node has a local transform, relative to its parent, and a world transform, local times
+* the parent's world. Nodes live in flat arrays (local, world, parent, flags), sorted so that every parent comes before
+* its children (by depth), so update() is one forward pass in which each node only looks at its own entry and its
+* parent's, already finished. Setting a local transform flags the node; the pass recomputes flagged nodes and every
+* node whose parent was recomputed, and skips the rest with a byte compare, starting at the first flagged node, so
+* a frame in which nothing moved costs nothing and one in which a leaf moved costs one multiply.
+* Nodes are known by handles, which stay valid until the node is destroyed; their position in the arrays (getIndex)
+* changes when setParent or destroy re-sort them, so getWorlds() can be handed to BatchTransform as is, indexed by
+* getIndex. Matrices are row-major, applied to row vectors (DirectXMath's convention), world = local * parent's world.
+*/
+
+class SceneGraph {
+public:
+	using Node = uint32_t;
+
+	static constexpr Node NONE{ std::numeric_limits<Node>::max() };
+private:
+	std::vector<math::XMFLOAT4X4> m_local; // the rest by position in the depth order
+	std::vector<math::XMFLOAT4X4> m_world;
+	std::vector<uint32_t> m_parent; // NONE for roots
+	std::vector<uint32_t> m_depth;
+	std::vector<uint8_t> m_dirty; // local transform set since the last update
+	std::vector<uint8_t> m_changed; // world recomputed by the last update
+	std::vector<Node> m_nodeAt;
+	std::vector<uint32_t> m_indexOf; // by handle; NONE for free handles
+	std::vector<Node> m_free;
+	size_t m_firstDirty; // where the next update starts
+	size_t m_firstChanged; // m_changed is 0 before this
+	bool m_unsorted; // a node comes before its parent or after a deeper node
+public:
+	SceneGraph() noexcept;
+	~SceneGraph() = default;
+
+	Node XM_CALLCONV create(Node parent = NONE, math::FXMMATRIX local = math::XMMatrixIdentity());
+	void destroy(Node node); // and all of its descendants
+	bool setParent(Node node, Node parent); // false (and nothing changes) if parent is node or one of its descendants
+	Node getParent(Node node) const noexcept;
+	bool contains(Node node) const noexcept;
+	size_t size() const noexcept;
+	void clear() noexcept;
+
+	void XM_CALLCONV setLocal(Node node, math::FXMMATRIX local) noexcept;
+	math::XMMATRIX getLocal(Node node) const noexcept;
+	math::XMMATRIX getWorld(Node node) const noexcept; // as of the last update
+	bool hasWorldChanged(Node node) const noexcept; // by the last update
+
+	// recomputes the world transforms that are out of date; returns how many were
+	size_t update();
+
+	// every world transform, by getIndex; valid until the next create, destroy or update
+	std::span<const math::XMFLOAT4X4> getWorlds() const noexcept;
+	size_t getIndex(Node node) const noexcept;
+private:
+	void markDirty(size_t index) noexcept;
+	void sort();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,477 @@
+#include "SceneIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace {
+	constexpr SceneIndex::Aabb EMPTY{
+		{ SceneIndex::NO_LIMIT, SceneIndex::NO_LIMIT, SceneIndex::NO_LIMIT },
+		{ -SceneIndex::NO_LIMIT, -SceneIndex::NO_LIMIT, -SceneIndex::NO_LIMIT }
+	};
+	constexpr size_t STACK_SIZE{ SceneIndex::MAX_DEPTH + 2u }; // depth-first traversals keep at most one sibling per level
+
+	inline void grow(SceneIndex::Aabb& box, const SceneIndex::Aabb& other) noexcept {
+		for (size_t a{ 0u }; a < 3u; a++) {
+			box.min[a] = std::min(box.min[a], other.min[a]);
+			box.max[a] = std::max(box.max[a], other.max[a]);
+		}
+	}
+
+	inline bool isEmpty(const SceneIndex::Aabb& box) noexcept {
+		return box.min[0] > box.max[0];
+	}
+
+	inline bool equal(const SceneIndex::Aabb& a, const SceneIndex::Aabb& b) noexcept {
+		for (size_t i{ 0u }; i < 3u; i++) {
+			if (a.min[i] != b.min[i] || a.max[i] != b.max[i]) return false;
+		}
+		return true;
+	}
+
+	// half the surface area, which is all the heuristic needs
+	inline float area(const SceneIndex::Aabb& box) noexcept {
+		if (isEmpty(box)) return 0.0f;
+		const float x{ box.max[0] - box.min[0] };
+		const float y{ box.max[1] - box.min[1] };
+		const float z{ box.max[2] - box.min[2] };
+		return x * y + y * z + z * x;
+	}
+
+	inline bool overlap(const SceneIndex::Aabb& a, const SceneIndex::Aabb& b) noexcept {
+		for (size_t i{ 0u }; i < 3u; i++) {
+			if (a.max[i] < b.min[i] || b.max[i] < a.min[i]) return false;
+		}
+		return true;
+	}
+
+	enum class Side {
+		OUTSIDE, CROSSING, INSIDE
+	};
+
+	inline Side classify(const Culling::Plane& p, const SceneIndex::Aabb& box) noexcept {
+		const float cx{ 0.5f * (box.min[0] + box.max[0]) };
+		const float cy{ 0.5f * (box.min[1] + box.max[1]) };
+		const float cz{ 0.5f * (box.min[2] + box.max[2]) };
+		const float reach{ 0.5f * (std::abs(p.x) * (box.max[0] - box.min[0]) + std::abs(p.y) * (box.max[1] - box.min[1])
+			+ std::abs(p.z) * (box.max[2] - box.min[2])) };
+		const float d{ p.x * cx + p.y * cy + p.z * cz + p.w };
+		if (d < -reach) return Side::OUTSIDE;
+		return d >= reach ? Side::INSIDE : Side::CROSSING;
+	}
+
+	// the ray in the form the slab test wants it
+	struct Slabs {
+		float origin[3];
+		float inverse[3];
+		bool negative[3];
+
+		explicit Slabs(const SceneIndex::Ray& ray) noexcept : origin{}, inverse{}, negative{} {
+			for (size_t a{ 0u }; a < 3u; a++) {
+				origin[a] = ray.origin[a];
+				inverse[a] = 1.0f / ray.direction[a];
+				negative[a] = std::signbit(ray.direction[a]);
+			}
+		}
+
+		// where the ray enters box, if it does within [0, limit]; an empty box is never entered
+		bool enter(const SceneIndex::Aabb& box, float limit, float& distance) const noexcept {
+			float tNear{ 0.0f };
+			float tFar{ limit };
+			for (size_t a{ 0u }; a < 3u; a++) {
+				const float t0{ ((negative[a] ? box.max[a] : box.min[a]) - origin[a]) * inverse[a] };
+				const float t1{ ((negative[a] ? box.min[a] : box.max[a]) - origin[a]) * inverse[a] };
+				tNear = t0 > tNear ? t0 : tNear; // written so that NaN (0 * infinity, on a slab's edge) is ignored
+				tFar = t1 < tFar ? t1 : tFar;
+			}
+			distance = tNear;
+			return tNear <= tFar;
+		}
+	};
+}
+
+SceneIndex::SceneIndex() noexcept
+	: m_bounds{}, m_alive{}, m_leafOf{}, m_free{}, m_nodes{}, m_parents{}, m_order{}, m_moved{}, m_count{ 0u },
+	m_inserted{ false } {}
+
+SceneIndex::Id SceneIndex::insert(const Aabb& bounds) {
+	Id id{};
+	if (m_free.empty()) {
+		id = static_cast<Id>(m_bounds.size());
+		m_bounds.push_back(bounds);
+		m_alive.push_back(1u);
+		m_leafOf.push_back(NO_NODE);
+	} else {
+		id = m_free.back();
+		m_free.pop_back();
+		m_bounds[id] = bounds;
+		m_alive[id] = 1u;
+		// still in its old leaf until the next build; refit keeps that leaf's box right meanwhile
+		m_moved.push_back(id);
+	}
+	m_count++;
+	m_inserted = true;
+	return id;
+}
+
+void SceneIndex::remove(Id id) {
+	if (!contains(id)) return;
+	m_alive[id] = 0u;
+	m_free.push_back(id);
+	m_moved.push_back(id);
+	m_count--;
+}
+
+void SceneIndex::setBounds(Id id, const Aabb& bounds) {
+	if (!contains(id)) return;
+	m_bounds[id] = bounds;
+	m_moved.push_back(id);
+}
+
+const SceneIndex::Aabb& SceneIndex::getBounds(Id id) const noexcept {
+	return m_bounds[id];
+}
+
+bool SceneIndex::contains(Id id) const noexcept {
+	return id < m_alive.size() && m_alive[id];
+}
+
+size_t SceneIndex::size() const noexcept {
+	return m_count;
+}
+
+void SceneIndex::clear() noexcept {
+	m_bounds.clear();
+	m_alive.clear();
+	m_leafOf.clear();
+	m_free.clear();
+	m_nodes.clear();
+	m_parents.clear();
+	m_order.clear();
+	m_moved.clear();
+	m_count = 0u;
+	m_inserted = false;
+}
+
+void SceneIndex::update() {
+	if (m_inserted) build();
+	else refit();
+}
+
+void SceneIndex::build() {
+	m_nodes.clear();
+	m_parents.clear();
+	m_order.clear();
+	m_moved.clear();
+	m_inserted = false;
+	std::fill(m_leafOf.begin(), m_leafOf.end(), NO_NODE);
+	if (m_count == 0u) return;
+
+	std::vector<Item> items{};
+	items.reserve(m_count);
+	for (Id id{ 0u }; id < m_bounds.size(); id++) {
+		if (!m_alive[id]) continue;
+		const Aabb& box{ m_bounds[id] };
+		items.push_back({ box, { 0.5f * (box.min[0] + box.max[0]), 0.5f * (box.min[1] + box.max[1]),
+			0.5f * (box.min[2] + box.max[2]) }, id });
+	}
+	m_order.resize(items.size());
+	m_nodes.reserve(2u * items.size()); // a binary tree with at least one id per leaf never needs more
+	m_parents.reserve(2u * items.size());
+	m_nodes.push_back({ EMPTY, 0u, 0u });
+	m_parents.push_back(NO_NODE);
+	buildNode(0u, items.data(), 0u, static_cast<uint32_t>(items.size()), 0u);
+}
+
+void SceneIndex::refit() noexcept {
+	if (m_moved.size() > m_nodes.size() / 16u) {
+		// children come after their parents in m_nodes, so one backwards sweep refits everything
+		for (size_t i{ m_nodes.size() }; i-- > 0u;) {
+			Node& node{ m_nodes[i] };
+			if (node.count > 0u) {
+				node.bounds = leafBounds(node);
+			} else {
+				node.bounds = m_nodes[node.first].bounds;
+				grow(node.bounds, m_nodes[node.first + 1u].bounds);
+			}
+		}
+		m_moved.clear();
+		return;
+	}
+	for (Id id : m_moved) {
+		uint32_t node{ m_leafOf[id] };
+		if (node == NO_NODE) continue;
+		Aabb bounds{ leafBounds(m_nodes[node]) };
+		// ancestors are the union of their children, so the walk can stop at the first box that stays the same
+		while (!equal(bounds, m_nodes[node].bounds)) {
+			m_nodes[node].bounds = bounds;
+			node = m_parents[node];
+			if (node == NO_NODE) break;
+			bounds = m_nodes[m_nodes[node].first].bounds;
+			grow(bounds, m_nodes[m_nodes[node].first + 1u].bounds);
+		}
+	}
+	m_moved.clear();
+}
+
+size_t SceneIndex::queryFrustum(const Culling::Frustum& frustum, std::vector<Id>& out) const {
+	if (m_nodes.empty()) return 0u;
+	const size_t before{ out.size() };
+	constexpr uint32_t ALL_PLANES{ (1u << 6) - 1u };
+	struct Entry {
+		uint32_t node;
+		uint32_t planes; // bit i: the node's parent crosses plane i, so the node must be tested against it
+	};
+	Entry stack[STACK_SIZE];
+	size_t top{ 0u };
+	stack[top++] = { 0u, ALL_PLANES };
+	while (top > 0u) {
+		const Entry entry{ stack[--top] };
+		const Node& node{ m_nodes[entry.node] };
+		if (isEmpty(node.bounds)) continue;
+		uint32_t planes{ entry.planes };
+		bool outside{ false };
+		for (uint32_t i{ 0u }; i < 6u && !outside; i++) {
+			if (!(planes & 1u << i)) continue;
+			const Side side{ classify(frustum.planes[i], node.bounds) };
+			outside = side == Side::OUTSIDE;
+			if (side == Side::INSIDE) planes &= ~(1u << i);
+		}
+		if (outside) continue;
+		if (node.count == 0u) {
+			stack[top++] = { node.first + 1u, planes };
+			stack[top++] = { node.first, planes };
+			continue;
+		}
+		for (uint32_t i{ node.first }; i < node.first + node.count; i++) {
+			const Id id{ m_order[i] };
+			if (!m_alive[id]) continue;
+			bool visible{ true };
+			for (uint32_t p{ 0u }; p < 6u && visible; p++) {
+				if (planes & 1u << p) visible = classify(frustum.planes[p], m_bounds[id]) != Side::OUTSIDE;
+			}
+			if (visible) out.push_back(id);
+		}
+	}
+	return out.size() - before;
+}
+
+size_t SceneIndex::queryAabb(const Aabb& box, std::vector<Id>& out) const {
+	if (m_nodes.empty()) return 0u;
+	const size_t before{ out.size() };
+	uint32_t stack[STACK_SIZE];
+	size_t top{ 0u };
+	stack[top++] = 0u;
+	while (top > 0u) {
+		const Node& node{ m_nodes[stack[--top]] };
+		if (isEmpty(node.bounds) || !overlap(node.bounds, box)) continue;
+		if (node.count == 0u) {
+			stack[top++] = node.first + 1u;
+			stack[top++] = node.first;
+			continue;
+		}
+		for (uint32_t i{ node.first }; i < node.first + node.count; i++) {
+			const Id id{ m_order[i] };
+			if (m_alive[id] && overlap(m_bounds[id], box)) out.push_back(id);
+		}
+	}
+	return out.size() - before;
+}
+
+std::optional<SceneIndex::Hit> SceneIndex::raycast(const Ray& ray, float maxDistance) const noexcept {
+	return raycast(ray, maxDistance, nullptr, nullptr);
+}
+
+size_t SceneIndex::getNodeCount() const noexcept {
+	return m_nodes.size();
+}
+
+SceneIndex::Ray SceneIndex::pickRay(const float* m, float x, float y, float width, float height) noexcept {
+	// pixel to normalized device coordinates (y points up), then back through the inverse at z = 0 (near) and 1 (far)
+	const float ndcX{ 2.0f * x / width - 1.0f };
+	const float ndcY{ 1.0f - 2.0f * y / height };
+	auto unproject = [m, ndcX, ndcY](float z, float (&point)[3]) {
+		float clip[4]{};
+		for (size_t c{ 0u }; c < 4u; c++)
+			clip[c] = ndcX * m[c] + ndcY * m[4u + c] + z * m[8u + c] + m[12u + c];
+		for (size_t a{ 0u }; a < 3u; a++)
+			point[a] = clip[a] / clip[3];
+	};
+	Ray ray{};
+	float to[3]{};
+	unproject(0.0f, ray.origin);
+	unproject(1.0f, to);
+	float length{ 0.0f };
+	for (size_t a{ 0u }; a < 3u; a++) {
+		ray.direction[a] = to[a] - ray.origin[a];
+		length += ray.direction[a] * ray.direction[a];
+	}
+	length = std::sqrt(length);
+	for (float& d : ray.direction)
+		d /= length;
+	return ray;
+}
+
+std::optional<SceneIndex::Hit> SceneIndex::raycast(const Ray& ray, float maxDistance, ExactTest test,
+	const void* pContext) const {
+
+	if (m_nodes.empty()) return std::nullopt;
+	const Slabs slabs{ ray };
+	std::optional<Hit> nearest{};
+	float limit{ maxDistance };
+	struct Entry {
+		uint32_t node;
+		float distance; // where the ray enters the node
+	};
+	Entry stack[STACK_SIZE];
+	size_t top{ 0u };
+	float distance{};
+	if (!slabs.enter(m_nodes[0].bounds, limit, distance)) return std::nullopt;
+	stack[top++] = { 0u, distance };
+	while (top > 0u) {
+		const Entry entry{ stack[--top] };
+		if (entry.distance > limit) continue; // something nearer was hit after this was pushed
+		const Node& node{ m_nodes[entry.node] };
+		if (node.count == 0u) {
+			float nearDistance{};
+			float farDistance{};
+			uint32_t nearChild{ node.first };
+			uint32_t farChild{ node.first + 1u };
+			bool hitNear{ slabs.enter(m_nodes[nearChild].bounds, limit, nearDistance) };
+			bool hitFar{ slabs.enter(m_nodes[farChild].bounds, limit, farDistance) };
+			if (hitNear && hitFar && farDistance < nearDistance) {
+				std::swap(nearChild, farChild);
+				std::swap(nearDistance, farDistance);
+			} else if (!hitNear) {
+				nearChild = farChild;
+				nearDistance = farDistance;
+				hitNear = hitFar;
+				hitFar = false;
+			}
+			// the nearer child is pushed last, so it is visited first
+			if (hitFar) stack[top++] = { farChild, farDistance };
+			if (hitNear) stack[top++] = { nearChild, nearDistance };
+			continue;
+		}
+		for (uint32_t i{ node.first }; i < node.first + node.count; i++) {
+			const Id id{ m_order[i] };
+			if (!m_alive[id] || !slabs.enter(m_bounds[id], limit, distance)) continue;
+			if (test) {
+				const std::optional<float> exact{ test(pContext, id, ray, limit) };
+				if (!exact || *exact > limit) continue;
+				distance = *exact;
+			}
+			limit = distance;
+			nearest = Hit{ id, distance };
+		}
+	}
+	return nearest;
+}
+
+void SceneIndex::buildNode(uint32_t node, Item* pItems, uint32_t first, uint32_t count, size_t depth) {
+	Item* const pBegin{ pItems + first };
+	Item* const pEnd{ pBegin + count };
+	Aabb bounds{ EMPTY };
+	Aabb centroidBounds{ EMPTY };
+	for (const Item* pItem{ pBegin }; pItem != pEnd; pItem++) {
+		grow(bounds, pItem->bounds);
+		for (size_t a{ 0u }; a < 3u; a++) {
+			centroidBounds.min[a] = std::min(centroidBounds.min[a], pItem->centroid[a]);
+			centroidBounds.max[a] = std::max(centroidBounds.max[a], pItem->centroid[a]);
+		}
+	}
+	m_nodes[node].bounds = bounds;
+	if (count <= MAX_LEAF_SIZE || depth >= MAX_DEPTH) {
+		for (uint32_t i{ first }; i < first + count; i++)
+			m_order[i] = pItems[i].id;
+		makeLeaf(node, first, count);
+		return;
+	}
+
+	// bin every axis in one pass, then sweep each for the cheapest split: left area * left count + right area * right count
+	struct Bin {
+		Aabb bounds;
+		uint32_t count;
+	};
+	Bin bins[3][BIN_COUNT]{};
+	float scales[3]{};
+	for (size_t a{ 0u }; a < 3u; a++) {
+		const float extent{ centroidBounds.max[a] - centroidBounds.min[a] };
+		scales[a] = extent > 0.0f ? static_cast<float>(BIN_COUNT) / extent : 0.0f;
+		for (Bin& bin : bins[a])
+			bin.bounds = EMPTY;
+	}
+	auto binOf = [&centroidBounds, &scales](const Item& item, size_t a) {
+		return std::min(BIN_COUNT - 1u, static_cast<size_t>((item.centroid[a] - centroidBounds.min[a]) * scales[a]));
+	};
+	for (const Item* pItem{ pBegin }; pItem != pEnd; pItem++) {
+		for (size_t a{ 0u }; a < 3u; a++) {
+			Bin& bin{ bins[a][binOf(*pItem, a)] };
+			grow(bin.bounds, pItem->bounds);
+			bin.count++;
+		}
+	}
+	float bestCost{ NO_LIMIT };
+	size_t bestAxis{ 0u };
+	size_t bestSplit{ 0u }; // bins [0, bestSplit) go left
+	for (size_t a{ 0u }; a < 3u; a++) {
+		if (scales[a] == 0.0f) continue;
+		float rightCost[BIN_COUNT]{}; // of bins [b, BIN_COUNT)
+		Aabb right{ EMPTY };
+		uint32_t rightCount{ 0u };
+		for (size_t b{ BIN_COUNT - 1u }; b > 0u; b--) {
+			grow(right, bins[a][b].bounds);
+			rightCount += bins[a][b].count;
+			rightCost[b] = area(right) * static_cast<float>(rightCount);
+		}
+		Aabb left{ EMPTY };
+		uint32_t leftCount{ 0u };
+		for (size_t b{ 1u }; b < BIN_COUNT; b++) {
+			grow(left, bins[a][b - 1u].bounds);
+			leftCount += bins[a][b - 1u].count;
+			if (leftCount == 0u || leftCount == count) continue;
+			const float cost{ area(left) * static_cast<float>(leftCount) + rightCost[b] };
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = a;
+				bestSplit = b;
+			}
+		}
+	}
+
+	Item* pMiddle{ pBegin + count / 2u };
+	if (bestCost < NO_LIMIT) {
+		pMiddle = std::partition(pBegin, pEnd, [&binOf, bestAxis, bestSplit](const Item& item) {
+			return binOf(item, bestAxis) < bestSplit;
+		});
+	}
+	// else every centroid is in the same place, and any split is as good as another
+	const uint32_t middle{ static_cast<uint32_t>(pMiddle - pItems) };
+
+	const uint32_t left{ static_cast<uint32_t>(m_nodes.size()) };
+	m_nodes.push_back({ EMPTY, 0u, 0u });
+	m_nodes.push_back({ EMPTY, 0u, 0u });
+	m_parents.push_back(node);
+	m_parents.push_back(node);
+	m_nodes[node].first = left;
+	m_nodes[node].count = 0u;
+	buildNode(left, pItems, first, middle - first, depth + 1u);
+	buildNode(left + 1u, pItems, middle, first + count - middle, depth + 1u);
+}
+
+void SceneIndex::makeLeaf(uint32_t node, uint32_t first, uint32_t count) noexcept {
+	m_nodes[node].first = first;
+	m_nodes[node].count = count;
+	for (uint32_t i{ first }; i < first + count; i++)
+		m_leafOf[m_order[i]] = node;
+}
+
+SceneIndex::Aabb SceneIndex::leafBounds(const Node& leaf) const noexcept {
+	Aabb bounds{ EMPTY };
+	for (uint32_t i{ leaf.first }; i < leaf.first + leaf.count; i++) {
+		if (m_alive[m_order[i]]) grow(bounds, m_bounds[m_order[i]]);
+	}
+	return bounds;
+}
\ No newline at end of file
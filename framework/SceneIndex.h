@@ -0,0 +1,120 @@
+#ifndef CWF_SCENEINDEX_H
+#define CWF_SCENEINDEX_H
+
+#include "Culling.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+/*
+* Spatial index of a scene's objects, each known only by an id and a world-space axis-aligned bounding box; a bounding
+* volume hierarchy over the boxes answers frustum (culling), ray (picking) and box overlap queries without looking at
+* every object. Knows nothing about DirectX.
+* build() splits with the surface area heuristic over 16 bins per axis, and leaves hold up to 4 objects. When objects
+* only move, refit() recomputes the boxes of the leaves that hold them and of their ancestors (or, when many objects
+* moved, sweeps every node once) and leaves the tree's shape alone; that keeps every query correct, but a tree refit
+* after large motions is slower to query than a fresh one, so rebuild now and then if most of the scene moves.
+* update() does whichever is needed: a build after insertions, a refit otherwise. Queries see the tree as of the last
+* update(); objects inserted since are not found, removed ones never are.
+* The frustum query drops planes a node lies entirely inside of, so whole subtrees inside the frustum are gathered
+* without testing them; the ray query visits the nearer child first and skips nodes beyond the closest hit so far.
+* Nodes are 32 bytes in one array, with both children of a node next to each other.
+*/
+
+class SceneIndex {
+public:
+	using Id = uint32_t;
+
+	struct Aabb {
+		float min[3];
+		float max[3];
+	};
+
+	struct Ray {
+		float origin[3];
+		float direction[3]; // unit length, so hit distances are in world units
+	};
+
+	struct Hit {
+		Id id;
+		float distance; // along the ray
+	};
+
+	static constexpr size_t MAX_LEAF_SIZE{ 4u };
+	static constexpr size_t BIN_COUNT{ 16u };
+	static constexpr size_t MAX_DEPTH{ 48u }; // deeper nodes become leaves, however many objects they hold
+	static constexpr float NO_LIMIT{ std::numeric_limits<float>::infinity() };
+private:
+	struct Node {
+		Aabb bounds;
+		uint32_t first; // leaf: first of its ids in m_order; inner node: left child (the right one is first + 1)
+		uint32_t count; // ids in a leaf; 0 for inner nodes
+	};
+
+	// what build() partitions: copies, so the splits sweep contiguous memory instead of following ids
+	struct Item {
+		Aabb bounds;
+		float centroid[3];
+		Id id;
+	};
+
+	static constexpr uint32_t NO_NODE{ std::numeric_limits<uint32_t>::max() };
+
+	std::vector<Aabb> m_bounds; // by id
+	std::vector<uint8_t> m_alive; // by id
+	std::vector<uint32_t> m_leafOf; // by id; NO_NODE until the next build
+	std::vector<Id> m_free; // removed ids, reused by insert
+	std::vector<Node> m_nodes; // m_nodes[0] is the root
+	std::vector<uint32_t> m_parents; // by node
+	std::vector<Id> m_order; // the ids of each leaf, contiguous
+	std::vector<Id> m_moved; // since the last refit
+	size_t m_count;
+	bool m_inserted; // since the last build
+public:
+	SceneIndex() noexcept;
+	~SceneIndex() = default;
+
+	Id insert(const Aabb& bounds);
+	void remove(Id id);
+	void setBounds(Id id, const Aabb& bounds);
+	const Aabb& getBounds(Id id) const noexcept;
+	bool contains(Id id) const noexcept;
+	size_t size() const noexcept;
+	void clear() noexcept;
+
+	void update(); // build() if anything was inserted since the last one, refit() otherwise
+	void build();
+	void refit() noexcept;
+
+	// append the ids found to out and return how many were appended
+	size_t queryFrustum(const Culling::Frustum& frustum, std::vector<Id>& out) const;
+	size_t queryAabb(const Aabb& box, std::vector<Id>& out) const;
+	// the nearest object whose box the ray enters within maxDistance (0 if the ray starts inside it)
+	std::optional<Hit> raycast(const Ray& ray, float maxDistance = NO_LIMIT) const noexcept;
+	// the same, but boxes only narrow the search: intersect(id, ray, maxDistance) returns the exact distance to the
+	// object (e.g. from its triangles) or std::nullopt if the ray misses it within maxDistance
+	template <typename Intersect>
+	std::optional<Hit> raycast(const Ray& ray, Intersect&& intersect, float maxDistance = NO_LIMIT) const {
+		return raycast(ray, maxDistance, [](const void* pIntersect, Id id, const Ray& r, float limit) -> std::optional<float> {
+			return (*static_cast<const std::remove_reference_t<Intersect>*>(pIntersect))(id, r, limit);
+		}, &intersect);
+	}
+
+	size_t getNodeCount() const noexcept;
+
+	// the ray through pixel (x, y) of a width by height viewport, from the near plane into the scene; the matrix is the
+	// inverse of view * projection (Graphics::getInverseViewProjection), 16 floats, row-major, as in Culling::frustum
+	static Ray pickRay(const float* pInverseViewProjection, float x, float y, float width, float height) noexcept;
+private:
+	using ExactTest = std::optional<float> (*)(const void* pContext, Id id, const Ray& ray, float maxDistance);
+
+	std::optional<Hit> raycast(const Ray& ray, float maxDistance, ExactTest test, const void* pContext) const;
+	void buildNode(uint32_t node, Item* pItems, uint32_t first, uint32_t count, size_t depth);
+	void makeLeaf(uint32_t node, uint32_t first, uint32_t count) noexcept;
+	Aabb leafBounds(const Node& leaf) const noexcept;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,257 @@
+#define NOMINMAX
+
+#include "ShaderPack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	constexpr char MAGIC[4]{ 'C', 'W', 'S', 'P' };
+	constexpr size_t HEADER_SIZE{ 32u };
+	constexpr size_t ENTRY_SIZE{ 48u };
+
+	// entry fields
+	constexpr size_t NAME_HASH{ 0u };
+	constexpr size_t SOURCE_HASH{ 8u };
+	constexpr size_t BLOB_OFFSET{ 16u };
+	constexpr size_t BLOB_SIZE{ 24u };
+	constexpr size_t NAME_OFFSET{ 32u };
+	constexpr size_t NAME_LENGTH{ 36u };
+
+	template <typename T>
+	void put(std::vector<std::byte>& out, size_t offset, T value) {
+		std::memcpy(out.data() + offset, &value, sizeof(value));
+	}
+
+	size_t alignUp(size_t value, size_t alignment) noexcept {
+		return (value + alignment - 1u) / alignment * alignment;
+	}
+}
+
+void ShaderPack::Writer::add(std::string_view name, uint64_t sourceHash, std::span<const std::byte> byteCode) {
+	auto it{ std::find_if(m_entries.begin(), m_entries.end(), [name](const Entry& e) { return e.name == name; }) };
+	if (it == m_entries.end())
+		it = m_entries.insert(m_entries.end(), Entry{ std::string{ name }, 0u, {} });
+	it->sourceHash = sourceHash;
+	it->byteCode.assign(byteCode.begin(), byteCode.end());
+}
+
+bool ShaderPack::Writer::addFile(std::string_view name, uint64_t sourceHash, const std::filesystem::path& compiledShader) {
+	std::ifstream file{ compiledShader, std::ios::binary };
+	if (!file) return false;
+	const std::vector<char> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	add(name, sourceHash, std::as_bytes(std::span<const char>{ bytes }));
+	return true;
+}
+
+bool ShaderPack::Writer::write(const std::filesystem::path& path) const {
+	std::vector<const Entry*> sorted{};
+	sorted.reserve(m_entries.size());
+	for (const Entry& e : m_entries)
+		sorted.push_back(&e);
+	std::sort(sorted.begin(), sorted.end(), [](const Entry* a, const Entry* b) {
+		const uint64_t ha{ hash(a->name) };
+		const uint64_t hb{ hash(b->name) };
+		return ha != hb ? ha < hb : a->name < b->name;
+	});
+
+	// lay out the names, then the blobs
+	size_t namesSize{ 0u };
+	for (const Entry* e : sorted)
+		namesSize += e->name.size();
+	size_t end{ HEADER_SIZE + sorted.size() * ENTRY_SIZE + namesSize };
+	std::vector<size_t> blobOffsets{};
+	for (const Entry* e : sorted) {
+		end = alignUp(end, BLOB_ALIGNMENT);
+		blobOffsets.push_back(end);
+		end += e->byteCode.size();
+	}
+
+	std::vector<std::byte> out(end);
+	std::memcpy(out.data(), MAGIC, sizeof(MAGIC));
+	put(out, 4u, VERSION);
+	put(out, 8u, static_cast<uint32_t>(sorted.size()));
+	put(out, 16u, static_cast<uint64_t>(out.size()));
+	size_t nameOffset{ HEADER_SIZE + sorted.size() * ENTRY_SIZE };
+	for (size_t i{ 0u }; i < sorted.size(); i++) {
+		const Entry& e{ *sorted[i] };
+		const size_t entry{ HEADER_SIZE + i * ENTRY_SIZE };
+		put(out, entry + NAME_HASH, hash(e.name));
+		put(out, entry + SOURCE_HASH, e.sourceHash);
+		put(out, entry + BLOB_OFFSET, static_cast<uint64_t>(blobOffsets[i]));
+		put(out, entry + BLOB_SIZE, static_cast<uint64_t>(e.byteCode.size()));
+		put(out, entry + NAME_OFFSET, static_cast<uint32_t>(nameOffset));
+		put(out, entry + NAME_LENGTH, static_cast<uint32_t>(e.name.size()));
+		std::memcpy(out.data() + nameOffset, e.name.data(), e.name.size());
+		nameOffset += e.name.size();
+		if (!e.byteCode.empty())
+			std::memcpy(out.data() + blobOffsets[i], e.byteCode.data(), e.byteCode.size());
+	}
+
+	std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+	file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+	return static_cast<bool>(file);
+}
+
+size_t ShaderPack::Writer::size() const noexcept {
+	return m_entries.size();
+}
+
+ShaderPack::ShaderPack(std::filesystem::path path) : m_path{ std::move(path) }, m_pData{ nullptr }, m_size{ 0u },
+	m_count{ 0u }, m_tried{ false }
+#ifdef _WIN32
+	, m_hFile{ INVALID_HANDLE_VALUE }, m_hMapping{ nullptr }
+#endif
+{}
+
+ShaderPack::~ShaderPack() {
+	close();
+}
+
+bool ShaderPack::open() {
+	if (m_tried) return isOpen();
+	m_tried = true;
+#ifdef _WIN32
+	m_hFile = CreateFileW(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart < static_cast<LONGLONG>(HEADER_SIZE)) {
+		close();
+		return false;
+	}
+	m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+	if (!m_hMapping) {
+		close();
+		return false;
+	}
+	m_pData = static_cast<const std::byte*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0u, 0u, 0u));
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	const int fd{ ::open(m_path.c_str(), O_RDONLY) };
+	if (fd < 0) return false;
+	struct stat info{};
+	if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(HEADER_SIZE)) {
+		::close(fd);
+		return false;
+	}
+	void* p{ mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0) };
+	::close(fd); // the mapping keeps the file
+	if (p == MAP_FAILED) return false;
+	m_pData = static_cast<const std::byte*>(p);
+	m_size = static_cast<size_t>(info.st_size);
+#endif
+	if (!m_pData || !validate()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool ShaderPack::isOpen() const noexcept {
+	return m_pData != nullptr;
+}
+
+std::optional<ShaderPack::Blob> ShaderPack::find(std::string_view name) {
+	if (!open()) return std::nullopt;
+	const uint64_t nameHash{ hash(name) };
+	// first entry whose name hash isn't less than ours
+	uint32_t lo{ 0u };
+	uint32_t hi{ m_count };
+	while (lo < hi) {
+		const uint32_t mid{ lo + (hi - lo) / 2u };
+		if (read64(HEADER_SIZE + mid * ENTRY_SIZE + NAME_HASH) < nameHash)
+			lo = mid + 1u;
+		else
+			hi = mid;
+	}
+	for (uint32_t i{ lo }; i < m_count; i++) {
+		const size_t entry{ HEADER_SIZE + i * ENTRY_SIZE };
+		if (read64(entry + NAME_HASH) != nameHash) break;
+		const std::string_view entryName{ reinterpret_cast<const char*>(m_pData + read32(entry + NAME_OFFSET)), read32(entry + NAME_LENGTH) };
+		if (entryName == name) {
+			return Blob{ { m_pData + read64(entry + BLOB_OFFSET), static_cast<size_t>(read64(entry + BLOB_SIZE)) },
+				read64(entry + SOURCE_HASH) };
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<ShaderPack::Blob> ShaderPack::find(std::string_view name, uint64_t sourceHash) {
+	std::optional<Blob> blob{ find(name) };
+	if (blob && blob->sourceHash != sourceHash) return std::nullopt;
+	return blob;
+}
+
+size_t ShaderPack::size() {
+	return open() ? m_count : 0u;
+}
+
+uint64_t ShaderPack::hash(std::string_view text) noexcept {
+	return hash(std::as_bytes(std::span<const char>{ text.data(), text.size() }));
+}
+
+uint64_t ShaderPack::hash(std::span<const std::byte> bytes) noexcept {
+	uint64_t h{ 14695981039346656037ull };
+	for (std::byte b : bytes) {
+		h ^= static_cast<uint64_t>(b);
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+void ShaderPack::close() noexcept {
+#ifdef _WIN32
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+	m_hMapping = nullptr;
+	m_hFile = INVALID_HANDLE_VALUE;
+#else
+	if (m_pData) munmap(const_cast<std::byte*>(m_pData), m_size);
+#endif
+	m_pData = nullptr;
+	m_size = 0u;
+	m_count = 0u;
+}
+
+// everything find() reads has to lie inside the file, so a truncated or corrupt pack is rejected up front
+bool ShaderPack::validate() noexcept {
+	if (std::memcmp(m_pData, MAGIC, sizeof(MAGIC)) != 0 || read32(4u) != VERSION) return false;
+	if (read64(16u) != m_size) return false;
+	m_count = read32(8u);
+	if (m_count > (m_size - HEADER_SIZE) / ENTRY_SIZE) return false;
+	for (uint32_t i{ 0u }; i < m_count; i++) {
+		const size_t entry{ HEADER_SIZE + i * ENTRY_SIZE };
+		const uint64_t blobOffset{ read64(entry + BLOB_OFFSET) };
+		const uint64_t blobSize{ read64(entry + BLOB_SIZE) };
+		const uint64_t nameOffset{ read32(entry + NAME_OFFSET) };
+		const uint64_t nameLength{ read32(entry + NAME_LENGTH) };
+		if (blobOffset > m_size || blobSize > m_size - blobOffset) return false;
+		if (nameOffset > m_size || nameLength > m_size - nameOffset) return false;
+		if (i > 0u && read64(entry + NAME_HASH) < read64(entry - ENTRY_SIZE + NAME_HASH)) return false;
+	}
+	return true;
+}
+
+uint64_t ShaderPack::read64(size_t offset) const noexcept {
+	uint64_t value{};
+	std::memcpy(&value, m_pData + offset, sizeof(value));
+	return value;
+}
+
+uint32_t ShaderPack::read32(size_t offset) const noexcept {
+	uint32_t value{};
+	std::memcpy(&value, m_pData + offset, sizeof(value));
+	return value;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef CWF_SHADERPACK_H
+#define CWF_SHADERPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+* A single file of precompiled shader blobs, memory-mapped and read in place: find() hands out spans straight into the
+* mapping, which go to Material::setVertexShader/setPixelShader without a copy, so a pack costs one open and one map
+* at startup however many shaders it holds, and only the pages of shaders actually used are ever read from disk.
+* The file isn't touched until the first lookup (or open()). Blobs stay valid as long as the ShaderPack does.
+* Each blob is stored under a name and the hash of the source it was compiled from, so a caller holding the source
+* can tell a stale blob from a current one (find(name, sourceHash)). Packs are built with ShaderPack::Writer.
+* Portable (Win32 file mapping or POSIX mmap); no exceptions, a missing or malformed pack just finds nothing.
+*
+* Format, all little-endian:
+*	header  - "CWSP", version, entry count, 0, file size (u64), 0 (u64)                          32 bytes
+*	entries - name hash, source hash, blob offset, blob size (u64 each), name offset, name length   48 bytes each,
+*	          sorted by name hash (then name) for binary search
+*	names   - the entries' names, back to back
+*	blobs   - each at a multiple of BLOB_ALIGNMENT
+*/
+
+class ShaderPack {
+public:
+	static constexpr uint32_t VERSION{ 1u };
+	static constexpr size_t BLOB_ALIGNMENT{ 16u };
+
+	struct Blob {
+		std::span<const std::byte> byteCode;
+		uint64_t sourceHash;
+	};
+
+	class Writer {
+	private:
+		struct Entry {
+			std::string name;
+			uint64_t sourceHash;
+			std::vector<std::byte> byteCode;
+		};
+
+		std::vector<Entry> m_entries;
+	public:
+		Writer() = default;
+
+		// a later entry with the same name replaces the earlier one
+		void add(std::string_view name, uint64_t sourceHash, std::span<const std::byte> byteCode);
+		bool addFile(std::string_view name, uint64_t sourceHash, const std::filesystem::path& compiledShader);
+		bool write(const std::filesystem::path& path) const;
+		size_t size() const noexcept;
+	};
+private:
+	std::filesystem::path m_path;
+	const std::byte* m_pData;
+	size_t m_size;
+	uint32_t m_count;
+	bool m_tried; // opening was attempted, successfully or not
+#ifdef _WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#endif
+public:
+	explicit ShaderPack(std::filesystem::path path);
+	~ShaderPack();
+	// no copy init/assign
+	ShaderPack(const ShaderPack& o) = delete;
+	ShaderPack& operator=(const ShaderPack& o) = delete;
+
+	bool open(); // maps the file now instead of at the first lookup; false if it is missing or malformed
+	bool isOpen() const noexcept;
+
+	std::optional<Blob> find(std::string_view name);
+	std::optional<Blob> find(std::string_view name, uint64_t sourceHash); // nothing if the blob is stale
+	size_t size(); // number of blobs
+
+	// FNV-1a, for names and sources
+	static uint64_t hash(std::string_view text) noexcept;
+	static uint64_t hash(std::span<const std::byte> bytes) noexcept;
+private:
+	void close() noexcept;
+	bool validate() noexcept;
+	uint64_t read64(size_t offset) const noexcept;
+	uint32_t read32(size_t offset) const noexcept;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,107 @@
+#ifndef CWF_SPSCRING_H
+#define CWF_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/*
+* Fixed-capacity, lock-free ring for one producer thread and one consumer thread (e.g. the message pump and the
+* simulation), which never allocates. push/emplace are the producer's side, pop/clear the consumer's; empty, size and
+* the overflow count may be read from either, as a snapshot.
+* A full ring drops the new element (the producer cannot drop the oldest, which belongs to the consumer) and counts it.
+* head and tail only ever grow (wrapping around size_t) and are masked into the array, so CAPACITY is a power of two.
+* Each side's index sits on its own cache line with that side's cached copy of the other index, which it only reloads
+* when the ring looks full (producer) or empty (consumer), so in steady state neither side touches the other's line.
+* T is trivially copyable, so slots need no construction or destruction bookkeeping.
+*/
+
+template <typename T, size_t CAPACITY>
+class SpscRing {
+	static_assert(CAPACITY > 0u && (CAPACITY & (CAPACITY - 1u)) == 0u, "SpscRing capacity must be a power of two");
+	static_assert(std::is_trivially_copyable_v<T>, "SpscRing elements must be trivially copyable");
+public:
+	static constexpr size_t CACHE_LINE{ 64u };
+private:
+	static constexpr size_t MASK{ CAPACITY - 1u };
+
+	struct alignas(T) Slot {
+		unsigned char bytes[sizeof(T)];
+	};
+
+	// producer's line
+	alignas(CACHE_LINE) std::atomic<size_t> m_head;
+	size_t m_tailCache;
+	std::atomic<uint64_t> m_overflows;
+	// consumer's line
+	alignas(CACHE_LINE) std::atomic<size_t> m_tail;
+	size_t m_headCache;
+	alignas(CACHE_LINE) Slot m_slots[CAPACITY];
+public:
+	SpscRing() noexcept : m_head{ 0u }, m_tailCache{ 0u }, m_overflows{ 0u }, m_tail{ 0u }, m_headCache{ 0u }, m_slots{} {}
+	~SpscRing() = default;
+	// no copy init/assign
+	SpscRing(const SpscRing& o) = delete;
+	SpscRing& operator=(const SpscRing& o) = delete;
+
+	static constexpr size_t capacity() noexcept {
+		return CAPACITY;
+	}
+
+	// producer only; false if the ring was full and value was dropped
+	bool push(const T& value) noexcept {
+		return emplace(value);
+	}
+
+	template <typename... Args>
+	bool emplace(Args&&... args) noexcept {
+		const size_t head{ m_head.load(std::memory_order_relaxed) };
+		if (head - m_tailCache == CAPACITY) {
+			m_tailCache = m_tail.load(std::memory_order_acquire);
+			if (head - m_tailCache == CAPACITY) {
+				m_overflows.fetch_add(1u, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		::new (static_cast<void*>(m_slots[head & MASK].bytes)) T{ std::forward<Args>(args)... };
+		m_head.store(head + 1u, std::memory_order_release); // publishes the slot
+		return true;
+	}
+
+	// consumer only
+	std::optional<T> pop() noexcept {
+		const size_t tail{ m_tail.load(std::memory_order_relaxed) };
+		if (tail == m_headCache) {
+			m_headCache = m_head.load(std::memory_order_acquire);
+			if (tail == m_headCache) return std::nullopt;
+		}
+		const T value{ *std::launder(reinterpret_cast<const T*>(m_slots[tail & MASK].bytes)) };
+		m_tail.store(tail + 1u, std::memory_order_release); // hands the slot back
+		return value;
+	}
+
+	// consumer only; drops everything pushed so far
+	void clear() noexcept {
+		m_headCache = m_head.load(std::memory_order_acquire);
+		m_tail.store(m_headCache, std::memory_order_release);
+	}
+
+	bool empty() const noexcept {
+		return size() == 0u;
+	}
+
+	size_t size() const noexcept {
+		const size_t tail{ m_tail.load(std::memory_order_acquire) };
+		return m_head.load(std::memory_order_acquire) - tail;
+	}
+
+	uint64_t getOverflowCount() const noexcept {
+		return m_overflows.load(std::memory_order_relaxed);
+	}
+};
+
+#endif
\ No newline at end of file
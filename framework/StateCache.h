@@ -0,0 +1,298 @@
+#ifndef CWF_STATECACHE_H
+#define CWF_STATECACHE_H
+
+#include "ShaderStage.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Shadow copy of the state bound to a device context, sitting in front of the context's binding calls. Every set*
+* call compares against what it last bound and drops the call if nothing would change, so consecutive materials that
+* share shaders, layouts, targets, textures, etc. only bind them once.
+* Nothing is known at first (and after invalidate()), so the first bind of everything always reaches the context.
+* Call invalidate() whenever the context's state changes behind the cache's back, e.g. after ExecuteCommandList,
+* which resets the immediate context's state.
+* Counters track issued vs. elided calls; endFrame() moves them into getLastFrameCounters() and starts over.
+* The context is a template parameter and every D3D type is deduced from the arguments, so the cache can be run
+* against a recording mock context; see StateCache/DeferredStateCache for the real instantiations.
+* Only the first TRACKED_SLOTS slots of each kind are shadowed; binds past them always go through.
+*/
+
+template <typename Context>
+class BasicStateCache {
+public:
+	static constexpr unsigned TRACKED_SLOTS{ 16u };
+
+	struct Counters {
+		size_t issued;
+		size_t elided;
+	};
+private:
+	static constexpr size_t STAGES{ 2u }; // see ShaderStage
+
+	template <typename T>
+	struct Shadow {
+		T value{};
+		bool known{ false };
+	};
+
+	struct VertexBuffer {
+		const void* pBuffer;
+		unsigned stride;
+		unsigned offset;
+		bool operator==(const VertexBuffer&) const = default;
+	};
+
+	struct IndexBuffer {
+		const void* pBuffer;
+		int64_t format;
+		unsigned offset;
+		bool operator==(const IndexBuffer&) const = default;
+	};
+
+	struct ConstantBuffer {
+		const void* pBuffer;
+		unsigned firstConstant; // both 0 for a whole-buffer bind
+		unsigned numConstants;
+		bool operator==(const ConstantBuffer&) const = default;
+	};
+
+	struct RenderTarget {
+		const void* pTarget;
+		const void* pDepthStencil;
+		bool operator==(const RenderTarget&) const = default;
+	};
+
+	struct Viewport {
+		float x, y, width, height, minDepth, maxDepth;
+		bool operator==(const Viewport&) const = default;
+	};
+
+	template <typename T>
+	using Slots = std::array<Shadow<T>, TRACKED_SLOTS>;
+
+	Context* m_pContext;
+	Shadow<int64_t> m_topology;
+	Shadow<const void*> m_pLayout;
+	Slots<VertexBuffer> m_vertexBuffers;
+	Shadow<IndexBuffer> m_indexBuffer;
+	std::array<Shadow<const void*>, STAGES> m_shaders;
+	std::array<Slots<ConstantBuffer>, STAGES> m_constantBuffers;
+	std::array<Slots<const void*>, STAGES> m_shaderResources;
+	std::array<Slots<const void*>, STAGES> m_samplers;
+	Shadow<RenderTarget> m_renderTarget;
+	Shadow<Viewport> m_viewport;
+	Counters m_counters;
+	Counters m_lastFrameCounters;
+public:
+	explicit BasicStateCache(Context* pContext) noexcept
+		: m_pContext{ pContext }, m_topology{}, m_pLayout{}, m_vertexBuffers{}, m_indexBuffer{}, m_shaders{},
+		m_constantBuffers{}, m_shaderResources{}, m_samplers{}, m_renderTarget{}, m_viewport{},
+		m_counters{}, m_lastFrameCounters{} {}
+
+	~BasicStateCache() = default;
+	// no copy init/assign
+	BasicStateCache(const BasicStateCache& o) = delete;
+	BasicStateCache& operator=(const BasicStateCache& o) = delete;
+
+	Context* getContext() const noexcept {
+		return m_pContext;
+	}
+
+	// forget everything; the next bind of each piece of state goes through
+	void invalidate() noexcept {
+		m_topology = {};
+		m_pLayout = {};
+		m_vertexBuffers = {};
+		m_indexBuffer = {};
+		m_shaders = {};
+		m_constantBuffers = {};
+		m_shaderResources = {};
+		m_samplers = {};
+		m_renderTarget = {};
+		m_viewport = {};
+	}
+
+	void endFrame() noexcept {
+		m_lastFrameCounters = m_counters;
+		m_counters = {};
+	}
+
+	Counters getCounters() const noexcept { // so far this frame
+		return m_counters;
+	}
+
+	Counters getLastFrameCounters() const noexcept {
+		return m_lastFrameCounters;
+	}
+
+	template <typename Topology>
+	void setPrimitiveTopology(Topology topology) {
+		if (update(m_topology, static_cast<int64_t>(topology)))
+			m_pContext->IASetPrimitiveTopology(topology);
+	}
+
+	template <typename Layout>
+	void setInputLayout(Layout* pLayout) {
+		if (update(m_pLayout, static_cast<const void*>(pLayout)))
+			m_pContext->IASetInputLayout(pLayout);
+	}
+
+	template <typename Buffer>
+	void setVertexBuffer(unsigned slot, Buffer* pBuffer, unsigned stride, unsigned offset) {
+		if (updateSlot(m_vertexBuffers, slot, VertexBuffer{ pBuffer, stride, offset }))
+			m_pContext->IASetVertexBuffers(slot, 1u, &pBuffer, &stride, &offset);
+	}
+
+	template <typename Buffer, typename Format>
+	void setIndexBuffer(Buffer* pBuffer, Format format, unsigned offset) {
+		if (update(m_indexBuffer, IndexBuffer{ pBuffer, static_cast<int64_t>(format), offset }))
+			m_pContext->IASetIndexBuffer(pBuffer, format, offset);
+	}
+
+	// class instances are not supported (the framework never uses them)
+	template <typename Shader>
+	void setVertexShader(Shader* pShader) {
+		if (update(m_shaders[index(ShaderStage::VERTEX)], static_cast<const void*>(pShader)))
+			m_pContext->VSSetShader(pShader, nullptr, 0u);
+	}
+
+	template <typename Shader>
+	void setPixelShader(Shader* pShader) {
+		if (update(m_shaders[index(ShaderStage::PIXEL)], static_cast<const void*>(pShader)))
+			m_pContext->PSSetShader(pShader, nullptr, 0u);
+	}
+
+	// one call for the whole range if any slot in it changes
+	template <typename Buffer>
+	void setConstantBuffers(ShaderStage stage, unsigned startSlot, unsigned count, Buffer* const* ppBuffers) {
+		if (!updateRange(m_constantBuffers[index(stage)], startSlot, count, [ppBuffers](unsigned i) {
+			return ConstantBuffer{ ppBuffers[i], 0u, 0u };
+		})) return;
+		switch (stage) {
+		case ShaderStage::VERTEX:
+			m_pContext->VSSetConstantBuffers(startSlot, count, ppBuffers);
+			break;
+		case ShaderStage::PIXEL:
+			m_pContext->PSSetConstantBuffers(startSlot, count, ppBuffers);
+			break;
+		}
+	}
+
+	// offset bind of part of a buffer (Direct3D 11.1, so Context must have *SetConstantBuffers1)
+	template <typename Buffer>
+	void setConstantBuffer1(ShaderStage stage, unsigned slot, Buffer* pBuffer, unsigned firstConstant, unsigned numConstants) {
+		if (!updateSlot(m_constantBuffers[index(stage)], slot, ConstantBuffer{ pBuffer, firstConstant, numConstants }))
+			return;
+		switch (stage) {
+		case ShaderStage::VERTEX:
+			m_pContext->VSSetConstantBuffers1(slot, 1u, &pBuffer, &firstConstant, &numConstants);
+			break;
+		case ShaderStage::PIXEL:
+			m_pContext->PSSetConstantBuffers1(slot, 1u, &pBuffer, &firstConstant, &numConstants);
+			break;
+		}
+	}
+
+	template <typename View>
+	void setShaderResource(ShaderStage stage, unsigned slot, View* pView) {
+		if (!updateSlot(m_shaderResources[index(stage)], slot, static_cast<const void*>(pView))) return;
+		switch (stage) {
+		case ShaderStage::VERTEX:
+			m_pContext->VSSetShaderResources(slot, 1u, &pView);
+			break;
+		case ShaderStage::PIXEL:
+			m_pContext->PSSetShaderResources(slot, 1u, &pView);
+			break;
+		}
+	}
+
+	template <typename Sampler>
+	void setSampler(ShaderStage stage, unsigned slot, Sampler* pSampler) {
+		if (!updateSlot(m_samplers[index(stage)], slot, static_cast<const void*>(pSampler))) return;
+		switch (stage) {
+		case ShaderStage::VERTEX:
+			m_pContext->VSSetSamplers(slot, 1u, &pSampler);
+			break;
+		case ShaderStage::PIXEL:
+			m_pContext->PSSetSamplers(slot, 1u, &pSampler);
+			break;
+		}
+	}
+
+	// one render target
+	template <typename Target, typename DepthStencil>
+	void setRenderTarget(Target* pTarget, DepthStencil* pDepthStencil) {
+		if (update(m_renderTarget, RenderTarget{ pTarget, pDepthStencil }))
+			m_pContext->OMSetRenderTargets(1u, &pTarget, pDepthStencil);
+	}
+
+	// one viewport; anything with D3D11_VIEWPORT's members works
+	template <typename ViewportDesc>
+	void setViewport(const ViewportDesc& viewport) {
+		const Viewport vp{ viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height,
+			viewport.MinDepth, viewport.MaxDepth };
+		if (update(m_viewport, vp))
+			m_pContext->RSSetViewports(1u, &viewport);
+	}
+private:
+	static constexpr size_t index(ShaderStage stage) noexcept {
+		return static_cast<size_t>(stage);
+	}
+
+	// true if the call has to be issued
+	template <typename T>
+	bool update(Shadow<T>& shadow, const T& value) noexcept {
+		if (shadow.known && shadow.value == value) {
+			m_counters.elided++;
+			return false;
+		}
+		shadow.value = value;
+		shadow.known = true;
+		m_counters.issued++;
+		return true;
+	}
+
+	template <typename T>
+	bool updateSlot(Slots<T>& slots, unsigned slot, const T& value) noexcept {
+		if (slot >= TRACKED_SLOTS) {
+			m_counters.issued++;
+			return true;
+		}
+		return update(slots[slot], value);
+	}
+
+	template <typename T, typename Get>
+	bool updateRange(Slots<T>& slots, unsigned startSlot, unsigned count, Get get) noexcept {
+		bool changed{ false };
+		for (unsigned i{ 0u }; i < count; i++) {
+			const unsigned slot{ startSlot + i };
+			if (slot >= TRACKED_SLOTS) {
+				changed = true;
+				continue;
+			}
+			const T value{ get(i) };
+			if (!slots[slot].known || !(slots[slot].value == value)) {
+				slots[slot].value = value;
+				slots[slot].known = true;
+				changed = true;
+			}
+		}
+		if (changed)
+			m_counters.issued++;
+		else
+			m_counters.elided++;
+		return changed;
+	}
+};
+
+#ifdef _WIN32
+#include <d3d11.h>
+#include <d3d11_1.h>
+
+using StateCache = BasicStateCache<ID3D11DeviceContext1>; // the immediate context (see Graphics::getStateCache)
+using DeferredStateCache = BasicStateCache<ID3D11DeviceContext>; // e.g. while recording a command list
+#endif
+
+#endif
\ No newline at end of file
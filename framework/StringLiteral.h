@@ -0,0 +1,17 @@
+#ifndef CWF_STRINGLITERAL_H
+#define CWF_STRINGLITERAL_H
+
+#include <cstddef>
+
+// narrow counterpart of WStringLiteral, e.g. for semantic names
+template <size_t N>
+struct StringLiteral {
+	size_t size;
+	char value[N];
+	constexpr StringLiteral(const char (&str)[N]) : size{ N }, value{} {
+		for (size_t i{ 0 }; i < N; i++)
+			value[i] = str[i];
+	}
+};
+
+#endif
\ No newline at end of file
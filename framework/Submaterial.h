@@ -1,12 +1,23 @@
 #ifndef CWF_SUBMATERIAL_H
 #define CWF_SUBMATERIAL_H
 
+#include "ConstantBufferRing.h"
+#include "Culling.h"
 #include "Graphics.h"
+#include "MeshRegistry.h"
+#include "RenderQueue.h"
 #include "ShaderStage.h"
+#include "StateCache.h"
+#include "VertexQuantization.h"
+#include <algorithm> // std::count_if, std::min
 #include <cstddef> // std::byte
+#include <cstdint>
 #include <cstring> // std::memcpy
 #include <d3d11.h>
+#include <DirectXMath.h>
 #include <memory>
+#include <span>
+#include <type_traits>
 #include <vector>
 #include <wrl.h>
 
@@ -14,6 +25,9 @@
 * A submaterial is a class-like object, representing a type of DirectX object that uses the same shader and general info
 * as a material, but requires different constant buffers. They should only exist as "children" of materials.
 * You can add as many meshes as you want; they all just have to be of the same material.
+* If the parent is instanced, the submaterial's meshes are drawn once per parent instance too, from indirect arguments
+* of its own; the parent's updateInstances keeps their instance count current (the submaterial attaches itself to the
+* parent for that, so it must not outlive it).
 */
 
 template<class Vertex, typename Index>
@@ -27,16 +41,19 @@ private:
 		size_t length;
 		ShaderStage stage;
 		bool readOnly;
-		ConstantBuffer(const void* p, size_t l, ShaderStage s, bool r)
-			: pBuffer{ p }, length{ l }, stage{ s }, readOnly{ r }{}
+		UINT slot; // register within its stage
+		std::byte* pCopy; // our own copy of the data, if copied
+		ConstantBuffer(const void* p, size_t l, ShaderStage s, bool r, UINT sl, std::byte* c = nullptr)
+			: pBuffer{ p }, length{ l }, stage{ s }, readOnly{ r }, slot{ sl }, pCopy{ c } {}
 	};
 private:
 	Material<Vertex, Index>& m_parent;
-	std::vector<Vertex> m_vtx;
-	std::vector<Index> m_idx;
+	MeshRegistry<Vertex, Index> m_meshes;
+	DXGI_FORMAT m_indexFormat; // packed separately from the parent's meshes, with the parent's policy
 	std::vector<std::unique_ptr<std::byte[]>> m_copiedConstantBuffers;
 	std::vector<std::unique_ptr<std::byte[], Graphics::AlignedDeleter>> m_copiedAlignedConstantBuffers;
 	std::vector<ConstantBuffer> m_cBuffers;
+	std::vector<ConstantBufferRing::Allocation> m_ringAllocations; // parallel to m_cBuffers
 
 	// need to maintain for GPU access later
 	struct {
@@ -49,51 +66,98 @@ private:
 			Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer{};
 		} index{};
 		struct {
+			std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> buffers{}; // parallel to m_cBuffers
 			std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> vertexBuffers{};
 			std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> pixelBuffers{};
 			std::vector<ID3D11Buffer*> vertexRawBuffers{};
 			std::vector<ID3D11Buffer*> pixelRawBuffers{};
 		} constant{};
+		struct {
+			Microsoft::WRL::ComPtr<ID3D11Buffer> pArgs{}; // one D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS per mesh part
+		} instance{};
 	} Data{};
 
 	// generated by DirectX
 	Microsoft::WRL::ComPtr<ID3D11CommandList> m_pCmdList;
+	std::vector<bool> m_recordedVisibility; // which meshes m_pCmdList draws
 
 public:
 	Submaterial(Material<Vertex, Index>& m_parentMaterial)
-		: m_parent{ m_parentMaterial }, m_vtx{}, m_idx{}, m_cBuffers{}, m_pCmdList{} {}
+		: m_parent{ m_parentMaterial }, m_meshes{}, m_indexFormat{ DXGI_FORMAT_R16_UINT }, m_cBuffers{}, m_pCmdList{},
+		m_recordedVisibility{} {
+		m_parent.attach(this);
+	}
+
+	~Submaterial() {
+		m_parent.detach(this);
+	}
+
+	// no copy init/assign, since the parent keeps a pointer to this
+	Submaterial(const Submaterial& o) = delete;
+	Submaterial& operator=(const Submaterial& o) = delete;
+
+	using MeshId = typename MeshRegistry<Vertex, Index>::MeshId;
+
+	// do not interact with DirectX; see Material::addMesh
+	MeshId addMesh(std::initializer_list<Vertex> vertices, std::initializer_list<Index> indices) noexcept {
+		return m_meshes.add(vertices, indices);
+	}
+
+	MeshId addMesh(const std::vector<Vertex>& vertices, const std::vector<Index>& indices) noexcept {
+		return m_meshes.add(vertices, indices);
+	}
 
-	// do not interact with DirectX
-	void addMesh(std::initializer_list<Vertex> vertices, std::initializer_list<Index> indices) noexcept {
-		m_vtx.insert(m_vtx.cend(), vertices);
-		m_idx.insert(m_idx.cend(), indices);
+	MeshId addMesh(const Graphics::IndexedVertexList<Vertex, Index>& mesh) noexcept {
+		return m_meshes.add(mesh.vertices, mesh.indices);
 	}
 
-	void addMesh(std::vector<Vertex> vertices, std::vector<Index> indices) noexcept {
-		m_vtx.insert(m_vtx.cend(), vertices.begin(), vertices.end());
-		m_idx.insert(m_idx.cend(), indices.begin(), indices.end());
+	template <class Source> requires (!std::is_same_v<Source, Vertex>)
+	MeshId addMesh(const Graphics::IndexedVertexList<Source, Index>& mesh, VertexQuantization::Report* pReport = nullptr) {
+		return m_meshes.add(VertexQuantization::quantize<Vertex, Source>(mesh.vertices, pReport), mesh.indices);
 	}
 
-	void addMesh(const Graphics::IndexedVertexList<Vertex, Index>& mesh) noexcept {
-		m_vtx.insert(m_vtx.cend(), mesh.vertices.begin(), mesh.vertices.end());
-		m_idx.insert(m_idx.cend(), mesh.indices.begin(), mesh.indices.end());
+	void setMeshVisible(MeshId id, bool visible) noexcept {
+		m_meshes.setVisible(id, visible);
+	}
+
+	// as Material::cull, for this submaterial's meshes
+	size_t XM_CALLCONV cull(const Graphics& gfx, math::FXMMATRIX world = math::XMMatrixIdentity()) noexcept {
+		if (m_parent.getInstanceCount() > 0u) {
+			m_meshes.uncull();
+			return m_meshes.size();
+		}
+		math::XMFLOAT4X4 worldViewProjection{};
+		math::XMStoreFloat4x4(&worldViewProjection, math::XMMatrixMultiply(world, gfx.getViewProjection()));
+		return m_meshes.cull(Culling::frustum(&worldViewProjection._11));
+	}
+
+	size_t cull(const Culling::Frustum& frustum) noexcept {
+		return m_meshes.cull(frustum);
+	}
+
+	void uncull() noexcept {
+		m_meshes.uncull();
+	}
+
+	const MeshRegistry<Vertex, Index>& getMeshes() const noexcept {
+		return m_meshes;
 	}
 
 	void addConstantBuffer(const void* pBuffer, size_t byteWidth, ShaderStage stage, bool readOnly = true) noexcept {
-		m_cBuffers.emplace_back( pBuffer, byteWidth, stage, readOnly );
+		m_cBuffers.emplace_back( pBuffer, byteWidth, stage, readOnly, nextSlot(stage) );
 	}
 
 	void copyConstantBuffer(const void* pBuffer, size_t byteWidth, ShaderStage stage, bool readOnly = true, bool aligned = false) {
 		if (!aligned) {
 			auto bytes = std::make_unique<std::byte[]>(byteWidth);
 			std::memcpy(bytes.get(), pBuffer, byteWidth);
-			m_cBuffers.emplace_back(bytes.get(), byteWidth, stage, readOnly);
+			m_cBuffers.emplace_back(bytes.get(), byteWidth, stage, readOnly, nextSlot(stage), bytes.get());
 			m_copiedConstantBuffers.push_back(std::move(bytes));
 		}
 		else {
 			void* raw = _aligned_malloc(byteWidth, 16);
 			std::memcpy(raw, pBuffer, byteWidth);
-			m_cBuffers.emplace_back(raw, byteWidth, stage, readOnly);
+			m_cBuffers.emplace_back(raw, byteWidth, stage, readOnly, nextSlot(stage), reinterpret_cast<std::byte*>(raw));
 			m_copiedAlignedConstantBuffers.push_back(std::unique_ptr<std::byte[], Graphics::AlignedDeleter>{ reinterpret_cast<std::byte*>(raw) });
 		}
 	}
@@ -102,37 +166,100 @@ public:
 		if (index >= m_cBuffers.size() || m_cBuffers[index].readOnly || !m_pCmdList) return;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> pImmediateContext{ gfx.getImmediateContext() };
 		D3D11_MAPPED_SUBRESOURCE mappedResource{ 0 };
-		ID3D11Buffer* pConstantBuffer{};
-		switch (m_cBuffers[index].stage) {
-		case ShaderStage::VERTEX:
-			pConstantBuffer = Data.constant.vertexRawBuffers[index];
-			break;
-		case ShaderStage::PIXEL:
-			pConstantBuffer = Data.constant.pixelRawBuffers[index];
-			break;
-#ifndef NDEBUG
-		default:
-			OutputDebugStringW(L"Update your other stage switch (submaterial), dumb dumb.\n");
-#endif
-		}
+		ID3D11Buffer* pConstantBuffer{ Data.constant.buffers[index].Get() };
 		THROW_IF_FAILED(gfx,
 			pImmediateContext->Map(pConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource));
 		std::memcpy(mappedResource.pData, pBuffer, byteWidth);
 		pImmediateContext->Unmap(pConstantBuffer, 0);
 	}
+
+	// see Material::setCopyConstantBuffer
+	void setCopyConstantBuffer(size_t index, const void* pBuffer, size_t byteWidth) noexcept {
+		if (index >= m_cBuffers.size() || !m_cBuffers[index].pCopy) return;
+		std::memcpy(m_cBuffers[index].pCopy, pBuffer, std::min(byteWidth, m_cBuffers[index].length));
+	}
+
+	// see Material::stageConstantBuffers
+	void stageConstantBuffers(ConstantBufferRing& ring) {
+		m_ringAllocations.resize(m_cBuffers.size());
+		for (size_t i{ 0u }; i < m_cBuffers.size(); i++) {
+			if (!m_cBuffers[i].readOnly)
+				m_ringAllocations[i] = ring.allocate(m_cBuffers[i].pBuffer, m_cBuffers[i].length);
+		}
+	}
 	
 	// call in another thread for optimal performance
 	void setupPipeline(const Graphics& gfx) {
 		if (m_pCmdList) return; // do not re-generate resources
+		createResources(gfx);
+		record(gfx);
+	}
+
+	// see Material::draw(gfx)
+	void draw(const Graphics& gfx) {
+		if (m_pCmdList && !m_meshes.hasVisibility(m_recordedVisibility)) record(gfx);
+		gfx.executeCommandList(m_pCmdList.Get());
+	}
+
+	// see Material::draw(gfx, ring, skip)
+	void draw(const Graphics& gfx, const ConstantBufferRing& ring, unsigned skip = RenderQueue::SKIP_NONE) {
+		if (!m_pCmdList) return;
+		StateCache& cache{ gfx.getStateCache() };
+		bindBuffers(cache);
+		for (size_t i{ 0u }; i < m_ringAllocations.size(); i++) {
+			if (!m_cBuffers[i].readOnly && m_ringAllocations[i].pBuffer)
+				ring.bind(m_cBuffers[i].stage, m_cBuffers[i].slot, m_ringAllocations[i]);
+		}
+		m_parent.bindPipeline(cache, true, skip);
+		m_parent.issueDraw(cache.getContext(), m_meshes, Data.instance.pArgs.Get());
+	}
+
+	// called by the parent's updateInstances
+	void updateInstanceCount(const Graphics& gfx, UINT count) {
+		if (!Data.instance.pArgs) return;
+		const std::vector<D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS> args{ Material<Vertex, Index>::indirectArgs(m_meshes, count) };
+		gfx.getImmediateContext()->UpdateSubresource(Data.instance.pArgs.Get(), 0u, nullptr, args.data(), 0u, 0u);
+	}
+
+	// see Material::submit; sorts and skips together with the parent, since the pipeline state is the parent's
+	void submit(RenderQueue& queue, float depth = 0.0f, uint8_t layer = 0u) {
+		const uint64_t key{ RenderQueue::SortKey::make(layer, queue.idFor(m_parent.getShaderState()), queue.idFor(m_parent.getTextureState()), depth) };
+		queue.submit(key, this, [](const void* pObject, const Graphics& gfx, const ConstantBufferRing& ring, unsigned skip) {
+			const_cast<Submaterial*>(static_cast<const Submaterial*>(pObject))->draw(gfx, ring, skip);
+		}, m_parent.getPipelineState(), m_parent.getTextureState());
+	}
+
+private:
+	// (re)records m_pCmdList with the meshes visible now; createResources must have run
+	void record(const Graphics& gfx) {
 		Microsoft::WRL::ComPtr<ID3D11Device> pDevice{ gfx.getDevice() };
 
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> pDeferred;
 		THROW_IF_FAILED(gfx, pDevice->CreateDeferredContext(0, &pDeferred));
 
+		DeferredStateCache cache{ pDeferred.Get() };
+		bindBuffers(cache);
+
+		m_parent.setupPipeline(gfx, pDeferred, m_pCmdList, true, &m_meshes, Data.instance.pArgs.Get());
+		m_meshes.getVisibility(m_recordedVisibility);
+	}
+
+	void createResources(const Graphics& gfx) {
+		Microsoft::WRL::ComPtr<ID3D11Device> pDevice{ gfx.getDevice() };
+
+		// same optimization as the parent's meshes
+		if (m_parent.shouldOptimizeMeshes())
+			m_meshes.optimize(m_parent.getMeshOptimization());
+
+		// index format, and the vertices/indices as they will be uploaded
+		const auto packed{ m_meshes.pack(m_parent.getIndexPolicy()) };
+		m_indexFormat = packed.wide ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+
 		// vertex buffer
 		{
+			const std::span<const Vertex> vertices{ m_meshes.vertexData(packed) };
 			D3D11_BUFFER_DESC vtxDesc{};
-			vtxDesc.ByteWidth = m_vtx.size() * sizeof(Vertex);
+			vtxDesc.ByteWidth = vertices.size() * sizeof(Vertex);
 			vtxDesc.Usage = D3D11_USAGE_DEFAULT;
 			vtxDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 			vtxDesc.CPUAccessFlags = 0u;
@@ -140,33 +267,49 @@ public:
 			vtxDesc.StructureByteStride = sizeof(Vertex);
 
 			D3D11_SUBRESOURCE_DATA vtxData{};
-			vtxData.pSysMem = m_vtx.data();
+			vtxData.pSysMem = vertices.data();
 
 			THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&vtxDesc, &vtxData, &Data.vertex.pBuffer));
 
 			Data.vertex.stride = sizeof(Vertex);
 			Data.vertex.offset = 0u;
-
-			pDeferred->IASetVertexBuffers(0u, 1u, Data.vertex.pBuffer.GetAddressOf(), 
-				&Data.vertex.stride, &Data.vertex.offset);
 		}
 
 		// index buffer
 		{
+			const std::span<const std::byte> indices{ m_meshes.indexData(packed) };
 			D3D11_BUFFER_DESC idxDesc{};
-			idxDesc.ByteWidth = m_idx.size() * sizeof(Index);
+			idxDesc.ByteWidth = indices.size();
 			idxDesc.Usage = D3D11_USAGE_DEFAULT;
 			idxDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 			idxDesc.CPUAccessFlags = 0u;
 			idxDesc.MiscFlags = 0u;
-			idxDesc.StructureByteStride = sizeof(Index);
+			idxDesc.StructureByteStride = packed.wide ? sizeof(uint32_t) : sizeof(uint16_t);
 
 			D3D11_SUBRESOURCE_DATA idxData{};
-			idxData.pSysMem = m_idx.data();
+			idxData.pSysMem = indices.data();
 
 			THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&idxDesc, &idxData, &Data.index.pBuffer));
+		}
+
+		// indirect draw arguments, once the parent has its instance buffer (and with it the capacity)
+		m_parent.createResources(gfx, true);
+		if (m_parent.isInstanced()) {
+			const std::vector<D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS> args{
+				Material<Vertex, Index>::indirectArgs(m_meshes, m_parent.getDrawnInstanceCount()) };
+
+			D3D11_BUFFER_DESC argsDesc{};
+			argsDesc.ByteWidth = args.size() * sizeof(D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS);
+			argsDesc.Usage = D3D11_USAGE_DEFAULT;
+			argsDesc.BindFlags = 0u;
+			argsDesc.CPUAccessFlags = 0u;
+			argsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+			argsDesc.StructureByteStride = 0u;
 
-			pDeferred->IASetIndexBuffer(Data.index.pBuffer.Get(), m_parent.getIndexFormat(), 0u);
+			D3D11_SUBRESOURCE_DATA argsData{};
+			argsData.pSysMem = args.data();
+
+			THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&argsDesc, &argsData, &Data.instance.pArgs));
 		}
 
 		// constant buffer
@@ -185,6 +328,7 @@ public:
 
 				Microsoft::WRL::ComPtr<ID3D11Buffer> pCBuff;
 				THROW_IF_FAILED(gfx, pDevice->CreateBuffer(&cbDesc, &cbData, &pCBuff));
+				Data.constant.buffers.push_back(pCBuff);
 
 				switch (cb.stage) {
 				case ShaderStage::VERTEX:
@@ -203,17 +347,22 @@ public:
 				Data.constant.vertexRawBuffers.push_back(comPtr.Get());
 			for (auto& comPtr : Data.constant.pixelBuffers)
 				Data.constant.pixelRawBuffers.push_back(comPtr.Get());
-			if (!Data.constant.vertexRawBuffers.empty())
-				pDeferred->VSSetConstantBuffers(0u, Data.constant.vertexRawBuffers.size(), Data.constant.vertexRawBuffers.data());
-			if (!Data.constant.pixelRawBuffers.empty())
-				pDeferred->VSSetConstantBuffers(0u, Data.constant.pixelRawBuffers.size(), Data.constant.pixelRawBuffers.data());
 		}
+	}
 
-		m_parent.setupPipeline(gfx, pDeferred, m_pCmdList, true);
+	template <typename Context>
+	void bindBuffers(BasicStateCache<Context>& cache) const {
+		cache.setVertexBuffer(0u, Data.vertex.pBuffer.Get(), Data.vertex.stride, Data.vertex.offset);
+		cache.setIndexBuffer(Data.index.pBuffer.Get(), m_indexFormat, 0u);
+		if (!Data.constant.vertexRawBuffers.empty())
+			cache.setConstantBuffers(ShaderStage::VERTEX, 0u, Data.constant.vertexRawBuffers.size(), Data.constant.vertexRawBuffers.data());
+		if (!Data.constant.pixelRawBuffers.empty())
+			cache.setConstantBuffers(ShaderStage::PIXEL, 0u, Data.constant.pixelRawBuffers.size(), Data.constant.pixelRawBuffers.data());
 	}
 
-	void draw(const Graphics& gfx) {
-		gfx.getImmediateContext()->ExecuteCommandList(m_pCmdList.Get(), FALSE);
+	UINT nextSlot(ShaderStage stage) const noexcept {
+		return static_cast<UINT>(std::count_if(m_cBuffers.cbegin(), m_cBuffers.cend(),
+			[stage](const ConstantBuffer& cb) { return cb.stage == stage; }));
 	}
 };
 
@@ -0,0 +1,148 @@
+#ifndef CWF_VERTEXQUANTIZATION_H
+#define CWF_VERTEXQUANTIZATION_H
+
+#include "ShapeConcepts.h"
+#include "Vertices.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/*
+* Encodes full-precision vertices (e.g. Vertices::Float3Tex) into the packed 16-bit ones (Vertices::Half3Tex,
+* Vertices::Snorm3Tex), which cut a textured vertex from 20 bytes to 12, and the vertex fetch bandwidth with it.
+*	Half3Tex  - positions stay where they are, in half floats; precision falls off with distance from the origin
+*	Snorm3Tex - the mesh's bounding box is mapped onto [-1, 1]^3, so precision only depends on the mesh's size; the
+*	            shader sees box-relative positions, so decodeTransform(report.bounds) has to be put in front of the
+*	            mesh's world transform
+* UVs become 16-bit unorm for both, so they must lie in [0, 1] (anything outside is clamped).
+* The Report gives the error bound the format guarantees, the largest error actually seen (by decoding every vertex
+* again), and the memory the mesh takes before and after.
+*/
+
+namespace VertexQuantization {
+	// position = center + quantized * extent
+	struct Bounds {
+		float center[3];
+		float extent[3]; // half of the box's size; never 0
+	};
+
+	struct Report {
+		Bounds bounds;
+		float positionErrorBound; // per component, guaranteed by the format
+		float texCoordErrorBound;
+		float positionError; // per component, the largest actually seen
+		float texCoordError;
+		size_t vertexCount;
+		size_t sourceBytes;
+		size_t packedBytes;
+	};
+
+	// true if Packed holds box-relative positions (see above)
+	template <class Packed>
+	constexpr bool isBoxRelative() noexcept {
+		return std::is_same_v<decltype(Packed{ 0.0f, 0.0f, 0.0f }.pos.x), Vertices::Snorm16>;
+	}
+
+	template <Vertex Source>
+	Bounds bounds(std::span<const Source> vertices) noexcept {
+		float lo[3]{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+		float hi[3]{ std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+		for (const Source& v : vertices) {
+			const float p[3]{ static_cast<float>(v.pos.x), static_cast<float>(v.pos.y), static_cast<float>(v.pos.z) };
+			for (int a{ 0 }; a < 3; a++) {
+				lo[a] = std::min(lo[a], p[a]);
+				hi[a] = std::max(hi[a], p[a]);
+			}
+		}
+		Bounds b{};
+		for (int a{ 0 }; a < 3; a++) {
+			if (vertices.empty()) lo[a] = hi[a] = 0.0f;
+			b.center[a] = 0.5f * (lo[a] + hi[a]);
+			b.extent[a] = 0.5f * (hi[a] - lo[a]);
+			if (!(b.extent[a] > 0.0f)) b.extent[a] = 1.0f; // flat along this axis; anything decodes to the center
+		}
+		return b;
+	}
+
+	template <class Packed, Vertex Source>
+	std::vector<Packed> quantize(std::span<const Source> vertices, Report* pReport = nullptr) {
+		constexpr bool boxRelative{ isBoxRelative<Packed>() };
+		const Bounds box{ bounds(vertices) };
+
+		std::vector<Packed> packed{};
+		packed.reserve(vertices.size());
+		float positionError{ 0.0f };
+		float texCoordError{ 0.0f };
+		float largest{ 0.0f }; // largest coordinate magnitude, for the bounds
+		for (const Source& v : vertices) {
+			const float p[3]{ static_cast<float>(v.pos.x), static_cast<float>(v.pos.y), static_cast<float>(v.pos.z) };
+			float q[3]{ p[0], p[1], p[2] };
+			if constexpr (boxRelative) {
+				for (int a{ 0 }; a < 3; a++)
+					q[a] = (p[a] - box.center[a]) / box.extent[a];
+			}
+			Packed& out{ packed.emplace_back(q[0], q[1], q[2]) };
+			if constexpr (VertexAndTexture<Source>)
+				out.tex.set(static_cast<float>(v.tex.u), static_cast<float>(v.tex.v));
+
+			// decode again to measure
+			const float decoded[3]{ static_cast<float>(out.pos.x), static_cast<float>(out.pos.y), static_cast<float>(out.pos.z) };
+			for (int a{ 0 }; a < 3; a++) {
+				const float d{ boxRelative ? box.center[a] + decoded[a] * box.extent[a] : decoded[a] };
+				positionError = std::max(positionError, std::abs(d - p[a]));
+				largest = std::max(largest, std::abs(p[a]));
+			}
+			if constexpr (VertexAndTexture<Source>) {
+				texCoordError = std::max({ texCoordError,
+					std::abs(static_cast<float>(out.tex.u) - static_cast<float>(v.tex.u)),
+					std::abs(static_cast<float>(out.tex.v) - static_cast<float>(v.tex.v)) });
+			}
+		}
+
+		if (pReport) {
+			constexpr float EPSILON{ std::numeric_limits<float>::epsilon() };
+			float bound{};
+			if constexpr (boxRelative) // half a step of the widest axis, plus the float rounding of encoding and decoding
+				bound = 0.5f * std::max({ box.extent[0], box.extent[1], box.extent[2] }) / 32767.0f + 2.0f * largest * EPSILON;
+			else // half an ulp at the largest magnitude (11 significant bits), but halves below 2^-14 are subnormal and
+				// keep a fixed ulp of 2^-24; past the half range it's all gone
+				bound = largest > 65504.0f ? std::numeric_limits<float>::infinity() : std::max(std::ldexp(largest, -11), std::ldexp(1.0f, -25));
+			*pReport = {
+				box,
+				bound,
+				0.5f / 65535.0f + EPSILON,
+				positionError,
+				texCoordError,
+				vertices.size(),
+				vertices.size() * sizeof(Source),
+				packed.size() * sizeof(Packed)
+			};
+		}
+		return packed;
+	}
+
+	template <class Packed, Vertex Source>
+	std::vector<Packed> quantize(const std::vector<Source>& vertices, Report* pReport = nullptr) {
+		return quantize<Packed, Source>(std::span<const Source>{ vertices }, pReport);
+	}
+}
+
+#ifdef _WIN32
+#include <DirectXMath.h>
+
+namespace VertexQuantization {
+	// maps box-relative positions back to the mesh's own space; multiply it in front of the world transform
+	inline DirectX::XMMATRIX XM_CALLCONV decodeTransform(const Bounds& b) noexcept {
+		return DirectX::XMMatrixMultiply(
+			DirectX::XMMatrixScaling(b.extent[0], b.extent[1], b.extent[2]),
+			DirectX::XMMatrixTranslation(b.center[0], b.center[1], b.center[2])
+		);
+	}
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -1,13 +1,103 @@
 #ifndef CWF_VERTICES_H
 #define CWF_VERTICES_H
 
+#include "InputLayout.h"
+#include <algorithm> // std::clamp
+#include <cmath> // std::lround
+#include <cstdint>
+#include <cstring> // std::memcpy
+
 namespace Vertices {
+	// 16-bit scalars for packed vertices; they read and write as float, so the packed vertices below still satisfy the
+	// concepts in ShapeConcepts.h and can be used anywhere the float ones are (at 16-bit precision)
+	// Every vertex type lists its members as a Layout, from which its input layout is derived (see InputLayout.h).
+
+	// IEEE half float (DXGI_FORMAT_R16*_FLOAT); float -> half rounds to nearest even
+	struct Half {
+		uint16_t bits;
+		Half(float f = 0.0f) noexcept : bits{ fromFloat(f) } {}
+		operator float() const noexcept {
+			return toFloat(bits);
+		}
+
+		static uint16_t fromFloat(float f) noexcept {
+			uint32_t x{};
+			std::memcpy(&x, &f, sizeof(x));
+			const uint32_t sign{ (x >> 16) & 0x8000u };
+			const uint32_t exponent{ (x >> 23) & 0xFFu };
+			uint32_t mantissa{ x & 0x7FFFFFu };
+			if (exponent == 0xFFu) // inf or NaN (kept quiet)
+				return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+			const int e{ static_cast<int>(exponent) - 127 + 15 };
+			if (e >= 31) return static_cast<uint16_t>(sign | 0x7C00u); // too big: inf
+			int shift{ 13 };
+			uint32_t h{};
+			if (e <= 0) { // subnormal half (or zero)
+				if (e < -10) return static_cast<uint16_t>(sign);
+				mantissa |= 0x800000u;
+				shift = 14 - e;
+			} else {
+				h = static_cast<uint32_t>(e) << 10;
+			}
+			const uint32_t half{ 1u << (shift - 1) };
+			const uint32_t rest{ mantissa & ((1u << shift) - 1u) };
+			h += mantissa >> shift;
+			if (rest > half || (rest == half && (h & 1u))) h++; // may carry into the exponent, which is still right
+			return static_cast<uint16_t>(sign | h);
+		}
+
+		static float toFloat(uint16_t h) noexcept {
+			const uint32_t sign{ static_cast<uint32_t>(h & 0x8000u) << 16 };
+			uint32_t exponent{ (h >> 10) & 0x1Fu };
+			uint32_t mantissa{ h & 0x3FFu };
+			uint32_t x{};
+			if (exponent == 0x1Fu) {
+				x = sign | 0x7F800000u | (mantissa << 13);
+			} else if (exponent == 0u) {
+				if (mantissa == 0u) {
+					x = sign;
+				} else { // subnormal half: normalize
+					exponent = 1u;
+					while (!(mantissa & 0x400u)) {
+						mantissa <<= 1;
+						exponent--;
+					}
+					x = sign | ((exponent + 127u - 15u) << 23) | ((mantissa & 0x3FFu) << 13);
+				}
+			} else {
+				x = sign | ((exponent + 127u - 15u) << 23) | (mantissa << 13);
+			}
+			float f{};
+			std::memcpy(&f, &x, sizeof(f));
+			return f;
+		}
+	};
+
+	// [-1, 1] in 16 bits (DXGI_FORMAT_R16*_SNORM); values outside are clamped
+	struct Snorm16 {
+		int16_t bits;
+		Snorm16(float f = 0.0f) noexcept : bits{ static_cast<int16_t>(std::lround(std::clamp(f, -1.0f, 1.0f) * 32767.0f)) } {}
+		operator float() const noexcept {
+			return std::max(static_cast<float>(bits) / 32767.0f, -1.0f);
+		}
+	};
+
+	// [0, 1] in 16 bits (DXGI_FORMAT_R16*_UNORM); values outside are clamped
+	struct Unorm16 {
+		uint16_t bits;
+		Unorm16(float f = 0.0f) noexcept : bits{ static_cast<uint16_t>(std::lround(std::clamp(f, 0.0f, 1.0f) * 65535.0f)) } {}
+		operator float() const noexcept {
+			return static_cast<float>(bits) / 65535.0f;
+		}
+	};
+
 	struct Float3 {
 		struct {
 			float x;
 			float y;
 			float z;
 		} pos;
+		using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>>;
 		Float3(float X, float Y, float Z) {
 			pos.x = X;
 			pos.y = Y;
@@ -24,6 +114,8 @@ namespace Vertices {
 				v = V;
 			}
 		} tex;
+		using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>,
+			InputLayout::Element<"TextureCoord", decltype(tex)>>;
 		Float3Tex(float X, float Y, float Z) : Float3(X, Y, Z), tex{} {}
 	};
 
@@ -34,6 +126,7 @@ namespace Vertices {
 			float z;
 			float w;
 		} pos;
+		using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>>;
 		Float4(float X, float Y, float Z, float W) {
 			pos.x = X;
 			pos.y = Y;
@@ -48,9 +141,73 @@ namespace Vertices {
 			float u;
 			float v;
 		} tex;
+		using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>,
+			InputLayout::Element<"TextureCoord", decltype(tex)>>;
 		Float4Tex(float X, float Y, float Z, float W) : Float4(X, Y, Z, W), tex{} {}
 		Float4Tex(float X, float Y, float Z) : Float4(X, Y, Z), tex{} {}
 	};
+
+	// packed Float3Tex: half-float position and 16-bit UV, 12 bytes instead of 20
+	// (DXGI has no three-component 16-bit formats, so w pads the position; the shader still reads a float3)
+	struct Half3Tex {
+		struct {
+			Half x;
+			Half y;
+			Half z;
+			Half w;
+		} pos;
+		struct {
+			Unorm16 u;
+			Unorm16 v;
+			void set(float U, float V) noexcept {
+				u = U;
+				v = V;
+			}
+		} tex;
+		using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>,
+			InputLayout::Element<"TextureCoord", decltype(tex)>>;
+		Half3Tex(float X, float Y, float Z) noexcept : pos{ X, Y, Z, 1.0f }, tex{} {}
+	};
+
+	// packed Float3Tex: 16-bit snorm position and 16-bit UV, 12 bytes instead of 20
+	// The position is in [-1, 1]; for anything bigger, VertexQuantization::quantize maps a mesh's bounding box onto it
+	// and hands back the transform that undoes it.
+	struct Snorm3Tex {
+		struct {
+			Snorm16 x;
+			Snorm16 y;
+			Snorm16 z;
+			Snorm16 w;
+		} pos;
+		struct {
+			Unorm16 u;
+			Unorm16 v;
+			void set(float U, float V) noexcept {
+				u = U;
+				v = V;
+			}
+		} tex;
+		using Layout = InputLayout::Elements<InputLayout::Element<"Position", decltype(pos)>,
+			InputLayout::Element<"TextureCoord", decltype(tex)>>;
+		Snorm3Tex(float X, float Y, float Z) noexcept : pos{ X, Y, Z, 1.0f }, tex{} {}
+	};
+}
+
+namespace InputLayout {
+	template <>
+	struct ComponentFormats<Vertices::Half> {
+		static constexpr std::array<Format, 4u> formats{ Format::R16_FLOAT, Format::R16G16_FLOAT, Format::UNKNOWN, Format::R16G16B16A16_FLOAT };
+	};
+
+	template <>
+	struct ComponentFormats<Vertices::Snorm16> {
+		static constexpr std::array<Format, 4u> formats{ Format::R16_SNORM, Format::R16G16_SNORM, Format::UNKNOWN, Format::R16G16B16A16_SNORM };
+	};
+
+	template <>
+	struct ComponentFormats<Vertices::Unorm16> {
+		static constexpr std::array<Format, 4u> formats{ Format::R16_UNORM, Format::R16G16_UNORM, Format::UNKNOWN, Format::R16G16B16A16_UNORM };
+	};
 }
 
 #endif
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "CwfException.h"
 #include "Graphics.h"
+#include "InputLog.h"
+#include "InputReplayer.h"
+#include "RawInputDecoder.h"
 #include "Window.h"
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <optional>
@@ -10,6 +14,24 @@
 #include <Windows.h>
 #include <windowsx.h>
 
+// RawInputDecoder reads packets through its own copies of these
+static_assert(sizeof(RawInputDecoder::Header) == sizeof(RAWINPUTHEADER)
+	&& offsetof(RawInputDecoder::Header, type) == offsetof(RAWINPUTHEADER, dwType)
+	&& offsetof(RawInputDecoder::Header, size) == offsetof(RAWINPUTHEADER, dwSize),
+	"RawInputDecoder::Header must match RAWINPUTHEADER");
+static_assert(sizeof(RawInputDecoder::Mouse) == sizeof(RAWMOUSE)
+	&& offsetof(RawInputDecoder::Mouse, flags) == offsetof(RAWMOUSE, usFlags)
+	&& offsetof(RawInputDecoder::Mouse, lastX) == offsetof(RAWMOUSE, lLastX)
+	&& offsetof(RawInputDecoder::Mouse, lastY) == offsetof(RAWMOUSE, lLastY),
+	"RawInputDecoder::Mouse must match RAWMOUSE");
+static_assert(RawInputDecoder::TYPE_MOUSE == RIM_TYPEMOUSE && RawInputDecoder::MOVE_ABSOLUTE == MOUSE_MOVE_ABSOLUTE,
+	"RawInputDecoder constants must match Windows'");
+
+static bool isInputMessage(UINT message) noexcept {
+	return (message >= WM_KEYFIRST && message <= WM_KEYLAST) || (message >= WM_MOUSEFIRST && message <= WM_MOUSELAST)
+		|| message == WM_INPUT;
+}
+
 // Nested classes
 Window::SmartHWND::SmartHWND() noexcept : m_hWnd{ nullptr } {}
 
@@ -112,7 +134,10 @@ Window::WindowInitializationStruct& Window::WindowInitializationStruct::operator
 // Constructor and Destructor
 Window::Window(Window::WindowInitializationStruct wis)
 	: m_hWnd{}, m_clientWindowProc{ wis.windowProc }, 
-	m_clientWidth{ wis.clientWidth }, m_clientHeight{ wis.clientHeight }, kbd{}, mouse{} {
+	m_clientWidth{ wis.clientWidth }, m_clientHeight{ wis.clientHeight }, m_graphics{},
+	m_rawBuffer{ std::make_unique<RAWINPUT[]>(RAW_BUFFER_COUNT) }, m_rawDecoder{},
+	m_rawBufferLayout{ RawInputDecoder::NATIVE }, m_pRecorder{ nullptr }, m_pReplayer{ nullptr },
+	kbd{}, mouse{} {
 	
 	// SetProcessDpiAwareness(PROCESS_DPI_AWARENESS::PROCESS_SYSTEM_DPI_AWARE);
 	// SetProcessDPIAware();
@@ -123,6 +148,11 @@ Window::Window(Window::WindowInitializationStruct wis)
 	if (hWnd == nullptr) throw CWF_LAST_EXCEPTION();
 	m_hWnd = hWnd;
 	m_graphics = std::make_unique<Graphics>(hWnd, m_clientWidth, m_clientHeight);
+
+#ifndef _WIN64
+	BOOL wow64{ FALSE };
+	if (IsWow64Process(GetCurrentProcess(), &wow64) && wow64) m_rawBufferLayout = RawInputDecoder::WOW64;
+#endif
 }
 
 /*Window::Window(Window&& o) noexcept : hWnd{o.hWnd}, clientWindowProc{o.clientWindowProc} {
@@ -166,6 +196,10 @@ void Window::showWindow(int showCommand) {
 std::optional<int> Window::processMessagesOnQueue() {
 	MSG msg;
 	while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) { // uses nullptr here to receive all messages from current thread
+		if (m_pReplayer && isInputMessage(msg.message)) { // the replay stands in for the devices
+			DispatchMessage(&msg);
+			continue;
+		}
 		switch (msg.message) {
 		// other messages
 		case WM_QUIT:
@@ -250,36 +284,38 @@ std::optional<int> Window::processMessagesOnQueue() {
 
 		// raw input
 		case WM_INPUT:
-			HRAWINPUT hRawInput{ reinterpret_cast<HRAWINPUT>(msg.lParam) };
-			UINT size;
-			
-			// read size of data and allocate buffer
-			GetRawInputData(hRawInput, RID_INPUT, nullptr, &size, sizeof(RAWINPUTHEADER));
-			if (size == 0) break;
-			std::unique_ptr<std::byte[]> data{ std::make_unique<std::byte[]>(size) };
-
-			// get data
-			if (GetRawInputData(hRawInput, RID_INPUT, data.get(), &size, sizeof(RAWINPUTHEADER)) != size)
-				break; // bail if read wrong amount of info
-
-			RAWINPUT* raw{ reinterpret_cast<RAWINPUT*>(data.get()) };
-			if (raw->header.dwType == RIM_TYPEMOUSE
-				// there must be some movement
-				&& (raw->data.mouse.lLastX != 0 || raw->data.mouse.lLastY != 0)
-				// if these are absolute (not a delta), ditch the data
-				&& !(raw->data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE)) {
-
-				mouse.raw(raw->data.mouse.lLastX, raw->data.mouse.lLastY);
-			}
-
+			readRawInput(reinterpret_cast<HRAWINPUT>(msg.lParam));
 			break;
 		}
 		TranslateMessage(&msg);
 		DispatchMessage(&msg);
 	}
+	// one delta per pass, however many packets the mouse sent since the last
+	if (const std::optional<RawInputDecoder::Delta> delta{ m_rawDecoder.take() }) mouse.raw(delta->x, delta->y);
+	if (m_pReplayer) m_pReplayer->replay(kbd, mouse);
+	if (m_pRecorder) m_pRecorder->nextFrame();
 	return {};
 }
 
+void Window::readRawInput(HRAWINPUT hRawInput) noexcept {
+	std::byte* buffer{ reinterpret_cast<std::byte*>(m_rawBuffer.get()) };
+	// this message's own packet; a mouse's or keyboard's always fits in one RAWINPUT, so there is no need to ask first
+	UINT size{ sizeof(RAWINPUT) };
+	const UINT read{ GetRawInputData(hRawInput, RID_INPUT, buffer, &size, sizeof(RAWINPUTHEADER)) };
+	if (read != static_cast<UINT>(-1)) m_rawDecoder.decode(buffer, read);
+
+	// then whatever has queued up behind it, in bulk; a later WM_INPUT whose packet was drained here reads nothing
+	while (true) {
+		UINT bytes{ RAW_BUFFER_COUNT * sizeof(RAWINPUT) };
+		const UINT count{ GetRawInputBuffer(m_rawBuffer.get(), &bytes, sizeof(RAWINPUTHEADER)) };
+		if (count == 0u || count == static_cast<UINT>(-1)) break; // that was everything
+		// only the count comes back, so the bytes written are where the last of those packets ends
+		const size_t filled{ RawInputDecoder::filledBytes(buffer, RAW_BUFFER_COUNT * sizeof(RAWINPUT), count,
+			m_rawBufferLayout) };
+		m_rawDecoder.decodeBuffer(buffer, filled, count, m_rawBufferLayout);
+	}
+}
+
 void Window::createExceptionMessageBox(const CwfException& e) {
 	MessageBoxW(m_hWnd.get(), e.getExceptionString().c_str(), s_exceptionCaption, MB_ICONERROR);
 }
@@ -292,6 +328,16 @@ HWND Window::getHWND() const noexcept {
 	return m_hWnd.get();
 }
 
+void Window::setInputRecorder(InputLog::Recorder* pRecorder) noexcept {
+	m_pRecorder = pRecorder;
+	kbd.m_pRecorder = pRecorder;
+	mouse.m_pRecorder = pRecorder;
+}
+
+void Window::setInputReplayer(InputReplayer* pReplayer) noexcept {
+	m_pReplayer = pReplayer;
+}
+
 bool Window::setTitle(LPCWSTR title) noexcept {
 	return SetWindowTextW(m_hWnd.get(), title);
 }
@@ -3,8 +3,11 @@
 
 #include "CwfException.h"
 #include "Graphics.h"
+#include "InputLog.h"
+#include "InputReplayer.h"
 #include "Keyboard.h"
 #include "Mouse.h"
+#include "RawInputDecoder.h"
 #include <exception>
 #include <memory>
 #include <optional>
@@ -68,7 +71,14 @@ private:
 	int m_clientWidth;
 	int m_clientHeight;
 	std::unique_ptr<Graphics> m_graphics;
+	std::unique_ptr<RAWINPUT[]> m_rawBuffer; // reused by every raw input read, so WM_INPUT never allocates
+	RawInputDecoder m_rawDecoder;
+	RawInputDecoder::Layout m_rawBufferLayout;
+	InputLog::Recorder* m_pRecorder;
+	InputReplayer* m_pReplayer;
 public:
+	static constexpr UINT RAW_BUFFER_COUNT = 64u; // packets drained per GetRawInputBuffer call
+
 	Keyboard kbd;
 	Mouse mouse;
 
@@ -93,11 +103,17 @@ public:
 	ClientWindowProc getClientWindowProc() const noexcept;
 	bool setTitle(LPCWSTR title) noexcept;
 	HWND getHWND() const noexcept;
+	// kbd and mouse record everything they're given into pRecorder, until this is called again with nullptr
+	void setInputRecorder(InputLog::Recorder* pRecorder) noexcept;
+	// while set, the real keyboard and mouse are ignored and each processMessagesOnQueue replays the next of pReplayer's
+	void setInputReplayer(InputReplayer* pReplayer) noexcept;
 	
 	static void createExceptionMessageBoxStatic(const CwfException& e);
 	static void createExceptionMessageBoxStatic(const std::exception& e);
 
 	friend class WindowBuilder;
+private:
+	void readRawInput(HRAWINPUT hRawInput) noexcept;
 };
 
 #endif
\ No newline at end of file
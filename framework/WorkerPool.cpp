@@ -0,0 +1,91 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+WorkerPool::WorkerPool(unsigned threadCount) : m_threads{}, m_task{ nullptr }, m_pContext{ nullptr }, m_chunks{ 0u },
+	m_next{ 0u }, m_busy{ 0u }, m_generation{ 0u }, m_stopping{ false } {
+	m_threads.reserve(threadCount);
+	for (unsigned i{ 0u }; i < threadCount; i++)
+		m_threads.emplace_back(&WorkerPool::work, this);
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+void WorkerPool::run(size_t chunks, Task task, const void* pContext) {
+	if (chunks == 0u) return;
+	if (chunks == 1u || m_threads.empty()) { // nothing to share
+		for (size_t chunk{ 0u }; chunk < chunks; chunk++)
+			task(pContext, chunk);
+		return;
+	}
+
+	std::lock_guard<std::mutex> runLock{ m_runMutex };
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_task = task;
+		m_pContext = pContext;
+		m_chunks = chunks;
+		m_next.store(0u, std::memory_order_relaxed);
+		m_busy = m_threads.size();
+		m_generation++;
+	}
+	m_wake.notify_all();
+	drain(task, pContext, chunks);
+
+	// every thread checks out, even one that found nothing left, so the next run can't be mixed up with this one
+	std::unique_lock<std::mutex> lock{ m_mutex };
+	m_done.wait(lock, [this] { return m_busy == 0u; });
+}
+
+unsigned WorkerPool::getThreadCount() const noexcept {
+	return static_cast<unsigned>(m_threads.size());
+}
+
+WorkerPool& WorkerPool::shared() {
+	static WorkerPool s_pool{ std::max(std::thread::hardware_concurrency(), 1u) - 1u };
+	return s_pool;
+}
+
+void WorkerPool::work() {
+	uint64_t seen{ 0u };
+	while (true) {
+		Task task{};
+		const void* pContext{};
+		size_t chunks{};
+		{
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			m_wake.wait(lock, [this, seen] { return m_stopping || m_generation != seen; });
+			if (m_stopping) return;
+			seen = m_generation;
+			task = m_task;
+			pContext = m_pContext;
+			chunks = m_chunks;
+		}
+		drain(task, pContext, chunks);
+		bool last{};
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			last = --m_busy == 0u;
+		}
+		if (last) m_done.notify_one();
+	}
+}
+
+void WorkerPool::drain(Task task, const void* pContext, size_t chunks) noexcept {
+	for (size_t chunk{ m_next.fetch_add(1u, std::memory_order_relaxed) }; chunk < chunks;
+		chunk = m_next.fetch_add(1u, std::memory_order_relaxed))
+		task(pContext, chunk);
+}
\ No newline at end of file
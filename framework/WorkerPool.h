@@ -0,0 +1,60 @@
+#ifndef CWF_WORKERPOOL_H
+#define CWF_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+* A fixed set of threads, started once, that split data-parallel work between them and the caller: run(chunks, f)
+* calls f(chunk) once for every chunk in [0, chunks), on whichever thread gets to it first, and returns when all of them
+* are done. The calling thread takes chunks too, so a pool of n threads runs n + 1 chunks at once.
+* Starting threads costs far more than a frame's worth of small jobs, which is why anything run every frame (e.g.
+* BatchTransform::multiplyTransposedParallel) should go through a pool instead of fresh std::threads.
+* One run at a time: concurrent callers take turns, and f must not call run on the same pool.
+* Portable; shared() is a process-wide pool with one thread per extra hardware thread.
+*/
+
+class WorkerPool {
+public:
+	using Task = void(*)(const void* pContext, size_t chunk);
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex m_runMutex; // one run at a time
+	std::mutex m_mutex; // guards everything below except m_next
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	Task m_task;
+	const void* m_pContext;
+	size_t m_chunks;
+	std::atomic<size_t> m_next; // next chunk to hand out
+	size_t m_busy; // threads that haven't finished with the current run yet
+	uint64_t m_generation; // bumped by every run, so sleeping threads know there is work
+	bool m_stopping;
+public:
+	explicit WorkerPool(unsigned threadCount); // threads besides the caller; 0 runs everything on the caller
+	~WorkerPool();
+	// no copy init/assign
+	WorkerPool(const WorkerPool& o) = delete;
+	WorkerPool& operator=(const WorkerPool& o) = delete;
+
+	void run(size_t chunks, Task task, const void* pContext);
+
+	template <typename F>
+	void run(size_t chunks, const F& f) {
+		run(chunks, [](const void* pContext, size_t chunk) { (*static_cast<const F*>(pContext))(chunk); }, &f);
+	}
+
+	unsigned getThreadCount() const noexcept;
+
+	static WorkerPool& shared();
+private:
+	void work();
+	void drain(Task task, const void* pContext, size_t chunks) noexcept;
+};
+
+#endif
\ No newline at end of file
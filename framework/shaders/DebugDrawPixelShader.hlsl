@@ -0,0 +1,3 @@
+float4 main(float4 color : Color) : SV_Target{
+	return color;
+}
\ No newline at end of file
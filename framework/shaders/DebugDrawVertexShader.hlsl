@@ -0,0 +1,17 @@
+cbuffer CBuf {
+	matrix viewProjection;
+};
+
+struct VSOut {
+	float4 color : Color;
+	float4 pos : SV_Position;
+};
+
+// positions are already in world space; color is packed RGBA8, red in the low byte (see DebugDraw::rgba)
+VSOut main(float3 pos : Position, uint color : Color)
+{
+	VSOut output;
+	output.color = float4(color & 0xffu, (color >> 8) & 0xffu, (color >> 16) & 0xffu, color >> 24) / 255.0f;
+	output.pos = mul(float4(pos, 1.0f), viewProjection);
+	return output;
+}
\ No newline at end of file
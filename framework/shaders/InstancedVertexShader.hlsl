@@ -0,0 +1,17 @@
+cbuffer CBuf {
+	matrix viewProjection;
+};
+
+struct VSOut {
+	float2 tc : TextureCoord;
+	float4 pos : SV_Position;
+};
+
+// per-instance world transform comes from vertex buffer slot 1 (see Material::s_instanceLayout)
+VSOut main(float3 pos : Position, float2 tc : TextureCoord, row_major float4x4 world : InstanceTransform)
+{
+	VSOut output;
+	output.tc = tc;
+	output.pos = mul(mul(float4(pos, 1.0f), world), viewProjection);
+	return output;
+}
\ No newline at end of file
@@ -1,7 +0,0 @@
-cbuffer CBuf {
-	float4 colors[6];
-};
-
-float4 main(uint tId : SV_PrimitiveID) : SV_Target{
-	return colors[tId / 2];
-}
\ No newline at end of file
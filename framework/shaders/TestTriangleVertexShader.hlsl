@@ -1,7 +0,0 @@
-cbuffer CBuf {
-	float4x4 transform;
-};
-
-float4 main(float3 pos : Position) : SV_Position{
-	return mul(float4(pos, 1.0f), transform);
-}
\ No newline at end of file
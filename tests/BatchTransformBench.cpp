@@ -0,0 +1,94 @@
+#include "BatchTransform.h"
+#include "Bench.h"
+#include "ForcedPath.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+	// what multiplyTransposedParallel used to do: fresh threads on every call
+	void freshThreads(const float* pMatrices, size_t count, const float* pRight, float* pOut, unsigned threadCount) {
+		const size_t chunks{ std::min<size_t>(threadCount, std::max<size_t>(count / BatchTransform::MIN_MATRICES_PER_THREAD, 1u)) };
+		const size_t chunkSize{ (count + chunks - 1u) / chunks };
+		std::vector<std::thread> workers{};
+		for (size_t c{ 1u }; c < chunks; c++) {
+			const size_t first{ c * chunkSize };
+			if (first >= count) break;
+			workers.emplace_back(BatchTransform::multiplyTransposed, pMatrices + first * 16u, std::min(chunkSize, count - first),
+				pRight, pOut + first * 16u, size_t{ 16u });
+		}
+		BatchTransform::multiplyTransposed(pMatrices, std::min(chunkSize, count), pRight, pOut);
+		for (std::thread& worker : workers) worker.join();
+	}
+
+	// a cube's 24 corners (4 per face) baked by 10k to 1M matrices, as Cube::addMeshes does; ns/item is per vertex
+	void benchTransformPoints(std::mt19937& rng) {
+		constexpr size_t POINTS{ 24u };
+		std::uniform_real_distribution<float> value{ -1.0f, 1.0f };
+		std::vector<float> x(POINTS), y(POINTS), z(POINTS);
+		for (size_t i{ 0u }; i < POINTS; i++) {
+			x[i] = value(rng);
+			y[i] = value(rng);
+			z[i] = value(rng);
+		}
+		const BatchTransform::Points points{ x.data(), y.data(), z.data(), POINTS };
+
+		for (const size_t count : { 10000u, 100000u, 1000000u }) {
+			std::vector<float> matrices(count * 16u);
+			for (float& f : matrices) f = value(rng);
+			std::vector<float> ox(count * POINTS), oy(count * POINTS), oz(count * POINTS);
+			const size_t vertices{ count * POINTS };
+			std::printf("transformPoints, %zu matrices x %zu points\n", count, POINTS);
+			for (const BatchTransform::Path path : cwf::availablePaths()) {
+				cwf::forcedPath() = path;
+				const double ms{ cwf::run([&] {
+					BatchTransform::transformPoints(matrices.data(), count, points, { ox.data(), oy.data(), oz.data() });
+				}) };
+				char name[64]{};
+				std::snprintf(name, sizeof(name), "  %s", cwf::pathName(path));
+				cwf::report(name, ms, vertices);
+				std::printf("    %.1fM vertices/s\n", vertices / ms * 1e-3);
+			}
+			cwf::keep(oz[vertices - 1u]);
+		}
+	}
+}
+
+// world matrices times the view projection, as done for every object every frame, then baking transformed copies
+int main() {
+	constexpr unsigned THREADS{ 4u };
+	std::mt19937 rng{ 1u };
+	std::uniform_real_distribution<float> value{ -1.0f, 1.0f };
+	std::vector<float> right(16u);
+	for (float& f : right) f = value(rng);
+	WorkerPool pool{ THREADS - 1u };
+	cwf::forcedPath() = cwf::availablePaths().back(); // what BatchTransform::path() would pick
+
+	for (const size_t count : { 10000u, 100000u, 1000000u }) {
+		std::vector<float> matrices(count * 16u);
+		for (float& f : matrices) f = value(rng);
+		std::vector<float> out(count * 16u);
+		std::printf("%zu matrices\n", count);
+
+		cwf::report("  scalar", cwf::run([&] {
+			BatchTransform::multiplyTransposedScalar(matrices.data(), count, right.data(), out.data());
+		}), count);
+		cwf::report("  SIMD, one thread", cwf::run([&] {
+			BatchTransform::multiplyTransposed(matrices.data(), count, right.data(), out.data());
+		}), count);
+		cwf::report("  parallel, fresh threads per call", cwf::run([&] {
+			freshThreads(matrices.data(), count, right.data(), out.data(), THREADS);
+		}), count);
+		cwf::report("  parallel, worker pool", cwf::run([&] {
+			BatchTransform::multiplyTransposedParallel(pool, matrices.data(), count, right.data(), out.data(), 16u, THREADS);
+		}), count);
+		cwf::keep(out[count * 16u - 1u]);
+	}
+
+	benchTransformPoints(rng);
+	return 0;
+}
\ No newline at end of file
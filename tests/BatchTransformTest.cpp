@@ -0,0 +1,93 @@
+#include "BatchTransform.h"
+#include "Check.h"
+#include "ForcedPath.h"
+#include "WorkerPool.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+namespace {
+	std::vector<float> randomFloats(size_t count, unsigned seed) {
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> value{ -2.0f, 2.0f };
+		std::vector<float> out(count);
+		for (float& f : out) f = value(rng);
+		return out;
+	}
+
+	bool near(const std::vector<float>& a, const std::vector<float>& b) {
+		if (a.size() != b.size()) return false;
+		for (size_t i{ 0u }; i < a.size(); i++) {
+			if (std::abs(a[i] - b[i]) > 1e-4f * (1.0f + std::abs(b[i]))) return false;
+		}
+		return true;
+	}
+
+	// the SIMD path and the parallel split must match the scalar reference, strides and gaps included; run once per path
+	void testMultiplyTransposed() {
+		const std::vector<float> right{ randomFloats(16u, 1u) };
+		WorkerPool pool{ 3u };
+		for (const size_t count : std::initializer_list<size_t>{ 0u, 1u, 5u, 1000u, 3u * BatchTransform::MIN_MATRICES_PER_THREAD + 7u }) {
+			const std::vector<float> matrices{ randomFloats(count * 16u, 2u) };
+			for (const size_t stride : { size_t{ 16u }, size_t{ 20u } }) {
+				std::vector<float> expected(count * stride, -1.0f);
+				BatchTransform::multiplyTransposedScalar(matrices.data(), count, right.data(), expected.data(), stride);
+				std::vector<float> out(count * stride, -1.0f);
+				BatchTransform::multiplyTransposed(matrices.data(), count, right.data(), out.data(), stride);
+				CWF_CHECK(near(out, expected));
+				for (const unsigned threads : { 0u, 2u, 4u }) {
+					std::vector<float> parallel(count * stride, -1.0f);
+					BatchTransform::multiplyTransposedParallel(pool, matrices.data(), count, right.data(), parallel.data(), stride, threads);
+					CWF_CHECK(near(parallel, expected));
+				}
+				std::vector<float> shared(count * stride, -1.0f);
+				BatchTransform::multiplyTransposedParallel(matrices.data(), count, right.data(), shared.data(), stride);
+				CWF_CHECK(near(shared, expected));
+			}
+		}
+	}
+
+	// every path against the scalar reference, for point counts around the vector widths (all tail, exact, and tail)
+	void testTransformPoints() {
+		constexpr size_t MATRICES{ 50u };
+		const std::vector<float> matrices{ randomFloats(MATRICES * 16u, 6u) };
+		for (const size_t count : std::initializer_list<size_t>{ 1u, 3u, 4u, 8u, 13u, 24u }) {
+			const std::vector<float> x{ randomFloats(count, 3u) }, y{ randomFloats(count, 4u) }, z{ randomFloats(count, 5u) };
+			const BatchTransform::Points points{ x.data(), y.data(), z.data(), count };
+			std::vector<float> ex(MATRICES * count), ey(MATRICES * count), ez(MATRICES * count);
+			BatchTransform::transformPointsScalar(matrices.data(), MATRICES, points, { ex.data(), ey.data(), ez.data() });
+			for (const BatchTransform::Path path : cwf::availablePaths()) {
+				cwf::forcedPath() = path;
+				std::vector<float> ox(MATRICES * count), oy(MATRICES * count), oz(MATRICES * count);
+				BatchTransform::transformPoints(matrices.data(), MATRICES, points, { ox.data(), oy.data(), oz.data() });
+				const bool agrees{ near(ox, ex) && near(oy, ey) && near(oz, ez) };
+				CWF_CHECK(agrees);
+				if (!agrees) std::fprintf(stderr, "%s path disagrees with scalar for %zu points\n", cwf::pathName(path), count);
+			}
+		}
+
+		// no matrices, or no points: nothing is written
+		const std::vector<float> x{ randomFloats(4u, 7u) };
+		std::vector<float> out(4u, -1.0f);
+		for (const BatchTransform::Path path : cwf::availablePaths()) {
+			cwf::forcedPath() = path;
+			BatchTransform::transformPoints(matrices.data(), 0u, { x.data(), x.data(), x.data(), 4u },
+				{ out.data(), out.data(), out.data() });
+			BatchTransform::transformPoints(matrices.data(), MATRICES, { x.data(), x.data(), x.data(), 0u },
+				{ out.data(), out.data(), out.data() });
+			CWF_CHECK(out == std::vector<float>(4u, -1.0f));
+		}
+	}
+}
+
+int main() {
+	for (const BatchTransform::Path path : cwf::availablePaths()) {
+		cwf::forcedPath() = path;
+		testMultiplyTransposed();
+	}
+	testTransformPoints();
+	return cwf::failures();
+}
\ No newline at end of file
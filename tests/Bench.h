@@ -0,0 +1,42 @@
+#ifndef CWF_TESTS_BENCH_H
+#define CWF_TESTS_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+/*
+* Timing for the portable benchmarks: run(f) calls f a few times and keeps the fastest, so one-off stalls (page faults,
+* another process) don't count; keep() stops the optimizer from throwing a result away.
+*/
+
+namespace cwf {
+	template <typename F>
+	double run(F&& f, size_t repetitions = 5u) {
+		double best{ 1e300 };
+		for (size_t i{ 0u }; i < repetitions; i++) {
+			const auto start{ std::chrono::steady_clock::now() };
+			f();
+			const std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - start };
+			best = std::min(best, elapsed.count());
+		}
+		return best; // milliseconds
+	}
+
+	template <typename T>
+	void keep(const T& value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const void* volatile s_sink{ nullptr };
+		s_sink = &value;
+#endif
+	}
+
+	inline void report(const char* name, double milliseconds, size_t items) {
+		std::printf("%-48s %10.3f ms %10.2f ns/item\n", name, milliseconds, milliseconds * 1e6 / static_cast<double>(items));
+	}
+}
+
+#endif
\ No newline at end of file
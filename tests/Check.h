@@ -0,0 +1,26 @@
+#ifndef CWF_TESTS_CHECK_H
+#define CWF_TESTS_CHECK_H
+
+#include <cstdio>
+
+/*
+* Just enough of a test framework for the portable tests: CWF_CHECK reports a failed condition with its file and line
+* and keeps going, and a test's main returns cwf::failures() so ctest sees the result.
+*/
+
+namespace cwf {
+	inline int& failures() noexcept {
+		static int count{ 0 };
+		return count;
+	}
+
+	inline void check(bool passed, const char* condition, const char* file, int line) noexcept {
+		if (passed) return;
+		std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+		failures()++;
+	}
+}
+
+#define CWF_CHECK(...) cwf::check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "BatchTransform.h"
+#include "Bench.h"
+#include "Culling.h"
+#include "ForcedPath.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// one frame's culling of 1M bounds, about a third of them visible, on every path this CPU has
+int main() {
+	constexpr size_t COUNT{ 1000000u };
+	const float ys{ 1.0f / std::tan(0.785f) };
+	const float range{ 1000.0f / (1000.0f - 1.0f) };
+	const float vp[16]{ ys, 0, 0, 0, 0, ys, 0, 0, 0, 0, range, 1, 0, 0, -range, 0 };
+	const Culling::Frustum f{ Culling::frustum(vp) };
+
+	std::mt19937 rng{ 4u };
+	std::uniform_real_distribution<float> xy{ -600.0f, 600.0f };
+	std::uniform_real_distribution<float> depth{ -100.0f, 1100.0f };
+	std::uniform_real_distribution<float> size{ 0.5f, 5.0f };
+	std::vector<float> x(COUNT), y(COUNT), z(COUNT), r(COUNT), ex(COUNT), ey(COUNT), ez(COUNT);
+	for (size_t i{ 0u }; i < COUNT; i++) {
+		x[i] = xy(rng);
+		y[i] = xy(rng);
+		z[i] = depth(rng);
+		r[i] = size(rng);
+		ex[i] = size(rng);
+		ey[i] = size(rng);
+		ez[i] = size(rng);
+	}
+	const Culling::Spheres spheres{ x.data(), y.data(), z.data(), r.data(), COUNT };
+	const Culling::Boxes boxes{ x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data(), COUNT };
+	std::vector<uint8_t> visible(COUNT);
+
+	for (const BatchTransform::Path path : cwf::availablePaths()) {
+		cwf::forcedPath() = path;
+		size_t count{ 0u };
+		char name[64]{};
+		std::snprintf(name, sizeof(name), "cullSpheres, %s", cwf::pathName(path));
+		cwf::report(name, cwf::run([&] { count = Culling::cullSpheres(f, spheres, visible.data()); }), COUNT);
+		std::snprintf(name, sizeof(name), "cullBoxes, %s", cwf::pathName(path));
+		cwf::report(name, cwf::run([&] { count += Culling::cullBoxes(f, boxes, visible.data()); }), COUNT);
+		cwf::keep(count);
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "BatchTransform.h"
+#include "Check.h"
+#include "Culling.h"
+#include "ForcedPath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+	// XMMatrixPerspectiveFovLH's layout: row-major, applied to row vectors
+	std::vector<float> perspective(float fovY, float aspect, float nearZ, float farZ) {
+		const float ys{ 1.0f / std::tan(fovY * 0.5f) };
+		const float range{ farZ / (farZ - nearZ) };
+		return {
+			ys / aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, ys, 0.0f, 0.0f,
+			0.0f, 0.0f, range, 1.0f,
+			0.0f, 0.0f, -range * nearZ, 0.0f
+		};
+	}
+
+	struct SphereData {
+		std::vector<float> x, y, z, radius;
+		Culling::Spheres view() const { return { x.data(), y.data(), z.data(), radius.data(), x.size() }; }
+		void add(float px, float py, float pz, float r) {
+			x.push_back(px);
+			y.push_back(py);
+			z.push_back(pz);
+			radius.push_back(r);
+		}
+	};
+
+	struct BoxData {
+		std::vector<float> cx, cy, cz, ex, ey, ez;
+		Culling::Boxes view() const { return { cx.data(), cy.data(), cz.data(), ex.data(), ey.data(), ez.data(), cx.size() }; }
+		void add(float x, float y, float z, float hx, float hy, float hz) {
+			cx.push_back(x);
+			cy.push_back(y);
+			cz.push_back(z);
+			ex.push_back(hx);
+			ey.push_back(hy);
+			ez.push_back(hz);
+		}
+	};
+
+	size_t countVisible(const std::vector<uint8_t>& visible) {
+		return static_cast<size_t>(std::count(visible.begin(), visible.end(), uint8_t{ 1u }));
+	}
+
+	// fov 90 degrees, square, near 1, far 100: the frustum is |x| <= z, |y| <= z, 1 <= z <= 100
+	void testKnownBounds(const Culling::Frustum& f) {
+		SphereData s{};
+		s.add(0.0f, 0.0f, 10.0f, 1.0f); // in the middle
+		s.add(0.0f, 0.0f, -5.0f, 1.0f); // behind the camera
+		s.add(0.0f, 0.0f, 150.0f, 10.0f); // past the far plane
+		s.add(30.0f, 0.0f, 10.0f, 1.0f); // off to the right
+		s.add(0.0f, -30.0f, 10.0f, 1.0f); // below
+		s.add(0.0f, 0.0f, 0.5f, 1.0f); // straddles the near plane
+		s.add(11.0f, 0.0f, 10.0f, 1.0f); // straddles the right plane
+		s.add(0.0f, 0.0f, 102.0f, 3.0f); // straddles the far plane
+		s.add(12.0f, 0.0f, 10.0f, 1.0f); // 1.41 outside the right plane, radius 1
+		const uint8_t sphereExpected[]{ 1u, 0u, 0u, 0u, 0u, 1u, 1u, 1u, 0u };
+
+		BoxData b{};
+		b.add(0.0f, 0.0f, 10.0f, 1.0f, 1.0f, 1.0f);
+		b.add(0.0f, 0.0f, -5.0f, 1.0f, 1.0f, 1.0f);
+		b.add(0.0f, 0.0f, 150.0f, 10.0f, 10.0f, 10.0f);
+		b.add(30.0f, 0.0f, 10.0f, 1.0f, 1.0f, 1.0f);
+		b.add(0.0f, 0.0f, 50.0f, 200.0f, 200.0f, 0.1f); // wider than the frustum: covers it
+		b.add(12.0f, 0.0f, 10.0f, 2.5f, 0.1f, 0.1f); // reaches across the right plane along x only
+		b.add(12.0f, 0.0f, 10.0f, 0.5f, 0.5f, 0.5f); // doesn't
+		const uint8_t boxExpected[]{ 1u, 0u, 0u, 0u, 1u, 1u, 0u };
+
+		for (const BatchTransform::Path path : cwf::availablePaths()) {
+			cwf::forcedPath() = path;
+			std::vector<uint8_t> visible(s.x.size(), 2u);
+			CWF_CHECK(Culling::cullSpheres(f, s.view(), visible.data()) == 4u);
+			CWF_CHECK(std::equal(visible.begin(), visible.end(), sphereExpected));
+
+			visible.assign(b.cx.size(), 2u);
+			CWF_CHECK(Culling::cullBoxes(f, b.view(), visible.data()) == 3u);
+			CWF_CHECK(std::equal(visible.begin(), visible.end(), boxExpected));
+		}
+	}
+
+	// how close bound i comes to lying exactly on a plane; results may only differ there (FMA rounds differently)
+	float sphereMargin(const Culling::Frustum& f, const SphereData& s, size_t i) {
+		float margin{ 1e30f };
+		for (const Culling::Plane& p : f.planes)
+			margin = std::min(margin, std::abs(p.x * s.x[i] + p.y * s.y[i] + p.z * s.z[i] + p.w + s.radius[i]));
+		return margin;
+	}
+
+	float boxMargin(const Culling::Frustum& f, const BoxData& b, size_t i) {
+		float margin{ 1e30f };
+		for (const Culling::Plane& p : f.planes) {
+			const float reach{ std::abs(p.x) * b.ex[i] + std::abs(p.y) * b.ey[i] + std::abs(p.z) * b.ez[i] };
+			margin = std::min(margin, std::abs(p.x * b.cx[i] + p.y * b.cy[i] + p.z * b.cz[i] + p.w + reach));
+		}
+		return margin;
+	}
+
+	// every path agrees with the scalar one on random bounds, at every count (so every tail length) up to a few thousand
+	void testAgainstScalar(const Culling::Frustum& f) {
+		std::mt19937 rng{ 21u };
+		std::uniform_real_distribution<float> xy{ -120.0f, 120.0f };
+		std::uniform_real_distribution<float> depth{ -20.0f, 130.0f };
+		std::uniform_real_distribution<float> size{ 0.0f, 8.0f };
+		SphereData s{};
+		BoxData b{};
+		for (size_t i{ 0u }; i < 4099u; i++) {
+			s.add(xy(rng), xy(rng), depth(rng), size(rng));
+			b.add(xy(rng), xy(rng), depth(rng), size(rng), size(rng), size(rng));
+		}
+
+		for (const BatchTransform::Path path : cwf::availablePaths()) {
+			bool agrees{ true };
+			for (const size_t count : { 0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u, 15u, 16u, 17u, 4099u }) {
+				Culling::Spheres spheres{ s.view() };
+				Culling::Boxes boxes{ b.view() };
+				spheres.count = count;
+				boxes.count = count;
+
+				std::vector<uint8_t> expected(count + 1u, 7u);
+				std::vector<uint8_t> visible(count + 1u, 7u); // one past the end, which must be left alone
+				Culling::cullSpheresScalar(f, spheres, expected.data());
+				cwf::forcedPath() = path;
+				const size_t visibleCount{ Culling::cullSpheres(f, spheres, visible.data()) };
+				for (size_t i{ 0u }; i < count; i++)
+					agrees = agrees && (visible[i] == expected[i] || sphereMargin(f, s, i) < 1e-4f);
+				agrees = agrees && visible[count] == 7u && visibleCount == countVisible(visible);
+
+				std::fill(expected.begin(), expected.end(), uint8_t{ 7u });
+				std::fill(visible.begin(), visible.end(), uint8_t{ 7u });
+				Culling::cullBoxesScalar(f, boxes, expected.data());
+				const size_t boxCount{ Culling::cullBoxes(f, boxes, visible.data()) };
+				for (size_t i{ 0u }; i < count; i++)
+					agrees = agrees && (visible[i] == expected[i] || boxMargin(f, b, i) < 1e-4f);
+				agrees = agrees && visible[count] == 7u && boxCount == countVisible(visible);
+			}
+			if (!agrees) std::fprintf(stderr, "%s path disagrees with scalar\n", cwf::pathName(path));
+			CWF_CHECK(agrees);
+		}
+	}
+
+	// the frustum of world * view projection is the view projection's frustum in the object's own space
+	void testObjectSpace() {
+		const std::vector<float> vp{ perspective(1.5707964f, 1.0f, 1.0f, 100.0f) };
+		std::vector<float> wvp(16u, 0.0f); // translate by (0, 0, 40), then vp
+		const float world[16]{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 40, 1 };
+		for (int r{ 0 }; r < 4; r++) {
+			for (int c{ 0 }; c < 4; c++) {
+				for (int k{ 0 }; k < 4; k++) wvp[r * 4 + c] += world[r * 4 + k] * vp[k * 4 + c];
+			}
+		}
+		const Culling::Frustum f{ Culling::frustum(wvp.data()) };
+		SphereData s{};
+		s.add(0.0f, 0.0f, 0.0f, 1.0f); // at z = 40 in the world: inside
+		s.add(0.0f, 0.0f, 65.0f, 1.0f); // at z = 105: past the far plane
+		s.add(0.0f, 0.0f, -39.5f, 0.2f); // at z = 0.5: in front of the near plane
+		std::vector<uint8_t> visible(3u);
+		cwf::forcedPath() = BatchTransform::Path::SCALAR;
+		Culling::cullSpheres(f, s.view(), visible.data());
+		CWF_CHECK(visible[0] == 1u && visible[1] == 0u && visible[2] == 0u);
+	}
+}
+
+int main() {
+	const std::vector<float> vp{ perspective(1.5707964f, 1.0f, 1.0f, 100.0f) };
+	const Culling::Frustum f{ Culling::frustum(vp.data()) };
+	for (const Culling::Plane& p : f.planes) CWF_CHECK(std::abs(p.x * p.x + p.y * p.y + p.z * p.z - 1.0f) < 1e-5f);
+
+	testKnownBounds(f);
+	testAgainstScalar(f);
+	testObjectSpace();
+	return cwf::failures();
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#include "BatchTransform.h"
+#include "ForcedPath.h"
+
+BatchTransform::Path& cwf::forcedPath() noexcept {
+	static BatchTransform::Path s_path{ BatchTransform::Path::SCALAR };
+	return s_path;
+}
+
+BatchTransform::Path BatchTransform::path() noexcept {
+	return cwf::forcedPath();
+}
\ No newline at end of file
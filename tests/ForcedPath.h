@@ -0,0 +1,32 @@
+#ifndef CWF_TESTS_FORCEDPATH_H
+#define CWF_TESTS_FORCEDPATH_H
+
+#include "BatchTransform.h"
+#include <vector>
+
+/*
+* Culling and BatchTransform dispatch on BatchTransform::path(). Their tests and benchmarks link against
+* ForcedPath.cpp's definition of it instead of BatchTransform.cpp's (which is left out, or built with
+* CWF_BATCHTRANSFORM_FORCED_PATH), so they can run every path the CPU has rather than only the one it would pick.
+*/
+
+namespace cwf {
+	BatchTransform::Path& forcedPath() noexcept; // what BatchTransform::path() returns
+
+	inline std::vector<BatchTransform::Path> availablePaths() {
+		std::vector<BatchTransform::Path> paths{ BatchTransform::Path::SCALAR };
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		paths.push_back(BatchTransform::Path::SSE2);
+#if defined(__GNUC__) || defined(__clang__)
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) paths.push_back(BatchTransform::Path::AVX2);
+#endif
+#endif
+		return paths;
+	}
+
+	inline const char* pathName(BatchTransform::Path path) noexcept {
+		return path == BatchTransform::Path::AVX2 ? "AVX2" : (path == BatchTransform::Path::SSE2 ? "SSE2" : "scalar");
+	}
+}
+
+#endif
\ No newline at end of file
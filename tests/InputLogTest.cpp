@@ -0,0 +1,104 @@
+#include "Check.h"
+#include "InputLog.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace {
+	using Record = InputLog::Record;
+	using Type = Record::Type;
+
+	bool same(const Record& a, const Record& b) {
+		return a.time == b.time && a.frame == b.frame && a.type == b.type && a.code == b.code && a.x == b.x && a.y == b.y
+			&& a.wheel == b.wheel;
+	}
+
+	bool same(const InputLog& a, const InputLog& b) {
+		if (a.size() != b.size() || a.getSource() != b.getSource()) return false;
+		for (size_t i{ 0u }; i < a.size(); i++) {
+			if (!same(a.records()[i], b.records()[i])) return false;
+		}
+		return true;
+	}
+
+	// one record of every type, with fields only where the format keeps them
+	std::vector<Record> everyType() {
+		return {
+			{ 0u, 0u, Type::KEY_PRESSED, 'W', 0, 0, 0 },
+			{ 1000u, 0u, Type::KEY_RELEASED, 'W', 0, 0, 0 },
+			{ 1500u, 1u, Type::CHARACTER_TYPED, 'w', 0, 0, 0 },
+			{ 2000u, 1u, Type::BUTTON_PRESSED, 2u, 10, -20, 0 },
+			{ 2000u, 1u, Type::BUTTON_RELEASED, 2u, 11, -21, 0 },
+			{ 3000u, 2u, Type::BUTTON_DOUBLECLICKED, 0u, 12, -22, 0 },
+			{ 4000000u, 5u, Type::SCROLLED, 0u, 13, 14, -240 },
+			{ 4000001u, 5u, Type::MOVED, 0u, 500, 600, 0 },
+			{ 4000002u, 6u, Type::ENTERED, 0u, 0, 0, 0 },
+			{ 4000003u, 6u, Type::LEFT, 0u, -1, -1, 0 },
+			{ 90000000000u, 9000u, Type::RAW, 0u, INT32_MIN, INT32_MAX, 0 }
+		};
+	}
+
+	void testRoundTrip() {
+		for (const InputLog::Source source : { InputLog::Source::WINDOW, InputLog::Source::TIMELINE }) {
+			const InputLog log{ everyType(), source };
+			const std::vector<std::byte> bytes{ log.encode() };
+			InputLog decoded{};
+			CWF_CHECK(decoded.decode(bytes));
+			CWF_CHECK(same(log, decoded));
+			CWF_CHECK(decoded.getDuration() == 90000000000u);
+		}
+
+		InputLog empty{};
+		CWF_CHECK(empty.getSource() == InputLog::Source::WINDOW);
+		CWF_CHECK(empty.decode(InputLog{}.encode()) && empty.size() == 0u);
+	}
+
+	// a version 1 log had a u32 version where the source now is, and reads as a WINDOW one
+	void testVersion1() {
+		const InputLog log{ everyType(), InputLog::Source::WINDOW };
+		std::vector<std::byte> bytes{ log.encode() };
+		bytes[4u] = std::byte{ 1u };
+		bytes[5u] = std::byte{ 0u };
+		InputLog decoded{ {}, InputLog::Source::TIMELINE };
+		CWF_CHECK(decoded.decode(bytes));
+		CWF_CHECK(same(log, decoded));
+	}
+
+	void testMalformed() {
+		const std::vector<std::byte> good{ InputLog{ everyType(), InputLog::Source::TIMELINE }.encode() };
+		auto fails = [](std::vector<std::byte> bytes) {
+			InputLog log{ everyType(), InputLog::Source::TIMELINE };
+			return !log.decode(bytes) && log.size() == 0u && log.getSource() == InputLog::Source::WINDOW;
+		};
+		std::vector<std::byte> bytes{ good };
+		bytes[0u] = std::byte{ 'X' };
+		CWF_CHECK(fails(bytes));
+		bytes = good;
+		bytes[4u] = std::byte{ InputLog::VERSION + 1u }; // from a later version
+		CWF_CHECK(fails(bytes));
+		bytes = good;
+		bytes[4u] = std::byte{ 0u };
+		CWF_CHECK(fails(bytes));
+		bytes = good;
+		bytes[6u] = std::byte{ 2u }; // no such source
+		CWF_CHECK(fails(bytes));
+		bytes = good;
+		bytes[7u] = std::byte{ 1u };
+		CWF_CHECK(fails(bytes));
+		bytes = good;
+		bytes.resize(bytes.size() - 1u); // the last record cut short
+		CWF_CHECK(fails(bytes));
+		bytes = good;
+		bytes[8u] = std::byte{ 0xffu }; // more records than the bytes could hold
+		CWF_CHECK(fails(bytes));
+		CWF_CHECK(fails({}));
+	}
+}
+
+int main() {
+	testRoundTrip();
+	testVersion1();
+	testMalformed();
+	return cwf::failures();
+}
\ No newline at end of file
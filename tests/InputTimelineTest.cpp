@@ -0,0 +1,204 @@
+#include "Check.h"
+#include "InputTimeline.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Event = InputTimeline::Event;
+	using Type = Event::Type;
+	using Time = InputTimeline::Time;
+
+	// sample looks without consuming; advance consumes up to its time, so each frame sees each motion once
+	void testSampleAdvance() {
+		const std::unique_ptr<InputTimeline> timeline{ std::make_unique<InputTimeline>() };
+		timeline->publish({ 10, Type::KEY_DOWN, 'W', 0, 0 });
+		timeline->publish({ 20, Type::MOTION, 0u, 1, 2 });
+		timeline->publish({ 30, Type::KEY_UP, 'W', 0, 0 });
+		timeline->publish({ 40, Type::MOTION, 0u, 3, 4 });
+		timeline->publish({ 45, Type::WHEEL, 0u, -120, 0 });
+
+		InputTimeline::State state{ timeline->sample(5) };
+		CWF_CHECK(state.time == 5 && !state.isKeyPressed('W') && state.dx == 0 && state.dy == 0);
+		state = timeline->sample(25);
+		CWF_CHECK(state.time == 25 && state.isKeyPressed('W') && state.dx == 1 && state.dy == 2);
+		state = timeline->sample(25); // nothing consumed
+		CWF_CHECK(state.isKeyPressed('W') && state.dx == 1 && state.dy == 2);
+		CWF_CHECK(timeline->getPendingCount() == 5u);
+
+		state = timeline->advance(25);
+		CWF_CHECK(state.time == 25 && state.isKeyPressed('W') && state.dx == 1 && state.dy == 2);
+		CWF_CHECK(timeline->getPendingCount() == 3u);
+
+		// the key comes up at 30; the motion before the last advance is not counted again
+		state = timeline->sample(35);
+		CWF_CHECK(!state.isKeyPressed('W') && state.dx == 0 && state.dy == 0);
+		state = timeline->advance(50);
+		CWF_CHECK(state.time == 50 && !state.isKeyPressed('W') && state.dx == 3 && state.dy == 4 && state.wheel == -120);
+		CWF_CHECK(timeline->getPendingCount() == 0u);
+		state = timeline->advance(60);
+		CWF_CHECK(state.dx == 0 && state.dy == 0 && state.wheel == 0);
+	}
+
+	void testButtons() {
+		const std::unique_ptr<InputTimeline> timeline{ std::make_unique<InputTimeline>() };
+		timeline->publish({ 1, Type::BUTTON_DOWN, InputTimeline::LEFT, 0, 0 });
+		timeline->publish({ 2, Type::BUTTON_DOWN, InputTimeline::X2, 0, 0 });
+		timeline->publish({ 3, Type::BUTTON_UP, InputTimeline::LEFT, 0, 0 });
+		InputTimeline::State state{ timeline->advance(2) };
+		CWF_CHECK(state.isButtonPressed(InputTimeline::LEFT) && state.isButtonPressed(InputTimeline::X2));
+		CWF_CHECK(!state.isButtonPressed(InputTimeline::RIGHT));
+		state = timeline->advance(3);
+		CWF_CHECK(!state.isButtonPressed(InputTimeline::LEFT) && state.isButtonPressed(InputTimeline::X2));
+	}
+
+	// an event stamped after the frame's time waits for the next advance, and so does everything published after it
+	void testLaterEventsHeld() {
+		const std::unique_ptr<InputTimeline> timeline{ std::make_unique<InputTimeline>() };
+		timeline->publish({ 100, Type::MOTION, 0u, 5, 0 });
+		timeline->publish({ 150, Type::KEY_DOWN, 'A', 0, 0 });
+		InputTimeline::State state{ timeline->advance(50) };
+		CWF_CHECK(state.dx == 0 && !state.isKeyPressed('A'));
+		CWF_CHECK(timeline->getPendingCount() == 2u);
+		state = timeline->advance(100); // exactly at the stamp counts
+		CWF_CHECK(state.dx == 5 && !state.isKeyPressed('A'));
+		CWF_CHECK(timeline->getPendingCount() == 1u);
+
+		// read before the last advance but only published after it: counted towards the next frame, not lost
+		timeline->publish({ 90, Type::MOTION, 0u, 7, 0 });
+		state = timeline->advance(120);
+		CWF_CHECK(state.dx == 0 && timeline->getPendingCount() == 2u); // behind the held KEY_DOWN, in publish order
+		state = timeline->advance(150);
+		CWF_CHECK(state.dx == 7 && state.isKeyPressed('A'));
+		CWF_CHECK(timeline->getPendingCount() == 0u);
+	}
+
+	// publish fails once the consumer is QUEUE_CAPACITY events behind, and each failure is counted
+	void testOverflow() {
+		const std::unique_ptr<InputTimeline> timeline{ std::make_unique<InputTimeline>() };
+		size_t accepted{ 0u };
+		for (Time t{ 1 }; t <= static_cast<Time>(InputTimeline::QUEUE_CAPACITY + 10u); t++)
+			accepted += timeline->publish({ t, Type::MOTION, 0u, 1, 0 }) ? 1u : 0u;
+		CWF_CHECK(accepted == InputTimeline::QUEUE_CAPACITY);
+		CWF_CHECK(timeline->getOverflowCount() == 10u);
+		const InputTimeline::State state{ timeline->advance(std::numeric_limits<Time>::max()) };
+		CWF_CHECK(state.dx == static_cast<long>(InputTimeline::QUEUE_CAPACITY));
+
+		// room again once the consumer has polled
+		CWF_CHECK(timeline->publish({ 1000000, Type::MOTION, 0u, 1, 0 }));
+		CWF_CHECK(timeline->getOverflowCount() == 10u);
+	}
+
+	// the consumer's own events line up behind what was published, and advance hands back what it folded in
+	void testInjectAndApplied() {
+		const std::unique_ptr<InputTimeline> timeline{ std::make_unique<InputTimeline>() };
+		timeline->publish({ 10, Type::MOTION, 0u, 1, 0 });
+		timeline->inject({ 20, Type::KEY_DOWN, 'R', 0, 0 });
+		timeline->publish({ 30, Type::MOTION, 0u, 2, 0 });
+		timeline->inject({ 25, Type::WHEEL, 0u, 120, 0 }); // behind the motion at 30, so held with it
+		CWF_CHECK(timeline->sample(20).isKeyPressed('R'));
+
+		std::vector<Event> applied{ { 0, Type::KEY_UP, 'X', 0, 0 } }; // appended to, not replaced
+		InputTimeline::State state{ timeline->advance(25, applied) };
+		CWF_CHECK(state.dx == 1 && state.isKeyPressed('R') && state.wheel == 0);
+		CWF_CHECK(applied.size() == 3u && applied[1].time == 10 && applied[2].type == Type::KEY_DOWN);
+		applied.clear();
+		state = timeline->advance(30, applied);
+		CWF_CHECK(state.dx == 2 && state.wheel == 120 && applied.size() == 2u && applied[1].type == Type::WHEEL);
+		applied.clear();
+		timeline->advance(40, applied);
+		CWF_CHECK(applied.empty());
+
+		// injecting never competes with the producer for the ring
+		for (Time t{ 1 }; t <= static_cast<Time>(InputTimeline::QUEUE_CAPACITY); t++)
+			timeline->publish({ 100 + t, Type::MOTION, 0u, 1, 0 });
+		timeline->inject({ 1000000, Type::MOTION, 0u, 5, 0 });
+		CWF_CHECK(timeline->getOverflowCount() == 0u);
+		CWF_CHECK(timeline->publish({ 1000001, Type::MOTION, 0u, 7, 0 })); // the inject polled the ring
+		state = timeline->advance(std::numeric_limits<Time>::max());
+		CWF_CHECK(state.dx == static_cast<long>(InputTimeline::QUEUE_CAPACITY) + 5 + 7);
+	}
+
+	// a producer thread publishing as fast as it can against a consumer advancing frames: every event is either
+	// summed by exactly one advance or counted as dropped, and the drops are the ones publish refused
+	void testProducerThread() {
+		constexpr uint32_t COUNT{ 1000000u };
+		const std::unique_ptr<InputTimeline> timeline{ std::make_unique<InputTimeline>() };
+		std::atomic<uint32_t> published{ 0u };
+		std::atomic<Time> stamped{ 0 };
+		uint64_t dropped{ 0u };
+		int64_t droppedY{ 0 };
+		std::thread producer{ [&] {
+			for (uint32_t i{ 0u }; i < COUNT; i++) {
+				const Time time{ static_cast<Time>(i) + 1 };
+				const int32_t y{ static_cast<int32_t>(i % 7u) };
+				if (!timeline->publish({ time, Type::MOTION, 0u, 1, y })) {
+					dropped++;
+					droppedY += y;
+				}
+				stamped.store(time, std::memory_order_release);
+				published.store(i + 1u, std::memory_order_release);
+			}
+		} };
+
+		// let the producer run a full queue ahead first, so some events are certainly dropped
+		while (published.load(std::memory_order_acquire) < 2u * InputTimeline::QUEUE_CAPACITY && published.load() < COUNT)
+			std::this_thread::yield();
+		int64_t dx{ 0 };
+		int64_t dy{ 0 };
+		int64_t appliedDx{ 0 };
+		long injected{ 0 };
+		long wheel{ 0 };
+		std::vector<Event> applied{};
+		Time last{ 0 };
+		bool neverAhead{ true }; // event i is stamped i + 1, so by time t at most t of them can have been summed
+		while (published.load(std::memory_order_acquire) < COUNT) {
+			// up to what the producer has stamped so far, minus a little, so some events are held for later frames
+			const Time time{ stamped.load(std::memory_order_acquire) - 100 };
+			if (time < last) continue;
+			// a replay's events come in on this side while the producer keeps publishing
+			timeline->inject({ time, Type::WHEEL, 0u, 1, 0 });
+			injected++;
+			applied.clear();
+			const InputTimeline::State state{ timeline->advance(time, applied) };
+			for (const Event& e : applied) appliedDx += e.type == Type::MOTION ? e.x : 0;
+			last = state.time;
+			dx += state.dx;
+			dy += state.dy;
+			wheel += state.wheel;
+			neverAhead = neverAhead && dx <= time;
+		}
+		producer.join();
+		applied.clear();
+		const InputTimeline::State state{ timeline->advance(std::numeric_limits<Time>::max(), applied) };
+		for (const Event& e : applied) appliedDx += e.type == Type::MOTION ? e.x : 0;
+		dx += state.dx;
+		dy += state.dy;
+		wheel += state.wheel;
+
+		int64_t allY{ 0 };
+		for (uint32_t i{ 0u }; i < COUNT; i++) allY += i % 7u;
+		CWF_CHECK(neverAhead);
+		CWF_CHECK(dropped > 0u);
+		CWF_CHECK(timeline->getOverflowCount() == dropped);
+		CWF_CHECK(dx + static_cast<int64_t>(dropped) == COUNT);
+		CWF_CHECK(dy + droppedY == allY);
+		CWF_CHECK(appliedDx == dx);
+		CWF_CHECK(wheel == injected);
+		CWF_CHECK(timeline->getPendingCount() == 0u);
+	}
+}
+
+int main() {
+	testSampleAdvance();
+	testButtons();
+	testLaterEventsHeld();
+	testOverflow();
+	testInjectAndApplied();
+	testProducerThread();
+	return cwf::failures();
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "Check.h"
+#include "InstanceBatcher.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// counts every allocation in the process, to check that a steady-state frame makes none
+namespace {
+	size_t s_allocations{ 0u };
+}
+
+void* operator new(size_t size) {
+	s_allocations++;
+	if (void* p{ std::malloc(size ? size : 1u) }) return p;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+	struct Instance {
+		uint32_t object;
+		float scale;
+	};
+
+	using Batcher = InstanceBatcher<const void*, Instance>;
+
+	void testGrouping() {
+		int materials[3]{};
+		Batcher batcher{};
+		// interleaved submissions: B, A, B, C, A, B
+		const int order[]{ 1, 0, 1, 2, 0, 1 };
+		for (uint32_t i{ 0u }; i < 6u; i++)
+			batcher.submit(&materials[order[i]], { i, 1.0f });
+		CWF_CHECK(batcher.submissionCount() == 6u);
+
+		const std::vector<Batcher::Batch>& batches{ batcher.plan() };
+		CWF_CHECK(batches.size() == 3u);
+		// batches in the order their key first appeared
+		CWF_CHECK(batches[0].key == &materials[1] && batches[0].first == 0u && batches[0].count == 3u);
+		CWF_CHECK(batches[1].key == &materials[0] && batches[1].first == 3u && batches[1].count == 2u);
+		CWF_CHECK(batches[2].key == &materials[2] && batches[2].first == 5u && batches[2].count == 1u);
+		// instances contiguous per batch, in submission order
+		const std::vector<Instance>& instances{ batcher.instances() };
+		const uint32_t expected[]{ 0u, 2u, 5u, 1u, 4u, 3u };
+		CWF_CHECK(instances.size() == 6u);
+		for (size_t i{ 0u }; i < 6u; i++) CWF_CHECK(instances[i].object == expected[i]);
+	}
+
+	void testManyKeys() {
+		// more keys than the table starts with, so it grows while keeping every key's batch
+		constexpr uint32_t KEYS{ 1000u };
+		std::vector<int> objects(KEYS);
+		Batcher batcher{};
+		for (uint32_t round{ 0u }; round < 3u; round++) {
+			for (uint32_t k{ 0u }; k < KEYS; k++)
+				batcher.submit(&objects[(k * 7u) % KEYS], { round * KEYS + k, 0.0f });
+		}
+		const std::vector<Batcher::Batch>& batches{ batcher.plan() };
+		CWF_CHECK(batches.size() == KEYS);
+		bool correct{ true };
+		for (size_t b{ 0u }; b < batches.size(); b++) {
+			correct = correct && batches[b].key == &objects[(b * 7u) % KEYS] && batches[b].count == 3u
+				&& batches[b].first == b * 3u;
+			for (uint32_t round{ 0u }; round < 3u; round++)
+				correct = correct && batcher.instances()[b * 3u + round].object == round * KEYS + b;
+		}
+		CWF_CHECK(correct);
+	}
+
+	void testClearKeepsAllocations() {
+		std::vector<int> objects(300u);
+		Batcher batcher{};
+		auto frame = [&](uint32_t salt) {
+			for (uint32_t i{ 0u }; i < 5000u; i++)
+				batcher.submit(&objects[(i * 13u + salt) % objects.size()], { i, 1.0f });
+			batcher.plan();
+			batcher.clear();
+		};
+		frame(0u);
+		frame(1u);
+		const size_t before{ s_allocations };
+		frame(2u); // same number of submissions and keys, different order
+		CWF_CHECK(s_allocations == before);
+
+		CWF_CHECK(batcher.submissionCount() == 0u);
+		CWF_CHECK(batcher.plan().empty());
+		CWF_CHECK(batcher.instances().empty());
+		batcher.submit(&objects[0], { 7u, 2.0f }); // a cleared batcher starts over
+		CWF_CHECK(batcher.plan().size() == 1u && batcher.instances()[0].object == 7u);
+	}
+
+	void testIntegerKeys() {
+		// identity hashes with a common stride must still spread over the table
+		InstanceBatcher<uint64_t, uint32_t> batcher{};
+		for (uint32_t i{ 0u }; i < 4096u; i++) batcher.submit(static_cast<uint64_t>(i % 512u) << 20u, i);
+		const auto& batches{ batcher.plan() };
+		CWF_CHECK(batches.size() == 512u);
+		CWF_CHECK(batches[5].key == uint64_t{ 5u } << 20u && batches[5].count == 8u);
+		CWF_CHECK(batcher.instances()[batches[5].first + 1u] == 512u + 5u);
+	}
+}
+
+int main() {
+	testGrouping();
+	testManyKeys();
+	testClearKeepsAllocations();
+	testIntegerKeys();
+	return cwf::failures();
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "Check.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace {
+	struct Vertex {
+		struct {
+			float x, y, z;
+		} pos;
+		uint32_t id; // the vertex's index before any reordering
+	};
+
+	struct Mesh {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// an n x n grid of quads on a gently curved sheet, two triangles each, in a shuffled order
+	Mesh grid(uint32_t n, uint32_t seed) {
+		Mesh mesh{};
+		for (uint32_t y{ 0u }; y <= n; y++) {
+			for (uint32_t x{ 0u }; x <= n; x++) {
+				const float fx{ static_cast<float>(x) };
+				const float fy{ static_cast<float>(y) };
+				mesh.vertices.push_back({ { fx, fy, (fx * fx + fy * fy) * 0.01f }, y * (n + 1u) + x });
+			}
+		}
+		std::vector<std::array<uint32_t, 3>> triangles{};
+		for (uint32_t y{ 0u }; y < n; y++) {
+			for (uint32_t x{ 0u }; x < n; x++) {
+				const uint32_t v{ y * (n + 1u) + x };
+				triangles.push_back({ v, v + n + 1u, v + 1u });
+				triangles.push_back({ v + 1u, v + n + 1u, v + n + 2u });
+			}
+		}
+		std::mt19937 rng{ seed };
+		std::shuffle(triangles.begin(), triangles.end(), rng);
+		for (const auto& t : triangles) mesh.indices.insert(mesh.indices.end(), t.cbegin(), t.cend());
+		return mesh;
+	}
+
+	// triangles over random vertices, with no structure for the optimizer to find
+	Mesh random(uint32_t vertexCount, size_t triangles, uint32_t seed) {
+		Mesh mesh{};
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> coordinate{ -1.0f, 1.0f };
+		for (uint32_t v{ 0u }; v < vertexCount; v++)
+			mesh.vertices.push_back({ { coordinate(rng), coordinate(rng), coordinate(rng) }, v });
+		std::uniform_int_distribution<uint32_t> vertex{ 0u, vertexCount - 1u };
+		for (size_t i{ 0u }; i < triangles * 3u; i++) mesh.indices.push_back(vertex(rng));
+		return mesh;
+	}
+
+	// each triangle as the original ids of its corners, in drawing order, sorted; renumbering vertices doesn't change it
+	std::vector<std::array<uint32_t, 3>> triangleSet(const Mesh& mesh) {
+		std::vector<std::array<uint32_t, 3>> triangles{};
+		for (size_t i{ 0u }; i + 2u < mesh.indices.size(); i += 3u) {
+			triangles.push_back({ mesh.vertices[mesh.indices[i]].id, mesh.vertices[mesh.indices[i + 1u]].id,
+				mesh.vertices[mesh.indices[i + 2u]].id });
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	bool isVertexPermutation(const Mesh& mesh) {
+		std::vector<uint32_t> ids{};
+		for (const Vertex& v : mesh.vertices) ids.push_back(v.id);
+		std::sort(ids.begin(), ids.end());
+		for (uint32_t i{ 0u }; i < ids.size(); i++) {
+			if (ids[i] != i) return false;
+		}
+		return true;
+	}
+
+	MeshOptimizer::Report optimize(Mesh& mesh, unsigned stages) {
+		return MeshOptimizer::optimize<Vertex, uint32_t>(mesh.indices, mesh.vertices, stages);
+	}
+
+	// whatever the stages, the same triangles (corners and winding) come out, and ACMR is never worse
+	void testPermutation() {
+		const std::vector<Mesh> meshes{ grid(40u, 1u), grid(7u, 2u), random(500u, 3000u, 3u), random(20u, 400u, 4u) };
+		constexpr unsigned STAGES[]{ MeshOptimizer::VERTEX_CACHE, MeshOptimizer::VERTEX_CACHE | MeshOptimizer::OVERDRAW,
+			MeshOptimizer::VERTEX_FETCH, MeshOptimizer::ALL };
+		for (const unsigned stages : STAGES) {
+			for (const Mesh& original : meshes) {
+				Mesh mesh{ original };
+				const MeshOptimizer::Report report{ optimize(mesh, stages) };
+				CWF_CHECK(report.triangles == original.indices.size() / 3u);
+				CWF_CHECK(mesh.indices.size() == original.indices.size());
+				CWF_CHECK(isVertexPermutation(mesh));
+				CWF_CHECK(triangleSet(mesh) == triangleSet(original));
+				CWF_CHECK(report.after.acmr <= report.before.acmr);
+
+				// the report measures what was handed in and what came out
+				const MeshOptimizer::CacheStats before{
+					MeshOptimizer::analyzeVertexCache<uint32_t>(original.indices, original.vertices.size()) };
+				const MeshOptimizer::CacheStats after{
+					MeshOptimizer::analyzeVertexCache<uint32_t>(mesh.indices, mesh.vertices.size()) };
+				CWF_CHECK(report.before.acmr == before.acmr && report.before.atvr == before.atvr);
+				CWF_CHECK(report.after.acmr == after.acmr && report.after.atvr == after.atvr);
+			}
+		}
+	}
+
+	// a shuffled grid is close to the worst case; cache ordering should bring it near the 0.5 a grid can reach
+	void testGridImproves() {
+		Mesh mesh{ grid(64u, 5u) };
+		const MeshOptimizer::Report report{ optimize(mesh, MeshOptimizer::ALL) };
+		CWF_CHECK(report.before.acmr > 2.0f);
+		CWF_CHECK(report.after.acmr < 1.0f);
+		CWF_CHECK(report.after.atvr < 2.0f);
+	}
+
+	void testVertexFetchOrder() {
+		Mesh mesh{ random(300u, 200u, 6u) }; // some vertices unused
+		optimize(mesh, MeshOptimizer::VERTEX_FETCH);
+		uint32_t next{ 0u };
+		for (const uint32_t i : mesh.indices) {
+			CWF_CHECK(i <= next);
+			if (i == next) next++;
+		}
+		// the unused vertices follow, in their old order
+		for (size_t v{ next + 1u }; v < mesh.vertices.size(); v++)
+			CWF_CHECK(mesh.vertices[v - 1u].id < mesh.vertices[v].id);
+	}
+
+	void testDegenerate() {
+		// repeated corners, a zero-area sliver and a whole triangle on one vertex
+		Mesh mesh{};
+		for (uint32_t v{ 0u }; v < 4u; v++) mesh.vertices.push_back({ { static_cast<float>(v), 0.0f, 0.0f }, v });
+		mesh.indices = { 0u, 0u, 1u, 0u, 1u, 2u, 3u, 3u, 3u, 1u, 2u, 3u, 2u, 2u, 0u };
+		const Mesh original{ mesh };
+		optimize(mesh, MeshOptimizer::ALL);
+		CWF_CHECK(triangleSet(mesh) == triangleSet(original));
+		CWF_CHECK(isVertexPermutation(mesh));
+
+		// every position the same, so every normal and area is zero
+		Mesh flat{ grid(6u, 7u) };
+		for (Vertex& v : flat.vertices) v.pos = { 1.0f, 1.0f, 1.0f };
+		const Mesh flatOriginal{ flat };
+		optimize(flat, MeshOptimizer::ALL);
+		CWF_CHECK(triangleSet(flat) == triangleSet(flatOriginal));
+
+		// one triangle: nothing to reorder
+		Mesh one{};
+		for (uint32_t v{ 0u }; v < 3u; v++) one.vertices.push_back({ { 0.0f, static_cast<float>(v), 0.0f }, v });
+		one.indices = { 2u, 0u, 1u };
+		const MeshOptimizer::Report report{ optimize(one, MeshOptimizer::VERTEX_CACHE | MeshOptimizer::OVERDRAW) };
+		CWF_CHECK((one.indices == std::vector<uint32_t>{ 2u, 0u, 1u }));
+		CWF_CHECK(report.triangles == 1u && report.before.acmr == 3.0f && report.after.acmr == 3.0f);
+	}
+
+	void testEmpty() {
+		Mesh empty{};
+		const MeshOptimizer::Report report{ optimize(empty, MeshOptimizer::ALL) };
+		CWF_CHECK(report.triangles == 0u);
+		CWF_CHECK(report.before.acmr == 0.0f && report.after.acmr == 0.0f && report.after.atvr == 0.0f);
+		CWF_CHECK(empty.indices.empty() && empty.vertices.empty());
+
+		// vertices but no triangles: nothing moves
+		Mesh noTriangles{ random(10u, 0u, 8u) };
+		optimize(noTriangles, MeshOptimizer::ALL);
+		for (uint32_t v{ 0u }; v < noTriangles.vertices.size(); v++) CWF_CHECK(noTriangles.vertices[v].id == v);
+
+		const MeshOptimizer::CacheStats none{ MeshOptimizer::analyzeVertexCache<uint16_t>(std::span<const uint16_t>{}, 0u) };
+		CWF_CHECK(none.acmr == 0.0f && none.atvr == 0.0f);
+	}
+}
+
+int main() {
+	testPermutation();
+	testGridImproves();
+	testVertexFetchOrder();
+	testDegenerate();
+	testEmpty();
+	return cwf::failures();
+}
\ No newline at end of file
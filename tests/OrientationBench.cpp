@@ -0,0 +1,39 @@
+#include "Bench.h"
+#include "Orientation.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// a frame's camera update: compose one small rotation, then (every frame) build the matrix
+int main() {
+	constexpr size_t UPDATES{ 1000000u };
+	std::mt19937 rng{ 2u };
+	std::uniform_real_distribution<float> angle{ -0.02f, 0.02f };
+	std::vector<float> angles(UPDATES * 3u);
+	for (float& a : angles) a = angle(rng);
+
+	Orientation o{};
+	const double update{ cwf::run([&] {
+		for (size_t i{ 0u }; i < UPDATES; i++) o.update(angles[i * 3u], angles[i * 3u + 1u], angles[i * 3u + 2u]);
+	}) };
+	cwf::keep(o.getQuaternion());
+	cwf::report("Orientation::update", update, UPDATES);
+
+	const double updateGet{ cwf::run([&] {
+		for (size_t i{ 0u }; i < UPDATES; i++) {
+			o.update(angles[i * 3u], angles[i * 3u + 1u], angles[i * 3u + 2u]);
+			cwf::keep(o.get());
+		}
+	}) };
+	cwf::report("Orientation::update + get", updateGet, UPDATES);
+
+	math::XMMATRIX m{ math::XMMatrixIdentity() };
+	const double matrix{ cwf::run([&] {
+		for (size_t i{ 0u }; i < UPDATES; i++)
+			m = math::XMMatrixMultiply(m, math::XMMatrixRotationRollPitchYaw(angles[i * 3u], angles[i * 3u + 1u], angles[i * 3u + 2u]));
+	}) };
+	cwf::keep(m);
+	cwf::report("matrix multiply (drifts)", matrix, UPDATES);
+	return 0;
+}
\ No newline at end of file
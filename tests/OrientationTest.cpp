@@ -0,0 +1,94 @@
+#include "Check.h"
+#include "Orientation.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+	// largest deviation of the rotation part from orthonormal: |row . row| from 1, and row . other row from 0
+	float orthonormalError(const math::XMMATRIX& m) {
+		math::XMFLOAT4X4 f{};
+		math::XMStoreFloat4x4(&f, m);
+		float error{ 0.0f };
+		for (int a{ 0 }; a < 3; a++) {
+			for (int b{ a }; b < 3; b++) {
+				const float dot{ f.m[a][0] * f.m[b][0] + f.m[a][1] * f.m[b][1] + f.m[a][2] * f.m[b][2] };
+				error = std::max(error, std::abs(dot - (a == b ? 1.0f : 0.0f)));
+			}
+		}
+		return error;
+	}
+
+	float maxDifference(const math::XMMATRIX& a, const math::XMMATRIX& b) {
+		math::XMFLOAT4X4 fa{};
+		math::XMFLOAT4X4 fb{};
+		math::XMStoreFloat4x4(&fa, a);
+		math::XMStoreFloat4x4(&fb, b);
+		float difference{ 0.0f };
+		for (int r{ 0 }; r < 4; r++) {
+			for (int c{ 0 }; c < 4; c++) difference = std::max(difference, std::abs(fa.m[r][c] - fb.m[r][c]));
+		}
+		return difference;
+	}
+
+	// a camera's worth of small mouse-driven updates, far more than any session makes
+	void testNoDrift() {
+		constexpr int UPDATES{ 10000000 };
+		std::mt19937 rng{ 17u };
+		std::uniform_real_distribution<float> angle{ -0.02f, 0.02f };
+		Orientation o{};
+		float worst{ 0.0f };
+		for (int i{ 1 }; i <= UPDATES; i++) {
+			o.update(angle(rng), angle(rng), angle(rng));
+			if (i % 100000 == 0) worst = std::max(worst, orthonormalError(o.get()));
+		}
+		CWF_CHECK(worst < 1e-5f);
+		math::XMFLOAT4 q{};
+		math::XMStoreFloat4(&q, o.getQuaternion());
+		CWF_CHECK(std::abs(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w - 1.0f) < 1e-5f);
+
+		// the same updates multiplied into a matrix, the way it was done before, drift off
+		std::mt19937 same{ 17u };
+		math::XMMATRIX m{ math::XMMatrixIdentity() };
+		for (int i{ 0 }; i < UPDATES / 10; i++)
+			m = math::XMMatrixMultiply(m, math::XMMatrixRotationRollPitchYaw(angle(same), angle(same), angle(same)));
+		CWF_CHECK(orthonormalError(m) > worst);
+	}
+
+	void testComposition() {
+		Orientation o{};
+		CWF_CHECK(maxDifference(o.get(), math::XMMatrixIdentity()) < 1e-6f);
+		o.update(0.3f, -0.2f, 0.1f);
+		CWF_CHECK(maxDifference(o.get(), math::XMMatrixRotationRollPitchYaw(0.3f, -0.2f, 0.1f)) < 1e-5f);
+
+		// each update applies after the current rotation, like multiplying on the right
+		o.update(-0.4f, 0.5f, 0.25f);
+		const math::XMMATRIX expected{ math::XMMatrixMultiply(math::XMMatrixRotationRollPitchYaw(0.3f, -0.2f, 0.1f),
+			math::XMMatrixRotationRollPitchYaw(-0.4f, 0.5f, 0.25f)) };
+		CWF_CHECK(maxDifference(o.get(), expected) < 1e-5f);
+
+		const Orientation set{ 0.3f, -0.2f, 0.1f };
+		CWF_CHECK(maxDifference(set.get(), math::XMMatrixRotationRollPitchYaw(0.3f, -0.2f, 0.1f)) < 1e-5f);
+		o.reset();
+		CWF_CHECK(maxDifference(o.get(), math::XMMatrixIdentity()) < 1e-6f);
+	}
+
+	void testRotate() {
+		Orientation o{ 0.7f, 1.1f, -0.4f };
+		math::XMFLOAT3 rotated{};
+		math::XMFLOAT3 transformed{};
+		const math::XMVECTOR v{ math::XMVectorSet(1.0f, -2.0f, 0.5f, 0.0f) };
+		math::XMStoreFloat3(&rotated, o.rotate(v));
+		math::XMStoreFloat3(&transformed, math::XMVector3Transform(v, o.get()));
+		CWF_CHECK(std::abs(rotated.x - transformed.x) < 1e-5f && std::abs(rotated.y - transformed.y) < 1e-5f
+			&& std::abs(rotated.z - transformed.z) < 1e-5f);
+	}
+}
+
+int main() {
+	testNoDrift();
+	testComposition();
+	testRotate();
+	return cwf::failures();
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "Bench.h"
+#include "RawInputDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace {
+	constexpr size_t PACKET{ sizeof(RawInputDecoder::Header) + sizeof(RawInputDecoder::Mouse) }; // a RAWINPUT's size
+	constexpr size_t BUFFER_PACKETS{ 64u }; // Window::RAW_BUFFER_COUNT
+
+	// count mouse packets back to back, as GetRawInputBuffer writes them; every eighth is a button-only packet
+	std::vector<std::byte> packets(size_t count) {
+		std::mt19937 rng{ 3u };
+		std::uniform_int_distribution<int32_t> delta{ -8, 8 };
+		std::vector<std::byte> bytes(count * PACKET);
+		for (size_t i{ 0u }; i < count; i++) {
+			const RawInputDecoder::Header header{ RawInputDecoder::TYPE_MOUSE, uint32_t{ PACKET }, nullptr, 0u };
+			const bool buttons{ i % 8u == 7u };
+			const RawInputDecoder::Mouse mouse{ 0u, 0u, buttons ? uint16_t{ 1u } : uint16_t{ 0u }, 0u, 0u,
+				buttons ? 0 : delta(rng), buttons ? 0 : delta(rng), 0u };
+			std::memcpy(bytes.data() + i * PACKET, &header, sizeof(header));
+			std::memcpy(bytes.data() + i * PACKET + sizeof(header), &mouse, sizeof(mouse));
+		}
+		return bytes;
+	}
+}
+
+// a fast mouse (8 kHz) sends a few packets per frame and a busy frame can see a full buffer; ns/item is per packet
+int main() {
+	constexpr size_t COUNT{ 1u << 20 };
+	const std::vector<std::byte> bytes{ packets(COUNT) };
+	RawInputDecoder decoder{};
+	long total{ 0 };
+
+	// one GetRawInputData-sized packet per call, as WM_INPUT delivers them
+	cwf::report("decode, one packet per call", cwf::run([&] {
+		for (size_t i{ 0u }; i < COUNT; i++) decoder.decode(bytes.data() + i * PACKET, PACKET);
+		if (const std::optional<RawInputDecoder::Delta> delta{ decoder.take() }) total += delta->x;
+	}), COUNT);
+
+	// what Window::readRawInput does per GetRawInputBuffer call: measure the filled bytes, then walk them
+	char name[64]{};
+	for (const size_t perBuffer : { size_t{ 4u }, BUFFER_PACKETS }) {
+		std::snprintf(name, sizeof(name), "filledBytes + decodeBuffer, %zu per buffer", perBuffer);
+		cwf::report(name, cwf::run([&] {
+			for (size_t i{ 0u }; i < COUNT; i += perBuffer) {
+				const std::byte* buffer{ bytes.data() + i * PACKET };
+				const size_t filled{ RawInputDecoder::filledBytes(buffer, BUFFER_PACKETS * PACKET, perBuffer) };
+				decoder.decodeBuffer(buffer, filled, perBuffer);
+				if (const std::optional<RawInputDecoder::Delta> delta{ decoder.take() }) total += delta->y;
+			}
+		}), COUNT);
+	}
+	cwf::keep(total);
+	std::printf("%llu packets decoded\n", static_cast<unsigned long long>(decoder.getPacketCount()));
+	return 0;
+}
\ No newline at end of file
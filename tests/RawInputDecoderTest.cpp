@@ -0,0 +1,217 @@
+#include "Check.h"
+#include "RawInputDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <vector>
+
+namespace {
+	using Layout = RawInputDecoder::Layout;
+
+	constexpr uint32_t TYPE_KEYBOARD{ 1u }; // RIM_TYPEKEYBOARD
+	constexpr uint32_t TYPE_HID{ 2u }; // RIM_TYPEHID
+	constexpr uint16_t KEY_BREAK{ 0x01u }; // RI_KEY_BREAK; 0 is a make
+	constexpr Layout X86{ 16u, 4u }; // a 32-bit process on 32-bit Windows; NATIVE is this on an x86 build
+
+	struct Keyboard { // RAWKEYBOARD
+		uint16_t makeCode;
+		uint16_t flags;
+		uint16_t reserved;
+		uint16_t vKey;
+		uint32_t message;
+		uint32_t extraInformation;
+	};
+
+	// packets laid out as GetRawInputBuffer would write them for layout: header, body, padding to the next one
+	class Packets {
+	private:
+		Layout m_layout;
+		std::vector<std::byte> m_bytes;
+		size_t m_count;
+		size_t m_end; // of the last packet, before its padding
+	public:
+		explicit Packets(Layout layout) : m_layout{ layout }, m_bytes{}, m_count{ 0u }, m_end{ 0u } {}
+
+		Packets& add(uint32_t type, const void* pBody, size_t bodySize) {
+			const size_t start{ m_bytes.size() };
+			const uint32_t size{ static_cast<uint32_t>(m_layout.headerSize + bodySize) };
+			m_bytes.resize(start + size, std::byte{ 0xccu }); // the handle and wParam are never read
+			std::memcpy(m_bytes.data() + start + offsetof(RawInputDecoder::Header, type), &type, sizeof(type));
+			std::memcpy(m_bytes.data() + start + offsetof(RawInputDecoder::Header, size), &size, sizeof(size));
+			std::memcpy(m_bytes.data() + start + m_layout.headerSize, pBody, bodySize);
+			m_end = start + size;
+			m_bytes.resize((m_end + m_layout.alignment - 1u) & ~(m_layout.alignment - 1u), std::byte{ 0xddu });
+			m_count++;
+			return *this;
+		}
+
+		Packets& mouse(int32_t x, int32_t y, uint16_t flags = 0u, uint16_t buttonFlags = 0u) {
+			const RawInputDecoder::Mouse body{ flags, 0u, buttonFlags, 0u, 0u, x, y, 0u };
+			return add(RawInputDecoder::TYPE_MOUSE, &body, sizeof(body));
+		}
+
+		Packets& key(uint16_t vKey, bool down) {
+			const Keyboard body{ 0x11u, down ? uint16_t{ 0u } : KEY_BREAK, 0u, vKey, down ? 0x100u : 0x101u, 0u };
+			return add(TYPE_KEYBOARD, &body, sizeof(body));
+		}
+
+		// e.g. a gamepad report; odd sizes are what make the alignment matter
+		Packets& hid(size_t bytes) {
+			const std::vector<std::byte> body(bytes, std::byte{ 0x7fu });
+			return add(TYPE_HID, body.data(), body.size());
+		}
+
+		std::vector<std::byte>& bytes() noexcept { return m_bytes; }
+		size_t count() const noexcept { return m_count; }
+		size_t end() const noexcept { return m_end; }
+		Layout layout() const noexcept { return m_layout; }
+	};
+
+	size_t decode(RawInputDecoder& decoder, Packets& packets) {
+		return decoder.decodeBuffer(packets.bytes().data(), packets.bytes().size(), packets.count(), packets.layout());
+	}
+
+	bool is(const std::optional<RawInputDecoder::Delta>& delta, long x, long y) {
+		return delta && delta->x == x && delta->y == y;
+	}
+
+	// one packet at a time, as GetRawInputData writes them
+	void testSinglePackets() {
+		RawInputDecoder decoder{};
+		CWF_CHECK(!decoder.take());
+		Packets packets{ RawInputDecoder::NATIVE };
+		packets.mouse(3, -2);
+		decoder.decode(packets.bytes().data(), packets.end());
+		packets = Packets{ RawInputDecoder::NATIVE }.mouse(1, 1);
+		decoder.decode(packets.bytes().data(), packets.end());
+		CWF_CHECK(is(decoder.take(), 4, -1));
+		CWF_CHECK(!decoder.take()); // taken
+		CWF_CHECK(decoder.getPacketCount() == 2u);
+
+		// absolute positions aren't motion, nor is a packet that only carries buttons or the wheel
+		packets = Packets{ RawInputDecoder::NATIVE }.mouse(30000, 40000, RawInputDecoder::MOVE_ABSOLUTE);
+		decoder.decode(packets.bytes().data(), packets.end());
+		packets = Packets{ RawInputDecoder::NATIVE }.mouse(0, 0, 0u, 0x0001u); // RI_MOUSE_LEFT_BUTTON_DOWN
+		decoder.decode(packets.bytes().data(), packets.end());
+		CWF_CHECK(!decoder.take());
+		CWF_CHECK(decoder.getPacketCount() == 4u);
+
+		// motion that cancels out still happened
+		packets = Packets{ RawInputDecoder::NATIVE }.mouse(5, 0).mouse(-5, 0);
+		decoder.decodeBuffer(packets.bytes().data(), packets.bytes().size(), 2u);
+		CWF_CHECK(is(decoder.take(), 0, 0));
+
+		// keyboard make and break: counted, never motion
+		packets = Packets{ RawInputDecoder::NATIVE }.key('W', true);
+		decoder.decode(packets.bytes().data(), packets.end());
+		packets = Packets{ RawInputDecoder::NATIVE }.key('W', false);
+		decoder.decode(packets.bytes().data(), packets.end());
+		CWF_CHECK(!decoder.take());
+		CWF_CHECK(decoder.getPacketCount() == 8u);
+	}
+
+	// a mixed buffer walks the same in every layout; on a 64-bit build NATIVE and WOW64 are the same numbers, so X86
+	// stands in for the 32-bit header to make sure the walk follows the layout it is given rather than its own
+	void testBufferLayouts() {
+		for (const Layout layout : { RawInputDecoder::NATIVE, RawInputDecoder::WOW64, X86 }) {
+			RawInputDecoder decoder{};
+			Packets packets{ layout };
+			packets.key('A', true).mouse(2, 3).hid(13u).mouse(100, 100, RawInputDecoder::MOVE_ABSOLUTE).key('A', false)
+				.mouse(0, 0, 0u, 0x0400u).hid(2u).mouse(-7, 1).key(0x10u, true).mouse(1, 1);
+			CWF_CHECK(decode(decoder, packets) == packets.count());
+			CWF_CHECK(decoder.getPacketCount() == packets.count());
+			CWF_CHECK(is(decoder.take(), -4, 5));
+			const std::vector<std::byte>& bytes{ packets.bytes() };
+			const size_t filled{ RawInputDecoder::filledBytes(bytes.data(), bytes.size(), packets.count(), layout) };
+			CWF_CHECK(filled == packets.end());
+		}
+
+		// the layouts really do differ: a buffer written for one, walked as another, gives different packets
+		Packets packets{ X86 };
+		packets.mouse(2, 3).hid(1u).mouse(4, 5);
+		RawInputDecoder decoder{};
+		decode(decoder, packets);
+		CWF_CHECK(is(decoder.take(), 6, 8));
+		decoder.decodeBuffer(packets.bytes().data(), packets.bytes().size(), packets.count(), RawInputDecoder::WOW64);
+		CWF_CHECK(!is(decoder.take(), 6, 8));
+	}
+
+	// whole packets before a tear are decoded; nothing at or after it is
+	void testTornBuffers() {
+		for (const Layout layout : { RawInputDecoder::NATIVE, X86 }) {
+			Packets packets{ layout };
+			packets.mouse(1, 0).mouse(2, 0).mouse(4, 0);
+			const std::vector<std::byte> whole{ packets.bytes() };
+			const size_t packet{ layout.headerSize + sizeof(RawInputDecoder::Mouse) };
+			const size_t second{ (packet + layout.alignment - 1u) & ~(layout.alignment - 1u) }; // where it starts
+
+			// cut inside the last packet, inside its header, inside the second and right after the first
+			for (const size_t cut : { packets.end() - 1u, 2u * second + 6u, second + packet - 1u, second }) {
+				RawInputDecoder decoder{};
+				const size_t expected{ cut >= second + packet ? 2u : 1u };
+				CWF_CHECK(decoder.decodeBuffer(whole.data(), cut, packets.count(), layout) == expected);
+				CWF_CHECK(is(decoder.take(), expected == 2u ? 3 : 1, 0));
+				CWF_CHECK(RawInputDecoder::filledBytes(whole.data(), cut, packets.count(), layout)
+					== (expected == 2u ? second + packet : packet));
+			}
+
+			// a size smaller than a header, or running past the buffer, stops the walk even with bytes to spare
+			for (const uint32_t size : { 0u, static_cast<uint32_t>(layout.headerSize - 1u), 100000u }) {
+				std::vector<std::byte> bytes{ whole };
+				std::memcpy(bytes.data() + second + offsetof(RawInputDecoder::Header, size), &size, sizeof(size));
+				RawInputDecoder decoder{};
+				CWF_CHECK(decoder.decodeBuffer(bytes.data(), bytes.size(), packets.count(), layout) == 1u);
+				CWF_CHECK(is(decoder.take(), 1, 0));
+				CWF_CHECK(RawInputDecoder::filledBytes(bytes.data(), bytes.size(), packets.count(), layout) == packet);
+			}
+
+			// a packet too short for a RAWMOUSE is counted but not read; the walk then lands in its old body, whose
+			// zeroes read as a size no packet can have
+			std::vector<std::byte> bytes{ whole };
+			const uint32_t shortSize{ static_cast<uint32_t>(layout.headerSize + 4u) };
+			std::memcpy(bytes.data() + second + offsetof(RawInputDecoder::Header, size), &shortSize, sizeof(shortSize));
+			RawInputDecoder decoder{};
+			CWF_CHECK(decoder.decodeBuffer(bytes.data(), bytes.size(), packets.count(), layout) == 2u);
+			CWF_CHECK(is(decoder.take(), 1, 0));
+
+			// fewer packets than the buffer holds: only count of them
+			decoder.decodeBuffer(whole.data(), whole.size(), 2u, layout);
+			CWF_CHECK(is(decoder.take(), 3, 0));
+			CWF_CHECK(RawInputDecoder::filledBytes(whole.data(), whole.size(), 0u, layout) == 0u);
+		}
+
+		// nothing, or less than a header
+		RawInputDecoder decoder{};
+		const std::byte empty[4]{};
+		CWF_CHECK(decoder.decodeBuffer(empty, 0u, 5u) == 0u);
+		CWF_CHECK(decoder.decodeBuffer(empty, sizeof(empty), 5u) == 0u);
+		decoder.decode(empty, sizeof(empty));
+		CWF_CHECK(decoder.getPacketCount() == 0u && !decoder.take());
+	}
+
+	// what GetRawInputBuffer leaves behind the packets it wrote (an earlier, longer read) is not decoded
+	void testStaleTail() {
+		Packets packets{ RawInputDecoder::NATIVE };
+		packets.mouse(1, 2).key('Q', true);
+		const size_t filled{ packets.end() };
+		Packets stale{ RawInputDecoder::NATIVE };
+		stale.mouse(1, 2).key('Q', true).mouse(50, 50).mouse(60, 60);
+		std::vector<std::byte>& bytes{ stale.bytes() };
+		std::memcpy(bytes.data(), packets.bytes().data(), filled);
+
+		CWF_CHECK(RawInputDecoder::filledBytes(bytes.data(), bytes.size(), packets.count()) == filled);
+		RawInputDecoder decoder{};
+		CWF_CHECK(decoder.decodeBuffer(bytes.data(), filled, stale.count()) == packets.count());
+		CWF_CHECK(is(decoder.take(), 1, 2));
+	}
+}
+
+int main() {
+	testSinglePackets();
+	testBufferLayouts();
+	testTornBuffers();
+	testStaleTail();
+	return cwf::failures();
+}
\ No newline at end of file
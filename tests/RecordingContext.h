@@ -0,0 +1,81 @@
+#ifndef CWF_TESTS_RECORDINGCONTEXT_H
+#define CWF_TESTS_RECORDINGCONTEXT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+* Stands in for an ID3D11DeviceContext1 under BasicStateCache: every binding call the cache lets through is written to
+* calls() as one line (name, then the arguments that identify the state), so a test can check exactly what reached the
+* context. Resources are opaque pointers; any distinct addresses do.
+*/
+
+struct Buffer {};
+struct InputLayout {};
+struct VertexShader {};
+struct PixelShader {};
+struct ShaderResourceView {};
+struct SamplerState {};
+struct RenderTargetView {};
+struct DepthStencilView {};
+
+enum Topology { TRIANGLELIST = 4, LINELIST = 2 };
+enum Format { R16_UINT = 57, R32_UINT = 42 };
+
+struct ViewportDesc {
+	float TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth;
+};
+
+class RecordingContext {
+private:
+	std::vector<std::string> m_calls;
+public:
+	const std::vector<std::string>& calls() const noexcept { return m_calls; }
+	void clear() noexcept { m_calls.clear(); }
+
+	// the line a call with these arguments is recorded as
+	template <typename... Args>
+	static std::string line(const char* name, Args... args) {
+		std::string out{ name };
+		((out += ' ', out += text(args)), ...);
+		return out;
+	}
+
+	void IASetPrimitiveTopology(Topology topology) { log("IASetPrimitiveTopology", topology); }
+	void IASetInputLayout(InputLayout* pLayout) { log("IASetInputLayout", pLayout); }
+	void IASetVertexBuffers(unsigned slot, unsigned count, Buffer* const* ppBuffers, const unsigned* pStrides, const unsigned* pOffsets) {
+		log("IASetVertexBuffers", slot, count, ppBuffers[0], pStrides[0], pOffsets[0]);
+	}
+	void IASetIndexBuffer(Buffer* pBuffer, Format format, unsigned offset) { log("IASetIndexBuffer", pBuffer, format, offset); }
+	void VSSetShader(VertexShader* pShader, const void*, unsigned) { log("VSSetShader", pShader); }
+	void PSSetShader(PixelShader* pShader, const void*, unsigned) { log("PSSetShader", pShader); }
+	void VSSetConstantBuffers(unsigned slot, unsigned count, Buffer* const* ppBuffers) { log("VSSetConstantBuffers", slot, count, ppBuffers[0]); }
+	void PSSetConstantBuffers(unsigned slot, unsigned count, Buffer* const* ppBuffers) { log("PSSetConstantBuffers", slot, count, ppBuffers[0]); }
+	void VSSetConstantBuffers1(unsigned slot, unsigned count, Buffer* const* ppBuffers, const unsigned* pFirst, const unsigned* pNum) {
+		log("VSSetConstantBuffers1", slot, count, ppBuffers[0], pFirst[0], pNum[0]);
+	}
+	void PSSetConstantBuffers1(unsigned slot, unsigned count, Buffer* const* ppBuffers, const unsigned* pFirst, const unsigned* pNum) {
+		log("PSSetConstantBuffers1", slot, count, ppBuffers[0], pFirst[0], pNum[0]);
+	}
+	void VSSetShaderResources(unsigned slot, unsigned count, ShaderResourceView* const* ppViews) { log("VSSetShaderResources", slot, count, ppViews[0]); }
+	void PSSetShaderResources(unsigned slot, unsigned count, ShaderResourceView* const* ppViews) { log("PSSetShaderResources", slot, count, ppViews[0]); }
+	void VSSetSamplers(unsigned slot, unsigned count, SamplerState* const* ppSamplers) { log("VSSetSamplers", slot, count, ppSamplers[0]); }
+	void PSSetSamplers(unsigned slot, unsigned count, SamplerState* const* ppSamplers) { log("PSSetSamplers", slot, count, ppSamplers[0]); }
+	void OMSetRenderTargets(unsigned count, RenderTargetView* const* ppTargets, DepthStencilView* pDepthStencil) {
+		log("OMSetRenderTargets", count, ppTargets[0], pDepthStencil);
+	}
+	void RSSetViewports(unsigned count, const ViewportDesc* pViewports) { log("RSSetViewports", count, pViewports[0].Width, pViewports[0].Height); }
+private:
+	static std::string text(const void* p) { return std::to_string(reinterpret_cast<uintptr_t>(p)); }
+	static std::string text(float f) { return std::to_string(f); }
+	static std::string text(unsigned i) { return std::to_string(i); }
+	static std::string text(int i) { return std::to_string(i); }
+
+	template <typename... Args>
+	void log(const char* name, Args... args) {
+		m_calls.push_back(line(name, args...));
+	}
+};
+
+#endif
\ No newline at end of file
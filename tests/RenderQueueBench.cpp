@@ -0,0 +1,70 @@
+#include "Bench.h"
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+class Graphics {};
+class ConstantBufferRing {};
+
+namespace {
+	size_t s_drawn{ 0u };
+
+	void count(const void*, const Graphics&, const ConstantBufferRing&, unsigned skip) {
+		s_drawn += skip;
+	}
+}
+
+// a frame of 100k submissions spread over 64 shaders, 512 textures and random depths
+int main() {
+	constexpr size_t SUBMISSIONS{ 100000u };
+	std::mt19937 rng{ 3u };
+	std::uniform_real_distribution<float> depth{ 0.0f, 1.0f };
+	std::vector<uint64_t> keys(SUBMISSIONS);
+	std::vector<uint64_t> textures(SUBMISSIONS);
+	for (size_t i{ 0u }; i < SUBMISSIONS; i++) {
+		const uint16_t shader{ static_cast<uint16_t>(rng() % 64u) };
+		const uint16_t texture{ static_cast<uint16_t>(rng() % 512u) };
+		keys[i] = RenderQueue::SortKey::make(static_cast<uint8_t>(rng() % 2u), shader, texture, depth(rng));
+		textures[i] = texture + 1u;
+	}
+
+	RenderQueue queue{};
+	const Graphics gfx{};
+	const ConstantBufferRing ring{};
+	const double submit{ cwf::run([&] {
+		queue.clear();
+		for (size_t i{ 0u }; i < SUBMISSIONS; i++)
+			queue.submit(keys[i], nullptr, count, RenderQueue::SortKey::shader(keys[i]) + 1u, textures[i]);
+	}) };
+	cwf::report("submit", submit, SUBMISSIONS);
+
+	const std::vector<RenderQueue::Entry> unsorted{ queue.entries() };
+	std::vector<RenderQueue::Entry> entries{};
+	std::vector<RenderQueue::Entry> scratch{};
+	const double radix{ cwf::run([&] {
+		entries = unsorted;
+		RenderQueue::radixSort(entries, scratch);
+	}) };
+	cwf::keep(entries.front());
+	cwf::report("radixSort", radix, SUBMISSIONS);
+
+	const double comparison{ cwf::run([&] {
+		entries = unsorted;
+		std::sort(entries.begin(), entries.end(), [](const RenderQueue::Entry& a, const RenderQueue::Entry& b) { return a.key < b.key; });
+	}) };
+	cwf::keep(entries.front());
+	cwf::report("std::sort", comparison, SUBMISSIONS);
+
+	const double frame{ cwf::run([&] {
+		queue.clear();
+		for (size_t i{ 0u }; i < SUBMISSIONS; i++)
+			queue.submit(keys[i], nullptr, count, RenderQueue::SortKey::shader(keys[i]) + 1u, textures[i]);
+		queue.execute(gfx, ring);
+	}) };
+	cwf::keep(s_drawn);
+	cwf::report("submit + sort + execute (no-op draws)", frame, SUBMISSIONS);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "Check.h"
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// RenderQueue only passes these through to the draw functions, so stand-ins do for the test
+class Graphics {};
+class ConstantBufferRing {};
+
+namespace {
+	using Entry = RenderQueue::Entry;
+	using SortKey = RenderQueue::SortKey;
+
+	bool sameOrder(const std::vector<Entry>& a, const std::vector<Entry>& b) {
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Entry& x, const Entry& y) {
+			return x.key == y.key && x.submission == y.submission;
+		});
+	}
+
+	// the radix sort must match a stable comparison sort, equal keys staying in submission order
+	void testRadixSort() {
+		std::mt19937_64 rng{ 11u };
+		std::vector<Entry> scratch{};
+		for (const size_t n : { 0u, 1u, 2u, 3u, 255u, 256u, 1000u, 100000u }) {
+			for (const uint64_t mask : { ~0ull, 0xFFull, 0xFF00FF0000000000ull, 0x0000000000F0000Full }) {
+				std::vector<Entry> entries(n);
+				for (size_t i{ 0u }; i < n; i++) entries[i] = { rng() & mask, static_cast<uint32_t>(i) };
+				std::vector<Entry> expected{ entries };
+				std::stable_sort(expected.begin(), expected.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+				RenderQueue::radixSort(entries, scratch);
+				CWF_CHECK(sameOrder(entries, expected));
+			}
+		}
+
+		std::vector<Entry> sorted(1000u);
+		for (size_t i{ 0u }; i < sorted.size(); i++) sorted[i] = { i * 0x0101010101ull, static_cast<uint32_t>(i) };
+		std::vector<Entry> expected{ sorted };
+		RenderQueue::radixSort(sorted, scratch);
+		CWF_CHECK(sameOrder(sorted, expected));
+		std::reverse(sorted.begin(), sorted.end());
+		RenderQueue::radixSort(sorted, scratch);
+		CWF_CHECK(sameOrder(sorted, expected));
+	}
+
+	void testSortKey() {
+		const uint64_t key{ SortKey::make(3u, 0xBEEFu, 0x1234u, 0.5f) };
+		CWF_CHECK(SortKey::layer(key) == 3u);
+		CWF_CHECK(SortKey::shader(key) == 0xBEEFu);
+		CWF_CHECK(SortKey::texture(key) == 0x1234u);
+		CWF_CHECK(SortKey::depth(key) == SortKey::quantizeDepth(0.5f));
+
+		CWF_CHECK(SortKey::quantizeDepth(-1.0f) == 0u);
+		CWF_CHECK(SortKey::quantizeDepth(std::nanf("")) == 0u);
+		CWF_CHECK(SortKey::quantizeDepth(1.0f) == SortKey::MAX_DEPTH);
+		CWF_CHECK(SortKey::quantizeDepth(7.0f) == SortKey::MAX_DEPTH);
+		bool monotonic{ true };
+		for (int i{ 1 }; i <= 1000; i++)
+			monotonic = monotonic && SortKey::quantizeDepth((i - 1) / 1000.0f) <= SortKey::quantizeDepth(i / 1000.0f);
+		CWF_CHECK(monotonic);
+
+		// fields order most significant first: layer beats shader beats texture beats depth
+		CWF_CHECK(SortKey::make(1u, 0u, 0u, 0.0f) > SortKey::make(0u, 0xFFFFu, 0xFFFFu, 1.0f));
+		CWF_CHECK(SortKey::make(0u, 1u, 0u, 0.0f) > SortKey::make(0u, 0u, 0xFFFFu, 1.0f));
+		CWF_CHECK(SortKey::make(0u, 0u, 1u, 0.0f) > SortKey::make(0u, 0u, 0u, 1.0f));
+		CWF_CHECK(SortKey::make(0u, 0u, 0u, 0.25f) < SortKey::make(0u, 0u, 0u, 0.75f));
+	}
+
+	struct Draw {
+		int object;
+		unsigned skip;
+	};
+
+	std::vector<Draw> s_draws{};
+
+	void record(const void* pObject, const Graphics&, const ConstantBufferRing&, unsigned skip) {
+		s_draws.push_back({ *static_cast<const int*>(pObject), skip });
+	}
+
+	void testExecute() {
+		RenderQueue queue{};
+		const int objects[5]{ 0, 1, 2, 3, 4 };
+		CWF_CHECK(queue.idFor(uint64_t{ 100u }) == 0u && queue.idFor(uint64_t{ 200u }) == 1u && queue.idFor(uint64_t{ 100u }) == 0u);
+
+		// pipeline 1 / texture 10 twice, at different depths, then pipeline 2; unknown state (0) never skips
+		queue.submit(SortKey::make(0u, 1u, 0u, 0.9f), &objects[0], record, 1u, 10u);
+		queue.submit(SortKey::make(0u, 2u, 0u, 0.1f), &objects[1], record, 2u, 10u);
+		queue.submit(SortKey::make(0u, 1u, 0u, 0.2f), &objects[2], record, 1u, 10u);
+		queue.submit(SortKey::make(1u, 0u, 0u, 0.0f), &objects[3], record, 0u, 0u);
+		queue.submit(SortKey::make(1u, 0u, 0u, 0.5f), &objects[4], record, 0u, 0u);
+		CWF_CHECK(queue.size() == 5u);
+
+		const Graphics gfx{};
+		const ConstantBufferRing ring{};
+		queue.execute(gfx, ring);
+		CWF_CHECK(s_draws.size() == 5u);
+		if (s_draws.size() == 5u) {
+			CWF_CHECK(s_draws[0].object == 2 && s_draws[0].skip == RenderQueue::SKIP_NONE);
+			CWF_CHECK(s_draws[1].object == 0 && s_draws[1].skip == (RenderQueue::SKIP_PIPELINE | RenderQueue::SKIP_TEXTURE));
+			CWF_CHECK(s_draws[2].object == 1 && s_draws[2].skip == RenderQueue::SKIP_TEXTURE);
+			CWF_CHECK(s_draws[3].object == 3 && s_draws[3].skip == RenderQueue::SKIP_NONE);
+			CWF_CHECK(s_draws[4].object == 4 && s_draws[4].skip == RenderQueue::SKIP_NONE);
+		}
+		const RenderQueue::Stats stats{ queue.getStats() };
+		CWF_CHECK(stats.submissions == 5u && stats.pipelineBinds == 4u && stats.textureBinds == 3u);
+
+		queue.clear();
+		s_draws.clear();
+		queue.execute(gfx, ring);
+		CWF_CHECK(s_draws.empty() && queue.getStats().submissions == 0u);
+	}
+}
+
+int main() {
+	testRadixSort();
+	testSortKey();
+	testExecute();
+	return cwf::failures();
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "Bench.h"
+#include "RingAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// per-object constants the way ConstantBufferRing hands them out: many small allocations, three frames in flight
+int main() {
+	constexpr size_t FRAMES{ 1000u };
+	for (const size_t objects : { 1000u, 10000u }) {
+		RingAllocator ring{ objects * 256u * 4u };
+		uint64_t fence{ 0u };
+		size_t sum{ 0u };
+		const double ms{ cwf::run([&] {
+			for (size_t f{ 0u }; f < FRAMES; f++) {
+				for (size_t i{ 0u }; i < objects; i++) sum += ring.allocate(64u + i % 192u);
+				ring.endFrame(++fence);
+				if (fence > 3u) ring.retire(fence - 3u);
+			}
+		}) };
+		cwf::keep(sum);
+		char name[64]{};
+		std::snprintf(name, sizeof(name), "allocate, %zu per frame, 3 in flight", objects);
+		cwf::report(name, ms, FRAMES * objects);
+	}
+	return 0;
+}
\ No newline at end of file
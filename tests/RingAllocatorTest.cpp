@@ -0,0 +1,146 @@
+#include "Check.h"
+#include "RingAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+	void testAlignment() {
+		RingAllocator ring{ 4096u };
+		const size_t a{ ring.allocate(1u) };
+		const size_t b{ ring.allocate(257u) };
+		const size_t c{ ring.allocate(256u) };
+		CWF_CHECK(a == 0u && b == 256u && c == 768u);
+		CWF_CHECK(ring.getUsed() == 1024u);
+
+		RingAllocator odd{ 480u, 48u }; // alignment need not be a power of two
+		CWF_CHECK(odd.allocate(1u) == 0u);
+		CWF_CHECK(odd.allocate(50u) == 48u);
+		CWF_CHECK(odd.allocate(48u) == 144u);
+		CWF_CHECK(RingAllocator::alignUp(97u, 48u) == 144u);
+	}
+
+	void testInvalid() {
+		RingAllocator ring{ 1024u };
+		CWF_CHECK(ring.allocate(0u) == RingAllocator::INVALID_OFFSET);
+		CWF_CHECK(ring.allocate(1025u) == RingAllocator::INVALID_OFFSET);
+		for (int i{ 0 }; i < 4; i++) CWF_CHECK(ring.allocate(200u) != RingAllocator::INVALID_OFFSET);
+		CWF_CHECK(ring.allocate(1u) == RingAllocator::INVALID_OFFSET); // full until a frame retires
+		CWF_CHECK(ring.getUsed() == 1024u);
+	}
+
+	void testFences() {
+		RingAllocator ring{ 1024u };
+		ring.allocate(256u);
+		ring.endFrame(1u);
+		ring.endFrame(2u); // nothing allocated: nothing to wait on
+		CWF_CHECK(ring.getFramesInFlight() == 1u);
+		ring.allocate(256u);
+		ring.endFrame(3u);
+		ring.allocate(256u);
+		ring.endFrame(4u);
+		CWF_CHECK(ring.getFramesInFlight() == 3u);
+
+		ring.retire(0u);
+		CWF_CHECK(ring.getFramesInFlight() == 3u && ring.getUsed() == 768u);
+		ring.retire(3u); // frames fenced 1 and 3
+		CWF_CHECK(ring.getFramesInFlight() == 1u && ring.getUsed() == 256u);
+		ring.retire(4u);
+		CWF_CHECK(ring.getFramesInFlight() == 0u && ring.getUsed() == 0u);
+		CWF_CHECK(ring.allocate(1024u) == 0u); // empty again: starts over at the front
+	}
+
+	void testWrap() {
+		RingAllocator ring{ 1024u };
+		CWF_CHECK(ring.allocate(512u) == 0u);
+		ring.endFrame(1u);
+		CWF_CHECK(ring.allocate(256u) == 512u);
+		ring.endFrame(2u);
+		ring.retire(1u); // [0, 512) is free again; head is at 768
+		CWF_CHECK(ring.allocate(512u) == 0u); // 256 left at the end isn't enough, so it wraps and wastes them
+		CWF_CHECK(ring.getUsed() == 256u + 512u + 256u);
+		ring.endFrame(3u);
+		CWF_CHECK(ring.allocate(1u) == RingAllocator::INVALID_OFFSET);
+		ring.retire(2u);
+		CWF_CHECK(ring.getUsed() == 512u + 256u); // frame 3 still owns the wasted end
+		ring.retire(3u);
+		CWF_CHECK(ring.getUsed() == 0u);
+	}
+
+	void testGrowth() {
+		// ConstantBufferRing's policy: when a frame alone doesn't fit, replace the buffer with one twice the size
+		RingAllocator ring{ 1024u };
+		uint64_t fence{ 0u };
+		for (int frame{ 0 }; frame < 3; frame++) {
+			for (int i{ 0 }; i < 10; i++) {
+				size_t offset{ ring.allocate(256u) };
+				if (offset == RingAllocator::INVALID_OFFSET) {
+					ring.reset(ring.getCapacity() * 2u);
+					CWF_CHECK(ring.getUsed() == 0u && ring.getFramesInFlight() == 0u);
+					offset = ring.allocate(256u);
+				}
+				CWF_CHECK(offset != RingAllocator::INVALID_OFFSET);
+			}
+			ring.endFrame(++fence);
+			ring.retire(fence);
+		}
+		CWF_CHECK(ring.getCapacity() == 4096u); // grew twice, then the frame fit
+	}
+
+	// random frame sizes with a few frames in flight: live allocations never overlap, and used adds up
+	void testRandomFrames() {
+		struct Range {
+			size_t offset;
+			size_t size;
+		};
+		constexpr size_t CAPACITY{ 64u * 1024u };
+		RingAllocator ring{ CAPACITY };
+		std::mt19937 rng{ 7u };
+		std::deque<std::pair<uint64_t, std::vector<Range>>> inFlight{}; // fence, allocations
+		uint64_t fence{ 0u };
+		bool disjoint{ true };
+		size_t failures{ 0u };
+		for (int frame{ 0 }; frame < 2000; frame++) {
+			std::vector<Range> current{};
+			const int count{ static_cast<int>(rng() % 40u) };
+			for (int i{ 0 }; i < count; i++) {
+				const size_t size{ 1u + rng() % 2000u };
+				const size_t offset{ ring.allocate(size) };
+				if (offset == RingAllocator::INVALID_OFFSET) {
+					failures++;
+					continue;
+				}
+				const Range r{ offset, RingAllocator::alignUp(size, RingAllocator::DEFAULT_ALIGNMENT) };
+				disjoint = disjoint && r.offset + r.size <= CAPACITY;
+				for (const auto& [f, ranges] : inFlight) {
+					for (const Range& o : ranges) disjoint = disjoint && (r.offset + r.size <= o.offset || o.offset + o.size <= r.offset);
+				}
+				for (const Range& o : current) disjoint = disjoint && (r.offset + r.size <= o.offset || o.offset + o.size <= r.offset);
+				current.push_back(r);
+			}
+			ring.endFrame(++fence);
+			if (!current.empty()) inFlight.emplace_back(fence, std::move(current));
+			if (fence > 3u) { // the GPU is three frames behind
+				ring.retire(fence - 3u);
+				while (!inFlight.empty() && inFlight.front().first <= fence - 3u) inFlight.pop_front();
+			}
+		}
+		CWF_CHECK(disjoint);
+		CWF_CHECK(failures > 0u); // the ring was small enough to fill up sometimes
+		ring.retire(fence);
+		CWF_CHECK(ring.getUsed() == 0u && ring.getFramesInFlight() == 0u);
+	}
+}
+
+int main() {
+	testAlignment();
+	testInvalid();
+	testFences();
+	testWrap();
+	testGrowth();
+	testRandomFrames();
+	return cwf::failures();
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "Bench.h"
+#include "Culling.h"
+#include "SceneIndex.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace {
+	using Aabb = SceneIndex::Aabb;
+
+	// a city-sized scene: boxes of 0.5 to 5 units, scattered over 2000 x 100 x 2000
+	std::vector<Aabb> scene(size_t count) {
+		std::mt19937 rng{ 19u };
+		std::uniform_real_distribution<float> ground{ -1000.0f, 1000.0f };
+		std::uniform_real_distribution<float> height{ 0.0f, 100.0f };
+		std::uniform_real_distribution<float> size{ 0.5f, 5.0f };
+		std::vector<Aabb> boxes(count);
+		for (Aabb& box : boxes) {
+			box.min[0] = ground(rng);
+			box.min[1] = height(rng);
+			box.min[2] = ground(rng);
+			for (size_t a{ 0u }; a < 3u; a++) box.max[a] = box.min[a] + size(rng);
+		}
+		return boxes;
+	}
+
+	// a camera at the origin looking along +z, 300 units deep
+	Culling::Frustum frustum() {
+		const float ys{ 1.0f / std::tan(0.6f) };
+		const float range{ 300.0f / (300.0f - 0.5f) };
+		const float vp[16]{ ys / 1.5f, 0, 0, 0, 0, ys, 0, 0, 0, 0, range, 1, 0, 0, -range * 0.5f, 0 };
+		return Culling::frustum(vp);
+	}
+
+	bool overlap(const Aabb& a, const Aabb& b) {
+		for (size_t i{ 0u }; i < 3u; i++) {
+			if (a.max[i] < b.min[i] || b.max[i] < a.min[i]) return false;
+		}
+		return true;
+	}
+
+	void bench(size_t count) {
+		const std::vector<Aabb> boxes{ scene(count) };
+		SceneIndex index{};
+		for (const Aabb& box : boxes) index.insert(box);
+		char name[64]{};
+
+		std::snprintf(name, sizeof(name), "build, %zu boxes", count);
+		cwf::report(name, cwf::run([&] { index.build(); }, 3u), count);
+
+		// every box moves a little, so refit sweeps every node
+		std::vector<Aabb> moved{ boxes };
+		for (Aabb& box : moved) {
+			box.min[1] += 0.25f;
+			box.max[1] += 0.25f;
+		}
+		std::snprintf(name, sizeof(name), "setBounds all + refit, %zu boxes", count);
+		cwf::report(name, cwf::run([&] {
+			for (SceneIndex::Id id{ 0u }; id < count; id++) index.setBounds(id, moved[id]);
+			index.refit();
+		}, 3u), count);
+		index.build();
+
+		// per query, against checking every box
+		constexpr size_t QUERIES{ 256u };
+		std::mt19937 rng{ 5u };
+		std::uniform_real_distribution<float> ground{ -1000.0f, 1000.0f };
+		std::vector<Aabb> regions(QUERIES);
+		std::vector<SceneIndex::Ray> rays(QUERIES);
+		for (size_t q{ 0u }; q < QUERIES; q++) {
+			const float x{ ground(rng) };
+			const float z{ ground(rng) };
+			regions[q] = { { x, 0.0f, z }, { x + 20.0f, 100.0f, z + 20.0f } };
+			const float dx{ ground(rng) - x };
+			const float dz{ ground(rng) - z };
+			const float length{ std::sqrt(dx * dx + dz * dz + 1.0f) };
+			rays[q] = { { x, 50.0f, z }, { dx / length, 1.0f / length, dz / length } };
+		}
+
+		std::vector<SceneIndex::Id> found{};
+		found.reserve(count);
+		size_t total{ 0u };
+		std::snprintf(name, sizeof(name), "queryAabb, %zu boxes", count);
+		cwf::report(name, cwf::run([&] {
+			for (const Aabb& region : regions) {
+				found.clear();
+				total += index.queryAabb(region, found);
+			}
+		}), QUERIES);
+		std::snprintf(name, sizeof(name), "queryAabb brute force, %zu boxes", count);
+		cwf::report(name, cwf::run([&] {
+			for (const Aabb& region : regions) {
+				for (const Aabb& box : boxes) total += overlap(box, region) ? 1u : 0u;
+			}
+		}, 1u), QUERIES);
+
+		const Culling::Frustum f{ frustum() };
+		std::snprintf(name, sizeof(name), "queryFrustum, %zu boxes", count);
+		cwf::report(name, cwf::run([&] {
+			found.clear();
+			total += index.queryFrustum(f, found);
+		}), 1u);
+		std::snprintf(name, sizeof(name), "raycast, %zu boxes", count);
+		cwf::report(name, cwf::run([&] {
+			for (const SceneIndex::Ray& ray : rays) {
+				const std::optional<SceneIndex::Hit> hit{ index.raycast(ray) };
+				total += hit ? hit->id : 0u;
+			}
+		}), QUERIES);
+		cwf::keep(total);
+		std::printf("%zu nodes, %zu visible\n", index.getNodeCount(), found.size());
+	}
+}
+
+// build, refit and each query over 10k, 100k and 1M boxes; ns/item is per box for build and refit, per query otherwise
+int main() {
+	for (const size_t count : { 10000u, 100000u, 1000000u }) bench(count);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "Check.h"
+#include "Culling.h"
+#include "SceneIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace {
+	using Aabb = SceneIndex::Aabb;
+	using Id = SceneIndex::Id;
+
+	// what the index should hold: the boxes it was last updated with, less what was removed since
+	struct Model {
+		std::vector<Aabb> bounds;
+		std::vector<uint8_t> indexed;
+	};
+
+	bool overlap(const Aabb& a, const Aabb& b) {
+		for (size_t i{ 0u }; i < 3u; i++) {
+			if (a.max[i] < b.min[i] || b.max[i] < a.min[i]) return false;
+		}
+		return true;
+	}
+
+	// visible unless entirely outside one plane, the same conservative test Culling::cullBoxes does
+	bool visible(const Culling::Frustum& f, const Aabb& box) {
+		for (const Culling::Plane& p : f.planes) {
+			const float reach{ 0.5f * (std::abs(p.x) * (box.max[0] - box.min[0]) + std::abs(p.y) * (box.max[1] - box.min[1])
+				+ std::abs(p.z) * (box.max[2] - box.min[2])) };
+			const float d{ p.x * 0.5f * (box.min[0] + box.max[0]) + p.y * 0.5f * (box.min[1] + box.max[1])
+				+ p.z * 0.5f * (box.min[2] + box.max[2]) + p.w };
+			if (d < -reach) return false;
+		}
+		return true;
+	}
+
+	// slab test: where the ray enters box within [0, limit], if it does
+	std::optional<float> enter(const SceneIndex::Ray& ray, const Aabb& box, float limit) {
+		float tNear{ 0.0f };
+		float tFar{ limit };
+		for (size_t a{ 0u }; a < 3u; a++) {
+			const float inverse{ 1.0f / ray.direction[a] };
+			const bool negative{ std::signbit(ray.direction[a]) };
+			const float t0{ ((negative ? box.max[a] : box.min[a]) - ray.origin[a]) * inverse };
+			const float t1{ ((negative ? box.min[a] : box.max[a]) - ray.origin[a]) * inverse };
+			tNear = t0 > tNear ? t0 : tNear;
+			tFar = t1 < tFar ? t1 : tFar;
+		}
+		if (tNear <= tFar) return tNear;
+		return std::nullopt;
+	}
+
+	Aabb randomBox(std::mt19937& rng) {
+		std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+		std::uniform_real_distribution<float> size{ 0.0f, 6.0f };
+		Aabb box{};
+		for (size_t a{ 0u }; a < 3u; a++) {
+			box.min[a] = position(rng);
+			box.max[a] = box.min[a] + (rng() % 16u == 0u ? 0.0f : size(rng)); // some are flat
+		}
+		return box;
+	}
+
+	SceneIndex::Ray randomRay(std::mt19937& rng) {
+		std::uniform_real_distribution<float> position{ -120.0f, 120.0f };
+		std::normal_distribution<float> direction{};
+		SceneIndex::Ray ray{};
+		float length{ 0.0f };
+		for (size_t a{ 0u }; a < 3u; a++) {
+			ray.origin[a] = position(rng);
+			ray.direction[a] = rng() % 8u == 0u ? 0.0f : direction(rng); // some run along an axis or a plane
+			length += ray.direction[a] * ray.direction[a];
+		}
+		if (length == 0.0f) {
+			ray.direction[0] = 1.0f;
+			length = 1.0f;
+		}
+		for (float& d : ray.direction)
+			d /= std::sqrt(length);
+		return ray;
+	}
+
+	std::vector<float> perspective(float fovY, float aspect, float nearZ, float farZ) {
+		const float ys{ 1.0f / std::tan(fovY * 0.5f) };
+		const float range{ farZ / (farZ - nearZ) };
+		return { ys / aspect, 0.0f, 0.0f, 0.0f, 0.0f, ys, 0.0f, 0.0f, 0.0f, 0.0f, range, 1.0f, 0.0f, 0.0f, -range * nearZ, 0.0f };
+	}
+
+	// the view projection of a camera at eye looking along +z, turned by yaw about y
+	Culling::Frustum randomFrustum(std::mt19937& rng) {
+		std::uniform_real_distribution<float> position{ -80.0f, 80.0f };
+		std::uniform_real_distribution<float> angle{ -3.14159f, 3.14159f };
+		const float eye[3]{ position(rng), position(rng), position(rng) };
+		const float yaw{ angle(rng) };
+		const float c{ std::cos(yaw) };
+		const float s{ std::sin(yaw) };
+		// inverse of (rotate by yaw, then translate to eye), for row vectors
+		const float view[16]{
+			c, 0.0f, s, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			-s, 0.0f, c, 0.0f,
+			-(eye[0] * c - eye[2] * s), -eye[1], -(eye[0] * s + eye[2] * c), 1.0f
+		};
+		const std::vector<float> projection{ perspective(1.2f, 1.5f, 0.5f, 90.0f) };
+		float vp[16]{};
+		for (int r{ 0 }; r < 4; r++) {
+			for (int col{ 0 }; col < 4; col++) {
+				for (int k{ 0 }; k < 4; k++) vp[r * 4 + col] += view[r * 4 + k] * projection[k * 4 + col];
+			}
+		}
+		return Culling::frustum(vp);
+	}
+
+	std::vector<Id> sorted(std::vector<Id> ids) {
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	}
+
+	// every query agrees with a scan over the model; returns false (after saying why) on the first disagreement
+	bool agrees(const SceneIndex& index, const Model& model, std::mt19937& rng, const char* stage) {
+		for (size_t q{ 0u }; q < 200u; q++) {
+			const Aabb box{ randomBox(rng) };
+			Aabb query{ box };
+			for (size_t a{ 0u }; a < 3u; a++) query.max[a] += 10.0f;
+			std::vector<Id> expected{};
+			for (Id id{ 0u }; id < model.bounds.size(); id++) {
+				if (model.indexed[id] && overlap(model.bounds[id], query)) expected.push_back(id);
+			}
+			std::vector<Id> found{ 7u }; // queries append
+			const size_t count{ index.queryAabb(query, found) };
+			found.erase(found.begin());
+			if (count != found.size() || sorted(found) != expected) {
+				std::fprintf(stderr, "%s: queryAabb disagrees\n", stage);
+				return false;
+			}
+
+			const Culling::Frustum f{ randomFrustum(rng) };
+			expected.clear();
+			for (Id id{ 0u }; id < model.bounds.size(); id++) {
+				if (model.indexed[id] && visible(f, model.bounds[id])) expected.push_back(id);
+			}
+			found.clear();
+			if (index.queryFrustum(f, found) != found.size() || sorted(found) != expected) {
+				std::fprintf(stderr, "%s: queryFrustum disagrees\n", stage);
+				return false;
+			}
+
+			const SceneIndex::Ray ray{ randomRay(rng) };
+			const float limit{ q % 2u == 0u ? SceneIndex::NO_LIMIT : 60.0f };
+			std::optional<float> nearest{};
+			for (Id id{ 0u }; id < model.bounds.size(); id++) {
+				if (!model.indexed[id]) continue;
+				const std::optional<float> distance{ enter(ray, model.bounds[id], limit) };
+				if (distance && (!nearest || *distance < *nearest)) nearest = distance;
+			}
+			const std::optional<SceneIndex::Hit> hit{ index.raycast(ray, limit) };
+			bool same{ hit.has_value() == nearest.has_value() };
+			if (same && hit) {
+				// ties may go to either box, so the hit only has to be one of the nearest
+				const std::optional<float> own{ enter(ray, model.bounds[hit->id], limit) };
+				same = model.indexed[hit->id] && hit->distance == *nearest && own && *own == *nearest;
+			}
+			if (!same) {
+				std::fprintf(stderr, "%s: raycast disagrees\n", stage);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void add(SceneIndex& index, Model& model, const Aabb& box) {
+		const Id id{ index.insert(box) };
+		if (id >= model.bounds.size()) {
+			model.bounds.resize(id + 1u);
+			model.indexed.resize(id + 1u, 0u);
+		}
+		model.bounds[id] = box;
+	}
+
+	// after update(), the index holds exactly what is alive
+	void updated(SceneIndex& index, Model& model) {
+		index.update();
+		for (Id id{ 0u }; id < model.bounds.size(); id++) model.indexed[id] = index.contains(id) ? 1u : 0u;
+	}
+
+	void testAgainstBruteForce() {
+		std::mt19937 rng{ 19u };
+		SceneIndex index{};
+		Model model{};
+		CWF_CHECK(agrees(index, model, rng, "empty"));
+
+		for (size_t i{ 0u }; i < 3000u; i++) add(index, model, randomBox(rng));
+		updated(index, model);
+		CWF_CHECK(index.size() == 3000u);
+		CWF_CHECK(agrees(index, model, rng, "built"));
+
+		// found only after the next update
+		for (size_t i{ 0u }; i < 300u; i++) add(index, model, randomBox(rng));
+		CWF_CHECK(agrees(index, model, rng, "inserted, not updated"));
+		updated(index, model);
+		CWF_CHECK(agrees(index, model, rng, "inserted"));
+
+		// removed ones are gone at once, and the refit that follows keeps everything else
+		std::vector<Id> removed{};
+		for (Id id{ 0u }; id < model.bounds.size(); id++) {
+			if (rng() % 5u == 0u) removed.push_back(id);
+		}
+		for (const Id id : removed) {
+			index.remove(id);
+			model.indexed[id] = 0u;
+		}
+		CWF_CHECK(agrees(index, model, rng, "removed, not updated"));
+		updated(index, model);
+		CWF_CHECK(agrees(index, model, rng, "removed"));
+
+		// a few moves refit only their leaves' ancestors, many sweep every node; both keep the tree's shape
+		for (const size_t moves : { 20u, 2000u }) {
+			for (size_t i{ 0u }; i < moves; i++) {
+				const Id id{ static_cast<Id>(rng() % model.bounds.size()) };
+				if (!index.contains(id)) continue;
+				Aabb box{ model.bounds[id] };
+				const float step{ static_cast<float>(static_cast<int>(rng() % 41u) - 20) };
+				for (size_t a{ 0u }; a < 3u; a++) {
+					box.min[a] += step;
+					box.max[a] += step;
+				}
+				index.setBounds(id, box);
+				model.bounds[id] = box;
+			}
+			const size_t nodes{ index.getNodeCount() };
+			updated(index, model);
+			CWF_CHECK(index.getNodeCount() == nodes);
+			CWF_CHECK(agrees(index, model, rng, moves == 20u ? "refit, few moved" : "refit, many moved"));
+		}
+
+		// ids are reused, and the build that follows puts them back in the tree
+		for (size_t i{ 0u }; i < removed.size() / 2u; i++) add(index, model, randomBox(rng));
+		CWF_CHECK(model.bounds.size() == 3300u);
+		updated(index, model);
+		CWF_CHECK(agrees(index, model, rng, "reinserted"));
+
+		index.clear();
+		model = {};
+		CWF_CHECK(index.size() == 0u);
+		CWF_CHECK(agrees(index, model, rng, "cleared"));
+	}
+
+	// a few boxes small enough to check by hand
+	void testKnownScene() {
+		SceneIndex index{};
+		const Id a{ index.insert({ { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } }) };
+		const Id b{ index.insert({ { 0.0f, 0.0f, 5.0f }, { 1.0f, 1.0f, 6.0f } }) };
+		const Id c{ index.insert({ { 10.0f, 0.0f, 0.0f }, { 11.0f, 1.0f, 1.0f } }) };
+		index.update();
+
+		const SceneIndex::Ray ray{ { 0.5f, 0.5f, -2.0f }, { 0.0f, 0.0f, 1.0f } };
+		std::optional<SceneIndex::Hit> hit{ index.raycast(ray) };
+		CWF_CHECK(hit && hit->id == a && hit->distance == 2.0f);
+		CWF_CHECK(!index.raycast(ray, 1.5f));
+		index.remove(a);
+		hit = index.raycast(ray);
+		CWF_CHECK(hit && hit->id == b && hit->distance == 7.0f);
+
+		// the callback replaces a box's entry distance with its own, or rejects the box
+		hit = index.raycast(ray, [](Id, const SceneIndex::Ray&, float) { return std::optional<float>{}; });
+		CWF_CHECK(!hit);
+		hit = index.raycast(ray, [](Id, const SceneIndex::Ray&, float) { return std::optional<float>{ 7.25f }; });
+		CWF_CHECK(hit && hit->id == b && hit->distance == 7.25f);
+
+		std::vector<Id> found{};
+		CWF_CHECK(index.queryAabb({ { 0.5f, 0.5f, 0.5f }, { 10.0f, 0.5f, 5.0f } }, found) == 2u);
+		CWF_CHECK(sorted(found) == std::vector<Id>({ b, c }));
+	}
+}
+
+int main() {
+	testKnownScene();
+	testAgainstBruteForce();
+	return cwf::failures();
+}
\ No newline at end of file
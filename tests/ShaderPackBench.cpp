@@ -0,0 +1,88 @@
+#include "Bench.h"
+#include "ShaderPack.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	// asks the OS to drop a file's cached pages, so the next read comes from disk (where the OS allows it)
+	void evict(const std::filesystem::path& path) {
+#if defined(__unix__)
+		const int fd{ ::open(path.c_str(), O_RDONLY) };
+		if (fd < 0) return;
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		::close(fd);
+#else
+		(void)path;
+#endif
+	}
+
+	uint64_t touch(const std::byte* p, size_t size) noexcept { // what CreateVertexShader would read
+		uint64_t sum{ 0u };
+		for (size_t i{ 0u }; i < size; i += 64u) sum += static_cast<uint64_t>(p[i]);
+		return sum;
+	}
+}
+
+// startup cost of loading every shader a scene uses: one .cso file read per shader, against one mapped pack
+int main() {
+	const std::filesystem::path dir{ std::filesystem::temp_directory_path() / "cwf_shaderpack_bench" };
+	std::filesystem::create_directories(dir);
+	std::mt19937 rng{ 8u };
+
+	for (const size_t count : { 16u, 128u, 1024u }) {
+		std::vector<std::string> names{};
+		std::vector<std::filesystem::path> files{};
+		ShaderPack::Writer writer{};
+		for (size_t i{ 0u }; i < count; i++) {
+			std::vector<std::byte> blob(2048u + rng() % 30000u); // compiled shaders are a few KiB to a few tens of KiB
+			for (std::byte& b : blob) b = static_cast<std::byte>(rng());
+			names.push_back("shader" + std::to_string(i));
+			files.push_back(dir / (names.back() + ".cso"));
+			std::ofstream file{ files.back(), std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+			writer.add(names.back(), i, blob);
+		}
+		const std::filesystem::path packPath{ dir / "shaders.pack" };
+		writer.write(packPath);
+		std::printf("%zu shaders\n", count);
+
+		uint64_t sum{ 0u };
+		for (const bool cold : { false, true }) {
+			const double perFile{ cwf::run([&] {
+				if (cold) for (const std::filesystem::path& f : files) evict(f);
+				for (const std::filesystem::path& f : files) {
+					std::ifstream file{ f, std::ios::binary };
+					const std::vector<char> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+					sum += touch(reinterpret_cast<const std::byte*>(bytes.data()), bytes.size());
+				}
+			}) };
+			const double packed{ cwf::run([&] {
+				if (cold) evict(packPath);
+				ShaderPack pack{ packPath };
+				for (const std::string& name : names) {
+					if (const std::optional<ShaderPack::Blob> blob{ pack.find(name) })
+						sum += touch(blob->byteCode.data(), blob->byteCode.size());
+				}
+			}) };
+			cwf::report(cold ? "  per-file reads (cold)" : "  per-file reads (warm)", perFile, count);
+			cwf::report(cold ? "  mapped pack (cold)" : "  mapped pack (warm)", packed, count);
+		}
+		cwf::keep(sum);
+		for (const std::filesystem::path& f : files) std::filesystem::remove(f);
+		std::filesystem::remove(packPath);
+	}
+	std::filesystem::remove(dir);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "Check.h"
+#include "ShaderPack.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	struct Shader {
+		std::string name;
+		uint64_t sourceHash;
+		std::vector<std::byte> byteCode;
+	};
+
+	std::filesystem::path temporary(const char* name) {
+		return std::filesystem::temp_directory_path() / (std::string{ "cwf_" } + name);
+	}
+
+	std::vector<std::byte> readFile(const std::filesystem::path& path) {
+		std::ifstream file{ path, std::ios::binary };
+		const std::vector<char> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+		std::vector<std::byte> out(bytes.size());
+		if (!bytes.empty()) std::memcpy(out.data(), bytes.data(), bytes.size());
+		return out;
+	}
+
+	void writeFile(const std::filesystem::path& path, const std::vector<std::byte>& bytes) {
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	std::vector<Shader> shaders(size_t count, unsigned seed) {
+		std::mt19937 rng{ seed };
+		std::vector<Shader> out{};
+		for (size_t i{ 0u }; i < count; i++) {
+			Shader& s{ out.emplace_back(Shader{ "shader" + std::to_string(i) + (i % 3u ? "VS" : "PS"), rng(), {} }) };
+			s.byteCode.resize(i == 0u ? 0u : rng() % 3000u); // one empty blob
+			for (std::byte& b : s.byteCode) b = static_cast<std::byte>(rng());
+		}
+		return out;
+	}
+
+	bool writePack(const std::filesystem::path& path, const std::vector<Shader>& list) {
+		ShaderPack::Writer writer{};
+		for (const Shader& s : list) writer.add(s.name, s.sourceHash, s.byteCode);
+		return writer.write(path);
+	}
+
+	void testRoundTrip() {
+		const std::filesystem::path path{ temporary("roundtrip.pack") };
+		const std::vector<Shader> list{ shaders(200u, 1u) };
+		CWF_CHECK(writePack(path, list));
+
+		ShaderPack pack{ path };
+		CWF_CHECK(!pack.isOpen()); // nothing is touched until the first lookup
+		CWF_CHECK(pack.size() == list.size() && pack.isOpen());
+		bool found{ true };
+		bool aligned{ true };
+		for (const Shader& s : list) {
+			const std::optional<ShaderPack::Blob> blob{ pack.find(s.name) };
+			found = found && blob && blob->sourceHash == s.sourceHash && blob->byteCode.size() == s.byteCode.size()
+				&& (s.byteCode.empty() || std::memcmp(blob->byteCode.data(), s.byteCode.data(), s.byteCode.size()) == 0);
+			aligned = aligned && blob && reinterpret_cast<uintptr_t>(blob->byteCode.data()) % ShaderPack::BLOB_ALIGNMENT == 0u;
+			found = found && pack.find(s.name, s.sourceHash) && !pack.find(s.name, s.sourceHash + 1u); // stale
+		}
+		CWF_CHECK(found);
+		CWF_CHECK(aligned);
+		CWF_CHECK(!pack.find("missing") && !pack.find("") && !pack.find("shader1"));
+		std::filesystem::remove(path);
+	}
+
+	void testWriter() {
+		const std::filesystem::path path{ temporary("writer.pack") };
+		const std::byte first[3]{ std::byte{ 1 }, std::byte{ 2 }, std::byte{ 3 } };
+		const std::byte second[2]{ std::byte{ 9 }, std::byte{ 8 } };
+		ShaderPack::Writer writer{};
+		writer.add("VS", 1u, first);
+		writer.add("VS", 2u, second); // replaces
+		CWF_CHECK(writer.size() == 1u);
+		CWF_CHECK(!writer.addFile("PS", 3u, temporary("no_such_shader.cso")));
+		CWF_CHECK(writer.write(path));
+		{
+			ShaderPack pack{ path };
+			const std::optional<ShaderPack::Blob> blob{ pack.find("VS") };
+			CWF_CHECK(pack.size() == 1u && blob && blob->sourceHash == 2u && blob->byteCode.size() == 2u && blob->byteCode[0] == std::byte{ 9 });
+		}
+
+		const std::filesystem::path cso{ temporary("writer.cso") };
+		writeFile(cso, { std::byte{ 0x44 }, std::byte{ 0x58 }, std::byte{ 0x42 }, std::byte{ 0x43 } });
+		CWF_CHECK(writer.addFile("PS", 3u, cso));
+		CWF_CHECK(writer.write(path));
+		ShaderPack pack{ path };
+		const std::optional<ShaderPack::Blob> blob{ pack.find("PS", 3u) };
+		CWF_CHECK(pack.size() == 2u && blob && blob->byteCode.size() == 4u && blob->byteCode[3] == std::byte{ 0x43 });
+
+		CWF_CHECK(ShaderPack::Writer{}.write(path)); // an empty pack is still a pack
+		ShaderPack empty{ path };
+		CWF_CHECK(empty.open() && empty.size() == 0u && !empty.find("VS"));
+		std::filesystem::remove(path);
+		std::filesystem::remove(cso);
+	}
+
+	void testMissing() {
+		ShaderPack pack{ temporary("no_such.pack") };
+		CWF_CHECK(!pack.find("VS") && !pack.isOpen() && pack.size() == 0u && !pack.open());
+	}
+
+	bool opens(const std::filesystem::path& path, const std::vector<std::byte>& bytes) {
+		writeFile(path, bytes);
+		ShaderPack pack{ path };
+		return pack.open();
+	}
+
+	template <typename T>
+	std::vector<std::byte> patched(std::vector<std::byte> bytes, size_t offset, T value) {
+		std::memcpy(bytes.data() + offset, &value, sizeof(value));
+		return bytes;
+	}
+
+	// validate() must turn away every malformed pack before find() reads anything out of bounds
+	void testCorruption() {
+		const std::filesystem::path good{ temporary("good.pack") };
+		const std::filesystem::path bad{ temporary("bad.pack") };
+		const std::vector<Shader> list{ shaders(8u, 2u) };
+		CWF_CHECK(writePack(good, list));
+		const std::vector<std::byte> bytes{ readFile(good) };
+		CWF_CHECK(opens(bad, bytes));
+
+		bool truncated{ true };
+		for (size_t size{ 0u }; size < bytes.size(); size += (size < 512u ? 1u : 97u))
+			truncated = truncated && !opens(bad, std::vector<std::byte>(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(size)));
+		CWF_CHECK(truncated);
+		std::vector<std::byte> longer{ bytes };
+		longer.push_back(std::byte{ 0 });
+		CWF_CHECK(!opens(bad, longer)); // the header's size must match the file's
+
+		constexpr size_t ENTRY{ 32u }; // the first entry
+		CWF_CHECK(!opens(bad, patched(bytes, 0u, 'X'))); // magic
+		CWF_CHECK(!opens(bad, patched(bytes, 4u, ShaderPack::VERSION + 1u)));
+		CWF_CHECK(!opens(bad, patched(bytes, 8u, uint32_t{ 0xFFFFFFFFu }))); // more entries than fit
+		CWF_CHECK(!opens(bad, patched(bytes, ENTRY + 16u, static_cast<uint64_t>(bytes.size() + 1u)))); // blob offset
+		CWF_CHECK(!opens(bad, patched(bytes, ENTRY + 24u, static_cast<uint64_t>(bytes.size())))); // blob size
+		CWF_CHECK(!opens(bad, patched(bytes, ENTRY + 24u, ~uint64_t{ 0u }))); // blob size that would wrap around
+		CWF_CHECK(!opens(bad, patched(bytes, ENTRY + 32u, static_cast<uint32_t>(bytes.size() + 1u)))); // name offset
+		CWF_CHECK(!opens(bad, patched(bytes, ENTRY + 36u, static_cast<uint32_t>(bytes.size())))); // name length
+		CWF_CHECK(!opens(bad, patched(bytes, ENTRY + 0u, ~uint64_t{ 0u }))); // entries out of hash order
+
+		// random damage may still be a well-formed pack, but every lookup must stay inside the file
+		std::mt19937 rng{ 3u };
+		bool inside{ true };
+		for (int round{ 0 }; round < 500; round++) {
+			std::vector<std::byte> damaged{ bytes };
+			for (int flips{ 0 }; flips < 4; flips++)
+				damaged[rng() % (32u + list.size() * 48u)] ^= static_cast<std::byte>(1u << (rng() % 8u));
+			writeFile(bad, damaged);
+			ShaderPack pack{ bad };
+			if (!pack.open()) continue;
+			for (const Shader& s : list) {
+				if (const std::optional<ShaderPack::Blob> blob{ pack.find(s.name) }) {
+					const std::vector<std::byte> copy(blob->byteCode.begin(), blob->byteCode.end()); // touches every byte
+					inside = inside && copy.size() <= damaged.size();
+				}
+			}
+		}
+		CWF_CHECK(inside);
+		std::filesystem::remove(good);
+		std::filesystem::remove(bad);
+	}
+}
+
+int main() {
+	testRoundTrip();
+	testWriter();
+	testMissing();
+	testCorruption();
+	return cwf::failures();
+}
\ No newline at end of file
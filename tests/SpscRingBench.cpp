@@ -0,0 +1,64 @@
+#include "Bench.h"
+#include "SpscRing.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+
+// events through the ring against the std::queue it replaced (behind a mutex, as it would need to be across threads)
+int main() {
+	constexpr size_t COUNT{ 10000000u };
+	struct Event {
+		int32_t x;
+		int32_t y;
+	};
+
+	static SpscRing<Event, 256u> ring{};
+	cwf::report("SpscRing push+pop, one thread", cwf::run([] {
+		int64_t sum{ 0 };
+		for (size_t i{ 0u }; i < COUNT; i++) {
+			ring.push({ static_cast<int32_t>(i), 1 });
+			sum += ring.pop()->x;
+		}
+		cwf::keep(sum);
+	}), COUNT);
+
+	cwf::report("std::queue+mutex push+pop, one thread", cwf::run([] {
+		std::queue<Event> queue{};
+		std::mutex mutex{};
+		int64_t sum{ 0 };
+		for (size_t i{ 0u }; i < COUNT; i++) {
+			{
+				const std::lock_guard lock{ mutex };
+				queue.push({ static_cast<int32_t>(i), 1 });
+			}
+			const std::lock_guard lock{ mutex };
+			sum += queue.front().x;
+			queue.pop();
+		}
+		cwf::keep(sum);
+	}), COUNT);
+
+	cwf::report("SpscRing producer and consumer threads", cwf::run([] {
+		std::thread producer{ [] {
+			for (size_t i{ 0u }; i < COUNT; ) {
+				if (ring.push({ static_cast<int32_t>(i), 1 })) i++;
+				else std::this_thread::yield();
+			}
+		} };
+		int64_t sum{ 0 };
+		for (size_t received{ 0u }; received < COUNT; ) {
+			if (const std::optional<Event> e{ ring.pop() }) {
+				sum += e->x;
+				received++;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+		cwf::keep(sum);
+	}, 3u), COUNT);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "Check.h"
+#include "SpscRing.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+namespace {
+	struct Pair {
+		int32_t a;
+		int32_t b;
+	};
+
+	void testEmpty() {
+		SpscRing<int, 8u> ring{};
+		CWF_CHECK(ring.empty());
+		CWF_CHECK(ring.size() == 0u);
+		CWF_CHECK(!ring.pop());
+		CWF_CHECK(ring.getOverflowCount() == 0u);
+		CWF_CHECK(SpscRing<int, 8u>::capacity() == 8u);
+	}
+
+	void testFullAndOverflow() {
+		SpscRing<int, 4u> ring{};
+		for (int i{ 0 }; i < 4; i++) CWF_CHECK(ring.push(i));
+		CWF_CHECK(ring.size() == 4u);
+		CWF_CHECK(!ring.push(100)); // full: the new element is the one dropped
+		CWF_CHECK(!ring.emplace(101));
+		CWF_CHECK(ring.getOverflowCount() == 2u);
+		for (int i{ 0 }; i < 4; i++) {
+			const std::optional<int> value{ ring.pop() };
+			CWF_CHECK(value && *value == i);
+		}
+		CWF_CHECK(ring.empty());
+		CWF_CHECK(ring.push(5)); // room again
+		CWF_CHECK(ring.getOverflowCount() == 2u);
+	}
+
+	void testWrap() {
+		SpscRing<Pair, 4u> ring{};
+		int32_t next{ 0 };
+		int32_t expected{ 0 };
+		for (int round{ 0 }; round < 1000; round++) { // head and tail go round the array many times, at varying fill
+			const int pushes{ 1 + round % 6 };
+			for (int i{ 0 }; i < pushes; i++) {
+				if (ring.emplace(next, -next)) next++;
+			}
+			const int pops{ 1 + (round * 7) % 4 };
+			for (int i{ 0 }; i < pops; i++) {
+				const std::optional<Pair> p{ ring.pop() };
+				if (!p) break;
+				CWF_CHECK(p->a == expected && p->b == -expected);
+				expected++;
+			}
+			CWF_CHECK(ring.size() == static_cast<size_t>(next - expected));
+		}
+		CWF_CHECK(ring.getOverflowCount() > 0u); // some rounds pushed into a full ring
+	}
+
+	void testClear() {
+		SpscRing<int, 8u> ring{};
+		for (int i{ 0 }; i < 5; i++) ring.push(i);
+		ring.clear();
+		CWF_CHECK(ring.empty());
+		CWF_CHECK(!ring.pop());
+		ring.push(42);
+		const std::optional<int> value{ ring.pop() };
+		CWF_CHECK(value && *value == 42);
+	}
+
+	// one producer, one consumer: every value arrives, once, in order
+	void testTwoThreads() {
+		constexpr uint32_t COUNT{ 1000000u };
+		SpscRing<uint32_t, 64u> ring{};
+		std::thread producer{ [&ring] {
+			for (uint32_t i{ 0u }; i < COUNT; ) {
+				if (ring.push(i)) i++;
+				else std::this_thread::yield(); // the consumer may share the core
+			}
+		} };
+		uint32_t expected{ 0u };
+		bool ordered{ true };
+		while (expected < COUNT) {
+			if (const std::optional<uint32_t> value{ ring.pop() }) {
+				ordered = ordered && *value == expected;
+				expected++;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+		CWF_CHECK(ordered);
+		CWF_CHECK(ring.empty());
+	}
+}
+
+int main() {
+	testEmpty();
+	testFullAndOverflow();
+	testWrap();
+	testClear();
+	testTwoThreads();
+	return cwf::failures();
+}
\ No newline at end of file
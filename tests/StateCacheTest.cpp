@@ -0,0 +1,151 @@
+#include "Check.h"
+#include "RecordingContext.h"
+#include "ShaderStage.h"
+#include "StateCache.h"
+#include <string>
+#include <vector>
+
+namespace {
+	using Cache = BasicStateCache<RecordingContext>;
+	using Calls = std::vector<std::string>;
+
+	// resources only need distinct addresses
+	Buffer s_buffers[4]{};
+	InputLayout s_layouts[2]{};
+	VertexShader s_vertexShaders[2]{};
+	PixelShader s_pixelShaders[2]{};
+	ShaderResourceView s_views[2]{};
+	SamplerState s_samplers[2]{};
+	RenderTargetView s_target{};
+	DepthStencilView s_depth{};
+
+	// binds everything a material binds, the way Material::bindPipeline does
+	void bindMaterial(Cache& cache, int which) {
+		cache.setPrimitiveTopology(TRIANGLELIST);
+		cache.setInputLayout(&s_layouts[which]);
+		cache.setVertexBuffer(0u, &s_buffers[which], 12u, 0u);
+		cache.setIndexBuffer(&s_buffers[2 + which], R16_UINT, 0u);
+		cache.setVertexShader(&s_vertexShaders[which]);
+		cache.setPixelShader(&s_pixelShaders[which]);
+		cache.setShaderResource(ShaderStage::PIXEL, 0u, &s_views[which]);
+		cache.setSampler(ShaderStage::PIXEL, 0u, &s_samplers[0]);
+		cache.setRenderTarget(&s_target, &s_depth);
+		cache.setViewport(ViewportDesc{ 0.0f, 0.0f, 1000.0f, 1000.0f, 0.0f, 1.0f });
+	}
+
+	void testFirstBindGoesThrough() {
+		RecordingContext context{};
+		Cache cache{ &context };
+		bindMaterial(cache, 0);
+		CWF_CHECK(context.calls().size() == 10u);
+		CWF_CHECK(context.calls()[0] == RecordingContext::line("IASetPrimitiveTopology", TRIANGLELIST));
+		CWF_CHECK(context.calls()[2] == RecordingContext::line("IASetVertexBuffers", 0u, 1u, &s_buffers[0], 12u, 0u));
+		CWF_CHECK(context.calls()[4] == RecordingContext::line("VSSetShader", &s_vertexShaders[0]));
+		CWF_CHECK(context.calls()[9] == RecordingContext::line("RSSetViewports", 1u, 1000.0f, 1000.0f));
+		CWF_CHECK(cache.getCounters().issued == 10u && cache.getCounters().elided == 0u);
+	}
+
+	void testElision() {
+		RecordingContext context{};
+		Cache cache{ &context };
+		bindMaterial(cache, 0);
+		context.clear();
+
+		bindMaterial(cache, 0); // same material again: nothing reaches the context
+		CWF_CHECK(context.calls().empty());
+		CWF_CHECK(cache.getCounters().issued == 10u && cache.getCounters().elided == 10u);
+
+		bindMaterial(cache, 1); // only what differs: layout, buffers, shaders and texture
+		const Calls expected{
+			RecordingContext::line("IASetInputLayout", &s_layouts[1]),
+			RecordingContext::line("IASetVertexBuffers", 0u, 1u, &s_buffers[1], 12u, 0u),
+			RecordingContext::line("IASetIndexBuffer", &s_buffers[3], R16_UINT, 0u),
+			RecordingContext::line("VSSetShader", &s_vertexShaders[1]),
+			RecordingContext::line("PSSetShader", &s_pixelShaders[1]),
+			RecordingContext::line("PSSetShaderResources", 0u, 1u, &s_views[1])
+		};
+		CWF_CHECK(context.calls() == expected);
+		CWF_CHECK(cache.getCounters().issued == 16u && cache.getCounters().elided == 14u);
+
+		// a changed argument other than the resource counts as a change
+		context.clear();
+		cache.setVertexBuffer(0u, &s_buffers[1], 12u, 48u);
+		cache.setIndexBuffer(&s_buffers[3], R32_UINT, 0u);
+		cache.setViewport(ViewportDesc{ 0.0f, 0.0f, 500.0f, 1000.0f, 0.0f, 1.0f });
+		cache.setPrimitiveTopology(LINELIST);
+		CWF_CHECK(context.calls().size() == 4u);
+	}
+
+	void testStagesAndSlots() {
+		RecordingContext context{};
+		Cache cache{ &context };
+		cache.setShaderResource(ShaderStage::VERTEX, 0u, &s_views[0]);
+		cache.setShaderResource(ShaderStage::PIXEL, 0u, &s_views[0]); // a different stage is different state
+		cache.setShaderResource(ShaderStage::PIXEL, 1u, &s_views[0]); // and so is a different slot
+		cache.setShaderResource(ShaderStage::PIXEL, 1u, &s_views[0]);
+		CWF_CHECK(context.calls().size() == 3u);
+		CWF_CHECK(context.calls()[0].starts_with("VSSetShaderResources"));
+
+		// slots past the tracked ones always go through
+		context.clear();
+		cache.setSampler(ShaderStage::PIXEL, Cache::TRACKED_SLOTS, &s_samplers[0]);
+		cache.setSampler(ShaderStage::PIXEL, Cache::TRACKED_SLOTS, &s_samplers[0]);
+		CWF_CHECK(context.calls().size() == 2u);
+	}
+
+	void testConstantBuffers() {
+		RecordingContext context{};
+		Cache cache{ &context };
+		Buffer* const range[2]{ &s_buffers[0], &s_buffers[1] };
+		cache.setConstantBuffers(ShaderStage::VERTEX, 0u, 2u, range);
+		cache.setConstantBuffers(ShaderStage::VERTEX, 0u, 2u, range); // the whole range is unchanged
+		CWF_CHECK(context.calls().size() == 1u);
+		Buffer* const changed[2]{ &s_buffers[0], &s_buffers[2] };
+		cache.setConstantBuffers(ShaderStage::VERTEX, 0u, 2u, changed); // one slot changed: the whole range is rebound
+		CWF_CHECK(context.calls().size() == 2u && context.calls()[1] == RecordingContext::line("VSSetConstantBuffers", 0u, 2u, &s_buffers[0]));
+
+		// ring slices: the same buffer at another offset is a different bind, and a whole-buffer bind differs from both
+		context.clear();
+		cache.setConstantBuffer1(ShaderStage::VERTEX, 0u, &s_buffers[0], 0u, 16u);
+		cache.setConstantBuffer1(ShaderStage::VERTEX, 0u, &s_buffers[0], 0u, 16u);
+		cache.setConstantBuffer1(ShaderStage::VERTEX, 0u, &s_buffers[0], 16u, 16u);
+		cache.setConstantBuffer1(ShaderStage::PIXEL, 0u, &s_buffers[0], 16u, 16u);
+		const Calls expected{
+			RecordingContext::line("VSSetConstantBuffers1", 0u, 1u, &s_buffers[0], 0u, 16u),
+			RecordingContext::line("VSSetConstantBuffers1", 0u, 1u, &s_buffers[0], 16u, 16u),
+			RecordingContext::line("PSSetConstantBuffers1", 0u, 1u, &s_buffers[0], 16u, 16u)
+		};
+		CWF_CHECK(context.calls() == expected);
+		Buffer* const whole[1]{ &s_buffers[0] };
+		cache.setConstantBuffers(ShaderStage::VERTEX, 0u, 1u, whole);
+		CWF_CHECK(context.calls().size() == 4u);
+	}
+
+	void testInvalidateAndCounters() {
+		RecordingContext context{};
+		Cache cache{ &context };
+		bindMaterial(cache, 0);
+		bindMaterial(cache, 0);
+		cache.endFrame();
+		CWF_CHECK(cache.getLastFrameCounters().issued == 10u && cache.getLastFrameCounters().elided == 10u);
+		CWF_CHECK(cache.getCounters().issued == 0u && cache.getCounters().elided == 0u);
+
+		// e.g. after ExecuteCommandList: everything is bound again
+		context.clear();
+		cache.invalidate();
+		bindMaterial(cache, 0);
+		CWF_CHECK(context.calls().size() == 10u);
+		cache.endFrame();
+		CWF_CHECK(cache.getLastFrameCounters().issued == 10u && cache.getLastFrameCounters().elided == 0u);
+		CWF_CHECK(cache.getContext() == &context);
+	}
+}
+
+int main() {
+	testFirstBindGoesThrough();
+	testElision();
+	testStagesAndSlots();
+	testConstantBuffers();
+	testInvalidateAndCounters();
+	return cwf::failures();
+}
\ No newline at end of file
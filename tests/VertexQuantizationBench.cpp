@@ -0,0 +1,58 @@
+#include "Bench.h"
+#include "VertexQuantization.h"
+#include "Vertices.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+	// a pass over the vertex data the way the input assembler reads it: every byte, front to back
+	template <class V>
+	uint64_t fetch(const std::vector<V>& vertices) noexcept {
+		uint64_t sum{ 0u };
+		const std::byte* p{ reinterpret_cast<const std::byte*>(vertices.data()) };
+		const size_t words{ vertices.size() * sizeof(V) / sizeof(uint32_t) };
+		for (size_t i{ 0u }; i < words; i++) {
+			uint32_t w{};
+			std::memcpy(&w, p + i * sizeof(uint32_t), sizeof(w));
+			sum += w;
+		}
+		return sum;
+	}
+
+	template <class V>
+	void reportFetch(const char* name, const std::vector<V>& vertices) {
+		uint64_t sum{ 0u };
+		const double ms{ cwf::run([&] { sum += fetch(vertices); }) };
+		cwf::keep(sum);
+		const double bytes{ static_cast<double>(vertices.size() * sizeof(V)) };
+		std::printf("%-48s %8.1f MiB %8.3f ms %8.2f GB/s\n", name, bytes / (1024.0 * 1024.0), ms, bytes / (ms * 1e6));
+	}
+}
+
+// large meshes: the cost of quantizing once at load, and the memory and read bandwidth it saves every frame
+int main() {
+	std::mt19937 rng{ 5u };
+	std::uniform_real_distribution<float> position{ -50.0f, 50.0f };
+	std::uniform_real_distribution<float> uv{ 0.0f, 1.0f };
+	for (const size_t count : { 100000u, 1000000u, 4000000u }) {
+		std::vector<Vertices::Float3Tex> source{};
+		source.reserve(count);
+		for (size_t i{ 0u }; i < count; i++)
+			source.emplace_back(position(rng), position(rng), position(rng)).tex.set(uv(rng), uv(rng));
+		std::printf("%zu vertices\n", count);
+
+		std::vector<Vertices::Half3Tex> half{};
+		std::vector<Vertices::Snorm3Tex> snorm{};
+		cwf::report("  quantize to Half3Tex", cwf::run([&] { half = VertexQuantization::quantize<Vertices::Half3Tex>(source); }, 3u), count);
+		cwf::report("  quantize to Snorm3Tex", cwf::run([&] { snorm = VertexQuantization::quantize<Vertices::Snorm3Tex>(source); }, 3u), count);
+
+		reportFetch("  read Float3Tex", source);
+		reportFetch("  read Half3Tex", half);
+		reportFetch("  read Snorm3Tex", snorm);
+	}
+	return 0;
+}
\ No newline at end of file
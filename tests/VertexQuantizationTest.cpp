@@ -0,0 +1,63 @@
+#include "Check.h"
+#include "VertexQuantization.h"
+#include "Vertices.h"
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace {
+	std::vector<Vertices::Float3Tex> mesh(size_t count, float scale, float offset, unsigned seed) {
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> position{ -1.0f, 1.0f };
+		std::uniform_real_distribution<float> uv{ 0.0f, 1.0f };
+		std::vector<Vertices::Float3Tex> vertices{};
+		for (size_t i{ 0u }; i < count; i++) {
+			Vertices::Float3Tex& v{ vertices.emplace_back(offset + scale * position(rng), offset + scale * position(rng), offset + scale * position(rng)) };
+			v.tex.set(uv(rng), uv(rng));
+		}
+		return vertices;
+	}
+
+	// the errors actually seen must stay within the bounds the report promises, at every scale
+	template <class Packed>
+	void testBounds() {
+		unsigned seed{ 1u };
+		for (const float scale : { 1e-7f, 3e-6f, 1e-4f, 0.01f, 1.0f, 100.0f, 30000.0f }) {
+			for (const float offset : { 0.0f, 2.0f * scale }) {
+				VertexQuantization::Report report{};
+				const std::vector<Packed> packed{ VertexQuantization::quantize<Packed>(mesh(4096u, scale, offset, seed++), &report) };
+				CWF_CHECK(packed.size() == 4096u && report.vertexCount == 4096u);
+				CWF_CHECK(report.positionError <= report.positionErrorBound);
+				CWF_CHECK(report.texCoordError <= report.texCoordErrorBound);
+				CWF_CHECK(report.sourceBytes == 4096u * 20u && report.packedBytes == 4096u * 12u);
+			}
+		}
+	}
+
+	void testHalfRange() {
+		VertexQuantization::Report report{};
+		VertexQuantization::quantize<Vertices::Half3Tex>(mesh(16u, 1.0f, 70000.0f, 9u), &report);
+		CWF_CHECK(std::isinf(report.positionErrorBound)); // past the half range nothing is promised
+
+		VertexQuantization::quantize<Vertices::Half3Tex>(mesh(16u, 1e-6f, 0.0f, 9u), &report);
+		CWF_CHECK(report.positionErrorBound == std::ldexp(1.0f, -25)); // subnormal: a fixed half ulp
+	}
+
+	void testSnormIsBoxRelative() {
+		VertexQuantization::Report report{};
+		const std::vector<Vertices::Float3Tex> source{ mesh(1000u, 5.0f, 1000.0f, 4u) };
+		VertexQuantization::quantize<Vertices::Snorm3Tex>(source, &report);
+		for (int a{ 0 }; a < 3; a++) CWF_CHECK(std::abs(report.bounds.center[a] - 1000.0f) < 5.0f && report.bounds.extent[a] <= 5.0f);
+		CWF_CHECK(report.positionErrorBound < 1e-3f); // the offset doesn't cost precision, unlike halves
+		CWF_CHECK(VertexQuantization::isBoxRelative<Vertices::Snorm3Tex>() && !VertexQuantization::isBoxRelative<Vertices::Half3Tex>());
+	}
+}
+
+int main() {
+	testBounds<Vertices::Half3Tex>();
+	testBounds<Vertices::Snorm3Tex>();
+	testHalfRange();
+	testSnormIsBoxRelative();
+	return cwf::failures();
+}
\ No newline at end of file
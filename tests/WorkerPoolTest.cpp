@@ -0,0 +1,60 @@
+#include "Check.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace {
+	// every chunk runs exactly once per run, however many threads and chunks there are
+	void testEveryChunkOnce() {
+		for (const unsigned threads : { 0u, 1u, 3u, 8u }) {
+			WorkerPool pool{ threads };
+			CWF_CHECK(pool.getThreadCount() == threads);
+			bool once{ true };
+			for (const size_t chunks : { 0u, 1u, 2u, 7u, 64u, 1000u }) {
+				for (int round{ 0 }; round < 20; round++) {
+					std::vector<std::atomic<int>> hits(chunks);
+					pool.run(chunks, [&hits](size_t chunk) { hits[chunk].fetch_add(1); });
+					for (const std::atomic<int>& h : hits) once = once && h.load() == 1;
+				}
+			}
+			CWF_CHECK(once);
+		}
+	}
+
+	void testWorkIsShared() {
+		WorkerPool pool{ 3u };
+		std::vector<std::thread::id> ran(64u);
+		pool.run(ran.size(), [&ran](size_t chunk) {
+			ran[chunk] = std::this_thread::get_id();
+			std::this_thread::sleep_for(std::chrono::microseconds{ 200 }); // long enough for the workers to wake
+		});
+		size_t onCaller{ 0u };
+		for (const std::thread::id& id : ran) onCaller += id == std::this_thread::get_id();
+		CWF_CHECK(onCaller < ran.size());
+	}
+
+	// runs from several threads at once take turns
+	void testConcurrentCallers() {
+		WorkerPool pool{ 2u };
+		std::atomic<size_t> total{ 0u };
+		std::vector<std::thread> callers{};
+		for (int c{ 0 }; c < 4; c++) {
+			callers.emplace_back([&pool, &total] {
+				for (int round{ 0 }; round < 200; round++)
+					pool.run(10u, [&total](size_t chunk) { total.fetch_add(chunk + 1u); });
+			});
+		}
+		for (std::thread& caller : callers) caller.join();
+		CWF_CHECK(total.load() == 4u * 200u * 55u);
+	}
+}
+
+int main() {
+	testEveryChunkOnce();
+	testWorkIsShared();
+	testConcurrentCallers();
+	return cwf::failures();
+}
\ No newline at end of file